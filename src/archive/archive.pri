@@ -0,0 +1,19 @@
+HEADERS += \
+  archive/bitreader.h \
+  archive/compresseddevice.h \
+  archive/inflater.h \
+  archive/jobimporter.h \
+  archive/lzwdecoder.h \
+  archive/tararchive.h \
+  archive/tarreader.h
+
+SOURCES += \
+  archive/bitreader.cpp \
+  archive/compresseddevice.cpp \
+  archive/inflater.cpp \
+  archive/jobimporter.cpp \
+  archive/lzwdecoder.cpp \
+  archive/tararchive.cpp \
+  archive/tarreader.cpp
+
+LIBS += -lz
@@ -0,0 +1,129 @@
+/**
+ * @file   bitreader.cpp
+ * @author Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ *
+ * Copyright (C) 2012 - 2014 Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ * All Rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "bitreader.h"
+
+#include <cstring>
+
+#define BUFFER_SIZE 65536
+
+BitReader::BitReader(QIODevice* source):
+  m_source(source), m_buf(BUFFER_SIZE, 0), m_pos(0), m_len(0), m_bitBuf(0),
+  m_bitCount(0), m_padBytes(0), m_consumed(0), m_eof(false),
+  m_sourceError(false)
+{
+}
+
+bool BitReader::refill(void)
+{
+  if (m_eof) {
+    return false;
+  }
+
+  qint64 n = m_source->read(m_buf.data(), m_buf.size());
+  if (n <= 0) {
+    m_sourceError = (n < 0);
+    m_eof = true;
+    m_pos = m_len = 0;
+    return false;
+  }
+  m_pos = 0;
+  m_len = int(n);
+  return true;
+}
+
+bool BitReader::hasBits(int n)
+{
+  ensure(n);
+  return m_bitCount - m_padBytes * 8 >= n;
+}
+
+void BitReader::skip(qint64 n)
+{
+  while (n > 0) {
+    int step = int(qMin(n, qint64(32)));
+    ensure(step);
+    drop(step);
+    n -= step;
+  }
+}
+
+void BitReader::alignToByte(void)
+{
+  drop(m_bitCount & 7);
+}
+
+int BitReader::readByte(void)
+{
+  if (m_bitCount >= 8) {
+    if (m_bitCount <= m_padBytes * 8) {
+      return -1;
+    }
+    return int(take(8));
+  }
+  if (m_pos == m_len && !refill()) {
+    return -1;
+  }
+  m_consumed += 8;
+  return (unsigned char)m_buf.constData()[m_pos++];
+}
+
+qint64 BitReader::readBytes(char* data, qint64 maxSize)
+{
+  qint64 done = 0;
+  while (done < maxSize && m_bitCount >= 8) {
+    int c = readByte();
+    if (c < 0) {
+      return done;
+    }
+    data[done++] = char(c);
+  }
+
+  while (done < maxSize) {
+    if (m_pos == m_len && !refill()) {
+      break;
+    }
+    int n = int(qMin(maxSize - done, qint64(m_len - m_pos)));
+    memcpy(data + done, m_buf.constData() + m_pos, n);
+    m_pos += n;
+    m_consumed += qint64(n) * 8;
+    done += n;
+  }
+  return done;
+}
+
+void BitReader::unread(const char* data, int n)
+{
+  if (n <= 0) {
+    return;
+  }
+
+  QByteArray rest(data, n);
+  rest.append(m_buf.constData() + m_pos, m_len - m_pos);
+  m_len = rest.size();
+  m_pos = 0;
+  m_buf = rest;
+  if (m_buf.size() < BUFFER_SIZE) {
+    m_buf.resize(BUFFER_SIZE);
+  }
+  m_consumed -= qint64(n) * 8;
+}
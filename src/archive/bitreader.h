@@ -0,0 +1,112 @@
+/**
+ * @file   bitreader.h
+ * @author Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ *
+ * Copyright (C) 2012 - 2014 Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ * All Rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __BITREADER_H__
+#define __BITREADER_H__
+
+#include <QByteArray>
+#include <QIODevice>
+
+/**
+ * Buffered LSB-first bit input shared by the gzip and LZW decoders; the
+ * Inflater takes whole bytes from it and feeds them to zlib.
+ *
+ * Reading past the end of the source yields zero bits instead of failing, so
+ * the decoders can always peek a full code; overrun() tells whether any of
+ * those padding bits were actually consumed.
+ */
+class BitReader {
+public:
+  BitReader(QIODevice* source);
+
+  /* Make at least n (<= 32) bits available to peek() */
+  void ensure(int n)
+  {
+    while (m_bitCount < n) {
+      m_bitBuf |= quint64(nextByte()) << m_bitCount;
+      m_bitCount += 8;
+    }
+  }
+
+  quint32 peek(int n)
+  {
+    ensure(n);
+    return quint32(m_bitBuf & ((quint64(1) << n) - 1));
+  }
+
+  void drop(int n)
+  {
+    m_bitBuf >>= n;
+    m_bitCount -= n;
+    m_consumed += n;
+  }
+
+  quint32 take(int n)
+  {
+    quint32 bits = peek(n);
+    drop(n);
+    return bits;
+  }
+
+  /* True if n more bits can be taken without running into the padding */
+  bool hasBits(int n);
+  /* Skip an arbitrary number of bits */
+  void skip(qint64 n);
+  void alignToByte(void);
+
+  /* Byte-aligned reads; the reader must be aligned first */
+  int readByte(void);
+  qint64 readBytes(char* data, qint64 maxSize);
+  /* Push back the last n bytes returned by readBytes() */
+  void unread(const char* data, int n);
+
+  bool overrun(void) const { return m_bitCount < m_padBytes * 8; }
+  /* Bits consumed since construction */
+  qint64 position(void) const { return m_consumed; }
+  bool sourceError(void) const { return m_sourceError; }
+
+private:
+  int nextByte(void)
+  {
+    if (m_pos == m_len && !refill()) {
+      ++m_padBytes;
+      return 0;
+    }
+    return (unsigned char)m_buf.constData()[m_pos++];
+  }
+
+  bool refill(void);
+
+private:
+  QIODevice* m_source;
+  QByteArray m_buf;
+  int m_pos;
+  int m_len;
+  quint64 m_bitBuf;
+  int m_bitCount;
+  int m_padBytes;
+  qint64 m_consumed;
+  bool m_eof;
+  bool m_sourceError;
+};
+
+#endif /* __BITREADER_H__ */
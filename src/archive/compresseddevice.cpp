@@ -0,0 +1,362 @@
+/**
+ * @file   compresseddevice.cpp
+ * @author Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ *
+ * Copyright (C) 2012 - 2014 Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ * All Rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "compresseddevice.h"
+
+#include <QFile>
+
+#include <cstring>
+#include <zlib.h>
+
+#include "bitreader.h"
+#include "inflater.h"
+#include "lzwdecoder.h"
+#include "tararchive.h"
+
+#define GZIP_ID1 0x1f
+#define GZIP_ID2 0x8b
+#define COMPRESS_ID2 0x9d
+#define GZIP_DEFLATE 8
+
+#define FHCRC 0x02
+#define FEXTRA 0x04
+#define FNAME 0x08
+#define FCOMMENT 0x10
+
+CompressedDevice::CompressedDevice(const QString& fileName):
+  m_source(TarArchive::openMounted(fileName)), m_ownsSource(true),
+  m_reader(NULL), m_inflater(NULL), m_lzw(NULL), m_format(Plain), m_crc(0),
+  m_size(0), m_output(0), m_memberBase(0), m_spacing(0), m_resumed(false),
+  m_end(false), m_failed(false)
+{
+  if (!m_source) {
+    m_source = new QFile(fileName);
+  }
+}
+
+CompressedDevice::CompressedDevice(QIODevice* source):
+  m_source(source), m_ownsSource(false), m_reader(NULL), m_inflater(NULL),
+  m_lzw(NULL), m_format(Plain), m_crc(0), m_size(0), m_output(0),
+  m_memberBase(0), m_spacing(0), m_resumed(false), m_end(false),
+  m_failed(false)
+{
+}
+
+CompressedDevice::~CompressedDevice()
+{
+  close();
+  if (m_ownsSource) {
+    delete m_source;
+  }
+}
+
+bool CompressedDevice::open(OpenMode mode)
+{
+  if (mode & (WriteOnly | Append)) {
+    setErrorString("CompressedDevice is read-only");
+    return false;
+  }
+  if (!m_source->isOpen() && !m_source->open(QIODevice::ReadOnly)) {
+    setErrorString(m_source->errorString());
+    return false;
+  }
+
+  m_reader = new BitReader(m_source);
+  m_format = Plain;
+  m_pending.clear();
+  m_output = m_memberBase = 0;
+  m_checkpoints.clear();
+  m_resumed = m_end = m_failed = false;
+
+  int id1 = m_reader->readByte();
+  int id2 = (id1 == GZIP_ID1)? m_reader->readByte(): -1;
+  if (id1 == GZIP_ID1 && id2 == GZIP_ID2) {
+    m_format = Gzip;
+    m_inflater = new Inflater(m_reader);
+    m_inflater->setCheckpointSpacing(m_spacing);
+    if (!readGzipHeader()) {
+      close();
+      return false;
+    }
+  } else if (id1 == GZIP_ID1 && id2 == COMPRESS_ID2) {
+    m_format = Compress;
+    m_lzw = new LzwDecoder(m_reader);
+  } else {
+    if (id1 >= 0) {
+      m_pending.append(char(id1));
+    }
+    if (id2 >= 0) {
+      m_pending.append(char(id2));
+    }
+  }
+
+  return QIODevice::open(mode);
+}
+
+bool CompressedDevice::openAt(const Inflater::Checkpoint& checkpoint,
+    OpenMode mode)
+{
+  if (mode & (WriteOnly | Append)) {
+    setErrorString("CompressedDevice is read-only");
+    return false;
+  }
+  if (!m_source->isOpen() && !m_source->open(QIODevice::ReadOnly)) {
+    setErrorString(m_source->errorString());
+    return false;
+  }
+  if (!m_source->seek(checkpoint.input / 8)) {
+    setErrorString("cannot seek to checkpoint");
+    return false;
+  }
+
+  m_reader = new BitReader(m_source);
+  m_reader->skip(checkpoint.input % 8);
+  m_format = Gzip;
+  m_pending.clear();
+  m_inflater = new Inflater(m_reader);
+  m_inflater->resume(checkpoint);
+  m_output = m_memberBase = checkpoint.output;
+  m_checkpoints.clear();
+  m_resumed = true;
+  m_end = m_failed = false;
+
+  return QIODevice::open(mode);
+}
+
+void CompressedDevice::close(void)
+{
+  if (isOpen()) {
+    QIODevice::close();
+  }
+  delete m_inflater;
+  delete m_lzw;
+  delete m_reader;
+  m_inflater = NULL;
+  m_lzw = NULL;
+  m_reader = NULL;
+  if (m_ownsSource) {
+    m_source->close();
+  }
+}
+
+bool CompressedDevice::isSequential(void) const
+{
+  return true;
+}
+
+bool CompressedDevice::atEnd(void) const
+{
+  // QIODevice only knows about buffered data on a sequential device; decode
+  // ahead a byte so loops over readLine() see the real end of the stream
+  char c;
+  return !isOpen() || const_cast<CompressedDevice*>(this)->peek(&c, 1) <= 0;
+}
+
+CompressedDevice::Format CompressedDevice::format(void) const
+{
+  return m_format;
+}
+
+qint64 CompressedDevice::sourcePosition(void) const
+{
+  return m_reader? m_reader->position() / 8: 0;
+}
+
+void CompressedDevice::setCheckpointSpacing(qint64 spacing)
+{
+  m_spacing = spacing;
+}
+
+void CompressedDevice::collectCheckpoints(void)
+{
+  if (!m_inflater) {
+    return;
+  }
+  foreach (Inflater::Checkpoint checkpoint, m_inflater->takeCheckpoints()) {
+    if (!m_resumed) {
+      checkpoint.output += m_memberBase;
+    }
+    m_checkpoints.append(checkpoint);
+  }
+}
+
+QList<Inflater::Checkpoint> CompressedDevice::checkpoints(void)
+{
+  collectCheckpoints();
+  return m_checkpoints;
+}
+
+bool CompressedDevice::readGzipHeader(void)
+{
+  // ID1 and ID2 have already been consumed
+  int method = m_reader->readByte();
+  int flags = m_reader->readByte();
+  if (method != GZIP_DEFLATE || flags < 0) {
+    setErrorString("unsupported gzip compression method");
+    return false;
+  }
+
+  char skip[6];
+  if (m_reader->readBytes(skip, 6) != 6) {     // MTIME, XFL, OS
+    setErrorString("truncated gzip header");
+    return false;
+  }
+
+  if (flags & FEXTRA) {
+    int lo = m_reader->readByte();
+    int hi = m_reader->readByte();
+    if (lo < 0 || hi < 0) {
+      setErrorString("truncated gzip header");
+      return false;
+    }
+    for (int i = lo | (hi << 8); i > 0; --i) {
+      if (m_reader->readByte() < 0) {
+        setErrorString("truncated gzip header");
+        return false;
+      }
+    }
+  }
+
+  for (int field = FNAME; field <= FCOMMENT; field <<= 1) {
+    if (!(flags & field)) {
+      continue;
+    }
+    int c;
+    while ((c = m_reader->readByte()) > 0);
+    if (c < 0) {
+      setErrorString("truncated gzip header");
+      return false;
+    }
+  }
+
+  if ((flags & FHCRC) && m_reader->readBytes(skip, 2) != 2) {
+    setErrorString("truncated gzip header");
+    return false;
+  }
+
+  m_inflater->reset();
+  m_crc = 0;
+  m_size = 0;
+  return true;
+}
+
+bool CompressedDevice::readGzipTrailer(void)
+{
+  m_reader->alignToByte();
+
+  unsigned char trailer[8];
+  if (m_reader->readBytes((char*)trailer, 8) != 8) {
+    setErrorString("truncated gzip trailer");
+    return false;
+  }
+
+  quint32 crc = trailer[0] | (trailer[1] << 8) | (trailer[2] << 16) |
+    (quint32(trailer[3]) << 24);
+  quint32 size = trailer[4] | (trailer[5] << 8) | (trailer[6] << 16) |
+    (quint32(trailer[7]) << 24);
+  if (!m_resumed && (crc != m_crc || size != m_size)) {
+    setErrorString("gzip checksum mismatch");
+    return false;
+  }
+  return true;
+}
+
+qint64 CompressedDevice::fail(const QString& message, qint64 done)
+{
+  setErrorString(message);
+  m_failed = true;
+  return done? done: -1;
+}
+
+qint64 CompressedDevice::readData(char* data, qint64 maxSize)
+{
+  if (m_failed) {
+    return -1;
+  }
+
+  qint64 n = 0;
+  if (!m_pending.isEmpty()) {
+    n = qMin(maxSize, qint64(m_pending.size()));
+    memcpy(data, m_pending.constData(), n);
+    m_pending.remove(0, int(n));
+  }
+
+  switch (m_format) {
+  case Plain:
+    if (n < maxSize) {
+      qint64 r = m_reader->readBytes(data + n, maxSize - n);
+      if (r == 0 && m_reader->sourceError()) {
+        return fail(m_source->errorString(), n);
+      }
+      n += r;
+    }
+    break;
+
+  case Compress:
+    if (n < maxSize) {
+      qint64 r = m_lzw->read(data + n, maxSize - n);
+      if (r < 0) {
+        return fail(m_lzw->errorString(), n);
+      }
+      n += r;
+    }
+    break;
+
+  case Gzip:
+    while (n < maxSize && !m_end) {
+      qint64 r = m_inflater->read(data + n, maxSize - n);
+      if (r < 0) {
+        return fail(m_inflater->errorString(), n);
+      }
+      m_crc = quint32(crc32(m_crc, (const Bytef*)(data + n), uInt(r)));
+      m_size += quint32(r);
+      m_output += r;
+      n += r;
+
+      if (m_inflater->atEnd()) {
+        if (!readGzipTrailer()) {
+          return fail(errorString(), n);
+        }
+        collectCheckpoints();
+        m_memberBase = m_output;
+        m_resumed = false;
+        // Concatenated members decode as one stream; anything else after
+        // the trailer is ignored, as gzip -d does
+        int id1 = m_reader->readByte();
+        int id2 = (id1 == GZIP_ID1)? m_reader->readByte(): -1;
+        if (id1 != GZIP_ID1 || id2 != GZIP_ID2) {
+          m_end = true;
+        } else if (!readGzipHeader()) {
+          return fail(errorString(), n);
+        }
+      }
+    }
+    break;
+  }
+
+  return n;
+}
+
+qint64 CompressedDevice::writeData(const char*, qint64)
+{
+  return -1;
+}
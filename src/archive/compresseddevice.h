@@ -0,0 +1,111 @@
+/**
+ * @file   compresseddevice.h
+ * @author Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ *
+ * Copyright (C) 2012 - 2014 Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ * All Rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __COMPRESSEDDEVICE_H__
+#define __COMPRESSEDDEVICE_H__
+
+#include <QIODevice>
+#include <QList>
+#include <QString>
+
+#include "inflater.h"
+
+class BitReader;
+class LzwDecoder;
+
+/**
+ * Read-only sequential device that decodes gzip or compress(1) data on the
+ * fly.  The format is sniffed from the magic bytes when the device is
+ * opened; anything else is passed through untouched, so callers can open
+ * every ODB++ file through it regardless of how it was stored.
+ *
+ * A file name below a mounted TarArchive reads the archive member instead.
+ */
+class CompressedDevice: public QIODevice {
+public:
+  enum Format {
+    Plain,
+    Gzip,
+    Compress
+  };
+
+  CompressedDevice(const QString& fileName);
+  CompressedDevice(QIODevice* source);
+  virtual ~CompressedDevice();
+
+  virtual bool open(OpenMode mode);
+  virtual void close(void);
+  virtual bool isSequential(void) const;
+  virtual bool atEnd(void) const;
+
+  Format format(void) const;
+
+  /* True once the stream turned out to be corrupt or truncated */
+  bool hasError(void) const { return m_failed; }
+
+  /* Compressed bytes consumed from the source so far */
+  qint64 sourcePosition(void) const;
+
+  /**
+   * Record gzip seek checkpoints every spacing decoded bytes; must be set
+   * before open().  Checkpoint offsets count from the start of the stream.
+   */
+  void setCheckpointSpacing(qint64 spacing);
+  QList<Inflater::Checkpoint> checkpoints(void);
+
+  /**
+   * Open a gzip stream in the middle, at a checkpoint recorded earlier from
+   * the same source; the source must support seeking.  Checksums of the
+   * partially read member are not verified.
+   */
+  bool openAt(const Inflater::Checkpoint& checkpoint, OpenMode mode);
+
+protected:
+  virtual qint64 readData(char* data, qint64 maxSize);
+  virtual qint64 writeData(const char* data, qint64 maxSize);
+
+private:
+  bool readGzipHeader(void);
+  bool readGzipTrailer(void);
+  void collectCheckpoints(void);
+  qint64 fail(const QString& message, qint64 done);
+
+private:
+  QIODevice* m_source;
+  bool m_ownsSource;
+  BitReader* m_reader;
+  Inflater* m_inflater;
+  LzwDecoder* m_lzw;
+  Format m_format;
+  QByteArray m_pending;
+  quint32 m_crc;
+  quint32 m_size;
+  qint64 m_output;
+  qint64 m_memberBase;
+  qint64 m_spacing;
+  QList<Inflater::Checkpoint> m_checkpoints;
+  bool m_resumed;
+  bool m_end;
+  bool m_failed;
+};
+
+#endif /* __COMPRESSEDDEVICE_H__ */
@@ -0,0 +1,192 @@
+/**
+ * @file   inflater.cpp
+ * @author Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ *
+ * Copyright (C) 2012 - 2014 Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ * All Rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "inflater.h"
+
+#include <zlib.h>
+
+/* Compressed bytes handed to zlib at a time */
+#define INPUT_SIZE 65536
+
+/* Largest output request passed to zlib in one go, it counts in uInt */
+#define MAX_CHUNK (1 << 30)
+
+Inflater::Inflater(BitReader* input):
+  m_input(input), m_stream(new z_stream), m_buffer(INPUT_SIZE, 0),
+  m_state(Running), m_total(0), m_spacing(0), m_lastCheckpoint(0)
+{
+  m_stream->zalloc = Z_NULL;
+  m_stream->zfree = Z_NULL;
+  m_stream->opaque = Z_NULL;
+  m_stream->next_in = Z_NULL;
+  m_stream->avail_in = 0;
+  if (inflateInit2(m_stream, -MAX_WBITS) != Z_OK) {
+    delete m_stream;
+    m_stream = NULL;
+    fail("cannot initialise zlib", 0);
+  }
+}
+
+Inflater::~Inflater()
+{
+  if (m_stream) {
+    inflateEnd(m_stream);
+    delete m_stream;
+  }
+}
+
+void Inflater::reset(void)
+{
+  if (!m_stream) {
+    return;
+  }
+
+  inflateReset(m_stream);
+  m_state = Running;
+  m_total = 0;
+  m_lastCheckpoint = 0;
+  m_errorString.clear();
+}
+
+void Inflater::setCheckpointSpacing(qint64 spacing)
+{
+  m_spacing = spacing;
+}
+
+QList<Inflater::Checkpoint> Inflater::takeCheckpoints(void)
+{
+  QList<Checkpoint> checkpoints = m_checkpoints;
+  m_checkpoints.clear();
+  return checkpoints;
+}
+
+void Inflater::addCheckpoint(qint64 output)
+{
+  // The low three bits of data_type count the unused bits of the last
+  // byte zlib took in
+  Checkpoint checkpoint;
+  checkpoint.output = output;
+  checkpoint.input = m_input->position() - qint64(m_stream->avail_in) * 8 -
+    (m_stream->data_type & 7);
+
+  uInt size = WINDOW_SIZE;
+  checkpoint.window.resize(WINDOW_SIZE);
+  inflateGetDictionary(m_stream, (Bytef*)checkpoint.window.data(), &size);
+  checkpoint.window.resize(int(size));
+
+  m_checkpoints.append(checkpoint);
+  m_lastCheckpoint = output;
+}
+
+void Inflater::resume(const Checkpoint& checkpoint)
+{
+  reset();
+  if (!m_stream) {
+    return;
+  }
+
+  // The input is past the first input % 8 bits of a byte; zlib takes the
+  // rest of it before the byte-aligned data
+  m_stream->avail_in = 0;
+  int skipped = int(checkpoint.input % 8);
+  if (skipped) {
+    int bits = 8 - skipped;
+    inflatePrime(m_stream, bits, int(m_input->take(bits)));
+  }
+  if (!checkpoint.window.isEmpty()) {
+    inflateSetDictionary(m_stream,
+        (const Bytef*)checkpoint.window.constData(),
+        uInt(checkpoint.window.size()));
+  }
+  m_total = checkpoint.output;
+  m_lastCheckpoint = checkpoint.output;
+}
+
+qint64 Inflater::fail(const QString& message, qint64 done)
+{
+  m_state = Failed;
+  m_errorString = message;
+  return done? done: -1;
+}
+
+qint64 Inflater::read(char* data, qint64 maxSize)
+{
+  if (m_state == Failed) {
+    return -1;
+  }
+  if (m_state == Done || maxSize <= 0) {
+    return 0;
+  }
+
+  // Z_BLOCK stops at every block boundary, where checkpoints can be taken
+  int flush = m_spacing? Z_BLOCK: Z_NO_FLUSH;
+  m_stream->next_out = (Bytef*)data;
+  m_stream->avail_out = uInt(qMin(maxSize, qint64(MAX_CHUNK)));
+  uInt requested = m_stream->avail_out;
+
+  while (m_stream->avail_out > 0) {
+    if (m_stream->avail_in == 0) {
+      qint64 n = m_input->readBytes(m_buffer.data(), m_buffer.size());
+      if (n == 0 && m_input->sourceError()) {
+        return fail("cannot read compressed data",
+            requested - m_stream->avail_out);
+      }
+      m_stream->next_in = (Bytef*)m_buffer.data();
+      m_stream->avail_in = uInt(n);
+    }
+
+    uInt before = m_stream->avail_in;
+    uInt room = m_stream->avail_out;
+    int ret = inflate(m_stream, flush);
+    qint64 done = requested - m_stream->avail_out;
+
+    if (ret == Z_STREAM_END) {
+      m_input->unread((const char*)m_stream->next_in,
+          int(m_stream->avail_in));
+      m_stream->avail_in = 0;
+      m_state = Done;
+      break;
+    }
+    if (ret == Z_BUF_ERROR && before == 0) {
+      return fail("unexpected end of stream", done);
+    }
+    if (ret != Z_OK && ret != Z_BUF_ERROR) {
+      return fail(m_stream->msg? QString(m_stream->msg):
+          QString("corrupt deflate stream"), done);
+    }
+    if (before == 0 && room == m_stream->avail_out) {
+      // No input left and nothing decoded
+      return fail("unexpected end of stream", done);
+    }
+
+    // Bit 7 of data_type is set at the end of a block, bit 6 in the last
+    if (m_spacing && (m_stream->data_type & 128) &&
+        !(m_stream->data_type & 64) &&
+        m_total + done - m_lastCheckpoint >= m_spacing) {
+      addCheckpoint(m_total + done);
+    }
+  }
+
+  qint64 n = requested - m_stream->avail_out;
+  m_total += n;
+  return n;
+}
@@ -0,0 +1,99 @@
+/**
+ * @file   inflater.h
+ * @author Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ *
+ * Copyright (C) 2012 - 2014 Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ * All Rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __INFLATER_H__
+#define __INFLATER_H__
+
+#include <QByteArray>
+#include <QList>
+#include <QString>
+
+#include "bitreader.h"
+
+struct z_stream_s;
+
+/**
+ * Pull-based raw DEFLATE (RFC 1951) decoder on top of zlib's inflate().
+ *
+ * read() decodes only as much as the caller asks for, so memory use is
+ * bounded by zlib's 32K window and one input buffer no matter how large the
+ * stream is.  Input that zlib buffered past the end of the stream is handed
+ * back to the BitReader, which can go on with whatever follows it.
+ */
+class Inflater {
+public:
+  /**
+   * Decoder state at a block boundary: everything needed to resume decoding
+   * from the middle of a stream after seeking the input to `input' bits.
+   */
+  struct Checkpoint {
+    qint64 output;
+    qint64 input;
+    QByteArray window;
+  };
+
+  Inflater(BitReader* input);
+  ~Inflater();
+
+  /* Start a new stream at the current input position */
+  void reset(void);
+
+  /* Returns the number of bytes decoded, 0 at end of stream, -1 on error */
+  qint64 read(char* data, qint64 maxSize);
+
+  bool atEnd(void) const { return m_state == Done; }
+  QString errorString(void) const { return m_errorString; }
+
+  /* Record a checkpoint at the first block boundary every spacing bytes */
+  void setCheckpointSpacing(qint64 spacing);
+  QList<Checkpoint> takeCheckpoints(void);
+
+  /* Continue decoding a stream whose input is positioned at checkpoint */
+  void resume(const Checkpoint& checkpoint);
+
+  enum {
+    WINDOW_SIZE = 32768
+  };
+
+private:
+  enum State {
+    Running,
+    Done,
+    Failed
+  };
+
+  qint64 fail(const QString& message, qint64 done);
+  void addCheckpoint(qint64 output);
+
+private:
+  BitReader* m_input;
+  z_stream_s* m_stream;
+  QByteArray m_buffer;
+  State m_state;
+  qint64 m_total;
+  qint64 m_spacing;
+  qint64 m_lastCheckpoint;
+  QList<Checkpoint> m_checkpoints;
+  QString m_errorString;
+};
+
+#endif /* __INFLATER_H__ */
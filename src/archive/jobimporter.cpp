@@ -0,0 +1,339 @@
+/**
+ * @file   jobimporter.cpp
+ * @author Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ *
+ * Copyright (C) 2012 - 2014 Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ * All Rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "jobimporter.h"
+
+#include <QBuffer>
+#include <QDir>
+#include <QFileInfo>
+#include <QRunnable>
+
+#include "compresseddevice.h"
+#include "logger.h"
+#include "tarreader.h"
+
+#define CHUNK_SIZE 65536
+#define REPORT_INTERVAL_MS 100
+/* Compressed layer data held in memory while waiting for a decoder */
+#define MAX_PENDING_KB (256 * 1024)
+
+class DecodeTask: public QRunnable {
+public:
+  DecodeTask(JobImporter* importer, const QByteArray& data,
+      const QString& path, int budget):
+    m_importer(importer), m_data(data), m_path(path), m_budget(budget),
+    m_spooled(false) {}
+
+  /* The member was written to path as is and is decoded from there */
+  DecodeTask(JobImporter* importer, const QString& path):
+    m_importer(importer), m_path(path), m_budget(0), m_spooled(true) {}
+
+  virtual void run(void)
+  {
+    m_importer->decodeFinished(m_budget, decode());
+  }
+
+private:
+  QString decode(void)
+  {
+    QBuffer buffer(&m_data);
+    QFile file(m_path);
+    CompressedDevice device(m_spooled? (QIODevice*)&file: &buffer);
+    if (!device.open(QIODevice::ReadOnly)) {
+      return QString("%1: %2").arg(m_path, device.errorString());
+    }
+
+    // Members that turn out not to be compressed keep their name
+    QString target = m_path;
+    if (device.format() != CompressedDevice::Plain) {
+      target.chop(2);
+    } else if (m_spooled) {
+      return QString();
+    }
+
+    QFile out(target);
+    if (!out.open(QIODevice::WriteOnly)) {
+      return QString("%1: %2").arg(target, out.errorString());
+    }
+
+    char chunk[CHUNK_SIZE];
+    qint64 n;
+    while ((n = device.read(chunk, CHUNK_SIZE)) > 0) {
+      if (out.write(chunk, n) != n) {
+        out.remove();
+        return QString("%1: %2").arg(target, out.errorString());
+      }
+    }
+    if (n < 0) {
+      out.remove();
+      return QString("%1: %2").arg(m_path, device.errorString());
+    }
+
+    if (m_spooled) {
+      file.close();
+      file.remove();
+    }
+    return QString();
+  }
+
+private:
+  JobImporter* m_importer;
+  QByteArray m_data;
+  QString m_path;
+  int m_budget;
+  bool m_spooled;
+};
+
+JobImporter::JobImporter(const QString& archive, const QString& destDir):
+  m_archive(archive), m_destDir(destDir), m_file(archive),
+  m_budget(MAX_PENDING_KB), m_layersDone(0), m_cancelled(false)
+{
+  m_state.bytesRead = 0;
+  m_state.bytesTotal = QFileInfo(archive).size();
+  m_state.layersDone = 0;
+  m_state.layersTotal = 0;
+}
+
+JobImporter::~JobImporter()
+{
+  m_pool.clear();
+  m_pool.waitForDone();
+}
+
+bool JobImporter::fail(const QString& message)
+{
+  if (m_errorString.isEmpty()) {
+    m_errorString = message;
+  }
+  return false;
+}
+
+bool JobImporter::report(bool force)
+{
+  if (!m_progress) {
+    return true;
+  }
+  if (!force && m_lastReport.isValid() &&
+      m_lastReport.elapsed() < REPORT_INTERVAL_MS) {
+    return true;
+  }
+  m_lastReport.start();
+
+  m_state.bytesRead = m_file.pos();
+  m_state.layersDone = m_layersDone.loadAcquire();
+  if (!m_progress(m_state)) {
+    m_cancelled = true;
+    return fail("Import cancelled");
+  }
+  return true;
+}
+
+QString JobImporter::targetPath(const QString& name, bool* ok)
+{
+  QStringList parts;
+  *ok = true;
+  foreach (const QString& part, name.split('/', Qt::SkipEmptyParts)) {
+    if (part == ".") {
+      continue;
+    }
+    if (part == "..") {
+      *ok = false;
+      return QString();
+    }
+    parts.append(part);
+  }
+
+  // Drop the job's top-level directory
+  if (parts.size() < 2) {
+    return QString();
+  }
+  parts.removeFirst();
+  return m_destDir + "/" + parts.join('/');
+}
+
+bool JobImporter::extractFile(TarReader& tar, qint64 size,
+    const QString& path)
+{
+  QFile out(path);
+  if (!out.open(QIODevice::WriteOnly)) {
+    return fail(QString("%1: %2").arg(path, out.errorString()));
+  }
+
+  char chunk[CHUNK_SIZE];
+  while (size > 0) {
+    qint64 n = tar.read(chunk, qMin(size, qint64(CHUNK_SIZE)));
+    if (n <= 0) {
+      return fail(tar.errorString());
+    }
+    if (out.write(chunk, n) != n) {
+      return fail(QString("%1: %2").arg(path, out.errorString()));
+    }
+    size -= n;
+    if (!report()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool JobImporter::queueDecode(TarReader& tar, qint64 size,
+    const QString& path)
+{
+  // Members too big to hold in memory go to disk first and are decoded
+  // from there
+  if (size > qint64(MAX_PENDING_KB) * 1024) {
+    if (!extractFile(tar, size, path)) {
+      return false;
+    }
+    ++m_state.layersTotal;
+    m_pool.start(new DecodeTask(this, path));
+    return true;
+  }
+
+  QByteArray data;
+  data.resize(int(size));
+  for (qint64 done = 0; done < size; ) {
+    qint64 n = tar.read(data.data() + done, qMin(size - done,
+          qint64(CHUNK_SIZE)));
+    if (n <= 0) {
+      return fail(tar.errorString());
+    }
+    done += n;
+    if (!report()) {
+      return false;
+    }
+  }
+
+  // Keep the GUI responsive while waiting for decoders to free memory
+  int budget = int(qBound(qint64(1), size / 1024, qint64(MAX_PENDING_KB)));
+  while (!m_budget.tryAcquire(budget, REPORT_INTERVAL_MS)) {
+    if (!report(true)) {
+      return false;
+    }
+  }
+
+  ++m_state.layersTotal;
+  m_pool.start(new DecodeTask(this, data, path, budget));
+  return true;
+}
+
+void JobImporter::decodeFinished(int budget, const QString& error)
+{
+  if (!error.isEmpty()) {
+    QMutexLocker locker(&m_errorMutex);
+    if (m_decodeError.isEmpty()) {
+      m_decodeError = error;
+    }
+  }
+  m_layersDone.fetchAndAddRelease(1);
+  m_budget.release(budget);
+}
+
+bool JobImporter::run(const ProgressFunc& progress)
+{
+  m_progress = progress;
+
+  LOG_STEP(QString("Importing %1 into %2").arg(m_archive, m_destDir));
+  QElapsedTimer timer;
+  timer.start();
+
+  if (!m_file.open(QIODevice::ReadOnly)) {
+    return fail(QString("%1: %2").arg(m_archive, m_file.errorString()));
+  }
+
+  CompressedDevice stream(&m_file);
+  if (!stream.open(QIODevice::ReadOnly)) {
+    return fail(QString("%1: %2").arg(m_archive, stream.errorString()));
+  }
+
+  TarReader tar(&stream);
+  TarReader::Entry entry;
+  int files = 0;
+  bool ok = true;
+
+  while (ok && tar.next(entry)) {
+    bool safe;
+    QString path = targetPath(entry.name, &safe);
+    if (!safe) {
+      LOG_WARNING(QString("Skipping unsafe archive member: %1")
+          .arg(entry.name));
+      continue;
+    }
+    if (path.isEmpty()) {
+      continue;
+    }
+
+    switch (entry.type) {
+    case TarReader::Entry::Directory:
+      if (!QDir().mkpath(path)) {
+        ok = fail(QString("Cannot create directory `%1'").arg(path));
+      }
+      break;
+
+    case TarReader::Entry::File:
+      if (!QDir().mkpath(QFileInfo(path).absolutePath())) {
+        ok = fail(QString("Cannot create directory for `%1'").arg(path));
+        break;
+      }
+      if (path.endsWith(".Z") || path.endsWith(".z")) {
+        ok = queueDecode(tar, entry.size, path);
+      } else {
+        ok = extractFile(tar, entry.size, path);
+      }
+      ++files;
+      break;
+
+    default:
+      LOG_WARNING(QString("Skipping non-regular archive member: %1")
+          .arg(entry.name));
+      break;
+    }
+
+    ok = ok && report();
+  }
+
+  if (ok && tar.hasError()) {
+    ok = fail(QString("%1: %2").arg(m_archive, tar.errorString()));
+  }
+
+  if (!ok) {
+    m_pool.clear();
+  }
+  while (!m_pool.waitForDone(REPORT_INTERVAL_MS)) {
+    if (ok && !report(true)) {
+      ok = false;
+      m_pool.clear();
+    }
+  }
+
+  if (ok && !m_decodeError.isEmpty()) {
+    ok = fail(m_decodeError);
+  }
+  if (ok) {
+    report(true);
+    LOG_INFO(QString("Extracted %1 files (%2 decoded layers) in %3 ms")
+        .arg(files).arg(m_state.layersTotal).arg(timer.elapsed()));
+  } else {
+    LOG_ERROR(QString("Import failed: %1").arg(m_errorString));
+  }
+  return ok;
+}
@@ -0,0 +1,96 @@
+/**
+ * @file   jobimporter.h
+ * @author Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ *
+ * Copyright (C) 2012 - 2014 Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ * All Rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __JOBIMPORTER_H__
+#define __JOBIMPORTER_H__
+
+#include <functional>
+
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QMutex>
+#include <QSemaphore>
+#include <QString>
+#include <QThreadPool>
+
+class TarReader;
+
+/**
+ * Extracts an ODB++ .tgz/.tar into a job directory without external tools.
+ *
+ * The archive is inflated and untarred in a single streaming pass on the
+ * calling thread, dropping the top-level directory like tar
+ * --strip-components=1.  Compressed members (features.Z and friends) are
+ * handed to a thread pool as soon as they have been read and written out
+ * decoded, so layer decoding overlaps with the rest of the extraction.
+ */
+class JobImporter {
+public:
+  struct Progress {
+    qint64 bytesRead;
+    qint64 bytesTotal;
+    int layersDone;
+    int layersTotal;
+  };
+
+  /* Return false to cancel the import */
+  typedef std::function<bool (const Progress& progress)> ProgressFunc;
+
+  JobImporter(const QString& archive, const QString& destDir);
+  ~JobImporter();
+
+  /* Returns false on error or cancellation; progress runs on this thread */
+  bool run(const ProgressFunc& progress = ProgressFunc());
+
+  bool cancelled(void) const { return m_cancelled; }
+  QString errorString(void) const { return m_errorString; }
+
+private:
+  friend class DecodeTask;
+
+  QString targetPath(const QString& name, bool* ok);
+  bool extractFile(TarReader& tar, qint64 size, const QString& path);
+  bool queueDecode(TarReader& tar, qint64 size, const QString& path);
+  void decodeFinished(int budget, const QString& error);
+  bool report(bool force = false);
+  bool fail(const QString& message);
+
+private:
+  QString m_archive;
+  QString m_destDir;
+  QFile m_file;
+  ProgressFunc m_progress;
+  Progress m_state;
+  QElapsedTimer m_lastReport;
+
+  QThreadPool m_pool;
+  QSemaphore m_budget;
+  QAtomicInt m_layersDone;
+  QMutex m_errorMutex;
+  QString m_decodeError;
+
+  bool m_cancelled;
+  QString m_errorString;
+};
+
+#endif /* __JOBIMPORTER_H__ */
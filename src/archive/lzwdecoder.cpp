@@ -0,0 +1,193 @@
+/**
+ * @file   lzwdecoder.cpp
+ * @author Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ *
+ * Copyright (C) 2012 - 2014 Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ * All Rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "lzwdecoder.h"
+
+#include <cstring>
+
+#define BLOCK_MODE 0x80
+#define BITS_MASK 0x1f
+
+LzwDecoder::LzwDecoder(BitReader* input):
+  m_input(input), m_state(Header), m_maxBits(MAX_BITS), m_blockMode(true),
+  m_bits(INIT_BITS), m_maxCode(0), m_maxMaxCode(0), m_freeEntry(0),
+  m_groupCodes(0), m_oldCode(0), m_finChar(0), m_stackTop(0)
+{
+  m_prefix = new quint16[1 << MAX_BITS];
+  m_suffix = new quint8[1 << MAX_BITS];
+  m_stack = new quint8[(1 << MAX_BITS) + 1];
+
+  for (int i = 0; i < 256; ++i) {
+    m_prefix[i] = 0;
+    m_suffix[i] = quint8(i);
+  }
+}
+
+LzwDecoder::~LzwDecoder()
+{
+  delete [] m_prefix;
+  delete [] m_suffix;
+  delete [] m_stack;
+}
+
+bool LzwDecoder::readHeader(void)
+{
+  int flags = m_input->readByte();
+  if (flags < 0) {
+    m_errorString = "missing compress header";
+    return false;
+  }
+
+  m_maxBits = flags & BITS_MASK;
+  m_blockMode = flags & BLOCK_MODE;
+  if (m_maxBits < INIT_BITS || m_maxBits > MAX_BITS) {
+    m_errorString = QString("unsupported %1-bit compression").arg(m_maxBits);
+    return false;
+  }
+
+  m_maxMaxCode = 1 << m_maxBits;
+  m_bits = INIT_BITS;
+  m_maxCode = (1 << m_bits) - 1;
+  m_freeEntry = m_blockMode? CLEAR + 1: 256;
+  m_groupCodes = 0;
+  return true;
+}
+
+void LzwDecoder::skipGroup(void)
+{
+  // compress(1) reads codes in groups of eight and discards the unused
+  // tail of a group whenever the code width changes
+  int rest = (8 - m_groupCodes % 8) % 8;
+  m_input->skip(qint64(rest) * m_bits);
+  m_groupCodes = 0;
+}
+
+bool LzwDecoder::nextCode(int& code)
+{
+  if (m_freeEntry > m_maxCode) {
+    skipGroup();
+    ++m_bits;
+    m_maxCode = (m_bits == m_maxBits)? m_maxMaxCode: (1 << m_bits) - 1;
+  }
+
+  if (!m_input->hasBits(m_bits)) {
+    return false;
+  }
+  code = m_input->take(m_bits);
+  ++m_groupCodes;
+  return true;
+}
+
+qint64 LzwDecoder::read(char* data, qint64 maxSize)
+{
+  qint64 n = 0;
+
+  while (n < maxSize) {
+    if (m_stackTop > 0) {
+      int count = int(qMin(qint64(m_stackTop), maxSize - n));
+      for (int i = 0; i < count; ++i) {
+        data[n++] = char(m_stack[--m_stackTop]);
+      }
+      continue;
+    }
+
+    int code;
+    switch (m_state) {
+    case Header:
+      if (!readHeader()) {
+        m_state = Failed;
+        return -1;
+      }
+      m_state = First;
+      break;
+
+    case First:
+      if (!nextCode(code)) {
+        m_state = Done;
+        return n;
+      }
+      if (code >= 256) {
+        m_errorString = "bad first code";
+        m_state = Failed;
+        return n? n: -1;
+      }
+      m_oldCode = m_finChar = code;
+      data[n++] = char(code);
+      m_state = Codes;
+      break;
+
+    case Codes: {
+      if (!nextCode(code)) {
+        m_state = Done;
+        return n;
+      }
+
+      if (code == CLEAR && m_blockMode) {
+        skipGroup();
+        m_freeEntry = CLEAR;
+        m_bits = INIT_BITS;
+        m_maxCode = (1 << m_bits) - 1;
+        break;
+      }
+
+      int inCode = code;
+      if (code >= m_freeEntry) {
+        // The KwKwK case: the code being defined is used right away
+        if (code > m_freeEntry) {
+          m_errorString = "corrupt input";
+          m_state = Failed;
+          return n? n: -1;
+        }
+        m_stack[m_stackTop++] = quint8(m_finChar);
+        code = m_oldCode;
+      }
+      while (code >= 256) {
+        if (m_stackTop >= (1 << MAX_BITS)) {
+          m_stackTop = 0;
+          m_errorString = "corrupt input";
+          m_state = Failed;
+          return n? n: -1;
+        }
+        m_stack[m_stackTop++] = m_suffix[code];
+        code = m_prefix[code];
+      }
+      m_finChar = m_suffix[code];
+      m_stack[m_stackTop++] = quint8(m_finChar);
+
+      if (m_freeEntry < m_maxMaxCode) {
+        m_prefix[m_freeEntry] = quint16(m_oldCode);
+        m_suffix[m_freeEntry] = quint8(m_finChar);
+        ++m_freeEntry;
+      }
+      m_oldCode = inCode;
+      break;
+    }
+
+    case Done:
+      return n;
+
+    case Failed:
+      return n? n: -1;
+    }
+  }
+  return n;
+}
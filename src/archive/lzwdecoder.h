@@ -0,0 +1,85 @@
+/**
+ * @file   lzwdecoder.h
+ * @author Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ *
+ * Copyright (C) 2012 - 2014 Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ * All Rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __LZWDECODER_H__
+#define __LZWDECODER_H__
+
+#include <QString>
+
+#include "bitreader.h"
+
+/**
+ * Pull-based decoder for Unix compress(1) streams, the format most ODB++
+ * writers use for features.Z.  The 0x1f 0x9d magic is expected to have been
+ * consumed already; the decoder starts at the flags byte.
+ */
+class LzwDecoder {
+public:
+  LzwDecoder(BitReader* input);
+  ~LzwDecoder();
+
+  /* Returns the number of bytes decoded, 0 at end of stream, -1 on error */
+  qint64 read(char* data, qint64 maxSize);
+
+  bool atEnd(void) const { return m_state == Done; }
+  QString errorString(void) const { return m_errorString; }
+
+  enum {
+    INIT_BITS = 9,
+    MAX_BITS = 16,
+    CLEAR = 256
+  };
+
+private:
+  enum State {
+    Header,
+    First,
+    Codes,
+    Done,
+    Failed
+  };
+
+  bool readHeader(void);
+  /* Skip to the end of the current group of eight codes */
+  void skipGroup(void);
+  bool nextCode(int& code);
+
+private:
+  BitReader* m_input;
+  State m_state;
+  int m_maxBits;
+  bool m_blockMode;
+  int m_bits;
+  int m_maxCode;
+  int m_maxMaxCode;
+  int m_freeEntry;
+  int m_groupCodes;
+  int m_oldCode;
+  int m_finChar;
+  quint16* m_prefix;
+  quint8* m_suffix;
+  quint8* m_stack;
+  int m_stackTop;
+  QString m_errorString;
+};
+
+#endif /* __LZWDECODER_H__ */
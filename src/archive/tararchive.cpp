@@ -0,0 +1,345 @@
+/**
+ * @file   tararchive.cpp
+ * @author Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ *
+ * Copyright (C) 2012 - 2014 Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ * All Rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "tararchive.h"
+
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutex>
+
+#include "logger.h"
+#include "tarreader.h"
+
+#define CHUNK_SIZE 65536
+
+static QMutex mountMutex;
+static QList<TarArchive*> mountedArchives;
+
+/* One member of the uncompressed tar stream */
+class TarMemberDevice: public QIODevice {
+public:
+  TarMemberDevice(QIODevice* stream, qint64 skip, qint64 size):
+    m_stream(stream), m_skip(skip), m_remaining(size) {}
+
+  virtual ~TarMemberDevice()
+  {
+    close();
+    delete m_stream;
+  }
+
+  virtual bool open(OpenMode mode)
+  {
+    if (mode & (WriteOnly | Append)) {
+      setErrorString("archive members are read-only");
+      return false;
+    }
+
+    if (!m_stream->isSequential()) {
+      if (!m_stream->seek(m_skip)) {
+        setErrorString(m_stream->errorString());
+        return false;
+      }
+    } else {
+      char chunk[CHUNK_SIZE];
+      while (m_skip > 0) {
+        qint64 n = m_stream->read(chunk, qMin(m_skip, qint64(CHUNK_SIZE)));
+        if (n <= 0) {
+          setErrorString("unexpected end of archive");
+          return false;
+        }
+        m_skip -= n;
+      }
+    }
+    m_skip = 0;
+    return QIODevice::open(mode);
+  }
+
+  virtual bool isSequential(void) const
+  {
+    return true;
+  }
+
+  virtual qint64 bytesAvailable(void) const
+  {
+    return m_remaining + QIODevice::bytesAvailable();
+  }
+
+protected:
+  virtual qint64 readData(char* data, qint64 maxSize)
+  {
+    if (m_remaining == 0) {
+      return 0;
+    }
+    qint64 n = m_stream->read(data, qMin(maxSize, m_remaining));
+    if (n <= 0) {
+      setErrorString("unexpected end of archive");
+      return -1;
+    }
+    m_remaining -= n;
+    return n;
+  }
+
+  virtual qint64 writeData(const char*, qint64)
+  {
+    return -1;
+  }
+
+private:
+  QIODevice* m_stream;
+  qint64 m_skip;
+  qint64 m_remaining;
+};
+
+TarArchive::TarArchive(const QString& fileName):
+  m_fileName(fileName), m_root(QDir(fileName).absolutePath()),
+  m_format(CompressedDevice::Plain)
+{
+}
+
+TarArchive::~TarArchive()
+{
+  unmount(this);
+}
+
+bool TarArchive::isArchive(const QString& fileName)
+{
+  QString name = fileName.toLower();
+  return QFileInfo(fileName).isFile() && (name.endsWith(".tgz") ||
+      name.endsWith(".tar.gz") || name.endsWith(".tar"));
+}
+
+QString TarArchive::memberPath(const QString& path) const
+{
+  QString clean = QDir::cleanPath(QDir::fromNativeSeparators(path));
+  while (clean.startsWith("./")) {
+    clean.remove(0, 2);
+  }
+  if (clean == "." || clean == "/") {
+    return QString();
+  }
+  return clean;
+}
+
+void TarArchive::addMember(const QString& path, const Member& member)
+{
+  if (m_members.contains(path)) {
+    m_members[path] = member;
+    return;
+  }
+  m_members.insert(path, member);
+
+  // Tarballs need not list directories, so create them from member paths
+  int slash = path.lastIndexOf('/');
+  QString parent = (slash < 0)? QString(): path.left(slash);
+  m_children[parent].append(path.mid(slash + 1));
+  if (!parent.isEmpty() && !m_members.contains(parent)) {
+    Member dir = { 0, 0, true };
+    addMember(parent, dir);
+  }
+}
+
+bool TarArchive::open(void)
+{
+  QElapsedTimer timer;
+  timer.start();
+
+  // The archive itself, never a member of a mounted one
+  QFile file(m_fileName);
+  CompressedDevice stream(&file);
+  stream.setCheckpointSpacing(CHECKPOINT_SPACING);
+  if (!stream.open(QIODevice::ReadOnly)) {
+    m_errorString = stream.errorString();
+    return false;
+  }
+  m_format = stream.format();
+
+  QList<QPair<QString, Member> > entries;
+  TarReader tar(&stream);
+  TarReader::Entry entry;
+  while (tar.next(entry)) {
+    if (entry.type != TarReader::Entry::File &&
+        entry.type != TarReader::Entry::Directory) {
+      continue;
+    }
+    QString name = memberPath(entry.name);
+    if (name.isEmpty() || name.startsWith("../") || name.startsWith("/")) {
+      continue;
+    }
+    Member member = { entry.offset, entry.size,
+      entry.type == TarReader::Entry::Directory };
+    entries.append(qMakePair(name, member));
+  }
+
+  if (tar.hasError()) {
+    m_errorString = tar.errorString();
+    return false;
+  }
+  if (entries.isEmpty()) {
+    m_errorString = "not a tar archive";
+    return false;
+  }
+
+  // Drop the job's top-level directory unless the job sits at the root
+  QString top = entries.first().first.section('/', 0, 0);
+  bool strip = (top != "matrix" && top != "steps");
+  for (int i = 0; i < entries.size() && strip; ++i) {
+    const QString& name = entries[i].first;
+    strip = name == top ||
+      (name.startsWith(top + "/") && name.size() > top.size() + 1);
+  }
+
+  m_members.clear();
+  m_children.clear();
+  Member root = { 0, 0, true };
+  m_members.insert(QString(), root);
+  for (int i = 0; i < entries.size(); ++i) {
+    QString name = entries[i].first;
+    if (strip) {
+      if (name == top) {
+        continue;
+      }
+      name = name.mid(top.size() + 1);
+    }
+    addMember(name, entries[i].second);
+  }
+
+  m_checkpoints = stream.checkpoints();
+
+  LOG_INFO(QString("Indexed %1: %2 members, %3 checkpoints in %4 ms")
+      .arg(m_fileName).arg(m_members.size()).arg(m_checkpoints.size())
+      .arg(timer.elapsed()));
+  return true;
+}
+
+bool TarArchive::exists(const QString& path) const
+{
+  return m_members.contains(memberPath(path));
+}
+
+bool TarArchive::isDirectory(const QString& path) const
+{
+  QHash<QString, Member>::const_iterator it = m_members.find(
+      memberPath(path));
+  return it != m_members.end() && it->directory;
+}
+
+qint64 TarArchive::size(const QString& path) const
+{
+  QHash<QString, Member>::const_iterator it = m_members.find(
+      memberPath(path));
+  return it != m_members.end()? it->size: -1;
+}
+
+QStringList TarArchive::entryList(const QString& dir) const
+{
+  QStringList list = m_children.value(memberPath(dir));
+  list.sort();
+  return list;
+}
+
+QIODevice* TarArchive::openMember(const QString& path) const
+{
+  QHash<QString, Member>::const_iterator it = m_members.find(
+      memberPath(path));
+  if (it == m_members.end() || it->directory) {
+    return NULL;
+  }
+  const Member& member = *it;
+
+  if (m_format == CompressedDevice::Plain) {
+    QFile* file = new QFile(m_fileName);
+    if (!file->open(QIODevice::ReadOnly)) {
+      delete file;
+      return NULL;
+    }
+    return new TarMemberDevice(file, member.offset, member.size);
+  }
+
+  // Resume inflating from the last checkpoint before the member
+  int lo = 0, hi = m_checkpoints.size();
+  while (lo < hi) {
+    int mid = (lo + hi) / 2;
+    if (m_checkpoints[mid].output <= member.offset) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+
+  // Read the archive file directly; going through the mount registry
+  // would come back here for every member of a mounted archive
+  QFile* file = new QFile(m_fileName);
+  CompressedDevice* stream = new CompressedDevice(file);
+  file->setParent(stream);
+  qint64 skip = member.offset;
+  bool ok;
+  if (lo > 0) {
+    ok = stream->openAt(m_checkpoints[lo - 1], QIODevice::ReadOnly);
+    skip -= m_checkpoints[lo - 1].output;
+  } else {
+    ok = stream->open(QIODevice::ReadOnly);
+  }
+  if (!ok) {
+    LOG_ERROR(QString("Cannot open %1 in %2: %3").arg(path, m_fileName,
+          stream->errorString()));
+    delete stream;
+    return NULL;
+  }
+  return new TarMemberDevice(stream, skip, member.size);
+}
+
+void TarArchive::mount(TarArchive* archive)
+{
+  QMutexLocker locker(&mountMutex);
+  if (!mountedArchives.contains(archive)) {
+    mountedArchives.append(archive);
+  }
+}
+
+void TarArchive::unmount(TarArchive* archive)
+{
+  QMutexLocker locker(&mountMutex);
+  mountedArchives.removeAll(archive);
+}
+
+QIODevice* TarArchive::openMounted(const QString& fileName)
+{
+  QString path = QDir::cleanPath(QDir::fromNativeSeparators(fileName));
+  TarArchive* found = NULL;
+  {
+    QMutexLocker locker(&mountMutex);
+    foreach (TarArchive* archive, mountedArchives) {
+      if (path.startsWith(archive->m_root + "/")) {
+        found = archive;
+        break;
+      }
+    }
+  }
+
+  // Members are opened without the lock, opening one may take a while
+  if (!found) {
+    return NULL;
+  }
+  return found->openMember(path.mid(found->m_root.size() + 1));
+}
@@ -0,0 +1,101 @@
+/**
+ * @file   tararchive.h
+ * @author Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ *
+ * Copyright (C) 2012 - 2014 Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ * All Rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __TARARCHIVE_H__
+#define __TARARCHIVE_H__
+
+#include <QHash>
+#include <QIODevice>
+#include <QList>
+#include <QMap>
+#include <QString>
+#include <QStringList>
+
+#include "compresseddevice.h"
+#include "inflater.h"
+
+/**
+ * Random-access view of a .tgz/.tar job archive.
+ *
+ * open() streams through the archive once and keeps an index of every member
+ * (offset and size in the uncompressed tar stream) plus gzip checkpoints
+ * every CHECKPOINT_SPACING bytes.  A member is then read by seeking to the
+ * closest checkpoint before it and inflating at most one spacing worth of
+ * data to reach it, so individual layers load without extracting the job.
+ *
+ * Member paths are relative to the job root; the archive's top-level
+ * directory is stripped the way JobImporter does.
+ */
+class TarArchive {
+public:
+  struct Member {
+    qint64 offset;
+    qint64 size;
+    bool directory;
+  };
+
+  TarArchive(const QString& fileName);
+  ~TarArchive();
+
+  /* Build the member index; false if the file is not a readable archive */
+  bool open(void);
+
+  QString fileName(void) const { return m_fileName; }
+  QString errorString(void) const { return m_errorString; }
+
+  bool exists(const QString& path) const;
+  bool isDirectory(const QString& path) const;
+  qint64 size(const QString& path) const;     /* -1 if missing */
+  QStringList entryList(const QString& dir) const;
+
+  /* New device reading one member, or NULL; the caller takes ownership */
+  QIODevice* openMember(const QString& path) const;
+
+  static bool isArchive(const QString& fileName);
+
+  /**
+   * While mounted, CompressedDevice resolves "<archive>/<member>" file names
+   * to archive members, so parsers read them like plain files.
+   */
+  static void mount(TarArchive* archive);
+  static void unmount(TarArchive* archive);
+  static QIODevice* openMounted(const QString& fileName);
+
+  enum {
+    CHECKPOINT_SPACING = 4 * 1024 * 1024
+  };
+
+private:
+  QString memberPath(const QString& path) const;
+  void addMember(const QString& path, const Member& member);
+
+private:
+  QString m_fileName;
+  QString m_root;
+  CompressedDevice::Format m_format;
+  QHash<QString, Member> m_members;
+  QMap<QString, QStringList> m_children;
+  QList<Inflater::Checkpoint> m_checkpoints;
+  QString m_errorString;
+};
+
+#endif /* __TARARCHIVE_H__ */
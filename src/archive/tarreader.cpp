@@ -0,0 +1,251 @@
+/**
+ * @file   tarreader.cpp
+ * @author Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ *
+ * Copyright (C) 2012 - 2014 Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ * All Rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "tarreader.h"
+
+#include <cstring>
+
+/* Largest long name or pax header accepted, they are held in memory */
+#define MAX_STRING_SIZE (1024 * 1024)
+
+/* Parse a numeric header field, octal or GNU base-256 */
+static qint64 parseNumber(const char* field, int size)
+{
+  const unsigned char* p = (const unsigned char*)field;
+  qint64 value = 0;
+
+  if (p[0] & 0x80) {
+    value = p[0] & 0x7f;
+    for (int i = 1; i < size; ++i) {
+      value = (value << 8) | p[i];
+    }
+    return value;
+  }
+
+  int i = 0;
+  while (i < size && (p[i] == ' ' || p[i] == 0)) {
+    ++i;
+  }
+  for (; i < size && p[i] >= '0' && p[i] <= '7'; ++i) {
+    value = (value << 3) | (p[i] - '0');
+  }
+  return value;
+}
+
+static QString headerString(const char* field, int size)
+{
+  return QString::fromUtf8(field, int(qstrnlen(field, size)));
+}
+
+TarReader::TarReader(QIODevice* source):
+  m_source(source), m_position(0), m_remaining(0), m_padding(0)
+{
+}
+
+bool TarReader::fail(const QString& message)
+{
+  m_errorString = message;
+  return false;
+}
+
+bool TarReader::readBlock(char* block)
+{
+  qint64 done = 0;
+  while (done < BLOCK_SIZE) {
+    qint64 n = m_source->read(block + done, BLOCK_SIZE - done);
+    if (n < 0) {
+      return fail(m_source->errorString());
+    }
+    if (n == 0) {
+      // A missing end-of-archive marker is common enough to accept
+      return done > 0? fail("unexpected end of archive"): false;
+    }
+    done += n;
+  }
+  m_position += BLOCK_SIZE;
+  return true;
+}
+
+bool TarReader::skip(qint64 size)
+{
+  char buf[16384];
+  while (size > 0) {
+    qint64 n = m_source->read(buf, qMin(size, qint64(sizeof(buf))));
+    if (n <= 0) {
+      return fail("unexpected end of archive");
+    }
+    size -= n;
+    m_position += n;
+  }
+  return true;
+}
+
+bool TarReader::readString(qint64 size, QByteArray& out)
+{
+  if (size < 0 || size > MAX_STRING_SIZE) {
+    return fail("oversized extended tar header");
+  }
+
+  out.resize(int(size));
+  qint64 done = 0;
+  while (done < size) {
+    qint64 n = m_source->read(out.data() + done, size - done);
+    if (n <= 0) {
+      return fail("unexpected end of archive");
+    }
+    done += n;
+  }
+  m_position += size;
+  return skip((BLOCK_SIZE - size % BLOCK_SIZE) % BLOCK_SIZE);
+}
+
+void TarReader::parsePax(const QByteArray& data, QString& name,
+    QString& linkName, qint64& size)
+{
+  // Records are "<length> <key>=<value>\n"
+  int pos = 0;
+  while (pos < data.size()) {
+    int space = data.indexOf(' ', pos);
+    if (space < 0) {
+      break;
+    }
+    int length = data.mid(pos, space - pos).toInt();
+    if (length <= 0 || pos + length > data.size()) {
+      break;
+    }
+    QByteArray record = data.mid(space + 1, pos + length - space - 2);
+    int eq = record.indexOf('=');
+    if (eq > 0) {
+      QByteArray key = record.left(eq);
+      QByteArray value = record.mid(eq + 1);
+      if (key == "path") {
+        name = QString::fromUtf8(value);
+      } else if (key == "linkpath") {
+        linkName = QString::fromUtf8(value);
+      } else if (key == "size") {
+        size = value.toLongLong();
+      }
+    }
+    pos += length;
+  }
+}
+
+bool TarReader::next(Entry& entry)
+{
+  if (hasError() || !skip(m_remaining + m_padding)) {
+    return false;
+  }
+  m_remaining = m_padding = 0;
+
+  QString longName, longLink;
+  qint64 paxSize = -1;
+
+  for (;;) {
+    char block[BLOCK_SIZE];
+    if (!readBlock(block)) {
+      return false;
+    }
+
+    bool empty = true;
+    for (int i = 0; i < BLOCK_SIZE && empty; ++i) {
+      empty = (block[i] == 0);
+    }
+    if (empty) {
+      return false;
+    }
+
+    unsigned sum = 0;
+    for (int i = 0; i < BLOCK_SIZE; ++i) {
+      sum += (i >= 148 && i < 156)? ' ': (unsigned char)block[i];
+    }
+    if (sum != unsigned(parseNumber(block + 148, 8))) {
+      return fail("bad tar header checksum");
+    }
+
+    qint64 size = parseNumber(block + 124, 12);
+    char type = block[156];
+
+    if (type == 'L' || type == 'K' || type == 'x' || type == 'g') {
+      QByteArray data;
+      if (!readString(size, data)) {
+        return false;
+      }
+      if (type == 'L') {
+        longName = headerString(data.constData(), data.size());
+      } else if (type == 'K') {
+        longLink = headerString(data.constData(), data.size());
+      } else if (type == 'x') {
+        parsePax(data, longName, longLink, paxSize);
+      }
+      continue;
+    }
+
+    entry.name = headerString(block, 100);
+    if (memcmp(block + 257, "ustar", 5) == 0 && block[345]) {
+      entry.name = headerString(block + 345, 155) + "/" + entry.name;
+    }
+    if (!longName.isEmpty()) {
+      entry.name = longName;
+    }
+    entry.linkName = longLink.isEmpty()? headerString(block + 157, 100):
+      longLink;
+
+    switch (type) {
+    case '0': case '\0': case '7':
+      entry.type = Entry::File;
+      break;
+    case '5':
+      entry.type = Entry::Directory;
+      break;
+    case '1': case '2':
+      entry.type = Entry::Link;
+      break;
+    default:
+      entry.type = Entry::Other;
+      break;
+    }
+
+    if (paxSize >= 0) {
+      size = paxSize;
+    }
+    if (entry.type == Entry::Directory || entry.type == Entry::Link) {
+      size = 0;
+    }
+    entry.size = size;
+    entry.offset = m_position;
+    m_remaining = size;
+    m_padding = (BLOCK_SIZE - size % BLOCK_SIZE) % BLOCK_SIZE;
+    return true;
+  }
+}
+
+qint64 TarReader::read(char* data, qint64 maxSize)
+{
+  qint64 n = m_source->read(data, qMin(maxSize, m_remaining));
+  if (n < 0 || (n == 0 && m_remaining > 0)) {
+    fail("unexpected end of archive");
+    return -1;
+  }
+  m_remaining -= n;
+  m_position += n;
+  return n;
+}
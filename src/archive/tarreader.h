@@ -0,0 +1,83 @@
+/**
+ * @file   tarreader.h
+ * @author Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ *
+ * Copyright (C) 2012 - 2014 Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ * All Rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __TARREADER_H__
+#define __TARREADER_H__
+
+#include <QIODevice>
+#include <QString>
+
+/**
+ * Streaming reader for ustar/GNU/pax tar archives.  Entries are visited in
+ * archive order; the data of the current entry is read with read() and any
+ * unread remainder is skipped by the next call to next().
+ */
+class TarReader {
+public:
+  struct Entry {
+    enum Type {
+      File,
+      Directory,
+      Link,
+      Other
+    };
+
+    QString name;
+    QString linkName;
+    Type type;
+    qint64 size;
+    /* Offset of the entry data in the uncompressed tar stream */
+    qint64 offset;
+  };
+
+  TarReader(QIODevice* source);
+
+  /* Advance to the next entry; false at the end of the archive or on error */
+  bool next(Entry& entry);
+
+  /* Read data of the current entry */
+  qint64 read(char* data, qint64 maxSize);
+
+  bool hasError(void) const { return !m_errorString.isEmpty(); }
+  QString errorString(void) const { return m_errorString; }
+
+  enum {
+    BLOCK_SIZE = 512
+  };
+
+private:
+  bool readBlock(char* block);
+  bool skip(qint64 size);
+  bool readString(qint64 size, QByteArray& out);
+  void parsePax(const QByteArray& data, QString& name, QString& linkName,
+      qint64& size);
+  bool fail(const QString& message);
+
+private:
+  QIODevice* m_source;
+  qint64 m_position;
+  qint64 m_remaining;
+  qint64 m_padding;
+  QString m_errorString;
+};
+
+#endif /* __TARREADER_H__ */
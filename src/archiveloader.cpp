@@ -23,17 +23,33 @@
 #include "archiveloader.h"
 
 #include <QtCore>
-#include <QFileInfo>
+#include "jobindex.h"
 #include "logger.h"
-#include "parser.h"
+#include "tararchive.h"
 
-ArchiveLoader::ArchiveLoader(QString filename): m_fileName(filename)
+ArchiveLoader::ArchiveLoader(QString filename):
+  m_archive(NULL), m_index(NULL), m_fileName(filename)
 {
   m_dir = QDir(filename);
+
+  if (TarArchive::isArchive(filename)) {
+    LOG_STEP(QString("Mounting archive: %1").arg(filename));
+    m_archive = new TarArchive(filename);
+    if (m_archive->open()) {
+      TarArchive::mount(m_archive);
+    } else {
+      LOG_ERROR(QString("Cannot mount `%1': %2").arg(filename,
+            m_archive->errorString()));
+      delete m_archive;
+      m_archive = NULL;
+    }
+  }
 }
 
 ArchiveLoader::~ArchiveLoader()
 {
+  delete m_index;
+  delete m_archive;
 }
 
 QString ArchiveLoader::absPath(QString path)
@@ -43,135 +59,60 @@ QString ArchiveLoader::absPath(QString path)
 
 QStringList ArchiveLoader::listDir(QString filename)
 {
+  if (m_archive) {
+    return m_archive->entryList(filename);
+  }
+
   QDir dir(m_dir.absoluteFilePath(filename));
   return dir.entryList(QDir::NoDotAndDotDot | QDir::AllDirs | QDir::Files);
 }
 
-QString ArchiveLoader::featuresPath(QString base)
+QString ArchiveLoader::dataPath(QString path)
 {
-  QString plain_path = absPath(base.toLower() + "/features");
-  LOG_INFO(QString("ArchiveLoader::featuresPath() - Base: %1, Plain path: %2").arg(base, plain_path));
-
-  // Ensure feature is not a gzipped file. If so, unzip it.
-  QString path = plain_path;
-  QFile file(path);
-
-  if (!file.exists()) { // try .[zZ]
-    LOG_INFO(QString("Features file not found at: %1, trying compressed versions").arg(path));
-    
-    file.setFileName(path + ".Z");
-    if (file.exists()) {
-      path += ".Z";
-      LOG_INFO(QString("Found compressed file: %1").arg(path));
-    } else {
-      file.setFileName(path + ".z");
-      if (!file.exists()) {
-        LOG_ERROR(QString("No features file found: %1, %2.Z, %2.z").arg(plain_path, plain_path));
-        return QString();
-      }
-      path += ".z";
-      LOG_INFO(QString("Found compressed file: %1").arg(path));
+  // Any ODB++ file may be stored compressed; the parsers decode .Z/.z
+  // transparently, so just pick whichever variant exists
+  if (!exists(path)) {
+    if (exists(path + ".Z")) {
+      return absPath(path + ".Z");
     }
-
-    LOG_STEP(QString("Decompressing features file: %1").arg(path));
-    int ret = executeGzipDecompression(path);
-    LOG_INFO(QString("Decompression result: %1").arg(ret));
-
-    if (ret != 0) {
-      LOG_ERROR(QString("Decompression failed with code: %1").arg(ret));
-      return QString();
+    if (exists(path + ".z")) {
+      return absPath(path + ".z");
     }
-    LOG_INFO("Decompression completed successfully");
-  } else {
-    LOG_INFO(QString("Features file already exists: %1").arg(path));
   }
+  return absPath(path);
+}
 
-  // Check final file
-  QFileInfo finalFileInfo(plain_path);
-  if (finalFileInfo.exists()) {
-    LOG_INFO(QString("Final features file - Size: %1 bytes, Readable: %2")
-            .arg(finalFileInfo.size())
-            .arg(finalFileInfo.isReadable() ? "Yes" : "No"));
-  } else {
-    LOG_ERROR(QString("Final features file does not exist: %1").arg(plain_path));
+bool ArchiveLoader::exists(QString path)
+{
+  if (m_archive) {
+    return m_archive->exists(path);
   }
-
-  return plain_path;
+  return QFile::exists(absPath(path));
 }
 
-int ArchiveLoader::executeGzipDecompression(QString filePath)
+qint64 ArchiveLoader::fileSize(QString path)
 {
-  LOG_INFO(QString("Attempting decompression of: %1").arg(filePath));
-  
-  // Debug: Check which platform we're on
-#ifdef Q_WS_WIN
-  LOG_INFO("Platform detected: Windows (Q_WS_WIN defined)");
-#elif defined(Q_OS_WIN)
-  LOG_INFO("Platform detected: Windows (Q_OS_WIN defined)");
-#else
-  LOG_INFO("Platform detected: Unix/Linux");
-#endif
-  
-#if defined(Q_WS_WIN) || defined(Q_OS_WIN)
-  // Primary method: Use 7-zip on Windows
-  LOG_INFO("Using 7-zip for decompression (Windows)");
-  QStringList sevenZipArgs;
-  sevenZipArgs << "x" << filePath << "-y" << QString("-o%1").arg(QFileInfo(filePath).absolutePath());
-  
-  int ret = QProcess::execute("7z", sevenZipArgs);
-  if (ret == 0) {
-    LOG_INFO("7-zip decompression successful");
-    // Remove the compressed file after successful extraction
-    if (QFile::remove(filePath)) {
-      LOG_INFO("Compressed file removed successfully");
-    } else {
-      LOG_WARNING("Failed to remove compressed file");
-    }
-    return 0;
+  if (m_archive) {
+    return m_archive->size(path);
   }
-  LOG_WARNING(QString("7-zip failed with code: %1").arg(ret));
-  
-  // Fallback 1: Try native gzip if available
-  QString gzipPath = QCoreApplication::applicationDirPath() + "/gzip.exe";
-  if (QFile::exists(gzipPath)) {
-    LOG_INFO("Trying local gzip as fallback");
-    QStringList gzipArgs;
-    gzipArgs << "-d" << filePath;
-    
-    ret = QProcess::execute(gzipPath, gzipArgs);
-    if (ret == 0) {
-      LOG_INFO("Local gzip decompression successful");
-      return 0;
-    }
-    LOG_WARNING(QString("Local gzip failed with code: %1").arg(ret));
-  }
-  
-  // Fallback 2: Try system gzip
-  LOG_INFO("Trying system gzip as fallback");
-  QStringList gzipArgs;
-  gzipArgs << "-d" << filePath;
-  
-  ret = QProcess::execute("gzip", gzipArgs);
-  if (ret == 0) {
-    LOG_INFO("System gzip decompression successful");
-    return 0;
-  }
-  LOG_WARNING(QString("System gzip failed with code: %1").arg(ret));
-  
-#else
-  // On Linux/Unix, use standard gzip
-  LOG_INFO("Using system gzip (Unix/Linux)");
-  QStringList gzipArgs;
-  gzipArgs << "-d" << filePath;
-  
-  int ret = QProcess::execute("gzip", gzipArgs);
-  if (ret == 0) {
-    LOG_INFO("Gzip decompression successful");
-    return 0;
+  QFileInfo info(absPath(path));
+  return info.exists()? info.size(): -1;
+}
+
+JobIndex* ArchiveLoader::index(void)
+{
+  if (!m_index) {
+    m_index = JobIndex::open(m_fileName, this);
   }
-  LOG_WARNING(QString("Gzip failed with code: %1").arg(ret));
-#endif
+  return m_index;
+}
 
-  LOG_ERROR("All decompression methods failed");
-  return -1;
+QString ArchiveLoader::featuresPath(QString base)
+{
+  QString name = base.toLower() + "/features";
+  if (!exists(name) && !exists(name + ".Z") && !exists(name + ".z")) {
+    LOG_ERROR(QString("No features file found: %1").arg(absPath(name)));
+    return QString();
+  }
+  return dataPath(name);
 }
@@ -27,25 +27,35 @@
 #include <QString>
 #include <QStringList>
 
-#if defined(Q_WS_WIN) || defined(Q_OS_WIN)
-# define GZIP_CMD "7z"  // Use 7-zip as primary tool on Windows
-#else
-# define GZIP_CMD "gzip"
-#endif
+class JobIndex;
+class TarArchive;
 
+/**
+ * Access to the files of one job.  The job is either an extracted directory
+ * or a .tgz/.tar archive, which is mounted in place and read on demand.
+ */
 class ArchiveLoader {
 public:
   ArchiveLoader(QString filename);
   ~ArchiveLoader();
 
+  QString fileName(void) const { return m_fileName; }
+  bool isArchive(void) const { return m_archive != NULL; }
+
   QString absPath(QString path);
+  QString dataPath(QString path);
   QStringList listDir(QString filename);
   QString featuresPath(QString base);
+  bool exists(QString path);
+  qint64 fileSize(QString path);
+
+  /* Job index, loaded or built on first use; NULL if the job is broken */
+  JobIndex* index(void);
 
 private:
-  int executeGzipDecompression(QString filePath);
-  
   QDir m_dir;
+  TarArchive* m_archive;
+  JobIndex* m_index;
   QString m_fileName;
 };
 
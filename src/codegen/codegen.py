@@ -21,6 +21,8 @@
 # Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
 #
 
+from __future__ import print_function
+
 import re
 import sys
 import os.path
@@ -28,6 +30,354 @@ import os.path
 from xml.etree import ElementTree
 from optparse import OptionParser, make_option
 
+PREFIX_CHARS = 'abcdefghijklmnopqrstuvwxyz_+'
+
+def char_literal(c):
+    if c in '\\\'':
+        return "'\\%s'" % c
+    return "'%s'" % c
+
+def wrap(indent, head, terms, sep, tail):
+    """Join terms into head ... tail, breaking lines after sep at 80
+    columns."""
+    lines = []
+    line = ' ' * indent + head
+    for k, term in enumerate(terms):
+        piece = term + (sep.rstrip() if k + 1 < len(terms) else tail)
+        if len(line) + len(piece) > 80 and line.strip() != head.strip():
+            lines.append(line.rstrip())
+            line = ' ' * (indent + 4)
+        line += piece
+        if k + 1 < len(terms):
+            line += ' '
+    lines.append(line)
+    return lines
+
+class PatternCompiler(object):
+    """Compile a symbol pattern into an allocation-free C++ matcher.
+
+    Only the regular expression subset used by the symbol specs is
+    supported: literals, character classes with an optional '+', capturing
+    groups and optional '(?:...)?' groups.  The generated code matches
+    greedily without backtracking, so patterns where that would make a
+    difference are rejected.
+    """
+
+    def __init__(self, pattern):
+        self.pattern = pattern
+        self.pos = 0
+        self.ncaps = 0
+        self.nvars = 0
+        self.nodes = self.parse_sequence()
+        if self.pos != len(pattern):
+            self.error('unbalanced ")"')
+        self.check(self.nodes, [])
+
+    def error(self, msg):
+        raise RuntimeError('pattern "%s": %s at %d' %
+                           (self.pattern, msg, self.pos))
+
+    def peek(self):
+        if self.pos < len(self.pattern):
+            return self.pattern[self.pos]
+        return None
+
+    def parse_sequence(self):
+        nodes = []
+        while self.peek() not in (None, ')'):
+            node = self.parse_item()
+            if node['type'] == 'literal' and nodes and \
+                    nodes[-1]['type'] == 'literal':
+                nodes[-1]['chars'] += node['chars']
+            else:
+                nodes.append(node)
+        return nodes
+
+    def parse_item(self):
+        c = self.peek()
+        if c == '(':
+            self.pos += 1
+            capture = None
+            if self.pattern.startswith('?:', self.pos):
+                self.pos += 2
+            else:
+                self.ncaps += 1
+                capture = self.ncaps
+            nodes = self.parse_sequence()
+            if self.peek() != ')':
+                self.error('missing ")"')
+            self.pos += 1
+            node = {'type': 'group', 'capture': capture, 'nodes': nodes,
+                    'optional': False}
+        elif c == '[':
+            end = self.pattern.find(']', self.pos)
+            if end < 0:
+                self.error('missing "]"')
+            body = self.pattern[self.pos + 1:end]
+            self.pos = end + 1
+            node = {'type': 'class', 'ranges': self.parse_class(body),
+                    'repeat': False}
+        elif c in '\\.*+?{}|^$':
+            self.error('unsupported "%s"' % c)
+        else:
+            self.pos += 1
+            node = {'type': 'literal', 'chars': c}
+
+        if self.peek() == '+':
+            if node['type'] != 'class':
+                self.error('"+" only supported after a character class')
+            self.pos += 1
+            node['repeat'] = True
+        elif self.peek() == '?':
+            if node['type'] != 'group':
+                self.error('"?" only supported after a group')
+            self.pos += 1
+            node['optional'] = True
+        return node
+
+    def parse_class(self, body):
+        if not body or body[0] == '^':
+            self.error('unsupported character class')
+        ranges = []
+        k = 0
+        while k < len(body):
+            if k + 2 < len(body) and body[k + 1] == '-':
+                ranges.append((body[k], body[k + 2]))
+                k += 3
+            else:
+                ranges.append((body[k], body[k]))
+                k += 1
+        return ranges
+
+    @staticmethod
+    def first(nodes, follow):
+        """Ranges of characters that can start a match of nodes."""
+        result = []
+        for node in nodes:
+            if node['type'] == 'literal':
+                return result + [(node['chars'][0], node['chars'][0])]
+            if node['type'] == 'class':
+                return result + node['ranges']
+            result += PatternCompiler.first(node['nodes'], [])
+            if not node['optional']:
+                return result
+        return result + follow
+
+    @staticmethod
+    def overlaps(a, b):
+        return any(lo1 <= hi2 and lo2 <= hi1
+                   for lo1, hi1 in a for lo2, hi2 in b)
+
+    def check(self, nodes, follow):
+        for k, node in enumerate(nodes):
+            rest = self.first(nodes[k + 1:], follow)
+            if node['type'] == 'class' and node['repeat']:
+                if self.overlaps(node['ranges'], rest):
+                    self.error('repeated class needs backtracking')
+            elif node['type'] == 'group':
+                if node['optional'] and \
+                        self.overlaps(self.first(node['nodes'], []), rest):
+                    self.error('optional group needs backtracking')
+                self.check(node['nodes'], rest)
+
+    def prefix(self):
+        """Literal name prefix the symbol factory dispatches on."""
+        if not self.nodes or self.nodes[0]['type'] != 'literal':
+            self.error('pattern must start with a literal name')
+        chars = self.nodes[0]['chars']
+        name = ''
+        while len(name) < len(chars) and chars[len(name)] in PREFIX_CHARS:
+            name += chars[len(name)]
+        if not name:
+            self.error('pattern must start with a literal name')
+        rest = [(c, c) for c in chars[len(name):len(name) + 1]] or \
+            self.first(self.nodes[1:], [])
+        if self.overlaps(rest, [(c, c) for c in PREFIX_CHARS]):
+            self.error('name prefix is ambiguous')
+        return name
+
+    def var(self, stem):
+        self.nvars += 1
+        return '%s%d' % (stem, self.nvars)
+
+    def captures(self, nodes):
+        result = []
+        for node in nodes:
+            if node['type'] == 'group':
+                if node['capture']:
+                    result.append(node['capture'])
+                result += self.captures(node['nodes'])
+        return result
+
+    def condition(self, ranges, c):
+        terms = []
+        for lo, hi in ranges:
+            if lo == hi:
+                terms.append('%s == %s' % (c, char_literal(lo)))
+            elif len(ranges) == 1:
+                terms.append('%s >= %s && %s <= %s' %
+                             (c, char_literal(lo), c, char_literal(hi)))
+            else:
+                terms.append('(%s >= %s && %s <= %s)' %
+                             (c, char_literal(lo), c, char_literal(hi)))
+        return terms
+
+    def emit_check(self, indent, terms, fail):
+        self.lines += wrap(indent, 'if (', terms, ' ||', ') {')
+        self.lines += [' ' * (indent + 2) + f for f in fail]
+        self.lines.append(' ' * indent + '}')
+
+    def gen_literal(self, indent, chars, fail):
+        if len(chars) == 1:
+            terms = ['i >= n', 's[i] != %s' % char_literal(chars)]
+        else:
+            terms = ['n - i < %d' % len(chars)]
+            terms += ['s[i + %d] != %s' % (k, char_literal(c)) if k else
+                      's[i] != %s' % char_literal(c)
+                      for k, c in enumerate(chars)]
+        self.emit_check(indent, terms, fail)
+        if len(chars) == 1:
+            self.lines.append(' ' * indent + '++i;')
+        else:
+            self.lines.append(' ' * indent + 'i += %d;' % len(chars))
+
+    def gen_class(self, indent, node, fail, start=None):
+        cond = self.condition(node['ranges'], 's[i]')
+        if not node['repeat']:
+            self.emit_check(indent, ['i >= n', '!(%s)' % ' || '.join(cond)],
+                            fail)
+            self.lines.append(' ' * indent + '++i;')
+            return
+        if start is None:
+            start = self.var('t')
+            self.lines.append(' ' * indent + 'const int %s = i;' % start)
+        if len(cond) > 1:
+            cond = ['(' + ' || '.join(cond) + ')']
+        self.lines += wrap(indent, 'while (', ['i < n'] + cond, ' &&',
+                           ') {')
+        self.lines.append(' ' * (indent + 2) + '++i;')
+        self.lines.append(' ' * indent + '}')
+        self.emit_check(indent, ['i == %s' % start], fail)
+
+    def gen_group(self, indent, node, fail):
+        inner = indent
+        if node['optional']:
+            mark = self.var('m')
+            self.lines.append(' ' * indent + 'do {')
+            inner = indent + 2
+            self.lines.append(' ' * inner + 'const int %s = i;' % mark)
+            fail = ['i = %s;' % mark]
+            fail += ['caps[%d] = SymbolParam();' % k
+                     for k in self.captures([node])]
+            fail += ['break;']
+
+        capture = node['capture']
+        if capture:
+            start = 'c%d' % capture
+            self.lines.append(' ' * inner + 'const int %s = i;' % start)
+            nodes = node['nodes']
+            if len(nodes) == 1 and nodes[0]['type'] == 'class' and \
+                    nodes[0]['repeat']:
+                self.gen_class(inner, nodes[0], fail, start)
+            else:
+                self.gen_sequence(inner, nodes, fail)
+            self.lines.append(' ' * inner +
+                              'caps[%d] = SymbolParam(s + %s, i - %s);' %
+                              (capture, start, start))
+        else:
+            self.gen_sequence(inner, node['nodes'], fail)
+
+        if node['optional']:
+            self.lines.append(' ' * indent + '} while (0);')
+
+    def gen_sequence(self, indent, nodes, fail):
+        for node in nodes:
+            if node['type'] == 'literal':
+                self.gen_literal(indent, node['chars'], fail)
+            elif node['type'] == 'class':
+                self.gen_class(indent, node, fail)
+            else:
+                self.gen_group(indent, node, fail)
+
+    def generate(self):
+        """Body of a function matching the whole of def and filling
+        caps[0..ncaps]."""
+        self.nvars = 0
+        self.lines = ['  const ushort* s = def.utf16();',
+                      '  const int n = def.length();',
+                      '  int i = 0;',
+                      '']
+        self.gen_sequence(2, self.nodes, ['return false;'])
+        self.lines += ['',
+                       '  caps[0] = SymbolParam(s, n);',
+                       '  return i == n;']
+        return '\n'.join(self.lines)
+
+class FactoryCompiler(object):
+    """Generate the trie dispatching a definition to its symbol class by
+    name prefix."""
+
+    def __init__(self):
+        self.trie = {}
+
+    def add(self, prefix, classname):
+        node = self.trie
+        for c in prefix:
+            node = node.setdefault(c, {})
+        if '' in node:
+            raise RuntimeError('prefix "%s" used by %s and %s' %
+                               (prefix, node[''], classname))
+        node[''] = classname
+
+    def gen_return(self, indent, classname):
+        pad = ' ' * indent
+        line = pad + '  return new %s(def, polarity, attrib);' % classname
+        if len(line) <= 80:
+            self.lines.append(line)
+        else:
+            self.lines += [pad + '  return new %s(def,' % classname,
+                           pad + '      polarity, attrib);']
+
+    def gen_node(self, indent, node, depth):
+        pad = ' ' * indent
+        if '' in node:
+            self.lines.append(pad + 'if (n == %d) {' % depth)
+            self.gen_return(indent, node[''])
+            self.lines.append(pad + '}')
+        children = sorted(c for c in node if c)
+        if len(children) == 1:
+            # Collapse a chain of single children into one comparison
+            chars = ''
+            while True:
+                c = [k for k in node if k][0]
+                chars += c
+                node = node[c]
+                if '' in node or len(node) != 1:
+                    break
+            terms = ['s[%d] == %s' % (depth + k, char_literal(c))
+                     for k, c in enumerate(chars)]
+            depth += len(chars)
+            if list(node) == ['']:
+                terms.append('n == %d' % depth)
+                self.lines += wrap(indent, 'if (', terms, ' &&', ') {')
+                self.gen_return(indent, node[''])
+            else:
+                self.lines += wrap(indent, 'if (', terms, ' &&', ') {')
+                self.gen_node(indent + 2, node, depth)
+            self.lines.append(pad + '}')
+        elif children:
+            self.lines.append(pad + 'switch (s[%d]) {' % depth)
+            for c in children:
+                self.lines.append(pad + 'case %s:' % char_literal(c))
+                self.gen_node(indent + 2, node[c], depth + 1)
+                self.lines.append(pad + '  break;')
+            self.lines.append(pad + '}')
+
+    def generate(self, indent):
+        self.lines = []
+        self.gen_node(indent, self.trie, 0)
+        return '\n'.join(self.lines)
+
 class TemplateEngine(object):
     def __init__(self, template_file, target_dir=None):
         with open(template_file, 'r') as f:
@@ -63,14 +413,37 @@ class TemplateEngine(object):
 
     def render(self, dataxml):
         tree = ElementTree.parse(dataxml)
-        self.root = tree.getroot()
+        root = tree.getroot()
+
+        pattern = root.find('pattern')
+        if pattern is not None:
+            compiler = PatternCompiler(pattern.text.strip())
+            ElementTree.SubElement(root, 'parser').text = compiler.generate()
+            ElementTree.SubElement(root, 'captures').text = \
+                str(compiler.ncaps + 1)
+
+        self.render_root(root)
+
+    def render_factory(self, dataxmls):
+        factory = FactoryCompiler()
+        for dataxml in dataxmls:
+            root = ElementTree.parse(dataxml).getroot()
+            compiler = PatternCompiler(root.find('pattern').text.strip())
+            factory.add(compiler.prefix(), root.attrib['name'])
+
+        root = ElementTree.Element('factory', name='SymbolFactory')
+        ElementTree.SubElement(root, 'dispatcher').text = factory.generate(6)
+        self.render_root(root)
+
+    def render_root(self, root):
+        self.root = root
 
         filename = '%s.%s' % (self.root.find('.').attrib['name'].lower(),
                               self.outfile_suffix)
         if self.target_dir:
             filename = os.path.join(self.target_dir, filename)
 
-        print 'GEN %s'  % filename
+        print('GEN %s' % filename)
 
         result = re.sub(r'{{([^{}]+?)}}\n?', self.interpolate, self.template,
                         flags=re.S).strip() + '\n'
@@ -89,6 +462,9 @@ def main():
         make_option('-t', '--template', action='store', type='string',
                     dest='template', default=None,
                     help='name of template'),
+        make_option('-f', '--factory', action='store_true', dest='factory',
+                    default=False,
+                    help='render one symbol factory from all xml files'),
     ]
     parser = OptionParser(usage='Usage: %s [OPTION...] xml1 xml2 ...' %sys.argv,
                           option_list=option_list)
@@ -100,11 +476,14 @@ def main():
 
     e = TemplateEngine(options.template, options.target_dir)
 
-    for xml in args:
-        e.render(xml)
+    if options.factory:
+        e.render_factory(args)
+    else:
+        for xml in args:
+            e.render(xml)
 
 if __name__ == '__main__':
     try:
         main()
     except Exception as e:
-        print 'error:', str(e)
+        print('error:', str(e))
@@ -0,0 +1,230 @@
+/**
+ * @file   arcgeometry.cpp
+ * @author Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ *
+ * Copyright (C) 2012 - 2014 Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ * All Rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "arcgeometry.h"
+
+#include <QtCore/qmath.h>
+
+#include <cmath>
+
+/* Size of the unit circle table, the finest grid there is */
+#define MAX_CIRCLE_STEPS 8192
+
+/* Slack in grid steps when deciding whether an end point is on the grid */
+#define GRID_EPSILON 1e-6
+
+/* Chordal error allowed when painting, in device pixels */
+#define PIXEL_ERROR 0.25
+
+namespace ArcGeometry {
+
+static qreal currentTolerance = 1e-4;
+static thread_local int drawBand = -1;
+
+struct UnitCircle {
+  UnitCircle()
+  {
+    for (int i = 0; i < MAX_CIRCLE_STEPS; ++i) {
+      qreal a = 2 * M_PI * i / MAX_CIRCLE_STEPS;
+      x[i] = qCos(a);
+      y[i] = qSin(a);
+    }
+  }
+
+  qreal x[MAX_CIRCLE_STEPS];
+  qreal y[MAX_CIRCLE_STEPS];
+};
+
+static const UnitCircle& unitCircle(void)
+{
+  static const UnitCircle table;
+  return table;
+}
+
+void setTolerance(qreal tolerance)
+{
+  if (tolerance > 0) {
+    currentTolerance = tolerance;
+  }
+}
+
+qreal tolerance(void)
+{
+  return drawBand < 0? currentTolerance: bandTolerance(drawBand);
+}
+
+int pixelBand(qreal pixel)
+{
+  qreal band = -std::log2(pixel * PIXEL_ERROR);
+  if (!(band > MIN_BAND)) {
+    return MIN_BAND;
+  }
+  if (band >= MAX_BAND) {
+    return MAX_BAND;
+  }
+  return qCeil(band);
+}
+
+qreal bandTolerance(int band)
+{
+  return std::ldexp(1.0, -band);
+}
+
+int currentBand(void)
+{
+  return drawBand;
+}
+
+DrawTolerance::DrawTolerance(qreal pixel): m_saved(drawBand)
+{
+  drawBand = pixelBand(pixel);
+}
+
+DrawTolerance::~DrawTolerance()
+{
+  drawBand = m_saved;
+}
+
+int circleSteps(qreal r, qreal tolerance)
+{
+  if (r <= tolerance) {
+    return 4;
+  }
+  qreal needed = M_PI / qAcos(1 - tolerance / r);
+  int n = 4;
+  while (n < needed && n < MAX_CIRCLE_STEPS) {
+    n <<= 1;
+  }
+  return n;
+}
+
+void appendArc(QPolygonF& ring, const QPointF& c, qreal r, qreal start,
+    qreal sweep, qreal tolerance)
+{
+  const UnitCircle& unit = unitCircle();
+  const int n = circleSteps(r, tolerance);
+  const int stride = MAX_CIRCLE_STEPS / n;
+  const qreal step = 2 * M_PI / n;
+  const qreal end = start + sweep;
+
+  // Grid points strictly inside the sweep, walked in its direction
+  qint64 first, last, dir;
+  if (sweep >= 0) {
+    first = qFloor(start / step + GRID_EPSILON) + 1;
+    last = qCeil(end / step - GRID_EPSILON) - 1;
+    dir = 1;
+  } else {
+    first = qCeil(start / step - GRID_EPSILON) - 1;
+    last = qFloor(end / step + GRID_EPSILON) + 1;
+    dir = -1;
+  }
+  qint64 count = qMax((last - first) * dir + 1, (qint64)0);
+
+  int base = ring.size();
+  ring.resize(base + count + 2);
+  QPointF* out = ring.data() + base;
+
+  out[0] = QPointF(c.x() + r * qCos(start), c.y() + r * qSin(start));
+  for (qint64 i = 0; i < count; ++i) {
+    int k = int((first + i * dir) & (n - 1)) * stride;
+    out[i + 1] = QPointF(c.x() + r * unit.x[k], c.y() + r * unit.y[k]);
+  }
+  out[count + 1] = QPointF(c.x() + r * qCos(end), c.y() + r * qSin(end));
+}
+
+QPolygonF circle(const QPointF& c, qreal r, qreal tolerance)
+{
+  QPolygonF ring;
+  appendArc(ring, c, r, 0, 2 * M_PI, tolerance);
+  ring.removeLast();
+  return ring;
+}
+
+/* Start angle and signed sweep of a features file arc, in ODB++ space */
+static void sweepOf(qreal sx, qreal sy, qreal ex, qreal ey, qreal cx,
+    qreal cy, bool cw, qreal& start, qreal& sweep)
+{
+  qreal sa = qAtan2(sy - cy, sx - cx);
+  qreal ea = qAtan2(ey - cy, ex - cx);
+
+  // A full turn when the ends meet
+  if (cw) {
+    if (sa <= ea) {
+      sa += 2 * M_PI;
+    }
+  } else {
+    if (ea <= sa) {
+      ea += 2 * M_PI;
+    }
+  }
+  start = sa;
+  sweep = ea - sa;
+}
+
+void appendRecordArc(QPolygonF& ring, qreal sx, qreal sy, qreal ex,
+    qreal ey, qreal cx, qreal cy, bool cw, qreal tolerance)
+{
+  qreal start, sweep;
+  sweepOf(sx, sy, ex, ey, cx, cy, cw, start, sweep);
+  qreal r = qSqrt((sx - cx) * (sx - cx) + (sy - cy) * (sy - cy));
+
+  // Negating y mirrors the angles as well
+  int base = ring.size();
+  appendArc(ring, QPointF(cx, -cy), r, -start, -sweep, tolerance);
+  ring[base] = QPointF(sx, -sy);
+  ring.last() = QPointF(ex, -ey);
+}
+
+QRectF bounds(qreal sx, qreal sy, qreal ex, qreal ey, qreal cx, qreal cy,
+    bool cw)
+{
+  qreal start, sweep;
+  sweepOf(sx, sy, ex, ey, cx, cy, cw, start, sweep);
+
+  // Drawing follows the radius at the start, the end snaps to the end
+  // point; the larger one covers both
+  qreal r = qMax(qSqrt((sx - cx) * (sx - cx) + (sy - cy) * (sy - cy)),
+      qSqrt((ex - cx) * (ex - cx) + (ey - cy) * (ey - cy)));
+
+  qreal left = qMin(sx, ex), right = qMax(sx, ex);
+  qreal bottom = qMin(sy, ey), top = qMax(sy, ey);
+
+  static const qreal axisX[] = { 1, 0, -1, 0 };
+  static const qreal axisY[] = { 0, 1, 0, -1 };
+  for (int k = 0; k < 4; ++k) {
+    qreal offset = (sweep < 0)? start - k * M_PI / 2: k * M_PI / 2 - start;
+    offset = fmod(offset, 2 * M_PI);
+    if (offset < 0) {
+      offset += 2 * M_PI;
+    }
+    if (offset < qAbs(sweep)) {
+      left = qMin(left, cx + r * axisX[k]);
+      right = qMax(right, cx + r * axisX[k]);
+      bottom = qMin(bottom, cy + r * axisY[k]);
+      top = qMax(top, cy + r * axisY[k]);
+    }
+  }
+
+  return QRectF(left, bottom, right - left, top - bottom);
+}
+
+} /* namespace ArcGeometry */
@@ -0,0 +1,116 @@
+/**
+ * @file   arcgeometry.h
+ * @author Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ *
+ * Copyright (C) 2012 - 2014 Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ * All Rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __ARCGEOMETRY_H__
+#define __ARCGEOMETRY_H__
+
+#include <QPolygonF>
+#include <QRectF>
+
+/**
+ * Circular arcs: exact bounds, and the one place curves are flattened.
+ *
+ * Every arc is replaced by chords on a fixed angular grid of n steps per
+ * full turn, where n is the smallest power of two keeping the chords within
+ * tolerance of the circle.  The grid points come from a single precomputed
+ * unit circle table, so no trigonometry is done per vertex, and the grid of
+ * a coarser zoom band is a subset of every finer one.  Rendering, areas,
+ * polygon booleans and clearances all flatten through here at tolerance(),
+ * so they see the very same polylines.
+ *
+ * Painting is the exception: it only needs curves as fine as the device
+ * pixels they land on, so a DrawTolerance switches tolerance() to a power
+ * of two band picked from the pixel size, on screen and in exports alike.
+ */
+namespace ArcGeometry {
+
+/* Largest chordal error allowed, in layer units; 1e-4 unless set */
+void setTolerance(qreal tolerance);
+qreal tolerance(void);
+
+/* Band b flattens to 2^-b layer units */
+enum {
+  MIN_BAND = 4,
+  MAX_BAND = 24
+};
+
+/* Coarsest band keeping the chords within a quarter of pixel */
+int pixelBand(qreal pixel);
+qreal bandTolerance(int band);
+
+/* Band tolerance() follows on this thread, -1 outside a DrawTolerance */
+int currentBand(void);
+
+/**
+ * Flatten for painting at pixel layer units per device pixel: for its
+ * lifetime, tolerance() on this thread is that of pixelBand(pixel).
+ */
+class DrawTolerance {
+public:
+  DrawTolerance(qreal pixel);
+  ~DrawTolerance();
+
+private:
+  int m_saved;
+};
+
+/* Grid steps per full turn for a circle of radius r, a power of two */
+int circleSteps(qreal r, qreal tolerance);
+
+/**
+ * Append the points of the arc around c of radius r from angle start over
+ * sweep (radians, negative for clockwise), both end points included.  The
+ * points in between sit on the circleSteps() grid.
+ */
+void appendArc(QPolygonF& ring, const QPointF& c, qreal r, qreal start,
+    qreal sweep, qreal tolerance);
+
+/* Closed ring approximating a full circle, without a repeated end point */
+QPolygonF circle(const QPointF& c, qreal r, qreal tolerance);
+
+/**
+ * Append a features file arc from (sx, sy) to (ex, ey) around (cx, cy),
+ * given in ODB++ coordinates with y pointing up, in scene coordinates
+ * (x, -y) as painter paths use them.  The end points are reproduced
+ * exactly; equal end points make a full circle.
+ */
+void appendRecordArc(QPolygonF& ring, qreal sx, qreal sy, qreal ex,
+    qreal ey, qreal cx, qreal cy, bool cw, qreal tolerance);
+
+/**
+ * Bounding box of the arc from (sx, sy) to (ex, ey) around (cx, cy), in
+ * ODB++ coordinates with y pointing up.  Equal start and end points make a
+ * full circle.  The box holds the end points and every axis crossing the
+ * arc sweeps over, so it is exact and no curve is ever approximated.
+ */
+QRectF bounds(qreal sx, qreal sy, qreal ex, qreal ey, qreal cx, qreal cy,
+    bool cw);
+
+/* r mirrored on the x axis, from ODB++ to scene coordinates */
+inline QRectF flipped(const QRectF& r)
+{
+  return QRectF(r.x(), -r.y() - r.height(), r.width(), r.height());
+}
+
+} /* namespace ArcGeometry */
+
+#endif /* __ARCGEOMETRY_H__ */
@@ -0,0 +1,629 @@
+/**
+ * @file   featureshape.cpp
+ * @author Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ *
+ * Copyright (C) 2012 - 2014 Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ * All Rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "featureshape.h"
+
+#include <QtCore/qmath.h>
+
+#include "arcgeometry.h"
+
+#define EPSILON 1e-12
+
+/* Skeleton of a thickened shape: a point, a segment or a CCW arc */
+struct Skeleton {
+  typedef enum { Point = 0, Segment, ArcCurve } Type;
+
+  Type type;
+  QPointF a, b, c;
+  qreal r, start, sweep;
+};
+
+static inline qreal dot(const QPointF& a, const QPointF& b)
+{
+  return a.x() * b.x() + a.y() * b.y();
+}
+
+static inline qreal cross(const QPointF& a, const QPointF& b)
+{
+  return a.x() * b.y() - a.y() * b.x();
+}
+
+static inline qreal length(const QPointF& v)
+{
+  return qSqrt(dot(v, v));
+}
+
+static inline qreal normalizeAngle(qreal a)
+{
+  a = fmod(a, 2 * M_PI);
+  return (a < 0)? a + 2 * M_PI: a;
+}
+
+static inline bool onArc(const Skeleton& s, qreal angle)
+{
+  return normalizeAngle(angle - s.start) <= s.sweep + 1e-9;
+}
+
+static inline QPointF arcPoint(const Skeleton& s, qreal angle)
+{
+  return s.c + QPointF(s.r * qCos(angle), s.r * qSin(angle));
+}
+
+static inline void keep(Proximity& best, const QPointF& pa, const QPointF& pb)
+{
+  qreal d = length(pb - pa);
+  if (!best.isValid() || d < best.distance) {
+    best = Proximity(d, pa, pb);
+  }
+}
+
+static Proximity pointPoint(const QPointF& p, const QPointF& q)
+{
+  return Proximity(length(q - p), p, q);
+}
+
+static QPointF closestOnSegment(const QPointF& p, const QPointF& a,
+    const QPointF& b)
+{
+  QPointF ab = b - a;
+  qreal len2 = dot(ab, ab);
+  if (len2 < EPSILON) {
+    return a;
+  }
+  qreal t = qBound(0.0, dot(p - a, ab) / len2, 1.0);
+  return a + ab * t;
+}
+
+static Proximity pointSegment(const QPointF& p, const QPointF& a,
+    const QPointF& b)
+{
+  return pointPoint(p, closestOnSegment(p, a, b));
+}
+
+static bool segmentIntersection(const QPointF& a, const QPointF& b,
+    const QPointF& c, const QPointF& d, QPointF* at)
+{
+  QPointF r = b - a, s = d - c;
+  qreal denom = cross(r, s);
+  if (qAbs(denom) < EPSILON) {
+    return false;
+  }
+  qreal t = cross(c - a, s) / denom;
+  qreal u = cross(c - a, r) / denom;
+  if (t < 0 || t > 1 || u < 0 || u > 1) {
+    return false;
+  }
+  *at = a + r * t;
+  return true;
+}
+
+static Proximity segmentSegment(const QPointF& a, const QPointF& b,
+    const QPointF& c, const QPointF& d)
+{
+  QPointF at;
+  if (segmentIntersection(a, b, c, d, &at)) {
+    return Proximity(0, at, at);
+  }
+
+  Proximity best = pointSegment(a, c, d);
+  Proximity p = pointSegment(b, c, d);
+  if (p.distance < best.distance) best = p;
+  p = pointSegment(c, a, b);
+  if (p.distance < best.distance) best = Proximity(p.distance, p.pb, p.pa);
+  p = pointSegment(d, a, b);
+  if (p.distance < best.distance) best = Proximity(p.distance, p.pb, p.pa);
+  return best;
+}
+
+static Proximity pointArc(const QPointF& p, const Skeleton& s)
+{
+  QPointF v = p - s.c;
+  Proximity best;
+  if (length(v) > EPSILON) {
+    qreal angle = qAtan2(v.y(), v.x());
+    if (onArc(s, angle)) {
+      keep(best, p, arcPoint(s, angle));
+    }
+  }
+  keep(best, p, s.a);
+  keep(best, p, s.b);
+  return best;
+}
+
+static Proximity segmentArc(const QPointF& a, const QPointF& b,
+    const Skeleton& s)
+{
+  Proximity best;
+
+  // Intersections of the segment with the circle that lie on the arc
+  QPointF d = b - a, f = a - s.c;
+  qreal qa = dot(d, d), qb = 2 * dot(f, d), qc = dot(f, f) - s.r * s.r;
+  qreal disc = qb * qb - 4 * qa * qc;
+  if (qa > EPSILON && disc >= 0) {
+    qreal root = qSqrt(disc);
+    qreal ts[2] = { (-qb - root) / (2 * qa), (-qb + root) / (2 * qa) };
+    for (int i = 0; i < 2; ++i) {
+      if (ts[i] >= 0 && ts[i] <= 1) {
+        QPointF at = a + d * ts[i];
+        if (onArc(s, qAtan2(at.y() - s.c.y(), at.x() - s.c.x()))) {
+          return Proximity(0, at, at);
+        }
+      }
+    }
+  }
+
+  // End points against the other primitive
+  Proximity p = pointArc(a, s);
+  keep(best, p.pa, p.pb);
+  p = pointArc(b, s);
+  keep(best, p.pa, p.pb);
+  p = pointSegment(s.a, a, b);
+  keep(best, p.pb, p.pa);
+  p = pointSegment(s.b, a, b);
+  keep(best, p.pb, p.pa);
+
+  // Interior extremes: arc points whose radius is normal to the segment
+  if (qa > EPSILON) {
+    qreal normal = qAtan2(d.x(), -d.y());
+    for (int i = 0; i < 2; ++i) {
+      qreal angle = normal + i * M_PI;
+      if (onArc(s, angle)) {
+        QPointF q = arcPoint(s, angle);
+        keep(best, closestOnSegment(q, a, b), q);
+      }
+    }
+  }
+
+  return best;
+}
+
+static Proximity arcArc(const Skeleton& s, const Skeleton& t)
+{
+  Proximity best;
+  QPointF cc = t.c - s.c;
+  qreal dc = length(cc);
+
+  // Circle intersections lying on both arcs
+  if (dc > EPSILON && dc <= s.r + t.r && dc >= qAbs(s.r - t.r)) {
+    qreal x = (dc * dc + s.r * s.r - t.r * t.r) / (2 * dc);
+    qreal h = qSqrt(qMax(0.0, s.r * s.r - x * x));
+    QPointF u = cc / dc, n(-u.y(), u.x());
+    QPointF base = s.c + u * x;
+    QPointF pts[2] = { base + n * h, base - n * h };
+    for (int i = 0; i < 2; ++i) {
+      QPointF v1 = pts[i] - s.c, v2 = pts[i] - t.c;
+      if (onArc(s, qAtan2(v1.y(), v1.x())) &&
+          onArc(t, qAtan2(v2.y(), v2.x()))) {
+        return Proximity(0, pts[i], pts[i]);
+      }
+    }
+  }
+
+  Proximity p = pointArc(s.a, t);
+  keep(best, p.pa, p.pb);
+  p = pointArc(s.b, t);
+  keep(best, p.pa, p.pb);
+  p = pointArc(t.a, s);
+  keep(best, p.pb, p.pa);
+  p = pointArc(t.b, s);
+  keep(best, p.pb, p.pa);
+
+  // Interior extremes lie on the line through both centers
+  if (dc > EPSILON) {
+    qreal base = qAtan2(cc.y(), cc.x());
+    for (int i = 0; i < 2; ++i) {
+      qreal as = base + i * M_PI;
+      if (!onArc(s, as)) {
+        continue;
+      }
+      for (int j = 0; j < 2; ++j) {
+        qreal at = base + j * M_PI;
+        if (onArc(t, at)) {
+          keep(best, arcPoint(s, as), arcPoint(t, at));
+        }
+      }
+    }
+  }
+
+  return best;
+}
+
+static Proximity skeletonDistance(const Skeleton& s, const Skeleton& t)
+{
+  Proximity p;
+
+  switch (s.type) {
+  case Skeleton::Point:
+    switch (t.type) {
+    case Skeleton::Point: return pointPoint(s.a, t.a);
+    case Skeleton::Segment: return pointSegment(s.a, t.a, t.b);
+    case Skeleton::ArcCurve: return pointArc(s.a, t);
+    }
+    break;
+  case Skeleton::Segment:
+    switch (t.type) {
+    case Skeleton::Point:
+      p = pointSegment(t.a, s.a, s.b);
+      return Proximity(p.distance, p.pb, p.pa);
+    case Skeleton::Segment: return segmentSegment(s.a, s.b, t.a, t.b);
+    case Skeleton::ArcCurve: return segmentArc(s.a, s.b, t);
+    }
+    break;
+  case Skeleton::ArcCurve:
+    switch (t.type) {
+    case Skeleton::Point:
+      p = pointArc(t.a, s);
+      return Proximity(p.distance, p.pb, p.pa);
+    case Skeleton::Segment:
+      p = segmentArc(t.a, t.b, s);
+      return Proximity(p.distance, p.pb, p.pa);
+    case Skeleton::ArcCurve: return arcArc(s, t);
+    }
+    break;
+  }
+  return p;
+}
+
+static Skeleton skeletonOf(const FeatureShape& shape)
+{
+  Skeleton s;
+  s.a = shape.p0;
+  s.b = shape.p1;
+  s.c = shape.center;
+  s.r = s.start = s.sweep = 0;
+
+  switch (shape.kind) {
+  case FeatureShape::Capsule:
+    s.type = Skeleton::Segment;
+    break;
+  case FeatureShape::Arc: {
+    s.type = Skeleton::ArcCurve;
+    s.r = length(shape.p0 - shape.center);
+    qreal a0 = qAtan2(shape.p0.y() - s.c.y(), shape.p0.x() - s.c.x());
+    qreal a1 = qAtan2(shape.p1.y() - s.c.y(), shape.p1.x() - s.c.x());
+    // Store every arc counter-clockwise
+    s.start = shape.cw? a1: a0;
+    s.sweep = normalizeAngle(shape.cw? a0 - a1: a1 - a0);
+    if (s.sweep < 1e-9) {
+      s.sweep = 2 * M_PI;
+    }
+    break;
+  }
+  default:
+    s.type = Skeleton::Point;
+    break;
+  }
+  return s;
+}
+
+static bool insideContour(const FeatureShape& shape, const QPointF& p)
+{
+  if (!shape.bounds.contains(p)) {
+    return false;
+  }
+
+  bool inside = false;
+  for (int r = 0; r < shape.rings.size(); ++r) {
+    const QPolygonF& ring = shape.rings[r];
+    int n = ring.size();
+    for (int i = 0, j = n - 1; i < n; j = i++) {
+      const QPointF& a = ring[i];
+      const QPointF& b = ring[j];
+      if ((a.y() > p.y()) != (b.y() > p.y()) &&
+          p.x() < (b.x() - a.x()) * (p.y() - a.y()) / (b.y() - a.y()) + a.x()) {
+        inside = !inside;
+      }
+    }
+  }
+  return inside;
+}
+
+template <typename EdgeFunc>
+static void forEachEdge(const FeatureShape& shape, EdgeFunc func)
+{
+  for (int r = 0; r < shape.rings.size(); ++r) {
+    const QPolygonF& ring = shape.rings[r];
+    int n = ring.size();
+    for (int i = 0, j = n - 1; i < n; j = i++) {
+      func(ring[j], ring[i]);
+    }
+  }
+}
+
+static Proximity skeletonContour(const Skeleton& s, const FeatureShape& c)
+{
+  if (insideContour(c, s.a)) {
+    return Proximity(0, s.a, s.a);
+  }
+
+  Proximity best;
+  forEachEdge(c, [&](const QPointF& a, const QPointF& b) {
+    if (best.isValid() && best.distance == 0) {
+      return;
+    }
+    Skeleton edge;
+    edge.type = Skeleton::Segment;
+    edge.a = a;
+    edge.b = b;
+    Proximity p = skeletonDistance(s, edge);
+    if (!best.isValid() || p.distance < best.distance) {
+      best = p;
+    }
+  });
+  return best;
+}
+
+static Proximity contourContour(const FeatureShape& c, const FeatureShape& d)
+{
+  for (int r = 0; r < c.rings.size(); ++r) {
+    if (!c.rings[r].isEmpty() && insideContour(d, c.rings[r].first())) {
+      return Proximity(0, c.rings[r].first(), c.rings[r].first());
+    }
+  }
+  for (int r = 0; r < d.rings.size(); ++r) {
+    if (!d.rings[r].isEmpty() && insideContour(c, d.rings[r].first())) {
+      return Proximity(0, d.rings[r].first(), d.rings[r].first());
+    }
+  }
+
+  Proximity best;
+  forEachEdge(c, [&](const QPointF& a, const QPointF& b) {
+    QRectF ab = QRectF(a, b).normalized();
+    forEachEdge(d, [&](const QPointF& e, const QPointF& f) {
+      if (best.isValid() && (best.distance == 0 || ShapeDistance::
+            boundsDistance(ab, QRectF(e, f).normalized()) >= best.distance)) {
+        return;
+      }
+      Proximity p = segmentSegment(a, b, e, f);
+      if (!best.isValid() || p.distance < best.distance) {
+        best = p;
+      }
+    });
+  });
+  return best;
+}
+
+/* Grow a skeleton distance by the radii of both shapes */
+static Proximity thicken(const Proximity& p, qreal ra, qreal rb)
+{
+  if (!p.isValid()) {
+    return p;
+  }
+
+  qreal gap = p.distance - ra - rb;
+  if (gap <= 0 || p.distance < EPSILON) {
+    QPointF at = (p.distance < EPSILON)? p.pa:
+      p.pa + (p.pb - p.pa) * qMin(1.0, ra / p.distance);
+    return Proximity(0, at, at);
+  }
+
+  QPointF u = (p.pb - p.pa) / p.distance;
+  return Proximity(gap, p.pa + u * ra, p.pb - u * rb);
+}
+
+static QRectF arcBounds(const FeatureShape& shape)
+{
+  Skeleton s = skeletonOf(shape);
+  qreal left = qMin(shape.p0.x(), shape.p1.x());
+  qreal right = qMax(shape.p0.x(), shape.p1.x());
+  qreal top = qMin(shape.p0.y(), shape.p1.y());
+  qreal bottom = qMax(shape.p0.y(), shape.p1.y());
+
+  for (int k = 0; k < 4; ++k) {
+    qreal angle = k * M_PI / 2;
+    if (onArc(s, angle)) {
+      QPointF p = arcPoint(s, angle);
+      left = qMin(left, p.x());
+      right = qMax(right, p.x());
+      top = qMin(top, p.y());
+      bottom = qMax(bottom, p.y());
+    }
+  }
+  return QRectF(left, top, right - left, bottom - top);
+}
+
+FeatureShape FeatureShape::disc(const QPointF& center, qreal radius)
+{
+  FeatureShape s;
+  s.kind = Disc;
+  s.p0 = s.p1 = s.center = center;
+  s.radius = radius;
+  s.bounds = QRectF(center.x() - radius, center.y() - radius,
+      2 * radius, 2 * radius);
+  return s;
+}
+
+FeatureShape FeatureShape::capsule(const QPointF& start, const QPointF& end,
+    qreal radius)
+{
+  FeatureShape s;
+  s.kind = Capsule;
+  s.p0 = start;
+  s.p1 = end;
+  s.radius = radius;
+  s.bounds = QRectF(start, end).normalized()
+    .adjusted(-radius, -radius, radius, radius);
+  return s;
+}
+
+FeatureShape FeatureShape::arc(const QPointF& start, const QPointF& end,
+    const QPointF& center, bool cw, qreal radius)
+{
+  FeatureShape s;
+  s.kind = Arc;
+  s.p0 = start;
+  s.p1 = end;
+  s.center = center;
+  s.cw = cw;
+  s.radius = radius;
+  s.bounds = arcBounds(s).adjusted(-radius, -radius, radius, radius);
+  return s;
+}
+
+FeatureShape FeatureShape::contour(const QList<QPolygonF>& rings)
+{
+  FeatureShape s;
+  for (int i = 0; i < rings.size(); ++i) {
+    if (rings[i].size() >= 3) {
+      s.rings.append(rings[i]);
+      s.bounds |= rings[i].boundingRect();
+    }
+  }
+  s.kind = s.rings.isEmpty()? Empty: Contour;
+  return s;
+}
+
+QList<QPolygonF> FeatureShape::toPolygons(qreal tolerance) const
+{
+  QList<QPolygonF> result;
+
+  switch (kind) {
+  case Disc: {
+    result.append(ArcGeometry::circle(p0, radius, tolerance));
+    break;
+  }
+  case Capsule: {
+    QPointF d = p1 - p0;
+    qreal a = (d.x() == 0 && d.y() == 0)? 0: qAtan2(d.y(), d.x());
+    QPolygonF ring;
+    ArcGeometry::appendArc(ring, p1, radius, a - M_PI / 2, M_PI, tolerance);
+    ArcGeometry::appendArc(ring, p0, radius, a + M_PI / 2, M_PI, tolerance);
+    result.append(ring);
+    break;
+  }
+  case Arc: {
+    Skeleton s = skeletonOf(*this);
+    qreal outer = s.r + radius, inner = qMax(s.r - radius, (qreal)0);
+
+    if (s.sweep >= 2 * M_PI - 1e-9) {
+      // Full circle: an annulus
+      result.append(ArcGeometry::circle(s.c, outer, tolerance));
+      if (inner > 0) {
+        result.append(ArcGeometry::circle(s.c, inner, tolerance));
+      }
+      break;
+    }
+
+    qreal end = s.start + s.sweep;
+    QPolygonF ring;
+    ArcGeometry::appendArc(ring, s.c, outer, s.start, s.sweep, tolerance);
+
+    // The end caps overlap behind the center when the arc is thicker than
+    // its radius or nearly closed; the outline would then cross itself, so
+    // close it on the envelope of the two caps instead.  The cap circles
+    // cross on the bisector behind the center at distances t = -r cos(h)
+    // +- root from it.
+    qreal h = s.sweep / 2, back = s.start + h + M_PI;
+    qreal sh = s.r * qSin(h);
+    if (s.r <= radius || (h > M_PI / 2 && sh < radius)) {
+      QPointF e0 = arcPoint(s, s.start), e1 = arcPoint(s, end);
+      QPointF u(qCos(back), qSin(back));
+      qreal root = qSqrt(radius * radius - sh * sh);
+
+      QPointF x = s.c + u * (root - s.r * qCos(h));
+      qreal a1 = qAtan2(x.y() - e1.y(), x.x() - e1.x());
+      qreal a0 = qAtan2(x.y() - e0.y(), x.x() - e0.x());
+      ArcGeometry::appendArc(ring, e1, radius, end, normalizeAngle(a1 - end),
+          tolerance);
+      ArcGeometry::appendArc(ring, e0, radius, a0,
+          normalizeAngle(s.start - a0), tolerance);
+      result.append(ring);
+
+      if (inner > 0) {
+        // The hole is closed by the inner sides of the caps
+        x = s.c + u * (-root - s.r * qCos(h));
+        a1 = qAtan2(x.y() - e1.y(), x.x() - e1.x());
+        a0 = qAtan2(x.y() - e0.y(), x.x() - e0.x());
+        QPolygonF hole;
+        ArcGeometry::appendArc(hole, s.c, inner, s.start, s.sweep, tolerance);
+        ArcGeometry::appendArc(hole, e1, radius, end + M_PI,
+            -normalizeAngle(end + M_PI - a1), tolerance);
+        ArcGeometry::appendArc(hole, e0, radius, a0,
+            -normalizeAngle(a0 - s.start - M_PI), tolerance);
+        result.append(hole);
+      }
+      break;
+    }
+
+    ArcGeometry::appendArc(ring, arcPoint(s, end), radius, end, M_PI,
+        tolerance);
+    ArcGeometry::appendArc(ring, s.c, inner, end, -s.sweep, tolerance);
+    ArcGeometry::appendArc(ring, arcPoint(s, s.start), radius,
+        s.start + M_PI, M_PI, tolerance);
+    result.append(ring);
+    break;
+  }
+  case Contour:
+    result = rings;
+    break;
+  default:
+    break;
+  }
+
+  return result;
+}
+
+namespace ShapeDistance {
+
+Proximity between(const FeatureShape& a, const FeatureShape& b)
+{
+  if (a.isEmpty() || b.isEmpty()) {
+    return Proximity();
+  }
+
+  if (a.kind == FeatureShape::Contour && b.kind == FeatureShape::Contour) {
+    return contourContour(a, b);
+  }
+
+  if (a.kind == FeatureShape::Contour) {
+    Proximity p = skeletonContour(skeletonOf(b), a);
+    return thicken(Proximity(p.distance, p.pb, p.pa), 0, b.radius);
+  }
+
+  if (b.kind == FeatureShape::Contour) {
+    return thicken(skeletonContour(skeletonOf(a), b), a.radius, 0);
+  }
+
+  return thicken(skeletonDistance(skeletonOf(a), skeletonOf(b)),
+      a.radius, b.radius);
+}
+
+Proximity toPoint(const FeatureShape& shape, const QPointF& p)
+{
+  return between(shape, FeatureShape::disc(p, 0));
+}
+
+qreal boundsDistance(const QRectF& a, const QRectF& b)
+{
+  qreal dx = qMax(0.0, qMax(a.left() - b.right(), b.left() - a.right()));
+  qreal dy = qMax(0.0, qMax(a.top() - b.bottom(), b.top() - a.bottom()));
+  return qSqrt(dx * dx + dy * dy);
+}
+
+qreal boundsDistance(const QRectF& r, const QPointF& p)
+{
+  qreal dx = qMax(0.0, qMax(r.left() - p.x(), p.x() - r.right()));
+  qreal dy = qMax(0.0, qMax(r.top() - p.y(), p.y() - r.bottom()));
+  return qSqrt(dx * dx + dy * dy);
+}
+
+} /* namespace ShapeDistance */
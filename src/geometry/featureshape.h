@@ -0,0 +1,93 @@
+/**
+ * @file   featureshape.h
+ * @author Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ *
+ * Copyright (C) 2012 - 2014 Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ * All Rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __FEATURESHAPE_H__
+#define __FEATURESHAPE_H__
+
+#include <QList>
+#include <QPointF>
+#include <QPolygonF>
+#include <QRectF>
+
+/**
+ * Analytic outline of a single feature.
+ *
+ * Round pads, lines and arcs are kept as a skeleton (point, segment or arc)
+ * thickened by a radius, everything else as a set of closed contours filled
+ * with the odd-even rule.  Distances between shapes are computed exactly on
+ * this representation, without rasterising or building painter paths.
+ */
+struct FeatureShape {
+  typedef enum { Empty = 0, Disc, Capsule, Arc, Contour } Kind;
+
+  FeatureShape(): kind(Empty), radius(0), cw(false) {}
+
+  static FeatureShape disc(const QPointF& center, qreal radius);
+  static FeatureShape capsule(const QPointF& start, const QPointF& end,
+      qreal radius);
+  static FeatureShape arc(const QPointF& start, const QPointF& end,
+      const QPointF& center, bool cw, qreal radius);
+  static FeatureShape contour(const QList<QPolygonF>& rings);
+
+  bool isEmpty(void) const { return kind == Empty; }
+  QRectF boundingRect(void) const { return bounds; }
+
+  /**
+   * Outline as odd-even filled rings.  Curves are replaced by chords which
+   * stay within tolerance of the true outline.
+   */
+  QList<QPolygonF> toPolygons(qreal tolerance) const;
+
+  Kind kind;
+  QPointF p0, p1;         /* disc center; segment or arc end points */
+  QPointF center;         /* arc center */
+  qreal radius;           /* half width of the skeleton */
+  bool cw;                /* arc direction */
+  QList<QPolygonF> rings; /* contour rings, odd-even filled */
+  QRectF bounds;
+};
+
+/**
+ * Closest approach between two shapes: distance is the edge-to-edge gap
+ * (0 when they touch or overlap) and pa/pb are the points realizing it.
+ */
+struct Proximity {
+  Proximity(): distance(-1) {}
+  Proximity(qreal d, const QPointF& a, const QPointF& b):
+    distance(d), pa(a), pb(b) {}
+
+  bool isValid(void) const { return distance >= 0; }
+
+  qreal distance;
+  QPointF pa, pb;
+};
+
+namespace ShapeDistance {
+
+Proximity between(const FeatureShape& a, const FeatureShape& b);
+Proximity toPoint(const FeatureShape& shape, const QPointF& p);
+qreal boundsDistance(const QRectF& a, const QRectF& b);
+qreal boundsDistance(const QRectF& r, const QPointF& p);
+
+} /* namespace ShapeDistance */
+
+#endif /* __FEATURESHAPE_H__ */
@@ -0,0 +1,17 @@
+HEADERS += \
+  geometry/arcgeometry.h \
+  geometry/featureshape.h \
+  geometry/parallel.h \
+  geometry/placement.h \
+  geometry/polygonboolean.h \
+  geometry/spatialindex.h \
+  geometry/tracewidthclassifier.h
+
+SOURCES += \
+  geometry/arcgeometry.cpp \
+  geometry/featureshape.cpp \
+  geometry/parallel.cpp \
+  geometry/placement.cpp \
+  geometry/polygonboolean.cpp \
+  geometry/spatialindex.cpp \
+  geometry/tracewidthclassifier.cpp
@@ -0,0 +1,103 @@
+/**
+ * @file   parallel.cpp
+ * @author Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ *
+ * Copyright (C) 2012 - 2014 Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ * All Rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "parallel.h"
+
+#include <QAtomicInt>
+#include <QRunnable>
+#include <QSemaphore>
+#include <QThreadPool>
+
+namespace Parallel {
+
+struct RangeJob {
+  RangeJob(int c, int g, const std::function<void (int, int)>& b):
+    count(c), grain(g), body(b), next(0) {}
+
+  void drain(void)
+  {
+    int begin;
+    while ((begin = next.fetchAndAddOrdered(grain)) < count) {
+      body(begin, qMin(begin + grain, count));
+    }
+  }
+
+  const int count;
+  const int grain;
+  const std::function<void (int, int)>& body;
+  QAtomicInt next;
+  QSemaphore finished;
+};
+
+class RangeWorker: public QRunnable {
+public:
+  RangeWorker(RangeJob* job): m_job(job) {}
+
+  virtual void run(void)
+  {
+    m_job->drain();
+    m_job->finished.release();
+  }
+
+private:
+  RangeJob* m_job;
+};
+
+int threadCount(void)
+{
+  return qMax(1, QThreadPool::globalInstance()->maxThreadCount()) + 1;
+}
+
+void forRange(int count, int grain,
+    const std::function<void (int begin, int end)>& body)
+{
+  if (count <= 0) {
+    return;
+  }
+
+  grain = qMax(1, grain);
+  if (count <= grain) {
+    body(0, count);
+    return;
+  }
+
+  RangeJob job(count, grain, body);
+  QThreadPool* pool = QThreadPool::globalInstance();
+
+  // Only take threads that are idle right now; the caller always works too,
+  // so nested calls from inside a pool thread can never deadlock.
+  int chunks = (count + grain - 1) / grain;
+  int started = 0;
+  for (int i = 1; i < chunks && i < threadCount(); ++i) {
+    RangeWorker* worker = new RangeWorker(&job);
+    if (!pool->tryStart(worker)) {
+      delete worker;
+      break;
+    }
+    ++started;
+  }
+
+  job.drain();
+  job.finished.acquire(started);
+}
+
+} /* namespace Parallel */
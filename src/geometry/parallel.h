@@ -0,0 +1,49 @@
+/**
+ * @file   parallel.h
+ * @author Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ *
+ * Copyright (C) 2012 - 2014 Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ * All Rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __PARALLEL_H__
+#define __PARALLEL_H__
+
+#include <functional>
+
+namespace Parallel {
+
+/**
+ * Run body(begin, end) over [0, count) in chunks of at most grain items.
+ *
+ * Chunks are handed out from a shared atomic counter to the calling thread
+ * and to whatever QThreadPool::globalInstance() workers are idle, so a slow
+ * chunk never leaves the other threads waiting for a fixed partition.  The
+ * call returns once every chunk has been processed.  body must be safe to
+ * call concurrently for disjoint ranges.
+ */
+void forRange(int count, int grain,
+    const std::function<void (int begin, int end)>& body);
+
+/**
+ * Number of threads forRange() may use, including the caller.
+ */
+int threadCount(void);
+
+} /* namespace Parallel */
+
+#endif /* __PARALLEL_H__ */
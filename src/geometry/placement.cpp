@@ -0,0 +1,237 @@
+/**
+ * @file   placement.cpp
+ * @author Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ *
+ * Copyright (C) 2012 - 2014 Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ * All Rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "placement.h"
+
+#include <cfloat>
+
+#include <QtCore/qmath.h>
+
+#if !defined(QT_COORD_TYPE) && (defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define PLACEMENT_SSE2
+#include <emmintrin.h>
+#endif
+
+/* Rotation by orient % 4 quarter turns, as QTransform::rotate() sets it */
+static const qreal QUARTER_TURNS[4][4] = {
+  {  1,  0,  0,  1 },
+  {  0,  1, -1,  0 },
+  { -1,  0,  0, -1 },
+  {  0, -1,  1,  0 }
+};
+
+Placement::Placement(void):
+  m_m11(1), m_m12(0), m_m21(0), m_m22(1), m_dx(0), m_dy(0)
+{
+}
+
+Placement::Placement(qreal m11, qreal m12, qreal m21, qreal m22, qreal dx,
+    qreal dy):
+  m_m11(m11), m_m12(m12), m_m21(m21), m_m22(m22), m_dx(dx), m_dy(dy)
+{
+}
+
+Placement Placement::fromTransform(const QTransform& trans)
+{
+  Q_ASSERT(trans.isAffine());
+  return Placement(trans.m11(), trans.m12(), trans.m21(), trans.m22(),
+      trans.dx(), trans.dy());
+}
+
+Placement Placement::fromOrient(Orient orient, const QPointF& pos)
+{
+  const qreal* r = QUARTER_TURNS[orient % 4];
+  qreal s = (orient >= M_0)? -1: 1;
+  return Placement(s * r[0], s * r[1], r[2], r[3], pos.x(), pos.y());
+}
+
+Placement Placement::fromStepRepeat(qreal angle, bool mirror,
+    const QPointF& datum)
+{
+  // Quarter turns are exact, the same special cases as QTransform::rotate()
+  qreal sina, cosa;
+  if (angle == 90 || angle == -270) {
+    sina = 1;
+    cosa = 0;
+  } else if (angle == 270 || angle == -90) {
+    sina = -1;
+    cosa = 0;
+  } else if (angle == 180) {
+    sina = 0;
+    cosa = -1;
+  } else {
+    qreal b = qDegreesToRadians(angle);
+    sina = qSin(b);
+    cosa = qCos(b);
+  }
+
+  Placement shift(1, 0, 0, 1, -datum.x(), datum.y());
+  Placement turn(cosa, sina, -sina, cosa, 0, 0);
+  Placement flip(mirror? -1: 1, 0, 0, 1, 0, 0);
+  return shift * turn * flip;
+}
+
+QTransform Placement::toTransform(void) const
+{
+  return QTransform(m_m11, m_m12, m_m21, m_m22, m_dx, m_dy);
+}
+
+Placement Placement::operator*(const Placement& o) const
+{
+  return Placement(
+      m_m11 * o.m_m11 + m_m12 * o.m_m21, m_m11 * o.m_m12 + m_m12 * o.m_m22,
+      m_m21 * o.m_m11 + m_m22 * o.m_m21, m_m21 * o.m_m12 + m_m22 * o.m_m22,
+      m_dx * o.m_m11 + m_dy * o.m_m21 + o.m_dx,
+      m_dx * o.m_m12 + m_dy * o.m_m22 + o.m_dy);
+}
+
+Placement Placement::translated(qreal dx, qreal dy) const
+{
+  return Placement(m_m11, m_m12, m_m21, m_m22, m_dx + dx, m_dy + dy);
+}
+
+QVector<Placement> Placement::about(const QPointF* origins, int count) const
+{
+  // Moving by o first adds map(o) - d - o to the offset
+  QVector<QPointF> moved(count);
+  map(origins, moved.data(), count);
+
+  QVector<Placement> placements(count);
+  for (int i = 0; i < count; ++i) {
+    placements[i] = translated(moved[i].x() - m_dx - origins[i].x(),
+        moved[i].y() - m_dy - origins[i].y());
+  }
+  return placements;
+}
+
+bool Placement::isIdentity(void) const
+{
+  return m_m11 == 1 && m_m12 == 0 && m_m21 == 0 && m_m22 == 1 &&
+    m_dx == 0 && m_dy == 0;
+}
+
+void Placement::map(const QPointF* src, QPointF* dst, int count) const
+{
+  int i = 0;
+#ifdef PLACEMENT_SSE2
+  // Two points at a time, the x and the y coordinates in separate registers
+  const double* in = reinterpret_cast<const double*>(src);
+  double* out = reinterpret_cast<double*>(dst);
+  const __m128d m11 = _mm_set1_pd(m_m11), m12 = _mm_set1_pd(m_m12);
+  const __m128d m21 = _mm_set1_pd(m_m21), m22 = _mm_set1_pd(m_m22);
+  const __m128d dx = _mm_set1_pd(m_dx), dy = _mm_set1_pd(m_dy);
+  for (; i + 2 <= count; i += 2) {
+    __m128d p0 = _mm_loadu_pd(in + 2 * i);
+    __m128d p1 = _mm_loadu_pd(in + 2 * i + 2);
+    __m128d x = _mm_unpacklo_pd(p0, p1);
+    __m128d y = _mm_unpackhi_pd(p0, p1);
+    __m128d mx = _mm_add_pd(_mm_add_pd(_mm_mul_pd(x, m11),
+          _mm_mul_pd(y, m21)), dx);
+    __m128d my = _mm_add_pd(_mm_add_pd(_mm_mul_pd(x, m12),
+          _mm_mul_pd(y, m22)), dy);
+    _mm_storeu_pd(out + 2 * i, _mm_unpacklo_pd(mx, my));
+    _mm_storeu_pd(out + 2 * i + 2, _mm_unpackhi_pd(mx, my));
+  }
+#endif
+  for (; i < count; ++i) {
+    qreal x = src[i].x(), y = src[i].y();
+    dst[i].setX(m_m11 * x + m_m21 * y + m_dx);
+    dst[i].setY(m_m12 * x + m_m22 * y + m_dy);
+  }
+}
+
+void Placement::map(QPolygonF& polygon) const
+{
+  if (!polygon.isEmpty()) {
+    QPointF* points = polygon.data();
+    map(points, points, polygon.size());
+  }
+}
+
+void Placement::map(QList<QPolygonF>& polygons) const
+{
+  for (int i = 0; i < polygons.size(); ++i) {
+    map(polygons[i]);
+  }
+}
+
+QRectF Placement::mapBounds(const QPointF* points, int count) const
+{
+  if (count <= 0) {
+    return QRectF();
+  }
+
+  qreal x0 = DBL_MAX, y0 = DBL_MAX, x1 = -DBL_MAX, y1 = -DBL_MAX;
+  int i = 0;
+#ifdef PLACEMENT_SSE2
+  const double* in = reinterpret_cast<const double*>(points);
+  const __m128d m11 = _mm_set1_pd(m_m11), m12 = _mm_set1_pd(m_m12);
+  const __m128d m21 = _mm_set1_pd(m_m21), m22 = _mm_set1_pd(m_m22);
+  const __m128d dx = _mm_set1_pd(m_dx), dy = _mm_set1_pd(m_dy);
+  __m128d loX = _mm_set1_pd(DBL_MAX), loY = loX;
+  __m128d hiX = _mm_set1_pd(-DBL_MAX), hiY = hiX;
+  for (; i + 2 <= count; i += 2) {
+    __m128d p0 = _mm_loadu_pd(in + 2 * i);
+    __m128d p1 = _mm_loadu_pd(in + 2 * i + 2);
+    __m128d x = _mm_unpacklo_pd(p0, p1);
+    __m128d y = _mm_unpackhi_pd(p0, p1);
+    __m128d mx = _mm_add_pd(_mm_add_pd(_mm_mul_pd(x, m11),
+          _mm_mul_pd(y, m21)), dx);
+    __m128d my = _mm_add_pd(_mm_add_pd(_mm_mul_pd(x, m12),
+          _mm_mul_pd(y, m22)), dy);
+    loX = _mm_min_pd(loX, mx);
+    hiX = _mm_max_pd(hiX, mx);
+    loY = _mm_min_pd(loY, my);
+    hiY = _mm_max_pd(hiY, my);
+  }
+  double lx[2], ly[2], hx[2], hy[2];
+  _mm_storeu_pd(lx, loX);
+  _mm_storeu_pd(ly, loY);
+  _mm_storeu_pd(hx, hiX);
+  _mm_storeu_pd(hy, hiY);
+  x0 = qMin(lx[0], lx[1]);
+  y0 = qMin(ly[0], ly[1]);
+  x1 = qMax(hx[0], hx[1]);
+  y1 = qMax(hy[0], hy[1]);
+#endif
+  for (; i < count; ++i) {
+    qreal x = points[i].x(), y = points[i].y();
+    qreal mx = m_m11 * x + m_m21 * y + m_dx;
+    qreal my = m_m12 * x + m_m22 * y + m_dy;
+    x0 = qMin(x0, mx);
+    y0 = qMin(y0, my);
+    x1 = qMax(x1, mx);
+    y1 = qMax(y1, my);
+  }
+  return QRectF(QPointF(x0, y0), QPointF(x1, y1));
+}
+
+QRectF Placement::mapRect(const QRectF& rect) const
+{
+  if (rect.isNull()) {
+    return QRectF();
+  }
+  const QPointF corners[4] = { rect.topLeft(), rect.topRight(),
+    rect.bottomRight(), rect.bottomLeft() };
+  return mapBounds(corners, 4);
+}
@@ -0,0 +1,690 @@
+/**
+ * @file   polygonboolean.cpp
+ * @author Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ *
+ * Copyright (C) 2012 - 2014 Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ * All Rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "polygonboolean.h"
+
+#include <algorithm>
+#include <cmath>
+#include <set>
+#include <vector>
+
+#include <QHash>
+#include <QtCore/qmath.h>
+
+#include "logger.h"
+
+/* Rounds of intersection splitting; snapped intersection points may create
+ * new crossings, which the next round resolves */
+#define MAX_SPLIT_ROUNDS 8
+
+namespace PolygonBoolean {
+
+/* A segment normalized to go upwards, or rightwards when horizontal */
+struct Segment {
+  IntPoint a, b;
+  int subject;
+};
+
+/* Unique segment with the subjects whose boundary it is (odd multiplicity)
+ * and, after the sweep, which side is covered: 1 left, -1 right, 0 none */
+struct Edge {
+  IntPoint a, b;
+  QVector<int> subjects;
+  int label;
+};
+
+struct OutEdge {
+  IntPoint from, to;
+  bool operator<(const OutEdge& o) const { return from < o.from; }
+};
+
+static inline Coord orient(const IntPoint& a, const IntPoint& b,
+    const IntPoint& c)
+{
+  return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+}
+
+static inline int sign(Coord v)
+{
+  return (v > 0) - (v < 0);
+}
+
+static inline Coord minX(const Segment& s)
+{
+  return qMin(s.a.x, s.b.x);
+}
+
+static inline Coord maxX(const Segment& s)
+{
+  return qMax(s.a.x, s.b.x);
+}
+
+static Segment makeSegment(IntPoint p, IntPoint q, int subject)
+{
+  if (q.y < p.y || (q.y == p.y && q.x < p.x)) {
+    std::swap(p, q);
+  }
+  Segment s;
+  s.a = p;
+  s.b = q;
+  s.subject = subject;
+  return s;
+}
+
+/* p is collinear with s; is it strictly between the end points? */
+static inline bool insideCollinear(const IntPoint& p, const Segment& s)
+{
+  return p != s.a && p != s.b &&
+    p.x >= minX(s) && p.x <= maxX(s) && p.y >= s.a.y && p.y <= s.b.y;
+}
+
+static IntPoint intersection(const Segment& s, const Segment& t)
+{
+  double o1 = (double)orient(s.a, s.b, t.a);
+  double o2 = (double)orient(s.a, s.b, t.b);
+  double u = o1 / (o1 - o2);
+  return IntPoint(llround(t.a.x + (t.b.x - t.a.x) * u),
+      llround(t.a.y + (t.b.y - t.a.y) * u));
+}
+
+/* Split segments at every crossing and touching point, true if any split */
+static bool splitSegments(QVector<Segment>& segs)
+{
+  int n = segs.size();
+  QVector<IntPath> cuts(n);
+  QVector<int> order(n);
+  for (int i = 0; i < n; ++i) {
+    order[i] = i;
+  }
+  std::sort(order.begin(), order.end(), [&](int a, int b) {
+    return minX(segs[a]) < minX(segs[b]);
+  });
+
+  bool split = false;
+  for (int oi = 0; oi < n; ++oi) {
+    int i = order[oi];
+    const Segment& s = segs[i];
+    Coord right = maxX(s);
+
+    for (int oj = oi + 1; oj < n && minX(segs[order[oj]]) <= right; ++oj) {
+      int j = order[oj];
+      const Segment& t = segs[j];
+      if (t.b.y < s.a.y || t.a.y > s.b.y) {
+        continue;
+      }
+
+      int o1 = sign(orient(s.a, s.b, t.a)), o2 = sign(orient(s.a, s.b, t.b));
+      int o3 = sign(orient(t.a, t.b, s.a)), o4 = sign(orient(t.a, t.b, s.b));
+
+      if (o1 * o2 < 0 && o3 * o4 < 0) {
+        IntPoint x = intersection(s, t);
+        if (x != s.a && x != s.b) {
+          cuts[i].append(x);
+        }
+        if (x != t.a && x != t.b) {
+          cuts[j].append(x);
+        }
+        continue;
+      }
+
+      // Touching and collinear overlaps
+      if (o1 == 0 && insideCollinear(t.a, s)) {
+        cuts[i].append(t.a);
+      }
+      if (o2 == 0 && insideCollinear(t.b, s)) {
+        cuts[i].append(t.b);
+      }
+      if (o3 == 0 && insideCollinear(s.a, t)) {
+        cuts[j].append(s.a);
+      }
+      if (o4 == 0 && insideCollinear(s.b, t)) {
+        cuts[j].append(s.b);
+      }
+    }
+  }
+
+  QVector<Segment> result;
+  result.reserve(n);
+  for (int i = 0; i < n; ++i) {
+    const Segment& s = segs[i];
+    if (cuts[i].isEmpty()) {
+      result.append(s);
+      continue;
+    }
+
+    split = true;
+    IntPath& c = cuts[i];
+    double dx = s.b.x - s.a.x, dy = s.b.y - s.a.y;
+    std::sort(c.begin(), c.end(), [&](const IntPoint& p, const IntPoint& q) {
+      return (p.x - s.a.x) * dx + (p.y - s.a.y) * dy <
+        (q.x - s.a.x) * dx + (q.y - s.a.y) * dy;
+    });
+    c.append(s.b);
+
+    IntPoint prev = s.a;
+    for (int k = 0; k < c.size(); ++k) {
+      if (c[k] != prev) {
+        result.append(makeSegment(prev, c[k], s.subject));
+        prev = c[k];
+      }
+    }
+  }
+
+  segs = result;
+  return split;
+}
+
+/* Merge identical segments, keeping subjects with odd multiplicity */
+static QVector<Edge> mergeSegments(QVector<Segment>& segs)
+{
+  std::sort(segs.begin(), segs.end(), [](const Segment& s, const Segment& t) {
+    if (s.a != t.a) {
+      return s.a < t.a;
+    }
+    if (s.b != t.b) {
+      return s.b < t.b;
+    }
+    return s.subject < t.subject;
+  });
+
+  QVector<Edge> edges;
+  for (int i = 0; i < segs.size();) {
+    Edge e;
+    e.a = segs[i].a;
+    e.b = segs[i].b;
+    e.label = 0;
+
+    int j = i;
+    while (j < segs.size() && segs[j].a == e.a && segs[j].b == e.b) {
+      int k = j;
+      while (k < segs.size() && segs[k].a == e.a && segs[k].b == e.b &&
+          segs[k].subject == segs[j].subject) {
+        ++k;
+      }
+      if ((k - j) % 2) {
+        e.subjects.append(segs[j].subject);
+      }
+      j = k;
+    }
+
+    if (!e.subjects.isEmpty()) {
+      edges.append(e);
+    }
+    i = j;
+  }
+
+  return edges;
+}
+
+/* Coverage while walking a scanbeam from left to right */
+class Coverage {
+public:
+  Coverage(const QVector<Subject>& subjects):
+    m_subjects(subjects), m_covered(0) {}
+
+  bool covered(void) const { return m_covered > 0; }
+
+  void toggle(int subject) {
+    std::set<int>& stack = m_groups[m_subjects[subject].group];
+    bool before = top(stack);
+    if (!stack.erase(subject)) {
+      stack.insert(subject);
+    }
+    m_covered += (int)top(stack) - (int)before;
+  }
+
+private:
+  bool top(const std::set<int>& stack) const {
+    return !stack.empty() && m_subjects[*stack.rbegin()].positive;
+  }
+
+  const QVector<Subject>& m_subjects;
+  QHash<int, std::set<int> > m_groups;
+  int m_covered;
+};
+
+/* Is edge a left of edge b just above y, both spanning that scanbeam */
+static bool edgeLess(const Edge& a, const Edge& b)
+{
+  // Test the higher start point against the other edge; segments never
+  // cross, so this decides the order over their whole common range
+  bool aHigher = (a.a.y >= b.a.y);
+  const Edge& s = aHigher? a: b;
+  const Edge& t = aHigher? b: a;
+
+  Coord o = orient(t.a, t.b, s.a);
+  if (o == 0) {
+    o = orient(t.a, t.b, s.b);
+  }
+  return aHigher? (o > 0): (o < 0);
+}
+
+/*
+ * Walk the active edges at height y.  Horizontal edges hs (sorted, at y)
+ * get the coverage of the scanbeam in states; edges starting at y get
+ * their label when labelNew is set.
+ */
+static void walk(const std::vector<int>& active, QVector<Edge>& edges,
+    Coord y, const int* hs, int hcount, QVector<char>& states,
+    bool labelNew, const QVector<Subject>& subjects)
+{
+  Coverage coverage(subjects);
+  int q = 0;
+
+  for (size_t k = 0; k < active.size(); ++k) {
+    Edge& e = edges[active[k]];
+    while (q < hcount && orient(e.a, e.b, IntPoint(edges[hs[q]].b.x, y)) >= 0) {
+      states[hs[q]] = coverage.covered();
+      ++q;
+    }
+
+    bool before = coverage.covered();
+    for (int i = 0; i < e.subjects.size(); ++i) {
+      coverage.toggle(e.subjects[i]);
+    }
+    bool after = coverage.covered();
+
+    if (labelNew && e.a.y == y) {
+      e.label = (before == after)? 0: (before? 1: -1);
+    }
+  }
+
+  for (; q < hcount; ++q) {
+    states[hs[q]] = coverage.covered();
+  }
+}
+
+static void label(QVector<Edge>& edges, const QVector<Subject>& subjects)
+{
+  QVector<int> sloped, flat;
+  QVector<Coord> ys;
+  for (int i = 0; i < edges.size(); ++i) {
+    (edges[i].a.y == edges[i].b.y? flat: sloped).append(i);
+    ys.append(edges[i].a.y);
+    ys.append(edges[i].b.y);
+  }
+  std::sort(sloped.begin(), sloped.end(), [&](int a, int b) {
+    return edges[a].a.y < edges[b].a.y;
+  });
+  std::sort(flat.begin(), flat.end(), [&](int a, int b) {
+    return (edges[a].a.y != edges[b].a.y)? edges[a].a.y < edges[b].a.y:
+      edges[a].a.x < edges[b].a.x;
+  });
+  std::sort(ys.begin(), ys.end());
+  ys.erase(std::unique(ys.begin(), ys.end()), ys.end());
+
+  QVector<char> above(edges.size(), 0), below(edges.size(), 0);
+  std::vector<int> active;
+  int si = 0, fi = 0;
+
+  for (int yi = 0; yi < ys.size(); ++yi) {
+    Coord y = ys[yi];
+    int fb = fi;
+    while (fi < flat.size() && edges[flat[fi]].a.y == y) {
+      ++fi;
+    }
+
+    // Scanbeam below y, before edges ending here are dropped
+    if (fi > fb) {
+      walk(active, edges, y, flat.constData() + fb, fi - fb, below, false,
+          subjects);
+    }
+
+    active.erase(std::remove_if(active.begin(), active.end(), [&](int e) {
+      return edges[e].b.y == y;
+    }), active.end());
+
+    bool added = false;
+    while (si < sloped.size() && edges[sloped[si]].a.y == y) {
+      int e = sloped[si++];
+      std::vector<int>::iterator it = std::upper_bound(active.begin(),
+          active.end(), e, [&](int a, int b) {
+        return edgeLess(edges[a], edges[b]);
+      });
+      active.insert(it, e);
+      added = true;
+    }
+
+    // Scanbeam above y
+    if (added || fi > fb) {
+      walk(active, edges, y, flat.constData() + fb, fi - fb, above, true,
+          subjects);
+    }
+  }
+
+  for (int i = 0; i < flat.size(); ++i) {
+    int e = flat[i];
+    edges[e].label = (above[e] == below[e])? 0: (above[e]? 1: -1);
+  }
+}
+
+/* Clockwise angle from direction r to direction d, in (0, 2pi] */
+static double clockwiseAngle(const IntPoint& r, const IntPoint& d)
+{
+  double a = atan2((double)r.y, (double)r.x) - atan2((double)d.y, (double)d.x);
+  a = fmod(a, 2 * M_PI);
+  return (a <= 0)? a + 2 * M_PI: a;
+}
+
+/* Link covered-on-the-left edges into rings, turning as tight as possible
+ * so regions touching at a vertex come out as separate rings */
+static QVector<IntPath> linkRings(QVector<OutEdge>& outs)
+{
+  std::sort(outs.begin(), outs.end());
+  QVector<bool> used(outs.size(), false);
+  QVector<IntPath> rings;
+
+  for (int first = 0; first < outs.size(); ++first) {
+    if (used[first]) {
+      continue;
+    }
+
+    IntPath ring;
+    int cur = first;
+    for (;;) {
+      used[cur] = true;
+      ring.append(outs[cur].from);
+
+      IntPoint v = outs[cur].to;
+      IntPoint r(outs[cur].from.x - v.x, outs[cur].from.y - v.y);
+      OutEdge key;
+      key.from = v;
+      QVector<OutEdge>::iterator lo = std::lower_bound(outs.begin(),
+          outs.end(), key);
+
+      int best = -1;
+      double bestAngle = 0;
+      for (QVector<OutEdge>::iterator it = lo;
+          it != outs.end() && it->from == v; ++it) {
+        int c = it - outs.begin();
+        if (used[c] && c != first) {
+          continue;
+        }
+        double angle = clockwiseAngle(r, IntPoint(it->to.x - v.x,
+              it->to.y - v.y));
+        if (best < 0 || angle < bestAngle) {
+          best = c;
+          bestAngle = angle;
+        }
+      }
+
+      if (best < 0 || best == first) {
+        break;
+      }
+      cur = best;
+    }
+
+    rings.append(ring);
+  }
+
+  return rings;
+}
+
+/* Drop collinear vertices and spikes */
+static IntPath simplify(const IntPath& ring)
+{
+  IntPath out;
+  for (int i = 0; i < ring.size(); ++i) {
+    while (out.size() >= 2 &&
+        orient(out[out.size() - 2], out.last(), ring[i]) == 0) {
+      out.removeLast();
+    }
+    out.append(ring[i]);
+  }
+
+  while (out.size() >= 3) {
+    if (orient(out[out.size() - 2], out.last(), out.first()) == 0) {
+      out.removeLast();
+    } else if (orient(out.last(), out[0], out[1]) == 0) {
+      out.removeFirst();
+    } else {
+      break;
+    }
+  }
+
+  return (out.size() >= 3)? out: IntPath();
+}
+
+/* 1 inside, 0 outside, -1 on the boundary */
+static int pointInRing(const IntPoint& p, const IntPath& ring)
+{
+  bool inside = false;
+  for (int i = 0; i < ring.size(); ++i) {
+    const IntPoint& a = ring[i];
+    const IntPoint& b = ring[(i + 1) % ring.size()];
+
+    Coord o = orient(a, b, p);
+    if (o == 0 && p.x >= qMin(a.x, b.x) && p.x <= qMax(a.x, b.x) &&
+        p.y >= qMin(a.y, b.y) && p.y <= qMax(a.y, b.y)) {
+      return -1;
+    }
+    if ((a.y <= p.y) != (b.y <= p.y)) {
+      if ((b.y > a.y)? (o > 0): (o < 0)) {
+        inside = !inside;
+      }
+    }
+  }
+  return inside? 1: 0;
+}
+
+static IntRect boundsOf(const IntPath& ring)
+{
+  IntRect r(ring[0].x, ring[0].y, ring[0].x, ring[0].y);
+  for (int i = 1; i < ring.size(); ++i) {
+    r.left = qMin(r.left, ring[i].x);
+    r.right = qMax(r.right, ring[i].x);
+    r.bottom = qMin(r.bottom, ring[i].y);
+    r.top = qMax(r.top, ring[i].y);
+  }
+  return r;
+}
+
+static QVector<Polygon> assemble(const QVector<IntPath>& rings)
+{
+  QVector<Polygon> polygons;
+  QVector<double> areas;
+  QVector<IntRect> bounds;
+  QVector<IntPath> holes;
+
+  for (int i = 0; i < rings.size(); ++i) {
+    IntPath ring = simplify(rings[i]);
+    if (ring.isEmpty()) {
+      continue;
+    }
+    double a = area(ring);
+    if (a > 0) {
+      Polygon p;
+      p.outer = ring;
+      polygons.append(p);
+      areas.append(a);
+      bounds.append(boundsOf(ring));
+    } else if (a < 0) {
+      holes.append(ring);
+    }
+  }
+
+  // Each hole goes to the smallest outer contour containing it
+  for (int h = 0; h < holes.size(); ++h) {
+    const IntPath& hole = holes[h];
+    IntRect hb = boundsOf(hole);
+    int best = -1;
+
+    for (int o = 0; o < polygons.size(); ++o) {
+      const IntRect& ob = bounds[o];
+      if (hb.left < ob.left || hb.right > ob.right ||
+          hb.bottom < ob.bottom || hb.top > ob.top) {
+        continue;
+      }
+      if (best >= 0 && areas[o] >= areas[best]) {
+        continue;
+      }
+
+      int where = -1;
+      for (int v = 0; v < hole.size() && where < 0; ++v) {
+        where = pointInRing(hole[v], polygons[o].outer);
+      }
+      if (where != 0) {
+        best = o;
+      }
+    }
+
+    if (best >= 0) {
+      polygons[best].holes.append(hole);
+    }
+  }
+
+  return polygons;
+}
+
+QVector<Polygon> flatten(const QVector<Subject>& subjects)
+{
+  QVector<Segment> segs;
+  for (int s = 0; s < subjects.size(); ++s) {
+    const QVector<IntPath>& rings = subjects[s].rings;
+    for (int r = 0; r < rings.size(); ++r) {
+      const IntPath& ring = rings[r];
+      for (int i = 0; i < ring.size(); ++i) {
+        const IntPoint& p = ring[i];
+        const IntPoint& q = ring[(i + 1) % ring.size()];
+        if (p != q) {
+          segs.append(makeSegment(p, q, s));
+        }
+      }
+    }
+  }
+
+  bool settled = false;
+  for (int round = 0; round < MAX_SPLIT_ROUNDS && !settled; ++round) {
+    settled = !splitSegments(segs);
+  }
+  if (!settled && splitSegments(segs)) {
+    // Crossings left over, the result may have stray slivers
+    LOG_WARNING(QString("PolygonBoolean: intersections not settled after %1 "
+          "rounds, %2 segments").arg(MAX_SPLIT_ROUNDS + 1).arg(segs.size()));
+  }
+
+  QVector<Edge> edges = mergeSegments(segs);
+  label(edges, subjects);
+
+  QVector<OutEdge> outs;
+  for (int i = 0; i < edges.size(); ++i) {
+    const Edge& e = edges[i];
+    if (e.label) {
+      OutEdge o;
+      o.from = (e.label > 0)? e.a: e.b;
+      o.to = (e.label > 0)? e.b: e.a;
+      outs.append(o);
+    }
+  }
+
+  return assemble(linkRings(outs));
+}
+
+IntPath clip(const IntPath& ring, const IntRect& rect)
+{
+  IntPath result = ring;
+
+  for (int side = 0; side < 4 && !result.isEmpty(); ++side) {
+    IntPath input = result;
+    result.clear();
+
+    auto inside = [&](const IntPoint& p) {
+      switch (side) {
+      case 0: return p.x >= rect.left;
+      case 1: return p.x <= rect.right;
+      case 2: return p.y >= rect.bottom;
+      default: return p.y <= rect.top;
+      }
+    };
+    auto cross = [&](const IntPoint& p, const IntPoint& q) {
+      if (side < 2) {
+        Coord x = (side == 0)? rect.left: rect.right;
+        double t = (double)(x - p.x) / (double)(q.x - p.x);
+        return IntPoint(x, llround(p.y + (q.y - p.y) * t));
+      }
+      Coord y = (side == 2)? rect.bottom: rect.top;
+      double t = (double)(y - p.y) / (double)(q.y - p.y);
+      return IntPoint(llround(p.x + (q.x - p.x) * t), y);
+    };
+
+    for (int i = 0; i < input.size(); ++i) {
+      const IntPoint& p = input[i];
+      const IntPoint& q = input[(i + 1) % input.size()];
+      bool pin = inside(p), qin = inside(q);
+      if (pin) {
+        result.append(p);
+      }
+      if (pin != qin) {
+        result.append(cross(p, q));
+      }
+    }
+  }
+
+  return (result.size() >= 3)? result: IntPath();
+}
+
+double area(const IntPath& ring)
+{
+  double sum = 0;
+  for (int i = 1; i + 1 < ring.size(); ++i) {
+    sum += (double)orient(ring[0], ring[i], ring[i + 1]);
+  }
+  return sum / 2;
+}
+
+double area(const Polygon& polygon)
+{
+  double sum = area(polygon.outer);
+  for (int i = 0; i < polygon.holes.size(); ++i) {
+    sum += area(polygon.holes[i]);
+  }
+  return sum;
+}
+
+IntPath toIntPath(const QPolygonF& polygon, qreal scale)
+{
+  IntPath path;
+  path.reserve(polygon.size());
+  for (int i = 0; i < polygon.size(); ++i) {
+    IntPoint p(llround(polygon[i].x() * scale),
+        llround(polygon[i].y() * scale));
+    if (path.isEmpty() || path.last() != p) {
+      path.append(p);
+    }
+  }
+  while (path.size() > 1 && path.first() == path.last()) {
+    path.removeLast();
+  }
+  return path;
+}
+
+QPolygonF toPolygonF(const IntPath& path, qreal scale)
+{
+  QPolygonF polygon;
+  polygon.reserve(path.size());
+  for (int i = 0; i < path.size(); ++i) {
+    polygon.append(QPointF(path[i].x / scale, path[i].y / scale));
+  }
+  return polygon;
+}
+
+} /* namespace PolygonBoolean */
@@ -0,0 +1,101 @@
+/**
+ * @file   polygonboolean.h
+ * @author Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ *
+ * Copyright (C) 2012 - 2014 Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ * All Rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __POLYGONBOOLEAN_H__
+#define __POLYGONBOOLEAN_H__
+
+#include <QPolygonF>
+#include <QVector>
+#include <QtGlobal>
+
+/**
+ * Scanline polygon boolean engine on integer coordinates.
+ *
+ * Resolves an ordered stack of positive and negative subjects into the
+ * area they finally cover, as outer contours with holes.  All predicates
+ * are evaluated exactly in 64-bit integers; only intersection points are
+ * rounded to the grid.  Coordinates must stay within +-2^30.
+ *
+ * Outer contours are counter-clockwise and holes clockwise in a y-up frame,
+ * i.e. the covered area is always on the left of the contour.
+ */
+namespace PolygonBoolean {
+
+typedef qint64 Coord;
+
+struct IntPoint {
+  IntPoint(): x(0), y(0) {}
+  IntPoint(Coord _x, Coord _y): x(_x), y(_y) {}
+
+  bool operator==(const IntPoint& o) const { return x == o.x && y == o.y; }
+  bool operator!=(const IntPoint& o) const { return !(*this == o); }
+  bool operator<(const IntPoint& o) const {
+    return (x != o.x)? x < o.x: y < o.y;
+  }
+
+  Coord x, y;
+};
+
+typedef QVector<IntPoint> IntPath;
+
+struct IntRect {
+  IntRect(): left(0), bottom(0), right(0), top(0) {}
+  IntRect(Coord l, Coord b, Coord r, Coord t):
+    left(l), bottom(b), right(r), top(t) {}
+
+  Coord left, bottom, right, top;
+};
+
+/**
+ * One input feature: rings filled with the odd-even rule.  Subjects later
+ * in the list are on top; a negative subject only erases subjects of the
+ * same group, so independently placed images (step-repeat instances) do
+ * not cut into each other.
+ */
+struct Subject {
+  Subject(): group(0), positive(true) {}
+
+  QVector<IntPath> rings;
+  int group;
+  bool positive;
+};
+
+struct Polygon {
+  IntPath outer;
+  QVector<IntPath> holes;
+};
+
+QVector<Polygon> flatten(const QVector<Subject>& subjects);
+
+/* Sutherland-Hodgman clip of a ring to rect, odd-even fill is preserved */
+IntPath clip(const IntPath& ring, const IntRect& rect);
+
+/* Signed area, positive for counter-clockwise rings */
+double area(const IntPath& ring);
+double area(const Polygon& polygon);
+
+IntPath toIntPath(const QPolygonF& polygon, qreal scale);
+QPolygonF toPolygonF(const IntPath& path, qreal scale);
+
+} /* namespace PolygonBoolean */
+
+#endif /* __POLYGONBOOLEAN_H__ */
@@ -0,0 +1,327 @@
+/**
+ * @file   spatialindex.cpp
+ * @author Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ *
+ * Copyright (C) 2012 - 2014 Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ * All Rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "spatialindex.h"
+
+#include <algorithm>
+#include <queue>
+#include <vector>
+
+#include <QtCore/qmath.h>
+
+#include "featureshape.h"
+#include "fixedpoint.h"
+
+#define NODE_CAPACITY 16
+
+/* QRectF::united() and intersects() ignore zero-area rects, which are
+ * legitimate bounds here (e.g. zero width lines along an axis). */
+static void unite(QRectF& rect, const QRectF& other, bool first)
+{
+  if (first) {
+    rect = other;
+    return;
+  }
+  qreal l = qMin(rect.left(), other.left());
+  qreal t = qMin(rect.top(), other.top());
+  qreal r = qMax(rect.right(), other.right());
+  qreal b = qMax(rect.bottom(), other.bottom());
+  rect = QRectF(l, t, r - l, b - t);
+}
+
+static bool overlaps(const QRectF& a, const QRectF& b)
+{
+  return a.left() <= b.right() && a.right() >= b.left() &&
+    a.top() <= b.bottom() && a.bottom() >= b.top();
+}
+
+SpatialIndex::SpatialIndex(): m_root(-1)
+{
+}
+
+void SpatialIndex::clear(void)
+{
+  m_bounds.clear();
+  m_nodes.clear();
+  m_children.clear();
+  m_items.clear();
+  m_root = -1;
+}
+
+QRectF SpatialIndex::bounds(void) const
+{
+  return (m_root < 0)? QRectF(): m_nodes[m_root].bounds;
+}
+
+static void unite(FixedRect& rect, const FixedRect& other, bool first)
+{
+  if (first) {
+    rect = other;
+    return;
+  }
+  rect.left = qMin(rect.left, other.left);
+  rect.top = qMin(rect.top, other.top);
+  rect.right = qMax(rect.right, other.right);
+  rect.bottom = qMax(rect.bottom, other.bottom);
+}
+
+/* Twice the center, which sorts the same and stays exact for integers */
+static qreal centerX(const QRectF& rect)
+{
+  return rect.left() + rect.right();
+}
+
+static qreal centerY(const QRectF& rect)
+{
+  return rect.top() + rect.bottom();
+}
+
+static qint64 centerX(const FixedRect& rect)
+{
+  return (qint64)rect.left + rect.right;
+}
+
+static qint64 centerY(const FixedRect& rect)
+{
+  return (qint64)rect.top + rect.bottom;
+}
+
+static QRectF toRectF(const QRectF& rect)
+{
+  return rect;
+}
+
+static QRectF toRectF(const FixedRect& rect)
+{
+  return rect.toRectF();
+}
+
+/* Sort-tile-recursive grouping of entries into runs of NODE_CAPACITY */
+template <typename Box>
+static void pack(QVector<int>& entries, const QVector<Box>& boxes,
+    QVector<QVector<int> >& groups)
+{
+  int n = entries.size();
+  int leaves = (n + NODE_CAPACITY - 1) / NODE_CAPACITY;
+  int slices = qMax(1, qCeil(qSqrt((qreal)leaves)));
+  int sliceSize = slices * NODE_CAPACITY;
+
+  std::sort(entries.begin(), entries.end(), [&](int a, int b) {
+    return centerX(boxes[a]) < centerX(boxes[b]);
+  });
+
+  for (int s = 0; s < n; s += sliceSize) {
+    QVector<int>::iterator begin = entries.begin() + s;
+    QVector<int>::iterator end = entries.begin() + qMin(n, s + sliceSize);
+    std::sort(begin, end, [&](int a, int b) {
+      return centerY(boxes[a]) < centerY(boxes[b]);
+    });
+
+    for (QVector<int>::iterator it = begin; it < end; it += NODE_CAPACITY) {
+      QVector<int> group;
+      for (QVector<int>::iterator g = it; g < end && g < it + NODE_CAPACITY;
+          ++g) {
+        group.append(*g);
+      }
+      groups.append(group);
+    }
+  }
+}
+
+void SpatialIndex::build(const QVector<QRectF>& bounds)
+{
+  buildTree(bounds);
+}
+
+void SpatialIndex::build(const QVector<FixedRect>& bounds)
+{
+  buildTree(bounds);
+}
+
+/**
+ * Packing and node bounds work on Box throughout; only the results are
+ * converted to QRectF for the queries.  Rounding a box to qreal is
+ * monotonic, so converted node bounds still contain their children.
+ */
+template <typename Box>
+void SpatialIndex::buildTree(const QVector<Box>& boxes)
+{
+  clear();
+
+  if (boxes.isEmpty()) {
+    return;
+  }
+
+  m_bounds.resize(boxes.size());
+  QVector<int> entries(boxes.size());
+  for (int i = 0; i < boxes.size(); ++i) {
+    m_bounds[i] = toRectF(boxes[i]);
+    entries[i] = i;
+  }
+
+  // Leaves
+  QVector<QVector<int> > groups;
+  pack(entries, boxes, groups);
+
+  QVector<Box> nodeBoxes;
+  QVector<int> level;
+  for (int g = 0; g < groups.size(); ++g) {
+    Node node;
+    node.first = m_items.size();
+    node.count = groups[g].size();
+    node.leaf = true;
+    Box box;
+    for (int i = 0; i < groups[g].size(); ++i) {
+      m_items.append(groups[g][i]);
+      unite(box, boxes[groups[g][i]], i == 0);
+    }
+    node.bounds = toRectF(box);
+    level.append(m_nodes.size());
+    m_nodes.append(node);
+    nodeBoxes.append(box);
+  }
+
+  // Inner levels until a single root remains
+  while (level.size() > 1) {
+    groups.clear();
+    pack(level, nodeBoxes, groups);
+
+    QVector<int> parents;
+    for (int g = 0; g < groups.size(); ++g) {
+      Node node;
+      node.first = m_children.size();
+      node.count = groups[g].size();
+      node.leaf = false;
+      Box box;
+      for (int i = 0; i < groups[g].size(); ++i) {
+        m_children.append(groups[g][i]);
+        unite(box, nodeBoxes[groups[g][i]], i == 0);
+      }
+      node.bounds = toRectF(box);
+      parents.append(m_nodes.size());
+      m_nodes.append(node);
+      nodeBoxes.append(box);
+    }
+    level = parents;
+  }
+
+  m_root = level.first();
+}
+
+void SpatialIndex::visit(const QRectF& rect,
+    const std::function<void (int)>& func) const
+{
+  if (m_root < 0) {
+    return;
+  }
+
+  QVector<int> stack;
+  stack.append(m_root);
+  while (!stack.isEmpty()) {
+    const Node& node = m_nodes[stack.last()];
+    stack.removeLast();
+
+    if (!overlaps(node.bounds, rect)) {
+      continue;
+    }
+
+    for (int i = node.first; i < node.first + node.count; ++i) {
+      if (node.leaf) {
+        int item = m_items[i];
+        if (overlaps(m_bounds[item], rect)) {
+          func(item);
+        }
+      } else {
+        stack.append(m_children[i]);
+      }
+    }
+  }
+}
+
+QVector<int> SpatialIndex::query(const QRectF& rect) const
+{
+  QVector<int> result;
+  visit(rect, [&](int item) { result.append(item); });
+  return result;
+}
+
+QVector<int> SpatialIndex::nearest(const QPointF& p, int k,
+    const DistanceFunc& distance, qreal maxDistance,
+    QVector<qreal>* distances) const
+{
+  QVector<int> result;
+  if (m_root < 0 || k <= 0) {
+    return result;
+  }
+
+  // Queue entries: (lower bound, kind, id) with kind 0 = node, 1 = item
+  // bounded by its rect, 2 = item with exact distance
+  struct Entry {
+    qreal d;
+    int kind;
+    int id;
+    bool operator<(const Entry& o) const { return d > o.d; }
+  };
+
+  std::priority_queue<Entry, std::vector<Entry> > queue;
+  Entry root = { ShapeDistance::boundsDistance(m_nodes[m_root].bounds, p),
+    0, m_root };
+  queue.push(root);
+
+  while (!queue.empty() && result.size() < k) {
+    Entry e = queue.top();
+    queue.pop();
+
+    if (maxDistance >= 0 && e.d > maxDistance) {
+      break;
+    }
+
+    if (e.kind == 2) {
+      result.append(e.id);
+      if (distances) {
+        distances->append(e.d);
+      }
+    } else if (e.kind == 1) {
+      Entry exact = { distance(e.id), 2, e.id };
+      if (exact.d >= 0) {
+        queue.push(exact);
+      }
+    } else {
+      const Node& node = m_nodes[e.id];
+      for (int i = node.first; i < node.first + node.count; ++i) {
+        if (node.leaf) {
+          int item = m_items[i];
+          Entry c = { ShapeDistance::boundsDistance(m_bounds[item], p), 1,
+            item };
+          queue.push(c);
+        } else {
+          int child = m_children[i];
+          Entry c = { ShapeDistance::boundsDistance(m_nodes[child].bounds, p),
+            0, child };
+          queue.push(c);
+        }
+      }
+    }
+  }
+
+  return result;
+}
@@ -0,0 +1,85 @@
+/**
+ * @file   spatialindex.h
+ * @author Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ *
+ * Copyright (C) 2012 - 2014 Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ * All Rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __SPATIALINDEX_H__
+#define __SPATIALINDEX_H__
+
+#include <functional>
+
+#include <QPointF>
+#include <QRectF>
+#include <QVector>
+
+struct FixedRect;
+
+/**
+ * Static packed R-tree (sort-tile-recursive) over item bounding rects.
+ *
+ * Built once from a flat array of bounds; items are referred to by their
+ * position in that array.  Supports window queries and best-first k-nearest
+ * searches with a caller supplied exact distance.
+ */
+class SpatialIndex {
+public:
+  typedef std::function<qreal (int item)> DistanceFunc;
+
+  SpatialIndex();
+
+  void build(const QVector<QRectF>& bounds);
+  /* Same from fixed-point boxes, packed with integer comparisons only */
+  void build(const QVector<FixedRect>& bounds);
+  void clear(void);
+
+  int size(void) const { return m_bounds.size(); }
+  QRectF bounds(void) const;
+  const QRectF& itemBounds(int item) const { return m_bounds[item]; }
+
+  /* Items whose bounds intersect rect, in no particular order */
+  QVector<int> query(const QRectF& rect) const;
+  void visit(const QRectF& rect, const std::function<void (int)>& func) const;
+
+  /**
+   * The k items closest to p by distance(), nearest first.  Bounds are used
+   * as lower bounds, so distance() is only evaluated for plausible items.
+   * Items further than maxDistance are never returned.
+   */
+  QVector<int> nearest(const QPointF& p, int k, const DistanceFunc& distance,
+      qreal maxDistance = -1, QVector<qreal>* distances = NULL) const;
+
+private:
+  struct Node {
+    QRectF bounds;
+    int first;    /* into m_children, or m_items for leaves */
+    int count;
+    bool leaf;
+  };
+
+  template <typename Box> void buildTree(const QVector<Box>& boxes);
+
+  QVector<QRectF> m_bounds;
+  QVector<Node> m_nodes;
+  QVector<int> m_children;
+  QVector<int> m_items;
+  int m_root;
+};
+
+#endif /* __SPATIALINDEX_H__ */
@@ -0,0 +1,281 @@
+/**
+ * @file   tracewidthclassifier.cpp
+ * @author Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ *
+ * Copyright (C) 2012 - 2014 Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ * All Rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "tracewidthclassifier.h"
+
+#include <algorithm>
+#include <climits>
+#include <iterator>
+
+#include <QtCore/qmath.h>
+
+#include "logger.h"
+#include "parallel.h"
+
+#define SURFACE_TRACE_ASPECT_RATIO 2.0
+
+QMap<FeaturesDataStore*, TraceWidthClassifier*>
+  TraceWidthClassifier::s_instances;
+QMutex TraceWidthClassifier::s_instancesMutex;
+
+TraceWidthClassifier* TraceWidthClassifier::forDataStore(FeaturesDataStore* ds)
+{
+  if (!ds) {
+    return NULL;
+  }
+
+  QMutexLocker locker(&s_instancesMutex);
+  static bool hooked = false;
+  if (!hooked) {
+    FeaturesDataStore::addDestroyHook(&TraceWidthClassifier::forget);
+    hooked = true;
+  }
+  TraceWidthClassifier* classifier = s_instances.value(ds, NULL);
+  if (!classifier) {
+    classifier = new TraceWidthClassifier(ds);
+    s_instances[ds] = classifier;
+  }
+  return classifier;
+}
+
+void TraceWidthClassifier::forget(FeaturesDataStore* ds)
+{
+  TraceWidthClassifier* classifier;
+  {
+    QMutexLocker locker(&s_instancesMutex);
+    classifier = s_instances.take(ds);
+  }
+  delete classifier;
+}
+
+TraceWidthClassifier::TraceWidthClassifier(FeaturesDataStore* ds)
+{
+  const QList<Record*> records = ds->records();
+  const FeaturesDataStore::IDMapType& names = ds->symbolNameMap();
+
+  // Lines and arcs only reference a handful of symbols, resolve them up front
+  // so the parallel pass is a plain table lookup.
+  int maxSymNum = names.isEmpty()? -1: names.lastKey();
+  QVector<qreal> symWidths(maxSymNum + 1, -1.0);
+  for (FeaturesDataStore::IDMapType::const_iterator it = names.begin();
+      it != names.end(); ++it) {
+    if (it.key() >= 0) {
+      symWidths[it.key()] = symbolWidth(it.value());
+    }
+  }
+
+  m_widths.resize(records.size());
+  qreal* widths = m_widths.data();
+  const QVector<qreal>& symbols = symWidths;
+
+  Parallel::forRange(records.size(), 1024, [&](int begin, int end) {
+    for (int i = begin; i < end; ++i) {
+      const Record* rec = records[i];
+      int sym_num = -1;
+      qreal w = -1.0;
+
+      if (const LineRecord* line = dynamic_cast<const LineRecord*>(rec)) {
+        sym_num = line->sym_num;
+      } else if (const ArcRecord* arc = dynamic_cast<const ArcRecord*>(rec)) {
+        sym_num = arc->sym_num;
+      } else if (const SurfaceRecord* surface =
+          dynamic_cast<const SurfaceRecord*>(rec)) {
+        w = surfaceWidth(surface);
+      }
+
+      if (sym_num >= 0 && sym_num < symbols.size()) {
+        w = symbols[sym_num];
+      }
+      widths[i] = w;
+    }
+  });
+
+  for (int i = 0; i < m_widths.size(); ++i) {
+    if (m_widths[i] > 0) {
+      m_sorted.append(WidthEntry(m_widths[i], i));
+    }
+  }
+  std::sort(m_sorted.begin(), m_sorted.end());
+
+  LOG_INFO(QString("Trace width classification: %1 traces in %2 records")
+      .arg(m_sorted.size()).arg(records.size()));
+}
+
+QVector<int> TraceWidthClassifier::traces(qreal maxWidth)
+{
+  QMutexLocker locker(&m_mutex);
+
+  QMap<qreal, QVector<int> >::const_iterator cached = m_cache.find(maxWidth);
+  if (cached != m_cache.end()) {
+    return cached.value();
+  }
+
+  QVector<WidthEntry>::const_iterator last = std::upper_bound(
+      m_sorted.begin(), m_sorted.end(), WidthEntry(maxWidth, INT_MAX));
+
+  QVector<int> result;
+  result.reserve(last - m_sorted.begin());
+  for (QVector<WidthEntry>::const_iterator it = m_sorted.begin();
+      it != last; ++it) {
+    result.append(it->second);
+  }
+  std::sort(result.begin(), result.end());
+
+  m_cache[maxWidth] = result;
+  return result;
+}
+
+QVector<int> TraceWidthClassifier::traces(qreal minWidth, qreal maxWidth)
+{
+  QVector<int> upper = traces(maxWidth);
+  QVector<int> lower = traces(minWidth);
+
+  QVector<int> result;
+  result.reserve(upper.size() - lower.size());
+  std::set_difference(upper.begin(), upper.end(), lower.begin(), lower.end(),
+      std::back_inserter(result));
+  return result;
+}
+
+QVector<int> TraceWidthClassifier::classify(const QList<qreal>& thresholds)
+{
+  QVector<int> classes(m_widths.size(), -1);
+  int* result = classes.data();
+  const QVector<qreal>& widths = m_widths;
+
+  Parallel::forRange(m_widths.size(), 4096, [&](int begin, int end) {
+    for (int i = begin; i < end; ++i) {
+      qreal w = widths[i];
+      if (w <= 0) {
+        continue;
+      }
+      for (int c = 0; c < thresholds.size(); ++c) {
+        if (w <= thresholds[c]) {
+          result[i] = c;
+          break;
+        }
+      }
+    }
+  });
+
+  return classes;
+}
+
+qreal TraceWidthClassifier::symbolWidth(const QString& name)
+{
+  // Lines and arcs may only be drawn with round or square apertures, whose
+  // size is given in mils right after the prefix (r10, s7.5).
+  if (name.length() < 2 || (name[0] != 'r' && name[0] != 's')) {
+    return -1.0;
+  }
+
+  bool ok = false;
+  qreal size = name.mid(1).toDouble(&ok);
+  return (ok && size > 0)? size / 1000.0: -1.0;
+}
+
+struct Bounds {
+  Bounds(): empty(true), left(0), right(0), top(0), bottom(0) {}
+
+  void add(qreal x, qreal y)
+  {
+    if (empty) {
+      left = right = x;
+      top = bottom = y;
+      empty = false;
+    } else {
+      left = qMin(left, x);
+      right = qMax(right, x);
+      top = qMin(top, y);
+      bottom = qMax(bottom, y);
+    }
+  }
+
+  void addArc(qreal xs, qreal ys, qreal xe, qreal ye, qreal xc, qreal yc,
+      bool cw)
+  {
+    add(xs, ys);
+    add(xe, ye);
+
+    qreal r = qSqrt((xs - xc) * (xs - xc) + (ys - yc) * (ys - yc));
+    qreal a0 = qAtan2(ys - yc, xs - xc);
+    qreal a1 = qAtan2(ye - yc, xe - xc);
+
+    // Walk the arc counter-clockwise and add every axis extreme it crosses.
+    qreal from = cw? a1: a0;
+    qreal to = cw? a0: a1;
+    if (to <= from) {
+      to += 2 * M_PI;
+    }
+    for (int k = -2; k <= 6; ++k) {
+      qreal a = k * M_PI / 2;
+      if (a > from && a < to) {
+        add(xc + r * qCos(a), yc + r * qSin(a));
+      }
+    }
+  }
+
+  bool empty;
+  qreal left, right, top, bottom;
+};
+
+qreal TraceWidthClassifier::surfaceWidth(const SurfaceRecord* rec)
+{
+  Bounds b;
+
+  for (QList<PolygonRecord*>::const_iterator it = rec->polygons.begin();
+      it != rec->polygons.end(); ++it) {
+    const PolygonRecord* poly = *it;
+    if (poly->poly_type != PolygonRecord::I) {
+      continue;
+    }
+
+    qreal x = poly->xbs, y = poly->ybs;
+    b.add(x, y);
+
+    for (QList<SurfaceOperation*>::const_iterator op = poly->operations.begin();
+        op != poly->operations.end(); ++op) {
+      if ((*op)->type == SurfaceOperation::SEGMENT) {
+        x = (*op)->x;
+        y = (*op)->y;
+        b.add(x, y);
+      } else {
+        b.addArc(x, y, (*op)->xe, (*op)->ye, (*op)->xc, (*op)->yc, (*op)->cw);
+        x = (*op)->xe;
+        y = (*op)->ye;
+      }
+    }
+  }
+
+  qreal w = b.right - b.left;
+  qreal h = b.bottom - b.top;
+  if (b.empty || w <= 0 || h <= 0) {
+    return -1.0;
+  }
+
+  // Same heuristic as SurfaceSymbol::isTrace(): an elongated surface is a
+  // trace and its narrow side is the trace width.
+  if (qMax(w, h) / qMin(w, h) <= SURFACE_TRACE_ASPECT_RATIO) {
+    return -1.0;
+  }
+  return qMin(w, h);
+}
@@ -0,0 +1,87 @@
+/**
+ * @file   tracewidthclassifier.h
+ * @author Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ *
+ * Copyright (C) 2012 - 2014 Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ * All Rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __TRACEWIDTHCLASSIFIER_H__
+#define __TRACEWIDTHCLASSIFIER_H__
+
+#include <QList>
+#include <QMap>
+#include <QMutex>
+#include <QPair>
+#include <QVector>
+
+#include "featuresdatastore.h"
+
+/**
+ * Batch trace width classification over the records of a FeaturesDataStore.
+ *
+ * The width of every line, arc and trace-like surface is computed once, in a
+ * single parallel pass straight from the records (no symbols or painter paths
+ * are built).  Threshold queries then reduce to a binary search over the
+ * sorted widths and their results are cached per threshold.  Indices always
+ * refer to positions in FeaturesDataStore::records().
+ */
+class TraceWidthClassifier {
+public:
+  static TraceWidthClassifier* forDataStore(FeaturesDataStore* ds);
+
+  /**
+   * Drops the classifier of a data store which is about to be destroyed;
+   * registered as a FeaturesDataStore destroy hook
+   */
+  static void forget(FeaturesDataStore* ds);
+
+  int count(void) const { return m_widths.size(); }
+  qreal width(int index) const { return m_widths[index]; }
+  bool isTrace(int index) const { return m_widths[index] > 0; }
+
+  /* Sorted indices of traces with width <= maxWidth */
+  QVector<int> traces(qreal maxWidth);
+
+  /* Sorted indices of traces with minWidth < width <= maxWidth */
+  QVector<int> traces(qreal minWidth, qreal maxWidth);
+
+  /**
+   * Width class of every record for the given ascending thresholds: class i
+   * holds widths in (thresholds[i-1], thresholds[i]].  Records which are not
+   * traces or are wider than the last threshold get -1.
+   */
+  QVector<int> classify(const QList<qreal>& thresholds);
+
+  static qreal symbolWidth(const QString& name);
+  static qreal surfaceWidth(const SurfaceRecord* rec);
+
+private:
+  TraceWidthClassifier(FeaturesDataStore* ds);
+
+  typedef QPair<qreal, int> WidthEntry;
+
+  QVector<qreal> m_widths;
+  QVector<WidthEntry> m_sorted;
+  QMap<qreal, QVector<int> > m_cache;
+  QMutex m_mutex;
+
+  static QMap<FeaturesDataStore*, TraceWidthClassifier*> s_instances;
+  static QMutex s_instancesMutex;
+};
+
+#endif /* __TRACEWIDTHCLASSIFIER_H__ */
@@ -0,0 +1,229 @@
+/**
+ * @file   copperdensity.cpp
+ * @author Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ *
+ * Copyright (C) 2012 - 2014 Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ * All Rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "copperdensity.h"
+
+#include <QColor>
+#include <QJsonArray>
+#include <QtCore/qmath.h>
+
+#include "layercopper.h"
+#include "logger.h"
+#include "parallel.h"
+
+using namespace PolygonBoolean;
+
+/* Opacity of the heatmap over the layer */
+#define HEATMAP_ALPHA 0.6
+
+/* Largest grid, columns times rows; smaller cells are enlarged to fit */
+#define MAX_CELLS (1024 * 1024)
+
+static IntRect boundsOf(const IntPath& ring)
+{
+  IntRect box(ring[0].x, ring[0].y, ring[0].x, ring[0].y);
+  for (int i = 1; i < ring.size(); ++i) {
+    box.left = qMin(box.left, ring[i].x);
+    box.bottom = qMin(box.bottom, ring[i].y);
+    box.right = qMax(box.right, ring[i].x);
+    box.top = qMax(box.top, ring[i].y);
+  }
+  return box;
+}
+
+static qint64 cellCount(Coord width, Coord height, Coord step)
+{
+  return qMax<Coord>(1, (width + step - 1) / step) *
+    qMax<Coord>(1, (height + step - 1) / step);
+}
+
+CopperDensity::CopperDensity(LayerCopper* copper, qreal cellSize):
+  m_cellSize(cellSize), m_resolution(copper->resolution()), m_originX(0),
+  m_originY(0), m_step(1), m_columns(0), m_rows(0), m_area(0)
+{
+  const QVector<Polygon>& polygons = copper->intPolygons();
+  m_area = copper->area();
+  if (copper->tileCount() == 0 || !(cellSize > 0) || !qIsFinite(cellSize)) {
+    return;
+  }
+
+  // Integer grid y points down like the scene, IntRect::bottom is the top
+  IntRect bounds = copper->intTileRect(0);
+  for (int t = 1; t < copper->tileCount(); ++t) {
+    IntRect r = copper->intTileRect(t);
+    bounds.left = qMin(bounds.left, r.left);
+    bounds.bottom = qMin(bounds.bottom, r.bottom);
+    bounds.right = qMax(bounds.right, r.right);
+    bounds.top = qMax(bounds.top, r.top);
+  }
+
+  // A cell wider than the board is one cell; a tiny one is enlarged until
+  // the grid fits in MAX_CELLS
+  Coord width = bounds.right - bounds.left;
+  Coord height = bounds.top - bounds.bottom;
+  double span = double(qMax<Coord>(1, qMax(width, height)));
+  m_step = qMax<Coord>(1, llround(qMin(cellSize / m_resolution, span)));
+  while (cellCount(width, height, m_step) > MAX_CELLS) {
+    m_step += qMax<Coord>(1, m_step / 8);
+  }
+  if (m_step * m_resolution > cellSize * 1.001) {
+    LOG_WARNING(QString("Copper density: cell size %1 raised to %2 to stay "
+          "within %3 cells").arg(cellSize).arg(m_step * m_resolution)
+        .arg(MAX_CELLS));
+  }
+  m_cellSize = m_step * m_resolution;
+  m_originX = bounds.left;
+  m_originY = bounds.bottom;
+  m_columns = int(qMax<Coord>(1, (width + m_step - 1) / m_step));
+  m_rows = int(qMax<Coord>(1, (height + m_step - 1) / m_step));
+  m_density.fill(0, m_columns * m_rows);
+
+  // Every polygon goes to the rows its outline spans
+  QVector<IntRect> boxes(polygons.size());
+  QVector<QVector<int> > rowPolygons(m_rows);
+  for (int i = 0; i < polygons.size(); ++i) {
+    if (polygons[i].outer.size() < 3) {
+      continue;
+    }
+    boxes[i] = boundsOf(polygons[i].outer);
+    int r0 = qBound(0, int((boxes[i].bottom - m_originY) / m_step),
+        m_rows - 1);
+    int r1 = qBound(0, int((boxes[i].top - m_originY) / m_step), m_rows - 1);
+    for (int r = r0; r <= r1; ++r) {
+      rowPolygons[r].append(i);
+    }
+  }
+
+  qreal* density = m_density.data();
+  const double cellArea = double(m_step) * double(m_step);
+  Parallel::forRange(m_rows, 1, [&](int begin, int end) {
+    for (int row = begin; row < end; ++row) {
+      Coord y0 = m_originY + row * m_step;
+      qreal* cells = density + row * m_columns;
+
+      foreach (int id, rowPolygons[row]) {
+        const Polygon& polygon = polygons[id];
+        const IntRect& box = boxes[id];
+        IntRect band(box.left, y0, box.right, y0 + m_step);
+
+        // Holes are clockwise, their signed area takes itself off
+        QVector<IntPath> rings;
+        rings.append(clip(polygon.outer, band));
+        if (rings[0].size() < 3) {
+          continue;
+        }
+        for (int h = 0; h < polygon.holes.size(); ++h) {
+          IntPath ring = clip(polygon.holes[h], band);
+          if (ring.size() >= 3) {
+            rings.append(ring);
+          }
+        }
+
+        int c0 = qBound(0, int((box.left - m_originX) / m_step),
+            m_columns - 1);
+        int c1 = qBound(0, int((box.right - m_originX) / m_step),
+            m_columns - 1);
+        for (int c = c0; c <= c1; ++c) {
+          IntRect cell(m_originX + c * m_step, y0,
+              m_originX + (c + 1) * m_step, y0 + m_step);
+          double sum = 0;
+          for (int r = 0; r < rings.size(); ++r) {
+            if (c0 == c1) {
+              sum += PolygonBoolean::area(rings[r]);
+            } else {
+              sum += PolygonBoolean::area(clip(rings[r], cell));
+            }
+          }
+          cells[c] += sum;
+        }
+      }
+
+      for (int c = 0; c < m_columns; ++c) {
+        cells[c] = qBound(0.0, cells[c] / cellArea, 1.0);
+      }
+    }
+  });
+
+  LOG_INFO(QString("Copper density: %1 x %2 cells of %3, area %4")
+      .arg(m_columns).arg(m_rows).arg(m_cellSize).arg(m_area));
+}
+
+QRectF CopperDensity::rect(void) const
+{
+  qreal size = m_step * m_resolution;
+  return QRectF(m_originX * m_resolution, m_originY * m_resolution,
+      m_columns * size, m_rows * size);
+}
+
+QImage CopperDensity::heatmap(void) const
+{
+  if (m_density.isEmpty()) {
+    return QImage();
+  }
+
+  QImage image(m_columns, m_rows, QImage::Format_ARGB32);
+  image.fill(Qt::transparent);
+  for (int row = 0; row < m_rows; ++row) {
+    for (int c = 0; c < m_columns; ++c) {
+      qreal d = density(c, row);
+      if (d > 0) {
+        image.setPixelColor(c, row,
+            QColor::fromHsvF((1 - d) * 2.0 / 3.0, 1, 1, HEATMAP_ALPHA));
+      }
+    }
+  }
+  return image;
+}
+
+QJsonObject CopperDensity::toJson(void) const
+{
+  // ODB++ coordinates, y up; rows run from the top down
+  QRectF r = rect();
+  QJsonArray rows;
+  qreal sum = 0, lo = 1, hi = 0;
+  for (int row = 0; row < m_rows; ++row) {
+    QJsonArray cells;
+    for (int c = 0; c < m_columns; ++c) {
+      qreal d = density(c, row);
+      cells.append(d);
+      sum += d;
+      lo = qMin(lo, d);
+      hi = qMax(hi, d);
+    }
+    rows.append(cells);
+  }
+
+  QJsonObject obj;
+  obj["cellSize"] = m_step * m_resolution;
+  obj["left"] = r.left();
+  obj["top"] = -r.top();
+  obj["columns"] = m_columns;
+  obj["rows"] = m_rows;
+  obj["area"] = m_area;
+  if (!m_density.isEmpty()) {
+    obj["min"] = lo;
+    obj["max"] = hi;
+    obj["mean"] = sum / m_density.size();
+  }
+  obj["density"] = rows;
+  return obj;
+}
@@ -0,0 +1,81 @@
+/**
+ * @file   copperdensity.h
+ * @author Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ *
+ * Copyright (C) 2012 - 2014 Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ * All Rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __COPPERDENSITY_H__
+#define __COPPERDENSITY_H__
+
+#include <QImage>
+#include <QJsonObject>
+#include <QRectF>
+#include <QVector>
+
+class LayerCopper;
+
+/**
+ * Copper coverage of a layer on a regular grid, for plating balance and
+ * warpage checks.
+ *
+ * The polygons of LayerCopper are integrated exactly: every polygon is
+ * clipped to the row bands it spans and then to the cells of the band, and
+ * the signed areas of the pieces are summed, so holes subtract themselves.
+ * Rows are processed in parallel.  The grid starts at the left top corner
+ * of the copper bounds in scene coordinates, row 0 at the top; cells past
+ * the copper on the right and bottom edges are still counted at full size.
+ * The grid is capped at about a million cells: a cell size too small for
+ * the board is enlarged, and cellSize() reports the size actually used.
+ */
+class CopperDensity {
+public:
+  CopperDensity(LayerCopper* copper, qreal cellSize);
+
+  int columns(void) const { return m_columns; }
+  int rows(void) const { return m_rows; }
+  qreal cellSize(void) const { return m_cellSize; }
+
+  /* Scene area covered by the grid */
+  QRectF rect(void) const;
+
+  /* Total copper area in square layer units */
+  qreal area(void) const { return m_area; }
+
+  /* Copper fraction of a cell, 0 to 1 */
+  qreal density(int column, int row) const {
+    return m_density[row * m_columns + column];
+  }
+  const QVector<qreal>& densities(void) const { return m_density; }
+
+  /* One pixel per cell, blue for bare through red for full copper */
+  QImage heatmap(void) const;
+
+  QJsonObject toJson(void) const;
+
+private:
+  qreal m_cellSize;
+  qreal m_resolution;
+  qint64 m_originX, m_originY;  /* left top corner on the copper grid */
+  qint64 m_step;                /* cell size on the copper grid */
+  int m_columns, m_rows;
+  QVector<qreal> m_density;
+  qreal m_area;
+};
+
+#endif /* __COPPERDENSITY_H__ */
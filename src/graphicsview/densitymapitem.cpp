@@ -0,0 +1,49 @@
+/**
+ * @file   densitymapitem.cpp
+ * @author Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ *
+ * Copyright (C) 2012 - 2014 Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ * All Rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "densitymapitem.h"
+
+#include <QtWidgets>
+
+#include "copperdensity.h"
+
+/* Above every layer and the profile */
+#define DENSITY_MAP_Z 1000
+
+DensityMapItem::DensityMapItem(const CopperDensity& density):
+  m_rect(density.rect()), m_image(density.heatmap())
+{
+  setZValue(DENSITY_MAP_Z);
+}
+
+QRectF DensityMapItem::boundingRect() const
+{
+  return m_rect;
+}
+
+void DensityMapItem::paint(QPainter *painter,
+    const QStyleOptionGraphicsItem *, QWidget *)
+{
+  // Cells stay sharp however far the view zooms in
+  painter->setRenderHint(QPainter::SmoothPixmapTransform, false);
+  painter->drawImage(m_rect, m_image);
+}
@@ -0,0 +1,48 @@
+/**
+ * @file   densitymapitem.h
+ * @author Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ *
+ * Copyright (C) 2012 - 2014 Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ * All Rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __DENSITYMAPITEM_H__
+#define __DENSITYMAPITEM_H__
+
+#include <QGraphicsItem>
+#include <QImage>
+
+class CopperDensity;
+
+/**
+ * Heatmap of a CopperDensity grid drawn over the layers: the one pixel per
+ * cell image stretched over the grid area.
+ */
+class DensityMapItem: public QGraphicsItem {
+public:
+  DensityMapItem(const CopperDensity& density);
+
+  virtual QRectF boundingRect() const;
+  virtual void paint(QPainter *painter, const QStyleOptionGraphicsItem *option,
+      QWidget *widget);
+
+private:
+  QRectF m_rect;
+  QImage m_image;
+};
+
+#endif /* __DENSITYMAPITEM_H__ */
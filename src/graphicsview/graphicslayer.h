@@ -40,6 +40,8 @@ public:
 
   void setViewRect(const QRect& rect);
   void setSceneRect(const QRectF& rect);
+  QRect viewRect(void) const { return m_viewRect; }
+  QRectF sceneRect(void) const { return m_sceneRect; }
   void setShowOutline(bool status);
   virtual void setPen(const QPen& pen);
   virtual void setBrush(const QBrush& brush);
@@ -23,7 +23,9 @@
 #include "graphicslayerscene.h"
 #include "graphicslayer.h"
 #include "layer.h"  // ADD THIS: Need Layer class for layer()
+#include "layergeometry.h"
 #include "context.h"
+#include "tracewidthclassifier.h"
 
 #include <QtWidgets>
 #include <QSet>
@@ -155,6 +157,90 @@ void GraphicsLayerScene::selectConnectedSymbols(Symbol* startSymbol)
   }
 }
 
+// Selection behaviour of a click on symbol, ctrl selects the connected group
+void GraphicsLayerScene::pickSymbol(Symbol* symbol,
+    Qt::KeyboardModifiers modifiers)
+{
+  if (!symbol || !m_highlight) {
+    return;
+  }
+
+  if (modifiers & Qt::ControlModifier) {
+    selectConnectedSymbols(symbol);
+  } else {
+    if (!symbol->isSelected()) {
+      symbol->setSelected(true);
+      symbol->savePrevColor();
+
+      // UPDATED: Use dynamic highlight color from context
+      QColor highlightColor = ctx.highlight_color;
+      symbol->setPen(QPen(highlightColor, 0));
+      symbol->setBrush(highlightColor);
+      symbol->update();
+    }
+    toggleSelection(symbol);
+  }
+}
+
+// Topmost feature under scenePos, looked up in the pick buffer of the
+// current view
+Symbol* GraphicsLayerScene::symbolAt(const QPointF& scenePos)
+{
+  if (!updatePickBuffer()) {
+    return NULL;
+  }
+
+  const PickBuffer::Entry* entry = m_pickBuffer.atScene(scenePos);
+  return entry? entry->symbol: NULL;
+}
+
+void GraphicsLayerScene::invalidatePickBuffer(void)
+{
+  m_pickBuffer.clear();
+}
+
+void GraphicsLayerScene::forgetSymbols(const QSet<Symbol*>& symbols)
+{
+  for (int i = m_selectedSymbols.size() - 1; i >= 0; --i) {
+    if (symbols.contains(m_selectedSymbols[i])) {
+      m_selectedSymbols.removeAt(i);
+    }
+  }
+  m_pickBuffer.clear();
+}
+
+bool GraphicsLayerScene::updatePickBuffer(void)
+{
+  Layer* layer = dynamic_cast<Layer*>(m_graphicsLayer);
+  if (!layer) {
+    return false;
+  }
+
+  QSize size = layer->viewRect().size();
+  QRectF rect = layer->sceneRect();
+  if (size.isEmpty() || rect.isEmpty()) {
+    return false;
+  }
+
+  if (!m_pickBuffer.isValidFor(size, rect)) {
+    m_pickBuffer.render(QList<Layer*>() << layer, size, rect);
+  }
+  return true;
+}
+
+void GraphicsLayerScene::mousePressEvent(QGraphicsSceneMouseEvent* event)
+{
+  // Hit-test through the pick buffer instead of testing the shape of every
+  // item in the scene
+  if (m_highlight && updatePickBuffer()) {
+    pickSymbol(symbolAt(event->scenePos()), event->modifiers());
+    event->accept();
+    return;
+  }
+
+  QGraphicsScene::mousePressEvent(event);
+}
+
 // UNCHANGED: Recursive flood-fill to find all connected symbols
 void GraphicsLayerScene::findConnectedSymbols(Symbol* symbol, QSet<Symbol*>& visited, qreal tolerance)
 {
@@ -202,110 +288,186 @@ bool GraphicsLayerScene::areSymbolsConnected(Symbol* sym1, Symbol* sym2, qreal t
   return shape1.intersects(shape2);
 }
 
-// UPDATED: Select all traces with width <= maxWidth
-void GraphicsLayerScene::selectTracesByWidth(qreal maxWidth)
+// Select every line, arc and trace-like surface with width <= maxWidth,
+// together with the net it is part of
+int GraphicsLayerScene::selectTracesByWidth(qreal maxWidth)
 {
-  QSet<Symbol*> alreadyProcessed;
-  for (Symbol* sym : m_selectedSymbols) {
-    alreadyProcessed.insert(sym);
+  QColor highlightColor = ctx.highlight_color;
+  int count = 0;
+  QSet<Symbol*> selected(m_selectedSymbols.begin(), m_selectedSymbols.end());
+
+  Layer* layer = dynamic_cast<Layer*>(m_graphicsLayer);
+  if (!layer || !layer->features()) {
+    return 0;
   }
-  
-  QList<QGraphicsItem*> allItems = items();
-  
-  int selectedCount = 0;
-  int totalSurfaceCount = 0;
-  int traceCount = 0;
-  int groupCount = 0;
-  
-  qDebug() << "=== Select Traces by Width (with Connected Symbols) ===";
-  qDebug() << "Max width threshold:" << maxWidth << "inches (" << (maxWidth * 25.4) << "mm)";
-  
-  QList<Symbol*> matchingTraces;
-  
-  for (QGraphicsItem* item : allItems) {
-    Symbol* symbol = dynamic_cast<Symbol*>(item);
-    
-    if (!symbol) {
-      continue;
-    }
-    
-    if (symbol->name() != "Surface") {
+
+  // Nets come from the layer's spatial index and union-find, built once
+  LayerGeometry* geometry = layer->geometry();
+  QSet<int> nets;
+
+  QList<LayerFeatures*> features = layer->allFeatures();
+  for (int i = 0; i < features.size(); ++i) {
+    TraceWidthClassifier* classifier =
+      TraceWidthClassifier::forDataStore(features[i]->dataStore());
+    if (!classifier) {
       continue;
     }
-    
-    totalSurfaceCount++;
-    
-    if (!symbol->isTrace()) {
-      continue;
+
+    QVector<int> traces = classifier->traces(maxWidth);
+    for (int j = 0; j < traces.size(); ++j) {
+      Symbol* symbol = features[i]->symbolAt(traces[j]);
+      if (!symbol || selected.contains(symbol)) {
+        continue;
+      }
+
+      int net = geometry->netOf(geometry->indexOf(symbol));
+      QList<Symbol*> group;
+      if (net < 0) {
+        group.append(symbol);
+      } else if (!nets.contains(net)) {
+        nets.insert(net);
+        QVector<int> members = geometry->netMembers(net);
+        for (int k = 0; k < members.size(); ++k) {
+          group.append(geometry->feature(members[k]).symbol);
+        }
+      }
+
+      foreach (Symbol* member, group) {
+        if (member && !selected.contains(member)) {
+          selected.insert(member);
+          highlightSymbol(member, highlightColor);
+          ++count;
+        }
+      }
     }
-    
-    traceCount++;
-    
-    qreal width = symbol->getWidth();
-    
-    if (width < 0) {
-      qDebug() << "Warning: Symbol has invalid width:" << width;
+  }
+
+  if (m_graphicsLayer) {
+    m_graphicsLayer->forceUpdate();
+  }
+
+  return count;
+}
+
+// Colour every trace by its width class: class i covers widths in
+// (thresholds[i-1], thresholds[i]] and is drawn with colors[i]
+int GraphicsLayerScene::showTraceWidthClasses(const QList<qreal>& thresholds,
+    const QList<QColor>& colors)
+{
+  int count = 0;
+  QSet<Symbol*> selected(m_selectedSymbols.begin(), m_selectedSymbols.end());
+
+  QList<LayerFeatures*> features = layerFeatures();
+  for (int i = 0; i < features.size(); ++i) {
+    TraceWidthClassifier* classifier =
+      TraceWidthClassifier::forDataStore(features[i]->dataStore());
+    if (!classifier) {
       continue;
     }
-    
-    if (width <= maxWidth) {
-      matchingTraces.append(symbol);
-      selectedCount++;
-      
-      if (selectedCount <= 5) {
-        qDebug() << "  Found trace:" << selectedCount 
-                 << "width =" << width << "inches (" << (width * 25.4) << "mm)";
+
+    QVector<int> classes = classifier->classify(thresholds);
+    for (int j = 0; j < classes.size(); ++j) {
+      int c = classes[j];
+      if (c < 0 || c >= colors.size()) {
+        continue;
+      }
+      Symbol* symbol = features[i]->symbolAt(j);
+      if (symbol && !selected.contains(symbol)) {
+        selected.insert(symbol);
+        highlightSymbol(symbol, colors[c]);
+        ++count;
       }
     }
   }
-  
-  qDebug() << "Found" << matchingTraces.size() << "traces matching criteria";
-  
-  // UPDATED: Use dynamic highlight color from context
-  QColor highlightColor = ctx.highlight_color;
-  
-  for (Symbol* trace : matchingTraces) {
-    if (alreadyProcessed.contains(trace)) {
-      continue;
-    }
-    
-    QSet<Symbol*> connectedSymbols;
-    findConnectedSymbols(trace, connectedSymbols);
-    
-    groupCount++;
-    
-    if (groupCount <= 3) {
-      qDebug() << "  Group" << groupCount << ":" << connectedSymbols.size() << "connected symbols";
+
+  if (m_graphicsLayer) {
+    m_graphicsLayer->forceUpdate();
+  }
+
+  return count;
+}
+
+int GraphicsLayerScene::highlightSymbols(const QList<Symbol*>& symbols,
+    const QColor& color)
+{
+  int count = 0;
+  QSet<Symbol*> selected(m_selectedSymbols.begin(), m_selectedSymbols.end());
+
+  for (int i = 0; i < symbols.size(); ++i) {
+    Symbol* symbol = symbols[i];
+    if (symbol && !selected.contains(symbol)) {
+      selected.insert(symbol);
+      highlightSymbol(symbol, color);
+      ++count;
     }
-    
-    // Highlight entire connected group with dynamic color
-    for (Symbol* sym : connectedSymbols) {
-      if (!m_selectedSymbols.contains(sym)) {
-        sym->setSelected(true);
-        sym->savePrevColor();
-        
-        // Use dynamic highlight color
-        sym->setPen(QPen(highlightColor, 0));
-        sym->setBrush(highlightColor);
-        sym->update();
-        
-        m_selectedSymbols.append(sym);
-        alreadyProcessed.insert(sym);
+  }
+
+  if (m_graphicsLayer) {
+    m_graphicsLayer->forceUpdate();
+  }
+
+  return count;
+}
+
+GraphicsLayerScene::HighlightState GraphicsLayerScene::saveHighlights(
+    void) const
+{
+  HighlightState state;
+  if (m_selectedSymbols.isEmpty()) {
+    return state;
+  }
+
+  QSet<Symbol*> selected(m_selectedSymbols.begin(), m_selectedSymbols.end());
+  QList<LayerFeatures*> features = layerFeatures();
+  for (int i = 0; i < features.size(); ++i) {
+    FeaturesDataStore* ds = features[i]->dataStore();
+    int count = ds? ds->records().size(): 0;
+    for (int j = 0; j < count; ++j) {
+      Symbol* symbol = features[i]->symbolAt(j);
+      if (symbol && selected.contains(symbol)) {
+        state.insert(qMakePair(i, j), symbol->brush().color());
       }
     }
   }
-  
+  return state;
+}
+
+void GraphicsLayerScene::restoreHighlights(const HighlightState& state)
+{
+  QSet<Symbol*> selected(m_selectedSymbols.begin(), m_selectedSymbols.end());
+  QList<LayerFeatures*> features = layerFeatures();
+  for (HighlightState::const_iterator it = state.begin(); it != state.end();
+      ++it) {
+    LayerFeatures* lf = features.value(it.key().first);
+    Symbol* symbol = lf? lf->symbolAt(it.key().second): NULL;
+    if (symbol && !selected.contains(symbol)) {
+      selected.insert(symbol);
+      highlightSymbol(symbol, it.value());
+    }
+  }
+
   if (m_graphicsLayer) {
     m_graphicsLayer->forceUpdate();
   }
-  
-  qDebug() << "=== Summary ===";
-  qDebug() << "Total surface symbols:" << totalSurfaceCount;
-  qDebug() << "Trace-like surfaces:" << traceCount;
-  qDebug() << "Matching traces (width <=" << maxWidth << "):" << selectedCount;
-  qDebug() << "Connected groups:" << groupCount;
-  qDebug() << "Total selected symbols:" << m_selectedSymbols.size();
-  qDebug() << "";
+}
+
+QList<LayerFeatures*> GraphicsLayerScene::layerFeatures(void) const
+{
+  Layer* layer = dynamic_cast<Layer*>(m_graphicsLayer);
+  if (!layer || !layer->features()) {
+    return QList<LayerFeatures*>();
+  }
+  return layer->allFeatures();
+}
+
+void GraphicsLayerScene::highlightSymbol(Symbol* symbol, const QColor& color)
+{
+  symbol->setSelected(true);
+  symbol->savePrevColor();
+  symbol->setPen(QPen(color, 0));
+  symbol->setBrush(color);
+  symbol->update();
+  m_selectedSymbols.append(symbol);
 }
 
 // FIXED: Get layer name helper method
@@ -23,15 +23,20 @@
 #ifndef __GRAPHICSLAYERSCENE__
 #define __GRAPHICSLAYERSCENE__
 
+#include <QColor>
 #include <QGraphicsScene>
+#include <QHash>
 #include <QList>
+#include <QPair>
 #include <QSet>
 #include <QJsonObject>
 #include <QJsonArray>
 
+#include "pickbuffer.h"
 #include "symbol.h"
 
 class GraphicsLayer;
+class LayerFeatures;
 
 class GraphicsLayerScene: public QGraphicsScene {
   Q_OBJECT
@@ -48,6 +53,13 @@ public:
   void updateSelection(Symbol* symbol);
   void toggleSelection(Symbol* symbol);
   void selectConnectedSymbols(Symbol* startSymbol);
+  void pickSymbol(Symbol* symbol, Qt::KeyboardModifiers modifiers);
+
+  Symbol* symbolAt(const QPointF& scenePos);
+  void invalidatePickBuffer(void);
+
+  /* Drop symbols that are about to be deleted from the selection */
+  void forgetSymbols(const QSet<Symbol*>& symbols);
 
   // NEW: Save/Load highlight data
   QJsonObject exportHighlightData() const;
@@ -56,18 +68,36 @@ public:
   // NEW: Get layer name for export
   QString getLayerName() const;
   
-  void selectTracesByWidth(qreal maxWidth);
-  void selectTracesR1() { selectTracesByWidth(0.015); }
-  void selectTracesR2() { selectTracesByWidth(0.020); }
-  void selectTracesR3() { selectTracesByWidth(0.025); }
+  // Trace width classes, see TraceWidthClassifier
+  int selectTracesByWidth(qreal maxWidth);
+  int selectTracesR1() { return selectTracesByWidth(0.015); }
+  int selectTracesR2() { return selectTracesByWidth(0.020); }
+  int selectTracesR3() { return selectTracesByWidth(0.025); }
+  int showTraceWidthClasses(const QList<qreal>& thresholds,
+      const QList<QColor>& colors);
+
+  /* Add symbols to the selection in color, returns how many were added */
+  int highlightSymbols(const QList<Symbol*>& symbols, const QColor& color);
+
+  /* Selection by (features, record) index, kept across a layer reload */
+  typedef QHash<QPair<int, int>, QColor> HighlightState;
+  HighlightState saveHighlights(void) const;
+  void restoreHighlights(const HighlightState& state);
 
 signals:
   void featureSelected(Symbol*);
 
+protected:
+  virtual void mousePressEvent(QGraphicsSceneMouseEvent* event);
+
 private:
   void findConnectedSymbols(Symbol* symbol, QSet<Symbol*>& visited, qreal tolerance = 0.001);
   bool areSymbolsConnected(Symbol* sym1, Symbol* sym2, qreal tolerance = 0.001);
 
+  QList<LayerFeatures*> layerFeatures(void) const;
+  bool updatePickBuffer(void);
+  void highlightSymbol(Symbol* symbol, const QColor& color);
+
   // Helper: Get unique identifier for a symbol
   QString getSymbolIdentifier(Symbol* symbol) const;
   Symbol* findSymbolByIdentifier(const QString& identifier) const;
@@ -75,6 +105,7 @@ private:
   GraphicsLayer* m_graphicsLayer;
   bool m_highlight;
   QList<Symbol*> m_selectedSymbols;
+  PickBuffer m_pickBuffer;
 };
 
 #endif /* __GRAPHICSLAYERSCENE__ */
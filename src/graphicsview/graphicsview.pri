@@ -1,23 +1,37 @@
 HEADERS += \
+  graphicsview/copperdensity.h \
+  graphicsview/densitymapitem.h \
   graphicsview/graphicslayer.h \
   graphicsview/graphicslayerscene.h \
   graphicsview/layerfeatures.h \
   graphicsview/layer.h \
+  graphicsview/layercopper.h \
+  graphicsview/layergeometry.h \
   graphicsview/measuregraphicsitem.h \
   graphicsview/notes.h \
   graphicsview/odbppgraphicsminimapview.h \
   graphicsview/odbppgraphicsscene.h \
   graphicsview/odbppgraphicsview.h \
-  graphicsview/profile.h
+  graphicsview/pickbuffer.h \
+  graphicsview/polygonexporter.h \
+  graphicsview/profile.h \
+  graphicsview/spacingchecker.h
 
 SOURCES += \
+  graphicsview/copperdensity.cpp \
+  graphicsview/densitymapitem.cpp \
   graphicsview/graphicslayer.cpp \
   graphicsview/graphicslayerscene.cpp \
   graphicsview/layer.cpp \
+  graphicsview/layercopper.cpp \
   graphicsview/layerfeatures.cpp \
+  graphicsview/layergeometry.cpp \
   graphicsview/measuregraphicsitem.cpp \
   graphicsview/notes.cpp \
   graphicsview/odbppgraphicsminimapview.cpp \
   graphicsview/odbppgraphicsscene.cpp \
   graphicsview/odbppgraphicsview.cpp \
-  graphicsview/profile.cpp
+  graphicsview/pickbuffer.cpp \
+  graphicsview/polygonexporter.cpp \
+  graphicsview/profile.cpp \
+  graphicsview/spacingchecker.cpp
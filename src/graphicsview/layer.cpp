@@ -25,10 +25,13 @@
 #include <QtWidgets>
 
 #include "context.h"
+#include "layercopper.h"
+#include "layergeometry.h"
 #include "odbppgraphicsscene.h"
 
 Layer::Layer(QString step, QString layer):
-  GraphicsLayer(NULL), m_step(step), m_layer(layer), m_notes(NULL)
+  GraphicsLayer(NULL), m_step(step), m_layer(layer), m_notes(NULL),
+  m_geometry(NULL), m_copper(NULL)
 {
   GraphicsLayerScene* scene = new GraphicsLayerScene;
   m_features = new LayerFeatures(step, "steps/%1/layers/" +layer +"/features");
@@ -41,6 +44,8 @@ Layer::~Layer()
   if (m_notes) {
     delete m_notes;
   }
+  delete m_copper;
+  delete m_geometry;
   delete m_features;
 }
 
@@ -62,6 +67,33 @@ Notes* Layer::notes()
   return m_notes;
 }
 
+QList<LayerFeatures*> Layer::allFeatures(void)
+{
+  // Step-and-repeat children carry their own data stores
+  QList<LayerFeatures*> result;
+  result.append(m_features);
+  for (int i = 0; i < result.size(); ++i) {
+    result.append(result[i]->repeats());
+  }
+  return result;
+}
+
+LayerGeometry* Layer::geometry(void)
+{
+  if (!m_geometry) {
+    m_geometry = new LayerGeometry(this);
+  }
+  return m_geometry;
+}
+
+LayerCopper* Layer::copper(void)
+{
+  if (!m_copper) {
+    m_copper = new LayerCopper(geometry());
+  }
+  return m_copper;
+}
+
 QStandardItemModel* Layer::reportModel(void)
 {
   return m_features->reportModel();
@@ -75,6 +107,54 @@ void Layer::setHighlightEnabled(bool status)
 void Layer::setShowStepRepeat(bool status)
 {
   m_features->setShowStepRepeat(status);
+  m_layerScene->invalidatePickBuffer();
+
+  // Feature numbering depends on which repeats are visible
+  delete m_copper;
+  m_copper = NULL;
+  delete m_geometry;
+  m_geometry = NULL;
+
+  forceUpdate();
+}
+
+void Layer::reloadFeatures(FeaturesDataStore* oldDs,
+    FeaturesDataStore* newDs, const FeaturesDiff& diff)
+{
+  if (!m_features->uses(oldDs)) {
+    return;
+  }
+
+  QList<Symbol*> removed;
+  if (m_features->dataStore() == oldDs) {
+    removed = m_features->reload(newDs, diff);
+  }
+  // Repeated copies carry their placement in every symbol transform, so
+  // those are rebuilt instead of patched
+  if (m_features->uses(oldDs)) {
+    removed.append(m_features->reloadStepAndRepeat());
+  }
+  discardSymbols(removed);
+}
+
+void Layer::reloadStepAndRepeat(const QString& step)
+{
+  if (m_features->usesStep(step)) {
+    discardSymbols(m_features->reloadStepAndRepeat());
+  }
+}
+
+void Layer::discardSymbols(const QList<Symbol*>& symbols)
+{
+  m_layerScene->forgetSymbols(QSet<Symbol*>(symbols.begin(), symbols.end()));
+  qDeleteAll(symbols);
+
+  // Feature numbering changed
+  delete m_copper;
+  m_copper = NULL;
+  delete m_geometry;
+  m_geometry = NULL;
+
   forceUpdate();
 }
 
@@ -32,6 +32,9 @@
 #include "symbol.h"
 #include <QTextEdit>
 
+class LayerCopper;
+class LayerGeometry;
+
 class Layer: public GraphicsLayer {
 public:
   Layer(QString step, QString layer);
@@ -40,11 +43,21 @@ public:
   QString step();
   QString layer();
   Notes* notes();
+  LayerFeatures* features(void) { return m_features; }
+  QList<LayerFeatures*> allFeatures(void);
+  LayerGeometry* geometry(void);
+  LayerCopper* copper(void);
   QStandardItemModel* reportModel(void);
 
   void setHighlightEnabled(bool status);
   void setShowStepRepeat(bool status);
 
+  /* A features file this layer reads was re-parsed from oldDs to newDs */
+  void reloadFeatures(FeaturesDataStore* oldDs, FeaturesDataStore* newDs,
+      const FeaturesDiff& diff);
+  /* The step header of step changed */
+  void reloadStepAndRepeat(const QString& step);
+
   virtual void setPen(const QPen& pen);
   virtual void setBrush(const QBrush& brush);
 
@@ -52,11 +65,16 @@ protected:
   virtual void mousePressEvent(QGraphicsSceneMouseEvent* event);
   virtual void mouseDoubleClickEvent(QGraphicsSceneMouseEvent* event);
 
+private:
+  void discardSymbols(const QList<Symbol*>& symbols);
+
 private:
   LayerFeatures* m_features;
   QString m_step;
   QString m_layer;
   Notes* m_notes;
+  LayerGeometry* m_geometry;
+  LayerCopper* m_copper;
 };
 
 #endif /* __LAYER_H__ */
@@ -0,0 +1,331 @@
+/**
+ * @file   layercopper.cpp
+ * @author Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ *
+ * Copyright (C) 2012 - 2014 Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ * All Rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "layercopper.h"
+
+#include <algorithm>
+
+#include <QHash>
+#include <QtCore/qmath.h>
+
+#include "layergeometry.h"
+#include "logger.h"
+#include "parallel.h"
+
+using namespace PolygonBoolean;
+
+/* Features per tile the grid is sized for */
+#define TILE_FEATURES 1024
+
+LayerCopper::LayerCopper(LayerGeometry* geometry, qreal resolution,
+    qreal tolerance):
+  m_geometry(geometry), m_scale(1.0 / resolution), m_tolerance(tolerance),
+  m_built(false), m_area(0), m_pathBuilt(false), m_islandsBuilt(false),
+  m_islandCount(0)
+{
+  QRectF bounds = geometry->boundingRect();
+  if (geometry->count() == 0 || bounds.isNull()) {
+    return;
+  }
+
+  int tiles = qMax(1, geometry->count() / TILE_FEATURES);
+  qreal aspect = (bounds.height() > 0)? bounds.width() / bounds.height(): 1;
+  int nx = qBound(1, qCeil(qSqrt(tiles * aspect)), tiles);
+  int ny = qMax(1, (tiles + nx - 1) / nx);
+
+  // Grid lines on the integer grid, shared by neighbouring tiles, with a
+  // margin so outlines on the layer bounds are never clipped
+  QVector<Coord> xs(nx + 1), ys(ny + 1);
+  for (int i = 0; i <= nx; ++i) {
+    xs[i] = llround((bounds.left() + bounds.width() * i / nx) * m_scale);
+  }
+  for (int j = 0; j <= ny; ++j) {
+    ys[j] = llround((bounds.top() + bounds.height() * j / ny) * m_scale);
+  }
+  xs[0] -= 1;
+  ys[0] -= 1;
+  xs[nx] += 1;
+  ys[ny] += 1;
+
+  for (int j = 0; j < ny; ++j) {
+    for (int i = 0; i < nx; ++i) {
+      IntRect r(xs[i], ys[j], xs[i + 1], ys[j + 1]);
+      m_intTiles.append(r);
+      m_tiles.append(QRectF(r.left / m_scale, r.bottom / m_scale,
+            (r.right - r.left) / m_scale, (r.top - r.bottom) / m_scale));
+    }
+  }
+}
+
+void LayerCopper::build(void)
+{
+  if (m_built) {
+    return;
+  }
+
+  int count = m_geometry->count();
+
+  // Negative features only erase copper of their own features file, which
+  // keeps step-repeat instances from cutting into each other
+  QHash<LayerFeatures*, int> groupIds;
+  QVector<int> groups(count);
+  for (int i = 0; i < count; ++i) {
+    LayerFeatures* features = m_geometry->feature(i).features;
+    if (!groupIds.contains(features)) {
+      groupIds.insert(features, groupIds.size());
+    }
+    groups[i] = groupIds.value(features);
+  }
+
+  // Outlines on the integer grid, once per feature
+  QVector<QVector<IntPath> > rings(count);
+  QVector<IntPath>* ringData = rings.data();
+  Parallel::forRange(count, 256, [&](int begin, int end) {
+    for (int i = begin; i < end; ++i) {
+      QList<QPolygonF> polygons = m_geometry->shape(i).toPolygons(m_tolerance);
+      for (int p = 0; p < polygons.size(); ++p) {
+        IntPath path = toIntPath(polygons[p], m_scale);
+        if (path.size() >= 3) {
+          ringData[i].append(path);
+        }
+      }
+    }
+  });
+
+  QVector<QVector<PolygonBoolean::Polygon> > results(m_tiles.size());
+  QVector<PolygonBoolean::Polygon>* resultData = results.data();
+  Parallel::forRange(m_tiles.size(), 1, [&](int begin, int end) {
+    for (int t = begin; t < end; ++t) {
+      QVector<int> ids = m_geometry->query(m_tiles[t]);
+      std::sort(ids.begin(), ids.end());
+
+      // Feature order is drawing order, later subjects are on top
+      QVector<Subject> subjects;
+      for (int k = 0; k < ids.size(); ++k) {
+        int id = ids[k];
+        Subject subject;
+        subject.group = groups[id];
+        subject.positive = m_geometry->feature(id).positive;
+        for (int r = 0; r < rings[id].size(); ++r) {
+          IntPath clipped = clip(rings[id][r], m_intTiles[t]);
+          if (!clipped.isEmpty()) {
+            subject.rings.append(clipped);
+          }
+        }
+        if (!subject.rings.isEmpty()) {
+          subjects.append(subject);
+        }
+      }
+
+      resultData[t] = flatten(subjects);
+    }
+  });
+
+  double area = 0;
+  for (int t = 0; t < results.size(); ++t) {
+    for (int p = 0; p < results[t].size(); ++p) {
+      const PolygonBoolean::Polygon& src = results[t][p];
+      Polygon polygon;
+      polygon.outer = toPolygonF(src.outer, m_scale);
+      for (int h = 0; h < src.holes.size(); ++h) {
+        polygon.holes.append(toPolygonF(src.holes[h], m_scale));
+      }
+      polygon.tile = t;
+
+      area += PolygonBoolean::area(src);
+      m_intPolygons.append(src);
+      m_polygons.append(polygon);
+    }
+  }
+
+  m_area = area / (m_scale * m_scale);
+  m_built = true;
+
+  LOG_INFO(QString("Layer copper: %1 polygons over %2 tiles, area %3")
+      .arg(m_polygons.size()).arg(m_tiles.size()).arg(m_area));
+}
+
+const QVector<LayerCopper::Polygon>& LayerCopper::polygons(void)
+{
+  QMutexLocker locker(&m_mutex);
+  build();
+  return m_polygons;
+}
+
+const QVector<PolygonBoolean::Polygon>& LayerCopper::intPolygons(void)
+{
+  QMutexLocker locker(&m_mutex);
+  build();
+  return m_intPolygons;
+}
+
+qreal LayerCopper::area(void)
+{
+  QMutexLocker locker(&m_mutex);
+  build();
+  return m_area;
+}
+
+QPainterPath LayerCopper::path(void)
+{
+  QMutexLocker locker(&m_mutex);
+  build();
+
+  if (!m_pathBuilt) {
+    m_path = QPainterPath();
+    m_path.setFillRule(Qt::OddEvenFill);
+    for (int i = 0; i < m_polygons.size(); ++i) {
+      m_path.addPolygon(m_polygons[i].outer);
+      m_path.closeSubpath();
+      for (int h = 0; h < m_polygons[i].holes.size(); ++h) {
+        m_path.addPolygon(m_polygons[i].holes[h]);
+        m_path.closeSubpath();
+      }
+    }
+    m_pathBuilt = true;
+  }
+
+  return m_path;
+}
+
+static int findRoot(QVector<int>& parent, int i)
+{
+  while (parent[i] != i) {
+    parent[i] = parent[parent[i]];
+    i = parent[i];
+  }
+  return i;
+}
+
+/* Edge of a polygon lying on a tile grid line */
+struct BorderRun {
+  bool vertical;
+  Coord line;
+  Coord lo, hi;
+  int polygon;
+
+  bool operator<(const BorderRun& o) const {
+    if (vertical != o.vertical) {
+      return vertical < o.vertical;
+    }
+    return (line != o.line)? line < o.line: lo < o.lo;
+  }
+};
+
+void LayerCopper::buildIslands(void)
+{
+  QVector<Coord> xs, ys;
+  for (int t = 0; t < m_intTiles.size(); ++t) {
+    xs << m_intTiles[t].left << m_intTiles[t].right;
+    ys << m_intTiles[t].bottom << m_intTiles[t].top;
+  }
+  std::sort(xs.begin(), xs.end());
+  xs.erase(std::unique(xs.begin(), xs.end()), xs.end());
+  std::sort(ys.begin(), ys.end());
+  ys.erase(std::unique(ys.begin(), ys.end()), ys.end());
+
+  // Polygons of neighbouring tiles touch when they share a stretch of the
+  // grid line between them
+  QVector<BorderRun> runs;
+  for (int p = 0; p < m_intPolygons.size(); ++p) {
+    QVector<IntPath> rings = m_intPolygons[p].holes;
+    rings.prepend(m_intPolygons[p].outer);
+    for (int r = 0; r < rings.size(); ++r) {
+      const IntPath& ring = rings[r];
+      for (int i = 0; i < ring.size(); ++i) {
+        const IntPoint& a = ring[i];
+        const IntPoint& b = ring[(i + 1) % ring.size()];
+        BorderRun run;
+        run.polygon = p;
+        if (a.x == b.x && std::binary_search(xs.begin(), xs.end(), a.x)) {
+          run.vertical = true;
+          run.line = a.x;
+          run.lo = qMin(a.y, b.y);
+          run.hi = qMax(a.y, b.y);
+        } else if (a.y == b.y &&
+            std::binary_search(ys.begin(), ys.end(), a.y)) {
+          run.vertical = false;
+          run.line = a.y;
+          run.lo = qMin(a.x, b.x);
+          run.hi = qMax(a.x, b.x);
+        } else {
+          continue;
+        }
+        runs.append(run);
+      }
+    }
+  }
+  std::sort(runs.begin(), runs.end());
+
+  QVector<int> parent(m_intPolygons.size());
+  for (int i = 0; i < parent.size(); ++i) {
+    parent[i] = i;
+  }
+
+  // Overlapping stretches on a line form chains; join each run to the one
+  // reaching furthest so far
+  for (int i = 0, reach = -1; i < runs.size(); ++i) {
+    const BorderRun& run = runs[i];
+    bool sameLine = (reach >= 0 && runs[reach].vertical == run.vertical &&
+        runs[reach].line == run.line);
+    if (sameLine && run.lo < runs[reach].hi) {
+      int a = findRoot(parent, run.polygon);
+      int b = findRoot(parent, runs[reach].polygon);
+      if (a != b) {
+        parent[qMax(a, b)] = qMin(a, b);
+      }
+      if (run.hi > runs[reach].hi) {
+        reach = i;
+      }
+    } else {
+      reach = i;
+    }
+  }
+
+  QHash<int, int> ids;
+  m_islands.resize(parent.size());
+  for (int i = 0; i < parent.size(); ++i) {
+    int root = findRoot(parent, i);
+    if (!ids.contains(root)) {
+      ids.insert(root, ids.size());
+    }
+    m_islands[i] = ids.value(root);
+  }
+  m_islandCount = ids.size();
+  m_islandsBuilt = true;
+}
+
+const QVector<int>& LayerCopper::islands(void)
+{
+  QMutexLocker locker(&m_mutex);
+  build();
+  if (!m_islandsBuilt) {
+    buildIslands();
+  }
+  return m_islands;
+}
+
+int LayerCopper::islandCount(void)
+{
+  islands();
+  return m_islandCount;
+}
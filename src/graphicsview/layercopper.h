@@ -0,0 +1,107 @@
+/**
+ * @file   layercopper.h
+ * @author Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ *
+ * Copyright (C) 2012 - 2014 Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ * All Rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __LAYERCOPPER_H__
+#define __LAYERCOPPER_H__
+
+#include <QList>
+#include <QMutex>
+#include <QPainterPath>
+#include <QPolygonF>
+#include <QRectF>
+#include <QVector>
+
+#include "arcgeometry.h"
+#include "polygonboolean.h"
+
+class LayerGeometry;
+
+/**
+ * Final copper of a layer: the ordered positive and negative features of
+ * LayerGeometry resolved by PolygonBoolean into polygons with holes.
+ *
+ * The layer is cut into tiles which are flattened independently and in
+ * parallel, so polygons are split along tile borders; islands() stitches
+ * them back together for connectivity.  Results are computed on first use
+ * and kept until the object is deleted.  Coordinates are scene coordinates.
+ */
+class LayerCopper {
+public:
+  struct Polygon {
+    QPolygonF outer;
+    QList<QPolygonF> holes;
+    int tile;
+  };
+
+  LayerCopper(LayerGeometry* geometry, qreal resolution = 1e-6,
+      qreal tolerance = ArcGeometry::tolerance());
+
+  int tileCount(void) const { return m_tiles.size(); }
+  QRectF tileRect(int tile) const { return m_tiles[tile]; }
+
+  const QVector<Polygon>& polygons(void);
+
+  /* The same polygons on the integer grid, before scaling back */
+  const QVector<PolygonBoolean::Polygon>& intPolygons(void);
+  PolygonBoolean::IntRect intTileRect(int tile) const {
+    return m_intTiles[tile];
+  }
+
+  /* Size of one integer grid step in scene units */
+  qreal resolution(void) const { return 1.0 / m_scale; }
+
+  /* Copper area in square inches */
+  qreal area(void);
+
+  /* Filled odd-even path of all polygons, e.g. for rendering */
+  QPainterPath path(void);
+
+  /* Island id of every polygon, joined across tile borders */
+  const QVector<int>& islands(void);
+  int islandCount(void);
+
+private:
+  void build(void);
+  void buildIslands(void);
+
+  LayerGeometry* m_geometry;
+  qreal m_scale;
+  qreal m_tolerance;
+  QVector<QRectF> m_tiles;
+  QVector<PolygonBoolean::IntRect> m_intTiles;
+
+  bool m_built;
+  QVector<PolygonBoolean::Polygon> m_intPolygons;
+  QVector<Polygon> m_polygons;
+  qreal m_area;
+
+  bool m_pathBuilt;
+  QPainterPath m_path;
+
+  bool m_islandsBuilt;
+  QVector<int> m_islands;
+  int m_islandCount;
+
+  QMutex m_mutex;
+};
+
+#endif /* __LAYERCOPPER_H__ */
@@ -28,6 +28,8 @@
 #include "context.h"
 #include "archiveloader.h"  
 #include "logger.h"
+#include "placement.h"
+#include "surfacesymbol.h"
 
 LayerFeatures::LayerFeatures(QString step, QString path, bool stepRepeat):
   Symbol("features"), m_step(step), m_path(path), m_scene(NULL),
@@ -37,7 +39,7 @@ LayerFeatures::LayerFeatures(QString step, QString path, bool stepRepeat):
   LOG_STEP(QString("LayerFeatures constructor"), QString("Step: %1, Path: %2").arg(step, path));
   setHandlesChildEvents(true);
 
-  QString fullPath = ctx.loader->absPath(path.arg(step));
+  QString fullPath = ctx.loader->dataPath(path.arg(step));
   LOG_INFO(QString("Parsing features file: %1").arg(fullPath));
   
   m_ds = CachedFeaturesParser::parse(fullPath);
@@ -46,16 +48,21 @@ LayerFeatures::LayerFeatures(QString step, QString path, bool stepRepeat):
     LOG_ERROR(QString("Failed to parse features file: %1").arg(fullPath));
     return;
   }
+  CachedFeaturesParser::acquire(m_ds);
 
   LOG_INFO(QString("Features file parsed successfully, records count: %1").arg(m_ds->records().size()));
 
   int symbolCount = 0;
-  for (QList<Record*>::const_iterator it = m_ds->records().begin();
-      it != m_ds->records().end(); ++it) {
+  // Symbols are created along the data store's draw order, so neighbouring
+  // features are neighbours in the scene's item list as well
+  const QList<Record*> records = m_ds->records();
+  m_recordSymbols.fill(NULL, records.size());
+  foreach (int i, m_ds->drawOrder()) {
     try {
-      Symbol* symbol = (*it)->createSymbol();
+      Symbol* symbol = records[i]->createSymbol();
       if (symbol) {
         m_symbols.append(symbol);
+        m_recordSymbols[i] = symbol;
         symbolCount++;
       } else {
         LOG_WARNING("Failed to create symbol from record");
@@ -69,19 +76,7 @@ LayerFeatures::LayerFeatures(QString step, QString path, bool stepRepeat):
 
   LOG_INFO(QString("Created %1 symbols from %2 records").arg(symbolCount).arg(m_ds->records().size()));
 
-  // Copy count maps
-  m_posLineCount = m_ds->posLineCountMap();
-  m_negLineCount = m_ds->negLineCountMap();
-  m_posPadCount = m_ds->posPadCountMap();
-  m_negPadCount = m_ds->negPadCountMap();
-  m_posArcCount = m_ds->posArcCountMap();
-  m_negArcCount = m_ds->negArcCountMap();
-  m_posSurfaceCount = m_ds->posSurfaceCount();
-  m_negSurfaceCount = m_ds->negSurfaceCount();
-  m_posTextCount = m_ds->posTextCount();
-  m_negTextCount = m_ds->negTextCount();
-  m_posBarcodeCount = m_ds->posBarcodeCount();
-  m_negBarcodeCount = m_ds->negBarcodeCount();
+  resetCounts();
 
   LOG_INFO(QString("Feature counts - Lines: %1/%2, Pads: %3/%4, Arcs: %5/%6, Surfaces: %7/%8, Text: %9/%10, Barcodes: %11/%12")
           .arg(m_posLineCount.size()).arg(m_negLineCount.size())
@@ -109,12 +104,17 @@ LayerFeatures::~LayerFeatures()
   if (m_reportModel) {
     delete m_reportModel;
   }
+
+  // A data store retired by a reload goes with its last user
+  if (m_ds) {
+    CachedFeaturesParser::release(m_ds);
+  }
 }
 
 void LayerFeatures::loadStepAndRepeat(void)
 {
   LOG_STEP("Loading step and repeat data");
-  QString path = ctx.loader->absPath(QString("steps/%1/stephdr").arg(m_step));
+  QString path = ctx.loader->dataPath(QString("steps/%1/stephdr").arg(m_step));
   LOG_INFO(QString("Parsing step header: %1").arg(path));
   
   StructuredTextDataStore* hds = CachedStructuredTextParser::parse(path);
@@ -172,65 +172,18 @@ void LayerFeatures::loadStepAndRepeat(void)
     LOG_INFO(QString("Step repeat: %1 at (%2,%3), delta (%4,%5), array %6x%7, angle %8, mirror %9")
             .arg(name).arg(x).arg(y).arg(dx).arg(dy).arg(nx).arg(ny).arg(angle).arg(mirror));
 
-    FeaturesDataStore::CountMapType countMap;
-
     for (int i = 0; i < nx; ++i) {
       for (int j = 0; j < ny; ++j) {
         try {
           LayerFeatures* step = new LayerFeatures(name, m_path, true);
           step->m_virtualParent = this;
           step->setPos(QPointF(x + dx * i, -(y + dy * j)));
-
-          QTransform trans;
-          if (mirror) {
-            trans.scale(-1, 1);
-          }
-          trans.rotate(angle);
-          trans.translate(-step->x_datum(), step->y_datum());
-          step->setTransform(trans);
+          step->setTransform(Placement::fromStepRepeat(angle, mirror,
+                QPointF(step->x_datum(), step->y_datum())).toTransform());
           m_repeats.append(step);
           repeatCount++;
 
-          // Aggregate count maps (existing code)
-          countMap = step->m_posLineCount;
-          for (FeaturesDataStore::CountMapType::iterator it = countMap.begin();
-              it != countMap.end(); ++it) {
-            m_posLineCount[it.key()] += it.value();
-          }
-          countMap = step->m_negLineCount;
-          for (FeaturesDataStore::CountMapType::iterator it = countMap.begin();
-              it != countMap.end(); ++it) {
-            m_negLineCount[it.key()] += it.value();
-          }
-          countMap = step->m_posPadCount;
-          for (FeaturesDataStore::CountMapType::iterator it = countMap.begin();
-              it != countMap.end(); ++it) {
-            m_posPadCount[it.key()] += it.value();
-          }
-          countMap = step->m_negPadCount;
-          for (FeaturesDataStore::CountMapType::iterator it = countMap.begin();
-              it != countMap.end(); ++it) {
-            m_negPadCount[it.key()] += it.value();
-          }
-          countMap = step->m_posArcCount;
-          for (FeaturesDataStore::CountMapType::iterator it = countMap.begin();
-              it != countMap.end(); ++it) {
-            m_posArcCount[it.key()] += it.value();
-          }
-          countMap = step->m_negArcCount;
-          for (FeaturesDataStore::CountMapType::iterator it = countMap.begin();
-              it != countMap.end(); ++it) {
-            m_negArcCount[it.key()] += it.value();
-          }
-
-          m_posSurfaceCount += step->m_posSurfaceCount;
-          m_negSurfaceCount += step->m_negSurfaceCount;
-
-          m_posTextCount += step->m_posTextCount;
-          m_negTextCount += step->m_negTextCount;
-
-          m_posBarcodeCount += step->m_posBarcodeCount;
-          m_negBarcodeCount += step->m_negBarcodeCount;
+          addCounts(step);
         } catch (const std::exception& e) {
           LOG_ERROR(QString("Exception creating step repeat [%1,%2]: %3").arg(i).arg(j).arg(e.what()));
         } catch (...) {
@@ -257,49 +210,24 @@ void LayerFeatures::loadStepAndRepeat(void)
 
 QRectF LayerFeatures::boundingRect() const
 {
-  LOG_INFO(QString("LayerFeatures::boundingRect() called, symbols count: %1").arg(m_symbols.size()));
-  
-  if (m_symbols.isEmpty()) {
-    LOG_WARNING("LayerFeatures has no symbols, returning empty rect");
-    return QRectF();
-  }
-
   QRectF bounds;
-  bool firstSymbol = true;
-  
   for (int i = 0; i < m_symbols.size(); ++i) {
     if (m_symbols[i]) {
-      QRectF symbolBounds = m_symbols[i]->boundingRect();
-      QPointF symbolPos = m_symbols[i]->pos();
-      
-      // Translate symbol bounds to its actual position
-      symbolBounds.translate(symbolPos);
-      
-      if (firstSymbol) {
-        bounds = symbolBounds;
-        firstSymbol = false;
-        LOG_INFO(QString("First symbol bounds: x=%1, y=%2, w=%3, h=%4")
-                .arg(symbolBounds.x()).arg(symbolBounds.y())
-                .arg(symbolBounds.width()).arg(symbolBounds.height()));
-      } else {
-        bounds = bounds.united(symbolBounds);
-      }
+      // Repeats carry their offset in the symbol transform, not in pos()
+      Placement place = Placement::fromTransform(
+          m_symbols[i]->sceneTransform());
+      bounds |= place.mapRect(m_symbols[i]->boundingRect());
     }
   }
-  
-  // Include repeats
+
   for (QList<LayerFeatures*>::const_iterator it = m_repeats.begin();
       it != m_repeats.end(); ++it) {
     QRectF repeatBounds = (*it)->boundingRect();
     if (!repeatBounds.isEmpty()) {
-      bounds = bounds.united(repeatBounds);
+      bounds |= repeatBounds;
     }
   }
-  
-  LOG_INFO(QString("LayerFeatures final bounds: x=%1, y=%2, w=%3, h=%4")
-          .arg(bounds.x()).arg(bounds.y())
-          .arg(bounds.width()).arg(bounds.height()));
-  
+
   return bounds;
 }
 
@@ -329,24 +257,28 @@ void LayerFeatures::addToScene(QGraphicsScene* scene)
 
 void LayerFeatures::setTransform(const QTransform& matrix, bool combine)
 {
-  LOG_INFO("Setting transform on LayerFeatures");
+  // Every symbol is placed about its position in the layer's own frame;
+  // the positions go back to that frame as one array
+  Placement place = Placement::fromTransform(matrix);
+  Placement back = Placement::fromTransform(transform().inverted());
+  QVector<QPointF> origins(m_symbols.size());
+  for (int i = 0; i < m_symbols.size(); ++i) {
+    origins[i] = m_symbols[i]->pos();
+  }
+  back.map(origins.constData(), origins.data(), origins.size());
+
+  QVector<Placement> placements =
+    place.about(origins.constData(), origins.size());
   for (int i = 0; i < m_symbols.size(); ++i) {
     Symbol* symbol = m_symbols[i];
-    QTransform trans;
-    QPointF o = transform().inverted().map(symbol->pos());
-    trans.translate(-o.x(), -o.y());
-    trans = matrix * trans;
-    trans.translate(o.x(), o.y());
-    symbol->setTransform(symbol->transform() * trans, false);
+    Placement current = Placement::fromTransform(symbol->transform());
+    symbol->setTransform((current * placements[i]).toTransform(), false);
   }
 
+  QPointF origin = back.map(pos());
+  QTransform trans = place.about(&origin, 1)[0].toTransform();
   for (QList<LayerFeatures*>::iterator it = m_repeats.begin();
       it != m_repeats.end(); ++it) {
-    QTransform trans;
-    QPointF o = transform().inverted().map(pos());
-    trans.translate(-o.x(), -o.y());
-    trans = matrix * trans;
-    trans.translate(o.x(), o.y());
     (*it)->setTransform(trans, combine);
   }
 
@@ -360,10 +292,11 @@ void LayerFeatures::setPos(QPointF pos)
 
 void LayerFeatures::setPos(qreal x, qreal y)
 {
-  LOG_INFO(QString("Setting LayerFeatures position to (%1, %2)").arg(x).arg(y));
   QTransform trans = QTransform::fromTranslate(x, y);
   for (int i = 0; i < m_symbols.size(); ++i) {
-    m_symbols[i]->setTransform(m_symbols[i]->transform() * trans, false);
+    Placement current = Placement::fromTransform(m_symbols[i]->transform());
+    m_symbols[i]->setTransform(current.translated(x, y).toTransform(),
+        false);
   }
 
   for (QList<LayerFeatures*>::iterator it = m_repeats.begin();
@@ -522,3 +455,205 @@ QStandardItemModel* LayerFeatures::reportModel(void)
   LOG_INFO("Report model created successfully");
   return m_reportModel;
 }
+
+void LayerFeatures::resetCounts(void)
+{
+  m_posLineCount = m_ds->posLineCountMap();
+  m_negLineCount = m_ds->negLineCountMap();
+  m_posPadCount = m_ds->posPadCountMap();
+  m_negPadCount = m_ds->negPadCountMap();
+  m_posArcCount = m_ds->posArcCountMap();
+  m_negArcCount = m_ds->negArcCountMap();
+  m_posSurfaceCount = m_ds->posSurfaceCount();
+  m_negSurfaceCount = m_ds->negSurfaceCount();
+  m_posTextCount = m_ds->posTextCount();
+  m_negTextCount = m_ds->negTextCount();
+  m_posBarcodeCount = m_ds->posBarcodeCount();
+  m_negBarcodeCount = m_ds->negBarcodeCount();
+}
+
+static void addCountMap(FeaturesDataStore::CountMapType& to,
+    const FeaturesDataStore::CountMapType& from)
+{
+  for (FeaturesDataStore::CountMapType::const_iterator it = from.begin();
+      it != from.end(); ++it) {
+    to[it.key()] += it.value();
+  }
+}
+
+void LayerFeatures::addCounts(const LayerFeatures* other)
+{
+  addCountMap(m_posLineCount, other->m_posLineCount);
+  addCountMap(m_negLineCount, other->m_negLineCount);
+  addCountMap(m_posPadCount, other->m_posPadCount);
+  addCountMap(m_negPadCount, other->m_negPadCount);
+  addCountMap(m_posArcCount, other->m_posArcCount);
+  addCountMap(m_negArcCount, other->m_negArcCount);
+
+  m_posSurfaceCount += other->m_posSurfaceCount;
+  m_negSurfaceCount += other->m_negSurfaceCount;
+  m_posTextCount += other->m_posTextCount;
+  m_negTextCount += other->m_negTextCount;
+  m_posBarcodeCount += other->m_posBarcodeCount;
+  m_negBarcodeCount += other->m_negBarcodeCount;
+}
+
+bool LayerFeatures::uses(FeaturesDataStore* ds) const
+{
+  if (m_ds == ds) {
+    return true;
+  }
+  for (int i = 0; i < m_repeats.size(); ++i) {
+    if (m_repeats[i]->uses(ds)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool LayerFeatures::usesStep(const QString& step) const
+{
+  if (m_step == step) {
+    return true;
+  }
+  for (int i = 0; i < m_repeats.size(); ++i) {
+    if (m_repeats[i]->usesStep(step)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+QList<Symbol*> LayerFeatures::reload(FeaturesDataStore* ds,
+    const FeaturesDiff& diff)
+{
+  LOG_STEP(QString("Reloading features of step %1").arg(m_step),
+      QString("%1 added, %2 removed").arg(diff.added()).arg(diff.removed()));
+
+  const QList<Record*> records = ds->records();
+  QVector<Symbol*> recordSymbols(records.size(), NULL);
+  QVector<bool> reused(m_recordSymbols.size(), false);
+
+  for (int i = 0; i < records.size(); ++i) {
+    int source = diff.sources().value(i, -1);
+    if (source >= 0 && source < m_recordSymbols.size()) {
+      recordSymbols[i] = m_recordSymbols[source];
+      reused[source] = true;
+
+      // Surfaces draw straight from their records, which go with the
+      // previous data store
+      SurfaceSymbol* surface = dynamic_cast<SurfaceSymbol*>(recordSymbols[i]);
+      const SurfaceRecord* rec = dynamic_cast<SurfaceRecord*>(records[i]);
+      if (surface && rec) {
+        surface->rebind(rec);
+      }
+      continue;
+    }
+
+    try {
+      Symbol* symbol = records[i]->createSymbol();
+      if (!symbol) {
+        LOG_WARNING("Failed to create symbol from record");
+        continue;
+      }
+      symbol->setPen(m_pen);
+      symbol->setBrush(m_brush);
+      if (m_scene) {
+        m_scene->addItem(symbol);
+      }
+      recordSymbols[i] = symbol;
+    } catch (const std::exception& e) {
+      LOG_ERROR(QString("Exception creating symbol: %1").arg(e.what()));
+    } catch (...) {
+      LOG_ERROR("Unknown exception creating symbol");
+    }
+  }
+
+  QList<Symbol*> removed;
+  for (int i = 0; i < m_recordSymbols.size(); ++i) {
+    if (!reused[i] && m_recordSymbols[i]) {
+      if (m_scene) {
+        m_scene->removeItem(m_recordSymbols[i]);
+      }
+      removed.append(m_recordSymbols[i]);
+    }
+  }
+
+  CachedFeaturesParser::acquire(ds);
+  CachedFeaturesParser::release(m_ds);
+  m_ds = ds;
+  m_recordSymbols = recordSymbols;
+  m_symbols.clear();
+  foreach (int i, m_ds->drawOrder()) {
+    if (m_recordSymbols[i]) {
+      m_symbols.append(m_recordSymbols[i]);
+    }
+  }
+
+  resetCounts();
+  for (int i = 0; i < m_repeats.size(); ++i) {
+    addCounts(m_repeats[i]);
+  }
+
+  delete m_reportModel;
+  m_reportModel = NULL;
+
+  return removed;
+}
+
+QList<Symbol*> LayerFeatures::takeSymbols(void)
+{
+  QList<Symbol*> symbols;
+  for (int i = 0; i < m_symbols.size(); ++i) {
+    if (m_scene) {
+      m_scene->removeItem(m_symbols[i]);
+    }
+    symbols.append(m_symbols[i]);
+  }
+  m_symbols.clear();
+  m_recordSymbols.clear();
+
+  for (int i = 0; i < m_repeats.size(); ++i) {
+    symbols.append(m_repeats[i]->takeSymbols());
+  }
+  return symbols;
+}
+
+void LayerFeatures::setSymbolStyle(const QPen& pen, const QBrush& brush)
+{
+  for (int i = 0; i < m_symbols.size(); ++i) {
+    m_symbols[i]->setPen(pen);
+    m_symbols[i]->setBrush(brush);
+  }
+  for (int i = 0; i < m_repeats.size(); ++i) {
+    m_repeats[i]->setSymbolStyle(pen, brush);
+  }
+}
+
+QList<Symbol*> LayerFeatures::reloadStepAndRepeat(void)
+{
+  QList<Symbol*> removed;
+  if (!m_stepRepeatLoaded) {
+    return removed;
+  }
+
+  LOG_STEP(QString("Reloading step and repeat of step %1").arg(m_step));
+  for (int i = 0; i < m_repeats.size(); ++i) {
+    removed.append(m_repeats[i]->takeSymbols());
+    delete m_repeats[i];
+  }
+  m_repeats.clear();
+
+  delete m_reportModel;
+  m_reportModel = NULL;
+
+  resetCounts();
+  m_activeRect = QRectF();
+  loadStepAndRepeat();
+
+  for (int i = 0; i < m_repeats.size(); ++i) {
+    m_repeats[i]->setSymbolStyle(m_pen, m_brush);
+    m_repeats[i]->setVisible(m_showStepRepeat);
+  }
+  return removed;
+}
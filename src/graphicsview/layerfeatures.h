@@ -30,7 +30,9 @@
 #include <QStandardItemModel>
 #include <QString>
 #include <QTextEdit>
+#include <QVector>
 
+#include "featuresdiff.h"
 #include "featuresparser.h"
 #include "macros.h"
 #include "record.h"
@@ -48,6 +50,10 @@ public:
   qreal y_datum(void) { return m_y_datum; }
   FeaturesDataStore* dataStore(void) { return m_ds; }
 
+  /* Symbol created for dataStore()->records()[index], NULL if it failed */
+  Symbol* symbolAt(int index) const { return m_recordSymbols.value(index); }
+  const QList<LayerFeatures*>& repeats(void) const { return m_repeats; }
+
   QStandardItemModel* reportModel(void);
 
   void setTransform(const QTransform& matrix, bool combine = false);
@@ -56,8 +62,27 @@ public:
   void setVisible(bool status);
   void setShowStepRepeat(bool status);
 
+  /* True if this features tree, repeats included, reads ds or step */
+  bool uses(FeaturesDataStore* ds) const;
+  bool usesStep(const QString& step) const;
+
+  /**
+   * Switch to a re-parsed data store of the same file.  Symbols of records
+   * that diff matched are kept, the others are created; symbols of dropped
+   * records are taken out of the scene and returned for the caller to
+   * delete once nothing refers to them any more.
+   */
+  QList<Symbol*> reload(FeaturesDataStore* ds, const FeaturesDiff& diff);
+
+  /* Rebuild the step-and-repeat children, returning their old symbols */
+  QList<Symbol*> reloadStepAndRepeat(void);
+
 protected:
   void loadStepAndRepeat(void);
+  void resetCounts(void);
+  void addCounts(const LayerFeatures* other);
+  QList<Symbol*> takeSymbols(void);
+  void setSymbolStyle(const QPen& pen, const QBrush& brush);
 
 private:
   LayerFeatures* m_virtualParent;
@@ -71,6 +96,7 @@ private:
   bool m_stepRepeatLoaded;
   bool m_showStepRepeat;
   QList<Symbol*> m_symbols;
+  QVector<Symbol*> m_recordSymbols;
   QList<LayerFeatures*> m_repeats;
   QStandardItemModel* m_reportModel;
 
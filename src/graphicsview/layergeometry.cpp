@@ -0,0 +1,358 @@
+/**
+ * @file   layergeometry.cpp
+ * @author Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ *
+ * Copyright (C) 2012 - 2014 Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ * All Rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "layergeometry.h"
+
+#include <QGraphicsItem>
+#include <QPainterPath>
+#include <QTransform>
+
+#include <climits>
+#include <cmath>
+
+#include "featuresdatastore.h"
+#include "layer.h"
+#include "layerfeatures.h"
+#include "logger.h"
+#include "parallel.h"
+#include "placement.h"
+#include "record.h"
+#include "symbol.h"
+#include "tracewidthclassifier.h"
+
+/* Features closer than this are considered touching when building nets */
+#define NET_TOLERANCE 1e-6
+
+static void collectRings(Symbol* symbol, QList<QPolygonF>& rings)
+{
+  QPainterPath path = symbol->painterPath();
+  if (!path.isEmpty()) {
+    // Odd-even filling of overlapping subpaths would punch holes
+    if (path.fillRule() == Qt::WindingFill) {
+      path = path.simplified();
+    }
+    QList<QPolygonF> local = path.toSubpathPolygons();
+    Placement::fromTransform(symbol->sceneTransform()).map(local);
+    rings.append(local);
+  }
+
+  QList<QGraphicsItem*> children = symbol->childItems();
+  for (int i = 0; i < children.size(); ++i) {
+    Symbol* child = dynamic_cast<Symbol*>(children[i]);
+    if (child && child->polarity() == P) {
+      collectRings(child, rings);
+    }
+  }
+}
+
+#ifdef QCAMBER_FIXED_COORDS
+static qint32 clampSteps(qint64 steps)
+{
+  return (qint32)qBound((qint64)INT_MIN, steps, (qint64)INT_MAX);
+}
+
+/**
+ * Box of a round line drawn untransformed, straight from its stored end
+ * points.  Scene y is the negated record y.
+ */
+static bool traceBounds(Symbol* symbol, const Record* rec,
+    const FeatureShape& shape, FixedRect& box)
+{
+  const LineRecord* line = dynamic_cast<const LineRecord*>(rec);
+  if (!line || shape.kind != FeatureShape::Capsule ||
+      symbol->sceneTransform().type() != QTransform::TxNone) {
+    return false;
+  }
+
+  qint64 r = (qint64)std::ceil(shape.radius * FixedPoint::resolution());
+  qint32 xs = line->xs.raw(), xe = line->xe.raw();
+  qint32 ys = line->ys.raw(), ye = line->ye.raw();
+  box.left = clampSteps(qMin(xs, xe) - r);
+  box.right = clampSteps(qMax(xs, xe) + r);
+  box.top = clampSteps(-(qint64)qMax(ys, ye) - r);
+  box.bottom = clampSteps(-(qint64)qMin(ys, ye) + r);
+  return true;
+}
+#endif
+
+static int findRoot(QVector<int>& parent, int i)
+{
+  while (parent[i] != i) {
+    parent[i] = parent[parent[i]];
+    i = parent[i];
+  }
+  return i;
+}
+
+LayerGeometry::LayerGeometry(Layer* layer): m_layer(layer), m_netsBuilt(false)
+{
+  QList<LayerFeatures*> features = layer->allFeatures();
+  for (int f = 0; f < features.size(); ++f) {
+    LayerFeatures* lf = features[f];
+    if (!lf->dataStore()) {
+      continue;
+    }
+
+    const QList<Record*>& records = lf->dataStore()->records();
+    foreach (int i, lf->dataStore()->drawOrder()) {
+      Symbol* symbol = lf->symbolAt(i);
+      if (!symbol || !symbol->isVisible()) {
+        continue;
+      }
+
+      Feature feature;
+      feature.features = lf;
+      feature.index = i;
+      feature.symbol = symbol;
+      feature.positive = (symbol->polarity() == P);
+
+      m_symbolIndex.insert(symbol, m_features.size());
+      m_features.append(feature);
+      m_shapes.append(buildShape(symbol, records[i]));
+    }
+  }
+
+#ifdef QCAMBER_FIXED_COORDS
+  QVector<FixedRect> bounds(m_shapes.size());
+  for (int i = 0; i < m_shapes.size(); ++i) {
+    const Feature& f = m_features[i];
+    if (!traceBounds(f.symbol, f.features->dataStore()->records()[f.index],
+          m_shapes[i], bounds[i])) {
+      bounds[i] = FixedRect::enclosing(m_shapes[i].boundingRect());
+    }
+  }
+#else
+  QVector<QRectF> bounds(m_shapes.size());
+  for (int i = 0; i < m_shapes.size(); ++i) {
+    bounds[i] = m_shapes[i].boundingRect();
+  }
+#endif
+  m_index.build(bounds);
+
+  LOG_INFO(QString("Layer geometry: %1 features on %2/%3")
+      .arg(m_features.size()).arg(layer->step()).arg(layer->layer()));
+}
+
+FeatureShape LayerGeometry::buildShape(Symbol* symbol, const Record* rec)
+{
+  QTransform trans = symbol->sceneTransform();
+  const FeaturesDataStore* ds = dynamic_cast<const FeaturesDataStore*>(
+      rec->ds);
+
+  // Round apertures have an exact skeleton representation; items draw in
+  // (x, -y) local coordinates, which the scene transform takes care of.
+  if (const LineRecord* line = dynamic_cast<const LineRecord*>(rec)) {
+    QString name = ds? ds->symbolNameMap().value(line->sym_num): QString();
+    qreal width = TraceWidthClassifier::symbolWidth(name);
+    if (name.startsWith('r') && width > 0) {
+      return FeatureShape::capsule(trans.map(QPointF(line->xs, -line->ys)),
+          trans.map(QPointF(line->xe, -line->ye)), width / 2);
+    }
+  } else if (const ArcRecord* arc = dynamic_cast<const ArcRecord*>(rec)) {
+    QString name = ds? ds->symbolNameMap().value(arc->sym_num): QString();
+    qreal width = TraceWidthClassifier::symbolWidth(name);
+    if (name.startsWith('r') && width > 0) {
+      // Flipping y reverses the direction, and so does a mirrored transform
+      bool cw = !arc->cw ^ (trans.determinant() < 0);
+      return FeatureShape::arc(trans.map(QPointF(arc->xs, -arc->ys)),
+          trans.map(QPointF(arc->xe, -arc->ye)),
+          trans.map(QPointF(arc->xc, -arc->yc)), cw, width / 2);
+    }
+  } else if (const PadRecord* pad = dynamic_cast<const PadRecord*>(rec)) {
+    qreal width = TraceWidthClassifier::symbolWidth(pad->sym_name);
+    if (pad->sym_name.startsWith('r') && width > 0) {
+      return FeatureShape::disc(trans.map(QPointF(0, 0)), width / 2);
+    }
+  }
+
+  QList<QPolygonF> rings;
+  collectRings(symbol, rings);
+  return FeatureShape::contour(rings);
+}
+
+int LayerGeometry::indexOf(Symbol* symbol) const
+{
+  return m_symbolIndex.value(symbol, -1);
+}
+
+QVector<int> LayerGeometry::query(const QRectF& rect) const
+{
+  return m_index.query(rect);
+}
+
+QVector<int> LayerGeometry::nearest(const QPointF& p, int k,
+    qreal maxDistance, QVector<qreal>* distances) const
+{
+  return m_index.nearest(p, k, [&](int i) -> qreal {
+    if (!m_features[i].positive) {
+      return -1;
+    }
+    return ShapeDistance::toPoint(m_shapes[i], p).distance;
+  }, maxDistance, distances);
+}
+
+Proximity LayerGeometry::clearance(int a, int b) const
+{
+  if (a < 0 || b < 0 || a >= count() || b >= count()) {
+    return Proximity();
+  }
+  return ShapeDistance::between(m_shapes[a], m_shapes[b]);
+}
+
+void LayerGeometry::ensureNets(void)
+{
+  if (m_netsBuilt) {
+    return;
+  }
+
+  // Find touching neighbours in parallel, then merge serially
+  QVector<QVector<int> > touching(count());
+  QVector<int>* out = touching.data();
+  Parallel::forRange(count(), 256, [&](int begin, int end) {
+    for (int i = begin; i < end; ++i) {
+      if (!m_features[i].positive || m_shapes[i].isEmpty()) {
+        continue;
+      }
+      QRectF window = m_shapes[i].boundingRect().adjusted(-NET_TOLERANCE,
+          -NET_TOLERANCE, NET_TOLERANCE, NET_TOLERANCE);
+      m_index.visit(window, [&](int j) {
+        if (j > i && m_features[j].positive) {
+          Proximity p = ShapeDistance::between(m_shapes[i], m_shapes[j]);
+          if (p.isValid() && p.distance <= NET_TOLERANCE) {
+            out[i].append(j);
+          }
+        }
+      });
+    }
+  });
+
+  QVector<int> parent(count());
+  for (int i = 0; i < count(); ++i) {
+    parent[i] = i;
+  }
+  for (int i = 0; i < count(); ++i) {
+    for (int n = 0; n < touching[i].size(); ++n) {
+      int a = findRoot(parent, i), b = findRoot(parent, touching[i][n]);
+      if (a != b) {
+        parent[qMax(a, b)] = qMin(a, b);
+      }
+    }
+  }
+
+  QHash<int, int> netIds;
+  m_nets.fill(-1, count());
+  for (int i = 0; i < count(); ++i) {
+    if (!m_features[i].positive || m_shapes[i].isEmpty()) {
+      continue;
+    }
+    int root = findRoot(parent, i);
+    if (!netIds.contains(root)) {
+      netIds.insert(root, m_netMembers.size());
+      m_netMembers.append(QVector<int>());
+    }
+    m_nets[i] = netIds[root];
+    m_netMembers[m_nets[i]].append(i);
+  }
+
+  m_netsBuilt = true;
+  LOG_INFO(QString("Layer geometry: %1 nets").arg(m_netMembers.size()));
+}
+
+int LayerGeometry::netOf(int i)
+{
+  ensureNets();
+  return (i >= 0 && i < count())? m_nets[i]: -1;
+}
+
+int LayerGeometry::netCount(void)
+{
+  ensureNets();
+  return m_netMembers.size();
+}
+
+QVector<int> LayerGeometry::netMembers(int net)
+{
+  ensureNets();
+  return m_netMembers.value(net);
+}
+
+Proximity LayerGeometry::netClearance(int netA, int netB)
+{
+  ensureNets();
+  if (netA < 0 || netB < 0 || netA >= m_netMembers.size() ||
+      netB >= m_netMembers.size()) {
+    return Proximity();
+  }
+  if (netA == netB) {
+    int f = m_netMembers[netA].first();
+    return Proximity(0, m_shapes[f].boundingRect().center(),
+        m_shapes[f].boundingRect().center());
+  }
+
+  // Walk the smaller net and only look at the other one within the best
+  // gap found so far
+  const QVector<int>& a = (m_netMembers[netA].size() <=
+      m_netMembers[netB].size())? m_netMembers[netA]: m_netMembers[netB];
+  int other = (&a == &m_netMembers[netA])? netB: netA;
+
+  Proximity best = ShapeDistance::between(m_shapes[a.first()],
+      m_shapes[m_netMembers[other].first()]);
+
+  for (int n = 0; n < a.size() && best.distance > 0; ++n) {
+    const FeatureShape& sa = m_shapes[a[n]];
+    qreal d = best.distance;
+    m_index.visit(sa.boundingRect().adjusted(-d, -d, d, d), [&](int j) {
+      if (m_nets[j] != other || ShapeDistance::boundsDistance(
+            sa.boundingRect(), m_shapes[j].boundingRect()) >= best.distance) {
+        return;
+      }
+      Proximity p = ShapeDistance::between(sa, m_shapes[j]);
+      if (p.isValid() && p.distance < best.distance) {
+        best = p;
+      }
+    });
+  }
+
+  // Keep pa on netA
+  if (other == netA) {
+    best = Proximity(best.distance, best.pb, best.pa);
+  }
+  return best;
+}
+
+QJsonObject LayerGeometry::toJson(int i)
+{
+  QJsonObject obj;
+  if (i < 0 || i >= count()) {
+    return obj;
+  }
+
+  const Feature& f = m_features[i];
+  obj["id"] = i;
+  obj["layer"] = m_layer->layer();
+  obj["step"] = f.features->dataStore()->stepName().toLower();
+  obj["index"] = f.index;
+  obj["symbol"] = f.symbol->name();
+  obj["info"] = f.symbol->infoText();
+  obj["net"] = netOf(i);
+  return obj;
+}
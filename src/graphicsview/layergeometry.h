@@ -0,0 +1,111 @@
+/**
+ * @file   layergeometry.h
+ * @author Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ *
+ * Copyright (C) 2012 - 2014 Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ * All Rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __LAYERGEOMETRY_H__
+#define __LAYERGEOMETRY_H__
+
+#include <QHash>
+#include <QJsonObject>
+#include <QPointF>
+#include <QRectF>
+#include <QVector>
+
+#include "featureshape.h"
+#include "spatialindex.h"
+
+class Layer;
+class LayerFeatures;
+struct Record;
+class Symbol;
+
+/**
+ * Analytic geometry of every visible feature of a layer in scene
+ * coordinates, with a spatial index on top.
+ *
+ * Features are numbered 0..count()-1 over Layer::allFeatures() in order, so
+ * the same numbering is valid as long as the step-repeat setting does not
+ * change.  Shapes are built once on construction and never modified, which
+ * makes all queries safe to run concurrently.
+ *
+ * A net is a connected component of touching positive features.  Negative
+ * features never join nets and are ignored by clearance queries.
+ */
+class LayerGeometry {
+public:
+  struct Feature {
+    LayerFeatures* features;
+    int index;          /* into features->dataStore()->records() */
+    Symbol* symbol;
+    bool positive;
+  };
+
+  LayerGeometry(Layer* layer);
+
+  int count(void) const { return m_features.size(); }
+  const Feature& feature(int i) const { return m_features[i]; }
+  const FeatureShape& shape(int i) const { return m_shapes[i]; }
+  const SpatialIndex& index(void) const { return m_index; }
+  QRectF boundingRect(void) const { return m_index.bounds(); }
+
+  /* Feature id of symbol, -1 if it is not part of this layer */
+  int indexOf(Symbol* symbol) const;
+
+  /* Feature ids whose bounds intersect rect */
+  QVector<int> query(const QRectF& rect) const;
+
+  /**
+   * Up to k positive features nearest to p by edge distance (0 inside a
+   * feature), nearest first.
+   */
+  QVector<int> nearest(const QPointF& p, int k, qreal maxDistance = -1,
+      QVector<qreal>* distances = NULL) const;
+
+  /* Edge-to-edge gap between features a and b */
+  Proximity clearance(int a, int b) const;
+
+  /* Net id of feature i, -1 for negative or empty features */
+  int netOf(int i);
+  int netCount(void);
+  QVector<int> netMembers(int net);
+
+  /* Edge-to-edge gap between nets, invalid if either is empty */
+  Proximity netClearance(int netA, int netB);
+
+  QJsonObject toJson(int i);
+
+  static FeatureShape buildShape(Symbol* symbol, const Record* rec);
+
+private:
+  void ensureNets(void);
+
+  Layer* m_layer;
+  QVector<Feature> m_features;
+  QVector<FeatureShape> m_shapes;
+  QHash<Symbol*, int> m_symbolIndex;
+  SpatialIndex m_index;
+
+  bool m_netsBuilt;
+  QVector<int> m_nets;
+  QVector<QVector<int> > m_netMembers;
+};
+
+#endif /* __LAYERGEOMETRY_H__ */
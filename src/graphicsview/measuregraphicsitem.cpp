@@ -31,13 +31,25 @@ MeasureGraphicsItem::MeasureGraphicsItem(QRectF rect): m_rect(rect)
 
 QRectF MeasureGraphicsItem::boundingRect() const
 {
-  return m_rect;
+  if (m_clearance.isNull()) {
+    return m_rect;
+  }
+  return m_rect.normalized().united(
+      QRectF(m_clearance.p1(), m_clearance.p2()).normalized());
 }
 
 void MeasureGraphicsItem::setRect(const QRectF& rect)
 {
   prepareGeometryChange();
   m_rect = rect;
+  m_clearance = QLineF();
+  update();
+}
+
+void MeasureGraphicsItem::setClearanceLine(const QLineF& line)
+{
+  prepareGeometryChange();
+  m_clearance = line;
   update();
 }
 
@@ -48,4 +60,9 @@ void MeasureGraphicsItem::paint(QPainter *painter,
   painter->setBrush(Qt::transparent);
   painter->drawRect(m_rect);
   painter->drawLine(QLineF(m_rect.topLeft(), m_rect.bottomRight()));
+
+  if (!m_clearance.isNull()) {
+    painter->setPen(QPen(Qt::cyan, 0));
+    painter->drawLine(m_clearance);
+  }
 }
@@ -24,6 +24,7 @@
 #define __MEASUREGRAPHICSITEM__
 
 #include <QGraphicsItem>
+#include <QLineF>
 
 class MeasureGraphicsItem: public QGraphicsItem {
 public:
@@ -32,11 +33,15 @@ public:
   virtual QRectF boundingRect() const;
   void setRect(const QRectF& rect);
 
+  /* Edge-to-edge clearance found at the end points, null line for none */
+  void setClearanceLine(const QLineF& line);
+
   virtual void paint(QPainter *painter, const QStyleOptionGraphicsItem *option,
       QWidget *widget);
 
 private:
   QRectF m_rect;
+  QLineF m_clearance;
 };
 
 #endif /* __MEASUREGRAPHICSITEM__ */
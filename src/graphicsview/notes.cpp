@@ -29,7 +29,7 @@
 #include "archiveloader.h" 
 Notes::Notes(QString step, QString layer): Symbol("symbol"), m_empty(false)
 {
-  QString filename = ctx.loader->absPath(QString("steps/%1/layers/%2/notes")
+  QString filename = ctx.loader->dataPath(QString("steps/%1/layers/%2/notes")
       .arg(step).arg(layer));
 
   NotesParser parser(filename);
@@ -57,6 +57,13 @@ void ODBPPGraphicsScene::setMeasureEnabled(bool status)
   m_state = (status? S_MEASURE: S_NONE);
 }
 
+void ODBPPGraphicsScene::setMeasureClearance(const QLineF& line)
+{
+  if (m_measured) {
+    m_measureRubberBand->setClearanceLine(line);
+  }
+}
+
 void ODBPPGraphicsScene::setHighlightEnabled(bool status)
 {
   for (int i = 0; i < m_layers.size(); ++i) {
@@ -159,6 +166,7 @@ void ODBPPGraphicsScene::mousePressEvent(QGraphicsSceneMouseEvent* event)
     break;
   case S_MEASURE_ACTIVE:
     m_state = S_MEASURE;
+    emit measureLineSelected(m_rubberPS, event->scenePos());
     break;
   default:
     break;
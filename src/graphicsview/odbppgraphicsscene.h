@@ -53,6 +53,7 @@ public:
   void updateLayerViewport(QRect viewRect, QRectF sceneRect);
 
   void setMeasureEnabled(bool status);
+  void setMeasureClearance(const QLineF& line);
   void setHighlightEnabled(bool status);
   void clearHighlight(void);
 
@@ -61,6 +62,7 @@ signals:
   void featureSelected(Symbol*);
   void rectSelected(QRectF);
   void measureRectSelected(QRectF);
+  void measureLineSelected(QPointF, QPointF);
 
 public slots:
   void setBackgroundColor(QColor color);
@@ -0,0 +1,263 @@
+/**
+ * @file   pickbuffer.cpp
+ * @author Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ *
+ * Copyright (C) 2012 - 2014 Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ * All Rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "pickbuffer.h"
+
+#include <QImage>
+#include <QMap>
+#include <QPainter>
+#include <QtCore/qmath.h>
+
+#include "layer.h"
+#include "layerfeatures.h"
+#include "logger.h"
+#include "parallel.h"
+#include "symbol.h"
+
+#define PICK_ID_MASK 0x00ffffff
+
+static void paintPickSymbol(QPainter* painter, const QTransform& view,
+    Symbol* symbol, QRgb id)
+{
+  // Negative features clear whatever lies below them on this layer
+  if (symbol->polarity() == N) {
+    id = 0;
+  }
+
+  QList<QGraphicsItem*> children = symbol->childItems();
+  if (children.isEmpty()) {
+    QColor color = QColor::fromRgb(0xff000000 | id);
+    painter->setTransform(symbol->sceneTransform() * view);
+    painter->setPen(QPen(color, 0));
+    painter->setBrush(color);
+    painter->drawPath(symbol->shape());
+    return;
+  }
+
+  for (int i = 0; i < children.size(); ++i) {
+    Symbol* child = dynamic_cast<Symbol*>(children[i]);
+    if (child && child->isVisible()) {
+      paintPickSymbol(painter, view, child, id);
+    }
+  }
+}
+
+PickBuffer::PickBuffer()
+{
+}
+
+void PickBuffer::clear(void)
+{
+  m_size = QSize();
+  m_sceneRect = QRectF();
+  m_layers.clear();
+  m_entries.clear();
+  m_ids.clear();
+}
+
+bool PickBuffer::isValidFor(const QSize& size, const QRectF& sceneRect) const
+{
+  return !isNull() && m_size == size && m_sceneRect == sceneRect;
+}
+
+void PickBuffer::render(const QList<Layer*>& layers, const QSize& size,
+    const QRectF& sceneRect)
+{
+  clear();
+
+  if (size.isEmpty() || sceneRect.isEmpty()) {
+    return;
+  }
+
+  m_size = size;
+  m_sceneRect = sceneRect;
+  m_layers = layers;
+  m_transform = QTransform::fromScale(size.width() / sceneRect.width(),
+      size.height() / sceneRect.height());
+  m_transform.translate(-sceneRect.left(), -sceneRect.top());
+  m_ids.fill(0, size.width() * size.height());
+
+  // Every layer is drawn into its own scratch image with layer-local IDs so
+  // its negative features cannot punch holes into the layers below it.
+  QImage scratch(size, QImage::Format_RGB32);
+
+  for (int l = 0; l < layers.size(); ++l) {
+    Layer* layer = layers[l];
+    if (!layer || !layer->isVisible()) {
+      continue;
+    }
+
+    scratch.fill(0);
+    int base = m_entries.size();
+
+    QPainter painter(&scratch);
+    painter.setRenderHint(QPainter::Antialiasing, false);
+
+    QList<LayerFeatures*> features = layer->allFeatures();
+    for (int f = 0; f < features.size(); ++f) {
+      LayerFeatures* lf = features[f];
+      if (!lf->dataStore()) {
+        continue;
+      }
+
+      int count = lf->dataStore()->records().size();
+      for (int i = 0; i < count; ++i) {
+        Symbol* symbol = lf->symbolAt(i);
+        if (!symbol || !symbol->isVisible() ||
+            !symbol->sceneBoundingRect().intersects(sceneRect)) {
+          continue;
+        }
+
+        QRgb id = 0;
+        if (symbol->polarity() == P) {
+          if (m_entries.size() - base >= PICK_ID_MASK) {
+            LOG_WARNING("Pick buffer: too many features in view, "
+                "remaining ones are not pickable");
+            break;
+          }
+          Entry entry = { l, i, lf, symbol };
+          m_entries.append(entry);
+          id = m_entries.size() - base;
+        }
+        paintPickSymbol(&painter, m_transform, symbol, id);
+      }
+    }
+    painter.end();
+
+    // Later layers are drawn on top, so they win where they cover a pixel
+    quint32* ids = m_ids.data();
+    const QImage& image = scratch;
+    int width = size.width();
+    Parallel::forRange(size.height(), 64, [&](int begin, int end) {
+      for (int y = begin; y < end; ++y) {
+        const QRgb* line =
+          reinterpret_cast<const QRgb*>(image.constScanLine(y));
+        quint32* out = ids + y * width;
+        for (int x = 0; x < width; ++x) {
+          quint32 local = line[x] & PICK_ID_MASK;
+          if (local) {
+            out[x] = base + local;
+          }
+        }
+      }
+    });
+  }
+}
+
+QPoint PickBuffer::mapFromScene(const QPointF& pos) const
+{
+  QPointF p = m_transform.map(pos);
+  return QPoint(qFloor(p.x()), qFloor(p.y()));
+}
+
+const PickBuffer::Entry* PickBuffer::at(const QPoint& pixel) const
+{
+  if (pixel.x() < 0 || pixel.y() < 0 || pixel.x() >= m_size.width() ||
+      pixel.y() >= m_size.height()) {
+    return NULL;
+  }
+
+  quint32 id = m_ids[pixel.y() * m_size.width() + pixel.x()];
+  return id? &m_entries[id - 1]: NULL;
+}
+
+const PickBuffer::Entry* PickBuffer::atScene(const QPointF& pos) const
+{
+  return at(mapFromScene(pos));
+}
+
+QList<const PickBuffer::Entry*> PickBuffer::entriesIn(const QRect& rect) const
+{
+  QList<const Entry*> result;
+  QRect r = rect.intersected(QRect(QPoint(0, 0), m_size));
+  if (r.isEmpty()) {
+    return result;
+  }
+
+  // Report in order of decreasing coverage so the dominant feature is first
+  QMap<quint32, int> coverage;
+  for (int y = r.top(); y <= r.bottom(); ++y) {
+    const quint32* line = m_ids.constData() + y * m_size.width();
+    for (int x = r.left(); x <= r.right(); ++x) {
+      if (line[x]) {
+        ++coverage[line[x]];
+      }
+    }
+  }
+
+  QMultiMap<int, quint32> byCoverage;
+  for (QMap<quint32, int>::const_iterator it = coverage.begin();
+      it != coverage.end(); ++it) {
+    byCoverage.insert(-it.value(), it.key());
+  }
+  for (QMultiMap<int, quint32>::const_iterator it = byCoverage.begin();
+      it != byCoverage.end(); ++it) {
+    result.append(&m_entries[it.value() - 1]);
+  }
+
+  return result;
+}
+
+QJsonObject PickBuffer::toJson(const Entry* entry) const
+{
+  QJsonObject obj;
+  if (!entry) {
+    return obj;
+  }
+
+  Layer* l = m_layers.value(entry->layer);
+  obj["layer"] = l? l->layer(): QString();
+  obj["step"] = entry->features->dataStore()->stepName().toLower();
+  obj["index"] = entry->feature;
+  obj["type"] = recordType(record(entry));
+  obj["symbol"] = entry->symbol->name();
+  obj["info"] = entry->symbol->infoText();
+  obj["selected"] = entry->symbol->isSelected();
+  return obj;
+}
+
+const Record* PickBuffer::record(const Entry* entry)
+{
+  if (!entry || !entry->features) {
+    return NULL;
+  }
+  return entry->features->dataStore()->records().value(entry->feature);
+}
+
+QString PickBuffer::recordType(const Record* rec)
+{
+  // Barcodes are text records too, so test them first
+  if (dynamic_cast<const LineRecord*>(rec)) {
+    return "line";
+  } else if (dynamic_cast<const PadRecord*>(rec)) {
+    return "pad";
+  } else if (dynamic_cast<const ArcRecord*>(rec)) {
+    return "arc";
+  } else if (dynamic_cast<const BarcodeRecord*>(rec)) {
+    return "barcode";
+  } else if (dynamic_cast<const TextRecord*>(rec)) {
+    return "text";
+  } else if (dynamic_cast<const SurfaceRecord*>(rec)) {
+    return "surface";
+  }
+  return QString();
+}
@@ -0,0 +1,90 @@
+/**
+ * @file   pickbuffer.h
+ * @author Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ *
+ * Copyright (C) 2012 - 2014 Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ * All Rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __PICKBUFFER_H__
+#define __PICKBUFFER_H__
+
+#include <QJsonObject>
+#include <QList>
+#include <QRect>
+#include <QRectF>
+#include <QSize>
+#include <QTransform>
+#include <QVector>
+
+class Layer;
+class LayerFeatures;
+struct Record;
+class Symbol;
+
+/**
+ * Per-pixel feature ID buffer.
+ *
+ * Renders the features of one or more layers into an ID image instead of a
+ * colour image: every pixel holds the topmost positive feature covering it
+ * (negative features clear what lies below them on the same layer, just like
+ * they do on screen).  Looking up what is under a pixel is then a single
+ * array access instead of a colour match or a walk over the scene.
+ */
+class PickBuffer {
+public:
+  struct Entry {
+    int layer;                /* index into the layers passed to render() */
+    int feature;              /* index into features->dataStore()->records() */
+    LayerFeatures* features;
+    Symbol* symbol;
+  };
+
+  PickBuffer();
+
+  void render(const QList<Layer*>& layers, const QSize& size,
+      const QRectF& sceneRect);
+  void clear(void);
+
+  bool isNull(void) const { return m_ids.isEmpty(); }
+  bool isValidFor(const QSize& size, const QRectF& sceneRect) const;
+  QSize size(void) const { return m_size; }
+  QRectF sceneRect(void) const { return m_sceneRect; }
+
+  QPoint mapFromScene(const QPointF& pos) const;
+  const Entry* at(const QPoint& pixel) const;
+  const Entry* atScene(const QPointF& pos) const;
+  QList<const Entry*> entriesIn(const QRect& rect) const;
+
+  Layer* layer(int index) const { return m_layers.value(index); }
+  QJsonObject toJson(const Entry* entry) const;
+
+  /* Record picked by entry, NULL if there is none */
+  static const Record* record(const Entry* entry);
+  /* "line", "pad", "arc", "text", "barcode" or "surface" */
+  static QString recordType(const Record* rec);
+
+private:
+  QSize m_size;
+  QRectF m_sceneRect;
+  QTransform m_transform;
+  QList<Layer*> m_layers;
+  QVector<Entry> m_entries;
+  QVector<quint32> m_ids;
+};
+
+#endif /* __PICKBUFFER_H__ */
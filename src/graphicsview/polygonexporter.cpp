@@ -0,0 +1,259 @@
+/**
+ * @file   polygonexporter.cpp
+ * @author Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ *
+ * Copyright (C) 2012 - 2014 Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ * All Rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "polygonexporter.h"
+
+#include <cstring>
+
+#include <QElapsedTimer>
+#include <QSaveFile>
+#include <QVector>
+#include <QtEndian>
+
+#include "layercopper.h"
+#include "logger.h"
+#include "parallel.h"
+
+using namespace PolygonBoolean;
+
+#define EXPORT_MAGIC "QCPOLYGN"
+#define EXPORT_END "QCPOLEND"
+#define EXPORT_VERSION 2
+
+template <typename T>
+static void put(QByteArray& out, T value)
+{
+  T le = qToLittleEndian(value);
+  out.append(reinterpret_cast<const char*>(&le), sizeof(T));
+}
+
+static void putDouble(QByteArray& out, double value)
+{
+  quint64 bits;
+  memcpy(&bits, &value, sizeof(bits));
+  put<quint64>(out, bits);
+}
+
+static void putRect(QByteArray& out, const IntRect& r)
+{
+  put<qint64>(out, r.left);
+  put<qint64>(out, r.bottom);
+  put<qint64>(out, r.right);
+  put<qint64>(out, r.top);
+}
+
+static void putVarint(QByteArray& out, quint64 value)
+{
+  while (value >= 0x80) {
+    out.append(char(value | 0x80));
+    value >>= 7;
+  }
+  out.append(char(value));
+}
+
+static void putDelta(QByteArray& out, qint64 delta)
+{
+  putVarint(out, (quint64(delta) << 1) ^ quint64(delta >> 63));
+}
+
+/* Scene y points down; machines and ODB++ have it pointing up */
+static IntRect machineRect(const IntRect& r)
+{
+  return IntRect(r.left, -r.top, r.right, -r.bottom);
+}
+
+static void putRing(QByteArray& out, const IntPath& ring, IntPoint& last)
+{
+  putVarint(out, ring.size());
+  // Mirroring y reverses the ring, walking it backwards restores the
+  // orientation
+  for (int i = ring.size() - 1; i >= 0; --i) {
+    IntPoint p(ring[i].x, -ring[i].y);
+    putDelta(out, p.x - last.x);
+    putDelta(out, p.y - last.y);
+    last = p;
+  }
+}
+
+/* One island's polygons, merged across tile borders, and its bounds */
+struct Island {
+  QByteArray payload;
+  IntRect rect;
+  int polygons;
+};
+
+static Island encodeIsland(const QVector<Polygon>& pieces,
+    const QVector<int>& members)
+{
+  // Pieces of an island meet exactly on the tile grid lines, so their union
+  // closes the seams
+  QVector<Polygon> merged;
+  if (members.size() == 1) {
+    merged.append(pieces[members[0]]);
+  } else {
+    QVector<Subject> subjects(members.size());
+    for (int i = 0; i < members.size(); ++i) {
+      const Polygon& piece = pieces[members[i]];
+      subjects[i].rings = piece.holes;
+      subjects[i].rings.prepend(piece.outer);
+    }
+    merged = flatten(subjects);
+  }
+
+  Island island;
+  island.polygons = merged.size();
+  bool first = true;
+  for (int i = 0; i < merged.size(); ++i) {
+    const IntPath& outer = merged[i].outer;
+    for (int k = 0; k < outer.size(); ++k) {
+      if (first) {
+        island.rect = IntRect(outer[k].x, outer[k].y, outer[k].x,
+            outer[k].y);
+        first = false;
+      }
+      island.rect.left = qMin(island.rect.left, outer[k].x);
+      island.rect.bottom = qMin(island.rect.bottom, outer[k].y);
+      island.rect.right = qMax(island.rect.right, outer[k].x);
+      island.rect.top = qMax(island.rect.top, outer[k].y);
+    }
+  }
+  island.rect = machineRect(island.rect);
+
+  IntPoint prev(island.rect.left, island.rect.bottom);
+  for (int i = 0; i < merged.size(); ++i) {
+    const Polygon& polygon = merged[i];
+    putVarint(island.payload, polygon.holes.size() + 1);
+    putRing(island.payload, polygon.outer, prev);
+    for (int h = 0; h < polygon.holes.size(); ++h) {
+      putRing(island.payload, polygon.holes[h], prev);
+    }
+  }
+  return island;
+}
+
+PolygonExporter::PolygonExporter(LayerCopper* copper):
+  m_copper(copper), m_polygonCount(0)
+{
+}
+
+bool PolygonExporter::write(const QString& fileName)
+{
+  QElapsedTimer timer;
+  timer.start();
+
+  const QVector<Polygon>& intPolygons = m_copper->intPolygons();
+  const QVector<int>& islands = m_copper->islands();
+  int islandCount = m_copper->islandCount();
+
+  QVector<QVector<int> > members(islandCount);
+  for (int i = 0; i < islands.size(); ++i) {
+    members[islands[i]].append(i);
+  }
+
+  IntRect bounds;
+  for (int t = 0; t < m_copper->tileCount(); ++t) {
+    IntRect r = machineRect(m_copper->intTileRect(t));
+    if (t == 0) {
+      bounds = r;
+    } else {
+      bounds.left = qMin(bounds.left, r.left);
+      bounds.bottom = qMin(bounds.bottom, r.bottom);
+      bounds.right = qMax(bounds.right, r.right);
+      bounds.top = qMax(bounds.top, r.top);
+    }
+  }
+
+  QSaveFile file(fileName);
+  if (!file.open(QIODevice::WriteOnly)) {
+    m_errorString = file.errorString();
+    return false;
+  }
+
+  QByteArray header(EXPORT_MAGIC, 8);
+  put<quint32>(header, EXPORT_VERSION);
+  put<quint32>(header, islandCount);
+  putDouble(header, m_copper->resolution());
+  putRect(header, bounds);
+  header.append(8, '\0');
+
+  QByteArray index("IIDX", 4);
+  put<quint32>(index, islandCount);
+
+  qint64 offset = 0;
+  bool ok = (file.write(header) == header.size());
+  offset += header.size();
+
+  // Merge a few islands per thread ahead of the writer, so payloads never
+  // pile up for the whole layer
+  int polygonCount = 0;
+  int batch = Parallel::threadCount() * 4;
+  for (int begin = 0; ok && begin < islandCount; begin += batch) {
+    int end = qMin(begin + batch, islandCount);
+    QVector<Island> encoded(end - begin);
+    Island* encodedData = encoded.data();
+    Parallel::forRange(end - begin, 1, [&](int b, int e) {
+      for (int k = b; k < e; ++k) {
+        encodedData[k] = encodeIsland(intPolygons, members[begin + k]);
+      }
+    });
+
+    for (int i = begin; ok && i < end; ++i) {
+      const Island& island = encoded[i - begin];
+      QByteArray chunk("ISLD", 4);
+      put<quint32>(chunk, i);
+      putRect(chunk, island.rect);
+      put<quint32>(chunk, island.polygons);
+      put<quint32>(chunk, island.payload.size());
+
+      putRect(index, island.rect);
+      put<quint64>(index, offset);
+      put<quint32>(index, island.polygons);
+      put<quint32>(index, island.payload.size());
+
+      ok = (file.write(chunk) == chunk.size() &&
+          file.write(island.payload) == island.payload.size());
+      offset += chunk.size() + island.payload.size();
+      polygonCount += island.polygons;
+    }
+  }
+
+  QByteArray footer;
+  put<quint64>(footer, offset);
+  footer.append(EXPORT_END, 8);
+
+  if (!ok || file.write(index) != index.size() ||
+      file.write(footer) != footer.size()) {
+    m_errorString = file.errorString();
+    file.cancelWriting();
+    return false;
+  }
+  if (!file.commit()) {
+    m_errorString = file.errorString();
+    return false;
+  }
+
+  m_polygonCount = polygonCount;
+  LOG_INFO(QString("Exported %1 polygons in %2 islands to %3 in %4 ms")
+      .arg(m_polygonCount).arg(islandCount).arg(fileName)
+      .arg(timer.elapsed()));
+  return true;
+}
@@ -0,0 +1,76 @@
+/**
+ * @file   polygonexporter.h
+ * @author Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ *
+ * Copyright (C) 2012 - 2014 Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ * All Rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __POLYGONEXPORTER_H__
+#define __POLYGONEXPORTER_H__
+
+#include <QByteArray>
+#include <QString>
+
+class LayerCopper;
+
+/**
+ * Writes the final copper of a layer as polygons for inspection machines.
+ *
+ * The polygons are those of LayerCopper, so negative features are already
+ * resolved and step-repeat instances are included whenever the layer shows
+ * them.  LayerCopper flattens the layer in tiles; the pieces of each island
+ * are merged back across the tile borders here, so a pour is written whole
+ * and never split at a seam.  Coordinates are integers on the LayerCopper
+ * grid in machine orientation (y up, the ODB++ frame): outer contours
+ * counter-clockwise, holes clockwise.  All numbers are little-endian.
+ *
+ *   header  "QCPOLYGN", u32 version (2), u32 island count, f64 resolution
+ *           in layer units, i64 left, bottom, right, top, 8 bytes reserved
+ *   islands "ISLD", u32 island, i64 left, bottom, right, top, u32 polygon
+ *           count, u32 payload size, payload
+ *   index   "IIDX", u32 island count, then per island i64 left, bottom,
+ *           right, top, u64 chunk offset, u32 polygon count, u32 payload
+ *           size
+ *   footer  u64 index offset, "QCPOLEND"
+ *
+ * An island is one connected piece of copper, normally a single polygon.
+ * A payload holds LEB128 varints: per polygon the ring count
+ * (outer ring first), per ring the point count and then its points.
+ * Points are zigzagged deltas from the previous point of the island, the
+ * first one from the left bottom corner of the island's bounds.  Chunks are
+ * self-contained, so the file can be consumed as a stream; a reader after
+ * one region seeks to the index through the footer and reads only the
+ * islands whose bounds it overlaps.  Islands are merged in parallel and
+ * written in order.
+ */
+class PolygonExporter {
+public:
+  PolygonExporter(LayerCopper* copper);
+
+  bool write(const QString& fileName);
+  QString errorString(void) const { return m_errorString; }
+
+  int polygonCount(void) const { return m_polygonCount; }
+
+private:
+  LayerCopper* m_copper;
+  QString m_errorString;
+  int m_polygonCount;
+};
+
+#endif /* __POLYGONEXPORTER_H__ */
@@ -0,0 +1,258 @@
+/**
+ * @file   spacingchecker.cpp
+ * @author Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ *
+ * Copyright (C) 2012 - 2014 Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ * All Rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "spacingchecker.h"
+
+#include <algorithm>
+
+#include <QJsonArray>
+#include <QMutex>
+#include <QtCore/qmath.h>
+
+#include "arcgeometry.h"
+#include "layergeometry.h"
+#include "logger.h"
+#include "parallel.h"
+#include "polygonboolean.h"
+
+/* Features per tile the grid is sized for */
+#define TILE_FEATURES 1024
+
+/* Grid negatives are resolved on, in layer units */
+#define RESOLVE_RESOLUTION 1e-6
+
+SpacingChecker::SpacingChecker(LayerGeometry* geometry):
+  m_geometry(geometry), m_tileCount(0)
+{
+}
+
+bool SpacingChecker::isErased(int feature, const QPointF& p) const
+{
+  const LayerGeometry::Feature& f = m_geometry->feature(feature);
+  bool erased = false;
+
+  // Only negatives of the same features file drawn later can clear it
+  m_geometry->index().visit(QRectF(p, QSizeF(0, 0)), [&](int j) {
+    const LayerGeometry::Feature& n = m_geometry->feature(j);
+    if (erased || n.positive || n.features != f.features ||
+        n.index < f.index) {
+      return;
+    }
+    Proximity d = ShapeDistance::toPoint(m_geometry->shape(j), p);
+    if (d.isValid() && d.distance <= 0) {
+      erased = true;
+    }
+  });
+
+  return erased;
+}
+
+// What is left of a feature once the negatives drawn after it are applied
+FeatureShape SpacingChecker::resolved(int feature) const
+{
+  using namespace PolygonBoolean;
+
+  const LayerGeometry::Feature& f = m_geometry->feature(feature);
+  const FeatureShape& shape = m_geometry->shape(feature);
+  qreal scale = 1.0 / RESOLVE_RESOLUTION;
+  qreal tolerance = ArcGeometry::tolerance();
+
+  QVector<Subject> subjects;
+  Subject subject;
+  QList<QPolygonF> polygons = shape.toPolygons(tolerance);
+  for (int p = 0; p < polygons.size(); ++p) {
+    subject.rings.append(toIntPath(polygons[p], scale));
+  }
+  subjects.append(subject);
+
+  QVector<int> negatives;
+  m_geometry->index().visit(shape.boundingRect(), [&](int j) {
+    const LayerGeometry::Feature& n = m_geometry->feature(j);
+    if (!n.positive && n.features == f.features && n.index >= f.index) {
+      negatives.append(j);
+    }
+  });
+
+  // Feature order is drawing order
+  std::sort(negatives.begin(), negatives.end());
+  for (int k = 0; k < negatives.size(); ++k) {
+    Subject negative;
+    negative.positive = false;
+    polygons = m_geometry->shape(negatives[k]).toPolygons(tolerance);
+    for (int p = 0; p < polygons.size(); ++p) {
+      negative.rings.append(toIntPath(polygons[p], scale));
+    }
+    subjects.append(negative);
+  }
+
+  QList<QPolygonF> rings;
+  QVector<Polygon> result = flatten(subjects);
+  for (int p = 0; p < result.size(); ++p) {
+    rings.append(toPolygonF(result[p].outer, scale));
+    for (int h = 0; h < result[p].holes.size(); ++h) {
+      rings.append(toPolygonF(result[p].holes[h], scale));
+    }
+  }
+
+  return FeatureShape::contour(rings);
+}
+
+QVector<SpacingChecker::Violation> SpacingChecker::check(qreal minSpacing)
+{
+  QVector<Violation> violations;
+  int count = m_geometry->count();
+  QRectF bounds = m_geometry->boundingRect();
+  if (count == 0 || minSpacing <= 0 || bounds.isNull()) {
+    return violations;
+  }
+
+  // Nets are built lazily, do it before going parallel
+  m_geometry->netCount();
+
+  // Grid roughly square in tile shape with TILE_FEATURES features per tile
+  int tiles = qMax(1, count / TILE_FEATURES);
+  qreal aspect = (bounds.height() > 0)? bounds.width() / bounds.height(): 1;
+  int nx = qBound(1, qCeil(qSqrt(tiles * aspect)), tiles);
+  int ny = qMax(1, (tiles + nx - 1) / nx);
+  m_tileCount = nx * ny;
+
+  qreal tw = bounds.width() / nx, th = bounds.height() / ny;
+  QVector<QVector<int> > tileFeatures(m_tileCount);
+  for (int i = 0; i < count; ++i) {
+    if (!m_geometry->feature(i).positive || m_geometry->shape(i).isEmpty()) {
+      continue;
+    }
+    QPointF c = m_geometry->shape(i).boundingRect().center();
+    int tx = (tw > 0)? qBound(0, (int)((c.x() - bounds.left()) / tw), nx - 1): 0;
+    int ty = (th > 0)? qBound(0, (int)((c.y() - bounds.top()) / th), ny - 1): 0;
+    tileFeatures[ty * nx + tx].append(i);
+  }
+
+  // Largest tiles first so stragglers are small
+  QVector<int> order(m_tileCount);
+  for (int t = 0; t < m_tileCount; ++t) {
+    order[t] = t;
+  }
+  std::sort(order.begin(), order.end(), [&](int a, int b) {
+    return tileFeatures[a].size() > tileFeatures[b].size();
+  });
+
+  const LayerGeometry* geometry = m_geometry;
+  QMutex mutex;
+
+  Parallel::forRange(m_tileCount, 1, [&](int begin, int end) {
+    QVector<Violation> local;
+
+    for (int t = begin; t < end; ++t) {
+      const QVector<int>& members = tileFeatures[order[t]];
+      for (int m = 0; m < members.size(); ++m) {
+        int i = members[m];
+        const FeatureShape& si = geometry->shape(i);
+        int net = m_geometry->netOf(i);
+        QRectF window = si.boundingRect().adjusted(-minSpacing, -minSpacing,
+            minSpacing, minSpacing);
+
+        geometry->index().visit(window, [&](int j) {
+          if (j <= i || !geometry->feature(j).positive) {
+            return;
+          }
+          int other = m_geometry->netOf(j);
+          if (other < 0 || other == net) {
+            return;
+          }
+          const FeatureShape& sj = geometry->shape(j);
+          if (ShapeDistance::boundsDistance(si.boundingRect(),
+                sj.boundingRect()) >= minSpacing) {
+            return;
+          }
+
+          Proximity gap = ShapeDistance::between(si, sj);
+          if (!gap.isValid() || gap.distance >= minSpacing) {
+            return;
+          }
+          if (isErased(i, gap.pa) || isErased(j, gap.pb)) {
+            // The closest points are gone, measure on the copper left over
+            FeatureShape ri = resolved(i), rj = resolved(j);
+            if (ri.isEmpty() || rj.isEmpty()) {
+              return;
+            }
+            gap = ShapeDistance::between(ri, rj);
+            if (!gap.isValid() || gap.distance >= minSpacing) {
+              return;
+            }
+          }
+
+          Violation v;
+          v.a = i;
+          v.b = j;
+          v.gap = gap;
+          local.append(v);
+        });
+      }
+    }
+
+    if (!local.isEmpty()) {
+      QMutexLocker locker(&mutex);
+      violations += local;
+    }
+  });
+
+  std::sort(violations.begin(), violations.end(),
+      [](const Violation& x, const Violation& y) {
+    return (x.a != y.a)? x.a < y.a: x.b < y.b;
+  });
+
+  LOG_INFO(QString("Spacing check < %1: %2 violations over %3 tiles")
+      .arg(minSpacing).arg(violations.size()).arg(m_tileCount));
+
+  return violations;
+}
+
+QJsonObject SpacingChecker::toJson(const QVector<Violation>& violations,
+    qreal minSpacing)
+{
+  // ODB++ coordinates, y up
+  QJsonArray items;
+  for (int i = 0; i < violations.size(); ++i) {
+    const Violation& v = violations[i];
+    QJsonObject item;
+    item["a"] = m_geometry->toJson(v.a);
+    item["b"] = m_geometry->toJson(v.b);
+    item["distance"] = v.gap.distance;
+
+    QJsonObject pa, pb;
+    pa["x"] = v.gap.pa.x();
+    pa["y"] = -v.gap.pa.y();
+    pb["x"] = v.gap.pb.x();
+    pb["y"] = -v.gap.pb.y();
+    item["pointA"] = pa;
+    item["pointB"] = pb;
+    items.append(item);
+  }
+
+  QJsonObject obj;
+  obj["minSpacing"] = minSpacing;
+  obj["count"] = violations.size();
+  obj["tiles"] = m_tileCount;
+  obj["violations"] = items;
+  return obj;
+}
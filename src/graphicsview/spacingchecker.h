@@ -0,0 +1,70 @@
+/**
+ * @file   spacingchecker.h
+ * @author Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ *
+ * Copyright (C) 2012 - 2014 Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ * All Rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __SPACINGCHECKER_H__
+#define __SPACINGCHECKER_H__
+
+#include <QJsonObject>
+#include <QVector>
+
+#include "featureshape.h"
+
+class LayerGeometry;
+
+/**
+ * Layer-wide minimum spacing check.
+ *
+ * Reports every pair of positive features on different nets whose
+ * edge-to-edge gap is below a threshold.  The layer is cut into tiles by
+ * feature position; tiles are pulled from a shared queue by the worker
+ * threads and every feature only looks at neighbours with a higher id, so
+ * each pair is examined exactly once.
+ *
+ * Negative features are taken into account when the closest point on
+ * either feature is erased by a negative feature drawn after it: both
+ * features are then resolved against the negatives covering them and the
+ * gap is measured again on what is left.
+ */
+class SpacingChecker {
+public:
+  struct Violation {
+    int a, b;           /* LayerGeometry feature ids, a < b */
+    Proximity gap;
+  };
+
+  SpacingChecker(LayerGeometry* geometry);
+
+  QVector<Violation> check(qreal minSpacing);
+
+  int tileCount(void) const { return m_tileCount; }
+
+  QJsonObject toJson(const QVector<Violation>& violations, qreal minSpacing);
+
+private:
+  bool isErased(int feature, const QPointF& p) const;
+  FeatureShape resolved(int feature) const;
+
+  LayerGeometry* m_geometry;
+  int m_tileCount;
+};
+
+#endif /* __SPACINGCHECKER_H__ */
@@ -8,7 +8,8 @@ HEADERS += \
   gui/layerinfobox.h \
   gui/jobmanagerdialog.h \
     gui/featurepropertiesdialog.h \
-    gui/featureshistogramwidget.h
+    gui/featureshistogramwidget.h \
+  gui/gotocoordinatedialog.h
 
 SOURCES += \
   gui/jobmatrix.cpp \
@@ -19,7 +20,8 @@ SOURCES += \
   gui/layerinfobox.cpp \
   gui/jobmanagerdialog.cpp \
     gui/featurepropertiesdialog.cpp \
-    gui/featureshistogramwidget.cpp
+    gui/featureshistogramwidget.cpp \
+  gui/gotocoordinatedialog.cpp
 
 FORMS += \
   gui/jobmatrix.ui \
@@ -92,7 +92,7 @@ void Home::showJobPage(const QString jobName)
   Code39::initPatterns();
   yydebug = 0;
   ctx.loader = new ArchiveLoader(currJob+".tgz");
-  StructuredTextParser parser(ctx.loader->absPath("matrix/matrix"));
+  StructuredTextParser parser(ctx.loader->dataPath("matrix/matrix"));
   ds = parser.parse();
 
   ClickableLabel *matrix = new ClickableLabel("Job Matrix");
@@ -26,11 +26,13 @@
 #include <QtWidgets>
 
 #include "context.h"
+#include "jobindex.h"
 #include "jobmatrix.h"
 #include "logger.h"
 #include "settings.h"
-#include "structuredtextparser.h"
-#include "archiveloader.h" 
+#include "archiveloader.h"
+#include "jobimporter.h"
+
 JobManagerDialog::JobManagerDialog(QWidget *parent) :
     QWidget(parent),
     ui(new Ui::JobManagerDialog)
@@ -124,132 +126,80 @@ void JobManagerDialog::on_importButton_clicked(void)
   QString extractDir = jobsDir.absoluteFilePath(jobName);
   LOG_INFO(QString("Extract directory: %1").arg(extractDir));
 
-  // Decompress tarball
+  // Extract the tarball and decode all compressed layers in-process
   LOG_STEP("Preparing to decompress main tarball");
-  QStringList args;
-
-#ifdef Q_WS_WIN
-  filename.replace(":", "");
-  filename.prepend('/');
-  LOG_INFO(QString("Windows path adjusted: %1").arg(filename));
-#endif
-
-  args << "xf" << filename << "--strip-components=1" << "-C" << extractDir;
-  LOG_INFO(QString("TAR command: %1 %2").arg(TAR_CMD, args.join(" ")));
-  LOG_DEBUG(QString("TAR command (raw): %1 xf %2 --strip-components=1 -C %3")
-      .arg(TAR_CMD).arg(filename).arg(extractDir));
-
-  QMessageBox msg(QMessageBox::Information, "Progress",
-      "Decompressing archive...");
-  msg.setStandardButtons(QMessageBox::NoButton);
-  msg.show();
-
-  LOG_STEP("Executing TAR extraction");
-  int ret = execute(TAR_CMD, args);
+  QProgressDialog progress("Decompressing archive...", "Cancel", 0, 1000,
+      this);
+  progress.setWindowTitle("Progress");
+  progress.setWindowModality(Qt::WindowModal);
+  progress.setMinimumDuration(0);
+
+  LOG_STEP("Executing archive extraction");
+  JobImporter importer(filename, extractDir);
+  bool ok = importer.run([&](const JobImporter::Progress& p) {
+    const qreal MB = 1024.0 * 1024.0;
+    if (p.bytesRead < p.bytesTotal) {
+      progress.setLabelText(QString("Decompressing archive... %1 / %2 MB")
+          .arg(p.bytesRead / MB, 0, 'f', 1).arg(p.bytesTotal / MB, 0, 'f', 1));
+      progress.setValue(int(p.bytesRead * 1000 / qMax(p.bytesTotal, 1LL)));
+    } else {
+      progress.setLabelText(QString("Decompressing layers... %1 / %2")
+          .arg(p.layersDone).arg(p.layersTotal));
+      progress.setValue(p.layersTotal?
+          p.layersDone * 1000 / p.layersTotal: 1000);
+    }
+    QCoreApplication::processEvents();
+    return !progress.wasCanceled();
+  });
 
-  msg.hide();
+  progress.reset();
 
-  if (ret != 0) {
-    LOG_ERROR(QString("TAR extraction failed with code: %1").arg(ret));
-    QMessageBox::critical(this, "Error",
-        QString("Error when decompressing `%1'").arg(filename));
+  if (!ok) {
+    if (importer.cancelled()) {
+      LOG_INFO("Import cancelled by user");
+    } else {
+      LOG_ERROR(QString("Import failed: %1").arg(importer.errorString()));
+      QMessageBox::critical(this, "Error",
+          QString("Error when decompressing `%1':\n%2")
+          .arg(filename, importer.errorString()));
+    }
     recurRemove(extractDir);
     return;
   }
-  LOG_INFO("TAR extraction completed successfully");
-
-  // Decompress all layers
-  LOG_STEP("Starting layer decompression");
-  msg.setText("Decompressing all layers...");
-  msg.show();
-
-  QString matrix = extractDir + "/matrix/matrix";
-  LOG_INFO(QString("Parsing matrix file: %1").arg(matrix));
+  LOG_INFO("Archive extraction completed successfully");
 
-  StructuredTextParser parser(matrix);
-  StructuredTextDataStore* ds = parser.parse();
+  // Index the job right away so opening it later needs no parsing
+  LOG_INFO(QString("Parsing matrix file: %1")
+      .arg(extractDir + "/matrix/matrix"));
+  ArchiveLoader loader(extractDir);
+  JobIndex* index = JobIndex::open(extractDir, &loader);
 
-  if (ds == NULL) {
-    LOG_ERROR("Failed to parse matrix file - invalid ODB++ database");
+  if (index == NULL) {
+    LOG_ERROR("Failed to index job - invalid ODB++ database");
     QMessageBox::critical(this, "Error",
         QString("`%1' is not a valid ODB++ database.").arg(filename));
     recurRemove(extractDir);
     return;
   }
+
   LOG_INFO("Matrix file parsed successfully");
 
-  StructuredTextDataStore::BlockIterPair ip;
-  QStringList steps, layers;
+  QStringList steps = index->steps();
+  QStringList layers = index->layerNames();
+  delete index;
 
   LOG_STEP("Extracting step information");
-  ip = ds->getBlocksByKey("STEP");
-  for (StructuredTextDataStore::BlockIter it = ip.first; it != ip.second; ++it)
-  {
-    QString stepName = QString::fromStdString(it->second->get("NAME")).toLower();
-    steps.append(stepName);
+  foreach (const QString& stepName, steps) {
     LOG_INFO(QString("Found step: %1").arg(stepName));
   }
 
   LOG_STEP("Extracting layer information");
-  ip = ds->getBlocksByKey("LAYER");
-  for (StructuredTextDataStore::BlockIter it = ip.first; it != ip.second; ++it)
-  {
-    QString layerName = QString::fromStdString(it->second->get("NAME")).toLower();
-    layers.append(layerName);
+  foreach (const QString& layerName, layers) {
     LOG_INFO(QString("Found layer: %1").arg(layerName));
   }
 
   LOG_INFO(QString("Total steps: %1, Total layers: %2").arg(steps.size()).arg(layers.size()));
 
-  QString layerPathTmpl = extractDir + "/steps/%1/layers/%2/features";
-  int totalFiles = 0;
-  int processedFiles = 0;
-  
-  // Count total compressed files
-  for (int i = 0; i < steps.size(); ++i) {
-    for (int j = 0; j < layers.size(); ++j) {
-      QString path = layerPathTmpl.arg(steps[i]).arg(layers[j]);
-      if (QFile(path + ".Z").exists() || QFile(path + ".z").exists()) {
-        totalFiles++;
-      }
-    }
-  }
-  
-  LOG_INFO(QString("Found %1 compressed layer files to decompress").arg(totalFiles));
-
-  for (int i = 0; i < steps.size(); ++i) {
-    for (int j = 0; j < layers.size(); ++j) {
-      QString path = layerPathTmpl.arg(steps[i]).arg(layers[j]);
-      QString gzFilename;
-      if (QFile(path + ".Z").exists()) {
-        gzFilename = path + ".Z";
-      } else if (QFile(path + ".z").exists()) {
-        gzFilename = path + ".z";
-      } else {
-        continue;
-      }
-
-      processedFiles++;
-      LOG_PROGRESS("Decompressing layers", processedFiles, totalFiles);
-      
-      msg.setText(QString("Decompressing %1/%2 ...")
-          .arg(steps[i]).arg(layers[j]));
-
-      LOG_INFO(QString("Decompressing: %1").arg(gzFilename));
-      int ret = executeGzipDecompression(gzFilename);
-
-      if (ret != 0) {
-        LOG_ERROR(QString("Decompression failed: %1 (code: %2)").arg(gzFilename).arg(ret));
-        QMessageBox::critical(this, "Error",
-            QString("Error when decompressing `%1'").arg(gzFilename));
-        recurRemove(extractDir);
-        msg.hide();
-        return;
-      }
-    }
-  }
-
-  msg.hide();
   LOG_STEP("Import completed successfully");
   LOG_INFO(QString("Job '%1' imported with %2 steps and %3 layers").arg(jobName).arg(steps.size()).arg(layers.size()));
 }
@@ -300,6 +250,20 @@ void JobManagerDialog::on_setRootButton_clicked(void)
   }
 }
 
+void JobManagerDialog::on_listView_clicked(const QModelIndex& index)
+{
+  // Only a stored index is consulted; never parse a job just to select it
+  QString jobPath = m_rootDirName + "/" + m_model->data(index).toString();
+  JobIndex jobIndex;
+
+  if (jobIndex.load(JobIndex::indexPath(jobPath))) {
+    ui->jobInfoLabel->setText(QString("%1 steps, %2 layers")
+        .arg(jobIndex.steps().size()).arg(jobIndex.layers().size()));
+  } else {
+    ui->jobInfoLabel->setText("Not indexed yet");
+  }
+}
+
 void JobManagerDialog::on_listView_doubleClicked(const QModelIndex& index)
 {
   QString name = m_model->data(index).toString();
@@ -324,45 +288,6 @@ void JobManagerDialog::on_listView_doubleClicked(const QModelIndex& index)
   }
 }
 
-int JobManagerDialog::execute(QString cmd, QStringList args)
-{
-  LOG_INFO(QString("Executing command: %1 %2").arg(cmd, args.join(" ")));
-  
-  QEventLoop loop;
-
-  QProcess process;
-  QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
-  env.insert("PATH", env.value("PATH") +
-      PATH_SEP + QCoreApplication::applicationDirPath());
-  process.setProcessEnvironment(env);
-  
-  // Connect process output for debugging
-  connect(&process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
-          [&](int exitCode, QProcess::ExitStatus exitStatus) {
-              LOG_INFO(QString("Process finished - Exit code: %1, Status: %2")
-                      .arg(exitCode)
-                      .arg(exitStatus == QProcess::NormalExit ? "Normal" : "Crashed"));
-              loop.quit();
-          });
-
-  connect(&process, &QProcess::errorOccurred,
-          [&](QProcess::ProcessError error) {
-              LOG_ERROR(QString("Process error occurred: %1").arg(error));
-          });
-
-  process.start(cmd, args);
-  
-  if (!process.waitForStarted()) {
-    LOG_ERROR(QString("Failed to start process: %1").arg(process.errorString()));
-    return -1;
-  }
-  
-  LOG_INFO("Process started successfully");
-  loop.exec();
-
-  return process.exitCode();
-}
-
 bool JobManagerDialog::recurRemove(const QString& dirname)
 {
   LOG_INFO(QString("Recursively removing directory: %1").arg(dirname));
@@ -398,80 +323,3 @@ bool JobManagerDialog::recurRemove(const QString& dirname)
   }
   return result;
 }
-
-int JobManagerDialog::executeGzipDecompression(QString filePath)
-{
-  LOG_INFO(QString("Attempting decompression of: %1").arg(filePath));
-  
-  // Debug: Check which platform we're on
-#ifdef Q_WS_WIN
-  LOG_INFO("Platform detected: Windows (Q_WS_WIN defined)");
-#elif defined(Q_OS_WIN)
-  LOG_INFO("Platform detected: Windows (Q_OS_WIN defined)");
-#else
-  LOG_INFO("Platform detected: Unix/Linux");
-#endif
-  
-#if defined(Q_WS_WIN) || defined(Q_OS_WIN)
-  // Primary method: Use 7-zip on Windows
-  LOG_INFO("Using 7-zip for decompression (Windows)");
-  QStringList sevenZipArgs;
-  sevenZipArgs << "x" << filePath << "-y" << QString("-o%1").arg(QFileInfo(filePath).absolutePath());
-  
-  int ret = execute("7z", sevenZipArgs);
-  if (ret == 0) {
-    LOG_INFO("7-zip decompression successful");
-    // Remove the compressed file after successful extraction
-    if (QFile::remove(filePath)) {
-      LOG_INFO("Compressed file removed successfully");
-    } else {
-      LOG_WARNING("Failed to remove compressed file");
-    }
-    return 0;
-  }
-  LOG_WARNING(QString("7-zip failed with code: %1").arg(ret));
-  
-  // Fallback 1: Try native gzip if available
-  QString gzipPath = QCoreApplication::applicationDirPath() + "/gzip.exe";
-  if (QFile::exists(gzipPath)) {
-    LOG_INFO("Trying local gzip as fallback");
-    QStringList gzipArgs;
-    gzipArgs << "-d" << filePath;
-    
-    ret = execute(gzipPath, gzipArgs);
-    if (ret == 0) {
-      LOG_INFO("Local gzip decompression successful");
-      return 0;
-    }
-    LOG_WARNING(QString("Local gzip failed with code: %1").arg(ret));
-  }
-  
-  // Fallback 2: Try system gzip
-  LOG_INFO("Trying system gzip as fallback");
-  QStringList gzipArgs;
-  gzipArgs << "-d" << filePath;
-  
-  ret = execute("gzip", gzipArgs);
-  if (ret == 0) {
-    LOG_INFO("System gzip decompression successful");
-    return 0;
-  }
-  LOG_WARNING(QString("System gzip failed with code: %1").arg(ret));
-  
-#else
-  // On Linux/Unix, use standard gzip
-  LOG_INFO("Using system gzip (Unix/Linux)");
-  QStringList gzipArgs;
-  gzipArgs << "-d" << filePath;
-  
-  int ret = execute("gzip", gzipArgs);
-  if (ret == 0) {
-    LOG_INFO("Gzip decompression successful");
-    return 0;
-  }
-  LOG_WARNING(QString("Gzip failed with code: %1").arg(ret));
-#endif
-
-  LOG_ERROR("All decompression methods failed");
-  return -1;
-}
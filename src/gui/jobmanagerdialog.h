@@ -26,16 +26,6 @@
 #include <QFileSystemModel>
 #include <QWidget>
 
-#if defined(Q_WS_WIN) || defined(Q_OS_WIN)
-# define TAR_CMD "tar"  // Use system tar on Windows (available in Windows 10+)
-# define GZIP_CMD "7z"  // Use 7-zip as primary decompression tool
-# define PATH_SEP ";"
-#else
-# define TAR_CMD "tar"
-# define GZIP_CMD "gzip"
-# define PATH_SEP ":"
-#endif
-
 namespace Ui {
 class JobManagerDialog;
 }
@@ -53,11 +43,10 @@ public slots:
   void on_importButton_clicked(void);
   void on_removeButton_clicked(void);
   void on_setRootButton_clicked(void);
+  void on_listView_clicked(const QModelIndex& index);
   void on_listView_doubleClicked(const QModelIndex& index);
 
 private:
-  int execute(QString cmd, QStringList args);
-  int executeGzipDecompression(QString filePath);
   bool recurRemove(const QString& dirname);
     
 private:
@@ -26,15 +26,21 @@
 #include <QtWidgets>
 #include "archiveloader.h" 
 #include "context.h"
-#include "structuredtextparser.h"
+#include "jobindex.h"
+#include "logger.h"
 
 JobMatrix::JobMatrix(QString job, QWidget *parent):
   QDialog(parent), ui(new Ui::JobMatrix), m_job(job)
 {
   ui->setupUi(this);
 
-  StructuredTextParser parser(ctx.loader->absPath("matrix/matrix"));
-  m_ds = parser.parse();
+  // The job index carries the matrix and which cells have features, so
+  // neither matrix/matrix nor any features file is read here
+  m_index = ctx.loader->index();
+  if (!m_index) {
+    LOG_ERROR(QString("Cannot read the matrix of job `%1'").arg(job));
+    return;
+  }
 
   setMatrix();
 }
@@ -42,7 +48,6 @@ JobMatrix::JobMatrix(QString job, QWidget *parent):
 JobMatrix::~JobMatrix()
 {
   delete ui;
-  delete m_ds;
 }
 
 void JobMatrix::on_CloseButton_clicked()
@@ -52,44 +57,28 @@ void JobMatrix::on_CloseButton_clicked()
 
 void JobMatrix::setMatrix()
 {
-  StructuredTextDataStore::BlockIterPair ip;
-  QString text,start,end;
-  int steps, layers;
-
-  steps = layers = 0;
-  ip = m_ds->getBlocksByKey("STEP");
-  for (StructuredTextDataStore::BlockIter it = ip.first; it != ip.second; ++it)
-    steps++;
-  ip = m_ds->getBlocksByKey("LAYER");
-  for (StructuredTextDataStore::BlockIter it = ip.first; it != ip.second; ++it)
-    layers++;
-
-  ui->tableWidget->setColumnCount(steps);
-  ui->tableWidget->setRowCount(layers);
-
-  steps = 1;
-  ip = m_ds->getBlocksByKey("STEP");
-  for (StructuredTextDataStore::BlockIter it = ip.first; it != ip.second; ++it)
+  QString text;
+  QList<JobIndex::Layer> layers = m_index->layers();
+
+  m_stepNames = m_index->steps();
+  m_layerNames = m_index->layerNames();
+
+  ui->tableWidget->setColumnCount(m_stepNames.size());
+  ui->tableWidget->setRowCount(layers.size());
+
+  for (int i = 0; i < m_stepNames.size(); i++)
   {
     QTableWidgetItem *item = new QTableWidgetItem();
-    QString stepName = QString::fromStdString(it->second->get("NAME"))
-      .toLower();
-    item->setText(stepName);
-    m_stepNames.append(stepName);
-    ui->tableWidget->setHorizontalHeaderItem(steps - 1,item);
-
-    steps++;
+    item->setText(m_stepNames[i]);
+    ui->tableWidget->setHorizontalHeaderItem(i, item);
   }
 
-  layers = 0;
-  ip = m_ds->getBlocksByKey("LAYER");
-
-  for (StructuredTextDataStore::BlockIter it = ip.first; it != ip.second; ++it)
+  for (int row = 0; row < layers.size(); row++)
   {
+    const JobIndex::Layer& layer = layers[row];
     QTableWidgetItem *item = new QTableWidgetItem();
-    text = QString::fromStdString(it->second->get("TYPE"));
-    QString context = QString::fromStdString(it->second->get("CONTEXT"));
-    if (context == "MISC") {
+    text = layer.type;
+    if (layer.context == "MISC") {
       m_layerTypes.append("DOCUMENT");
     } else {
       m_layerTypes.append(text);
@@ -111,46 +100,36 @@ void JobMatrix::setMatrix()
       text = "(sp ,";
     else
       text = "( ,";
-    if(it->second->get("POLARITY") == "POSITIVE")
+    if(layer.polarity == "POSITIVE")
       text += "p)  ";
     else
       text += "n)  ";
 
-    QString layerName = QString::fromStdString(it->second->get("NAME"))
-      .toLower();
-    m_layerNames.append(layerName);
-    text += layerName;
+    text += layer.name;
     item->setText(text);
-    ui->tableWidget->setVerticalHeaderItem(layers, item);
+    ui->tableWidget->setVerticalHeaderItem(row, item);
 
     for(int i = 0; i < m_stepNames.size(); i++)
     {
-      text = m_stepNames[i] + "/" + layerName;
-      QTableWidgetItem *btn = new QTableWidgetItem(text);
-      ui->tableWidget->setItem(layers, i, btn);
-
-      QString pathTmpl = "steps/%1/layers/%2";
-      text = pathTmpl.arg(m_stepNames[i]).arg(layerName);
-
-      if (QFile(ctx.loader->featuresPath(text)).size() == 0) {
-        btn->setText("");
+      QTableWidgetItem *btn = new QTableWidgetItem();
+      if (m_index->hasFeatures(m_stepNames[i], layer.name)) {
+        JobIndex::Features features = m_index->features(m_stepNames[i],
+            layer.name);
+        btn->setText(m_stepNames[i] + "/" + layer.name);
+        btn->setToolTip(QString("%1 features, %2 symbols, %3 KB")
+            .arg(features.records()).arg(features.symbols)
+            .arg((features.dataSize + 1023) / 1024));
       }
+      ui->tableWidget->setItem(row, i, btn);
     }
-    layers++;
   }
 
-  ip = m_ds->getBlocksByKey("LAYER");
-  for (StructuredTextDataStore::BlockIter it = ip.first; it != ip.second; ++it)
+  foreach (const JobIndex::Layer& layer, layers)
   {
-    text = (QString)it->second->get("TYPE").c_str();
-    if(text == "DRILL"){
-        start = (QString)it->second->get("START_NAME").c_str();
-        end = (QString)it->second->get("END_NAME").c_str();
-        if(start != "")
-        {
-          drawDrillLine((QString)it->second->get("NAME").c_str(),
-                        m_layerNames.indexOf(start),m_layerNames.indexOf(end));
-        }
+    if(layer.type == "DRILL" && layer.startName != "")
+    {
+      drawDrillLine(layer.name, m_layerNames.indexOf(layer.startName),
+          m_layerNames.indexOf(layer.endName));
     }
   }
 
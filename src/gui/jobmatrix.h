@@ -27,12 +27,13 @@
 #include <QSignalMapper>
 #include <QTableWidget>
 
-#include "structuredtextparser.h"
 #include "odbppgraphicsview.h"
 #include "clickablelabel.h"
 #include "iostream"
 #include "viewerwindow.h"
 
+class JobIndex;
+
 namespace Ui {
   class JobMatrix;
 }
@@ -59,7 +60,7 @@ private:
   QStringList m_stepNames;
   QStringList m_layerNames;
   QStringList m_layerTypes;
-  StructuredTextDataStore *m_ds;
+  JobIndex* m_index;
 };
 
 #endif // JOBMATRIX_H
@@ -100,6 +100,12 @@ Layer* LayerInfoBox::layer(void)
   return m_layer;
 }
 
+void LayerInfoBox::unloadLayer(void)
+{
+  delete m_layer;
+  m_layer = NULL;
+}
+
 void LayerInfoBox::setColor(const QColor& color)
 {
   m_color = color;
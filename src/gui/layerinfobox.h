@@ -47,6 +47,9 @@ public:
   QString name(void);
   QColor color(void);
   Layer* layer(void);
+  bool isLayerLoaded(void) const { return m_layer != NULL; }
+  /* Delete the layer; layer() loads it again when it is needed */
+  void unloadLayer(void);
 
   void setColor(const QColor& color);
   void setLayer(Layer* layer);
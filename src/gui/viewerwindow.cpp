@@ -31,6 +31,7 @@
 #include <QPixmap>
 #include <QTimer>
 #include <QDateTime>
+#include <QElapsedTimer>
 #include <QEventLoop>
 #include <QThread>
 #include <QFile>
@@ -40,22 +41,49 @@
 #include <QFileDialog>
 #include <QMessageBox>
 
+#include "archiveloader.h"
+#include "cachedparser.h"
 #include "context.h"
 #include "gotocoordinatedialog.h"
+#include "jobindex.h"
+#include "jobwatcher.h"
+#include "layerstore.h"
+#include "symbolpool.h"
 #include "layerinfobox.h"
 #include "logger.h"
 #include "settingsdialog.h"
 #include "settings.h"
 #include "restapi/restapiserver.h"
 #include "graphicslayerscene.h"
+#include "copperdensity.h"
+#include "densitymapitem.h"
+#include "layercopper.h"
+#include "layergeometry.h"
+#include "spacingchecker.h"
+#include "pickbuffer.h"
+#include "polygonexporter.h"
+#include "tracewidthclassifier.h"
+
+/* Hidden layers are only demoted when ColdLayerDelay is set */
+#define DEFAULT_COLD_DELAY 0
+#define COLD_CHECK_INTERVAL 10000
+/* Rough heap cost of one Symbol and its graphics item state, in bytes */
+#define SYMBOL_FOOTPRINT 512
+
+/* Viewer windows open; the job's shared state goes with the last one */
+static int openViewers = 0;
 
 ViewerWindow::ViewerWindow(QWidget *parent) :
   QMainWindow(parent), ui(new Ui::ViewerWindow), m_displayUnit(U_INCH),
   m_activeInfoBox(NULL), m_transition(false), m_restApiServer(nullptr),
+  m_jobWatcher(NULL), m_densityMap(NULL), m_coldTimer(NULL),
+  m_memoryCeiling(0),
+  m_coldDelay(DEFAULT_COLD_DELAY), m_coldSpill(false),
   m_highlightColor(QColor(0, 0, 255))
 {
   ui->setupUi(this);
   setAttribute(Qt::WA_DeleteOnClose);
+  ++openViewers;
 
   ctx.highlight_color = QColor(0, 0, 255);
 
@@ -83,11 +111,32 @@ ViewerWindow::ViewerWindow(QWidget *parent) :
       SLOT(updateCursorCoord(QPointF)));
   connect(ui->viewWidget->scene(), SIGNAL(measureRectSelected(QRectF)), this,
       SLOT(updateMeasureResult(QRectF)));
+  connect(ui->viewWidget->scene(), SIGNAL(measureLineSelected(QPointF, QPointF)),
+      this, SLOT(updateMeasureClearance(QPointF, QPointF)));
   connect(ui->viewWidget->scene(), SIGNAL(featureSelected(Symbol*)), this,
       SLOT(updateFeatureDetail(Symbol*)));
   connect(ui->viewWidget->scene(), SIGNAL(featureSelected(Symbol*)),
       m_featurePropertiesDialog, SLOT(update(Symbol*)));
 
+  m_jobWatcher = new JobWatcher(this);
+  connect(m_jobWatcher, SIGNAL(featuresReloaded(FeaturesDataStore*,
+          FeaturesDataStore*, const FeaturesDiff&)), this,
+      SLOT(reloadFeatures(FeaturesDataStore*, FeaturesDataStore*,
+          const FeaturesDiff&)));
+  connect(m_jobWatcher, SIGNAL(stepHeaderChanged(const QString&)), this,
+      SLOT(reloadStepAndRepeat(const QString&)));
+
+  m_memoryCeiling = SETTINGS->get("System", "MemoryCeilingMB").toLongLong() *
+    1024 * 1024;
+  QString delay = SETTINGS->get("System", "ColdLayerDelay").toString();
+  if (!delay.isEmpty()) {
+    m_coldDelay = delay.toInt();
+  }
+  m_coldSpill = SETTINGS->get("System", "ColdLayerSpill").toBool();
+  m_coldTimer = new QTimer(this);
+  connect(m_coldTimer, SIGNAL(timeout()), this, SLOT(demoteColdLayers()));
+  m_coldTimer->start(COLD_CHECK_INTERVAL);
+
   connect(ui->miniMapView, SIGNAL(minimapRectSelected(QRectF)), ui->viewWidget,
       SLOT(zoomToRect(QRectF)));
   connect(ui->viewWidget, SIGNAL(sceneRectChanged(QRectF)), ui->miniMapView,
@@ -108,22 +157,38 @@ ViewerWindow::ViewerWindow(QWidget *parent) :
   QPushButton* btnR2 = new QPushButton("R2", this);
   QPushButton* btnR3 = new QPushButton("R3", this);
   
-  btnR1->setToolTip("Select traces < 6 mils (0.15mm)");
-  btnR2->setToolTip("Select traces < 10 mils (0.25mm)");
-  btnR3->setToolTip("Select traces < 15 mils (0.38mm)");
+  QPushButton* btnClasses = new QPushButton("W", this);
+  QPushButton* btnSpacing = new QPushButton("S", this);
+  QPushButton* btnDensity = new QPushButton("D", this);
+
+  btnR1->setToolTip("Select traces <= 15 mils (0.38mm)");
+  btnR2->setToolTip("Select traces <= 20 mils (0.51mm)");
+  btnR3->setToolTip("Select traces <= 25 mils (0.64mm)");
+  btnClasses->setToolTip("Color traces by width class (R1/R2/R3)");
+  btnSpacing->setToolTip("Highlight features closer than a minimum spacing");
+  btnDensity->setToolTip("Show or hide the copper density heatmap");
   
   btnR1->setFixedSize(40, 30);
   btnR2->setFixedSize(40, 30);
   btnR3->setFixedSize(40, 30);
+  btnClasses->setFixedSize(40, 30);
+  btnSpacing->setFixedSize(40, 30);
+  btnDensity->setFixedSize(40, 30);
   
   connect(btnR1, &QPushButton::clicked, this, &ViewerWindow::on_actionSelectTraceR1_triggered);
   connect(btnR2, &QPushButton::clicked, this, &ViewerWindow::on_actionSelectTraceR2_triggered);
   connect(btnR3, &QPushButton::clicked, this, &ViewerWindow::on_actionSelectTraceR3_triggered);
+  connect(btnClasses, &QPushButton::clicked, this, &ViewerWindow::on_actionShowTraceWidthClasses_triggered);
+  connect(btnSpacing, &QPushButton::clicked, this, &ViewerWindow::on_actionCheckSpacing_triggered);
+  connect(btnDensity, &QPushButton::clicked, this, &ViewerWindow::on_actionCopperDensity_triggered);
   
   traceToolBar->addWidget(new QLabel("Trace Filter: "));
   traceToolBar->addWidget(btnR1);
   traceToolBar->addWidget(btnR2);
   traceToolBar->addWidget(btnR3);
+  traceToolBar->addWidget(btnClasses);
+  traceToolBar->addWidget(btnSpacing);
+  traceToolBar->addWidget(btnDensity);
   
   traceToolBar->addSeparator();
   QPushButton* btnHighlightColor = new QPushButton("🎨", this);
@@ -165,9 +230,20 @@ ViewerWindow::ViewerWindow(QWidget *parent) :
 
 ViewerWindow::~ViewerWindow()
 {
+  delete m_jobWatcher;
   delete ui;
   delete m_featurePropertiesDialog;
   delete m_goToCoordinateDialog;
+
+  if (--openViewers == 0) {
+    // The pads go with the child widgets after this, so free their user
+    // symbols once the window is gone, unless another job was opened
+    QTimer::singleShot(0, []() {
+      if (openViewers == 0) {
+        SYMBOLPOOL->releaseUserSymbols();
+      }
+    });
+  }
 }
 
 void ViewerWindow::setJob(QString job)
@@ -185,16 +261,31 @@ void ViewerWindow::setLayers(const QStringList& layers,
     const QStringList& types)
 {
   ui->viewWidget->clearScene();
+  m_densityMap = NULL;          // deleted with the scene items
   ui->viewWidget->loadProfile(m_step);
   ui->miniMapView->loadProfile(m_step);
 
   QVBoxLayout* layout = qobject_cast<QVBoxLayout*>(ui->scrollWidget->layout());
   clearLayout(layout, true);
-  QString pathTmpl = "steps/%1/layers/%2";
+  JobIndex* index = ctx.loader->index();
 
   for (int i = 0; i < layers.count(); ++i) {
     LayerInfoBox *l = new LayerInfoBox(layers[i], m_step, types[i]);
 
+    if (index) {
+      if (index->hasFeatures(m_step, layers[i])) {
+        JobIndex::Features features = index->features(m_step, layers[i]);
+        l->setToolTip(QString("%1 features (%2 lines, %3 pads, %4 arcs, "
+              "%5 surfaces, %6 texts)\n%7 KB")
+            .arg(features.records()).arg(features.lines).arg(features.pads)
+            .arg(features.arcs).arg(features.surfaces)
+            .arg(features.texts + features.barcodes)
+            .arg((features.dataSize + 1023) / 1024));
+      } else {
+        l->setToolTip("No features in this step");
+      }
+    }
+
     connect(l, SIGNAL(toggled(bool)), this, SLOT(toggleShowLayer(bool)));
     connect(l, SIGNAL(activated(bool)), this, SLOT(layerActivated(bool)));
 
@@ -202,6 +293,120 @@ void ViewerWindow::setLayers(const QStringList& layers,
     layout->addWidget(l);
   }
   layout->addStretch();
+
+  m_jobWatcher->watch(index? index->steps(): QStringList() << m_step, layers);
+}
+
+void ViewerWindow::reloadFeatures(FeaturesDataStore* oldDs,
+    FeaturesDataStore* newDs, const FeaturesDiff& diff)
+{
+  foreach (LayerInfoBox* box, m_SelectorMap) {
+    if (box->isLayerLoaded()) {
+      box->layer()->reloadFeatures(oldDs, newDs, diff);
+    }
+  }
+}
+
+void ViewerWindow::reloadStepAndRepeat(const QString& step)
+{
+  foreach (LayerInfoBox* box, m_SelectorMap) {
+    if (box->isLayerLoaded()) {
+      box->layer()->reloadStepAndRepeat(step);
+    }
+  }
+}
+
+static qint64 layerFootprint(Layer* layer)
+{
+  qint64 size = 0;
+  foreach (LayerFeatures* lf, layer->allFeatures()) {
+    if (lf->dataStore()) {
+      size += lf->dataStore()->memoryUsage() +
+        lf->dataStore()->records().size() * SYMBOL_FOOTPRINT;
+    }
+  }
+  return size;
+}
+
+void ViewerWindow::demoteColdLayers(void)
+{
+  if (m_coldDelay <= 0 && m_memoryCeiling <= 0) {
+    return;
+  }
+
+  // A reload in flight still holds the old data stores
+  if (m_jobWatcher && m_jobWatcher->isBusy()) {
+    return;
+  }
+
+  qint64 resident = LayerStore::demotedSize();
+  QMultiMap<qint64, LayerInfoBox*> hidden;
+  foreach (LayerInfoBox* box, m_SelectorMap) {
+    if (!box->isLayerLoaded()) {
+      continue;
+    }
+    resident += layerFootprint(box->layer());
+    if (m_hiddenSince.contains(box) && box != m_activeInfoBox &&
+        !m_visibles.contains(box)) {
+      hidden.insert(m_hiddenSince.value(box), box);
+    }
+  }
+
+  // Least recently shown first
+  qint64 now = QDateTime::currentMSecsSinceEpoch();
+  for (QMultiMap<qint64, LayerInfoBox*>::const_iterator it = hidden.begin();
+      it != hidden.end(); ++it) {
+    bool expired = m_coldDelay > 0 && now - it.key() >= m_coldDelay * 1000LL;
+    bool over = m_memoryCeiling > 0 && resident > m_memoryCeiling;
+    if (!expired && !over) {
+      break;
+    }
+    qint64 packed = LayerStore::demotedSize();
+    resident -= layerFootprint(it.value()->layer());
+    demoteLayer(it.value());
+    resident += LayerStore::demotedSize() - packed;
+  }
+}
+
+void ViewerWindow::demoteLayer(LayerInfoBox* box)
+{
+  QList<FeaturesDataStore*> stores;
+  foreach (LayerFeatures* lf, box->layer()->allFeatures()) {
+    if (lf->dataStore() && !stores.contains(lf->dataStore())) {
+      stores.append(lf->dataStore());
+    }
+  }
+
+  GraphicsLayerScene* scene = dynamic_cast<GraphicsLayerScene*>(
+      box->layer()->layerScene());
+  if (scene) {
+    GraphicsLayerScene::HighlightState state = scene->saveHighlights();
+    if (!state.isEmpty()) {
+      m_coldHighlights.insert(box, state);
+    }
+  }
+
+  LOG_INFO(QString("Demoting hidden layer %1").arg(box->name()));
+  box->unloadLayer();
+  m_hiddenSince.remove(box);
+
+  // Step-and-repeat children may share data stores with other layers
+  foreach (FeaturesDataStore* ds, stores) {
+    bool used = false;
+    foreach (LayerInfoBox* other, m_SelectorMap) {
+      if (other->isLayerLoaded() && other->layer()->features()->uses(ds)) {
+        used = true;
+        break;
+      }
+    }
+    QString fileName = CachedFeaturesParser::fileName(ds);
+    if (used || fileName.isEmpty()) {
+      continue;
+    }
+    LayerStore::demote(fileName, ds, m_coldSpill);
+    CachedFeaturesParser::evict(fileName);
+    delete ds;
+  }
 }
 
 void ViewerWindow::clearLayout(QLayout* layout, bool deleteWidgets)
@@ -241,7 +446,17 @@ void ViewerWindow::toggleShowLayer(bool selected)
     infobox->layer()->setShowOutline(ui->actionShowOutline->isChecked());
     infobox->layer()->setShowStepRepeat(ui->actionShowStepRepeat->isChecked());
 
+    if (m_coldHighlights.contains(infobox)) {
+      GraphicsLayerScene* scene = dynamic_cast<GraphicsLayerScene*>(
+          infobox->layer()->layerScene());
+      if (scene) {
+        scene->restoreHighlights(m_coldHighlights.value(infobox));
+      }
+      m_coldHighlights.remove(infobox);
+    }
+
     m_visibles.append(infobox);
+    m_hiddenSince.remove(infobox);
     if (m_visibles.size() == 1) {
       infobox->setActive(true);
     }
@@ -250,6 +465,7 @@ void ViewerWindow::toggleShowLayer(bool selected)
     m_colorsMap[index] = false;
     ui->viewWidget->removeLayer(infobox->layer());
     m_visibles.removeOne(infobox);
+    m_hiddenSince.insert(infobox, QDateTime::currentMSecsSinceEpoch());
 
     if (infobox->isActive()) {
       if (m_visibles.size()) {
@@ -338,6 +554,47 @@ void ViewerWindow::updateMeasureResult(QRectF rect)
     .arg(qSqrt(rect.width() * rect.width() + rect.height() * rect.height())));
 }
 
+void ViewerWindow::updateMeasureClearance(QPointF start, QPointF end)
+{
+  if (!m_activeInfoBox || !m_activeInfoBox->layer()) {
+    return;
+  }
+
+  // Snap each end point to the closest copper within a few pixels
+  LayerGeometry* geometry = m_activeInfoBox->layer()->geometry();
+  qreal snap = 8.0 / qMax(qAbs(ui->viewWidget->transform().m11()), 1e-9);
+  QVector<int> a = geometry->nearest(start, 1, snap);
+  QVector<int> b = geometry->nearest(end, 1, snap);
+  if (a.isEmpty() || b.isEmpty() || a[0] == b[0]) {
+    return;
+  }
+
+  Proximity gap = geometry->clearance(a[0], b[0]);
+  if (!gap.isValid()) {
+    return;
+  }
+
+  int netA = geometry->netOf(a[0]), netB = geometry->netOf(b[0]);
+  qreal scale = (m_displayUnit == U_INCH)? 1.0: 25.4;
+  QString result = QString("Clearance=%1").arg(gap.distance * scale);
+  if (netA == netB) {
+    result += ", same net";
+  } else {
+    Proximity netGap = geometry->netClearance(netA, netB);
+    if (netGap.isValid() && netGap.distance < gap.distance) {
+      result += QString(", net clearance=%1").arg(netGap.distance * scale);
+      gap = netGap;
+    }
+  }
+  m_featureDetailLabel->setText(result);
+
+  ODBPPGraphicsScene* scene =
+    dynamic_cast<ODBPPGraphicsScene*>(ui->viewWidget->scene());
+  if (scene) {
+    scene->setMeasureClearance(QLineF(gap.pa, gap.pb));
+  }
+}
+
 void ViewerWindow::on_actionSetColor_triggered(void)
 {
   SettingsDialog dialog;
@@ -709,6 +966,59 @@ void ViewerWindow::on_actionExportPNG_triggered(void)
   ui->viewWidget->setFocus(Qt::MouseFocusReason);
 }
 
+void ViewerWindow::on_actionExportPolygons_triggered(void)
+{
+  if (!m_activeInfoBox || !m_activeInfoBox->layer()) {
+    QMessageBox::warning(this, tr("No Active Layer"),
+                        tr("Please select an active layer first."));
+    return;
+  }
+
+  QString defaultName = QString("%1_%2_%3.qcp")
+    .arg(m_job)
+    .arg(m_step)
+    .arg(m_activeInfoBox->name());
+
+  QString filePath = QFileDialog::getSaveFileName(this,
+      tr("Export Polygons"), defaultName,
+      tr("Polygon Files (*.qcp);;All Files (*)"));
+  if (filePath.isEmpty()) {
+    return;
+  }
+
+  // The whole panel is exported, so repeats must be part of the geometry
+  // for the duration of the export; the view keeps the user's setting
+  Layer* layer = m_activeInfoBox->layer();
+  bool repeats = ui->actionShowStepRepeat->isChecked();
+  if (!repeats) {
+    layer->setShowStepRepeat(true);
+  }
+
+  QApplication::setOverrideCursor(Qt::WaitCursor);
+  PolygonExporter exporter(layer->copper());
+  bool success = exporter.write(filePath);
+  if (!repeats) {
+    layer->setShowStepRepeat(false);
+  }
+  QApplication::restoreOverrideCursor();
+
+  if (success) {
+    QMessageBox::information(this, tr("Export Successful"),
+                            tr("Polygons exported to:\n%1\n\n"
+                               "Polygons: %2")
+                            .arg(filePath)
+                            .arg(exporter.polygonCount()));
+  } else {
+    LOG_ERROR(QString("Polygon export failed: %1")
+        .arg(exporter.errorString()));
+    QMessageBox::critical(this, tr("Export Failed"),
+                         tr("Cannot write to file:\n%1\n\n%2")
+                         .arg(filePath).arg(exporter.errorString()));
+  }
+
+  ui->viewWidget->setFocus(Qt::MouseFocusReason);
+}
+
 void ViewerWindow::on_actionGoToCoordinate_triggered(void)
 {
   m_goToCoordinateDialog->setDisplayUnit(m_displayUnit);
@@ -764,9 +1074,11 @@ void ViewerWindow::handleCaptureRequest(const QJsonObject &request)
         QString savedFilePath;
         QByteArray imageData;
         QString detectedObject;
+        QJsonArray features;
         
         bool success = navigateAndCapture(layerName, x, y, zoom, 
-                                         &savedFilePath, &imageData, &detectedObject);
+                                         &savedFilePath, &imageData, &detectedObject,
+                                         &features);
         
         if (!success) {
             LOG_ERROR("Failed to navigate and capture image");
@@ -787,6 +1099,7 @@ void ViewerWindow::handleCaptureRequest(const QJsonObject &request)
         metadata["format"] = "PNG";
         metadata["savedPath"] = savedFilePath;
         metadata["detectedObject"] = detectedObject;
+        metadata["features"] = features;
         metadata["timestamp"] = QDateTime::currentDateTime().toString(Qt::ISODate);
         
         if (m_restApiServer) {
@@ -796,6 +1109,152 @@ void ViewerWindow::handleCaptureRequest(const QJsonObject &request)
     });
 }
 
+void ViewerWindow::handleQueryRequest(const QJsonObject &request)
+{
+    QString requestId = request["requestId"].toString();
+    QString layerName = request["layerName"].toString();
+
+    QJsonObject response;
+    Layer* layer = queryLayer(layerName);
+    if (!layer) {
+        response["error"] = QString("Layer not loaded: %1").arg(layerName);
+    } else {
+        QElapsedTimer timer;
+        timer.start();
+        response = runQuery(layer, request);
+        response["elapsedUs"] = static_cast<double>(timer.nsecsElapsed() / 1000);
+    }
+
+    response["requestId"] = requestId;
+    response["type"] = request["type"].toString();
+    if (m_restApiServer) {
+        m_restApiServer->sendQueryResponse(requestId, response);
+    }
+}
+
+Layer* ViewerWindow::queryLayer(const QString& layerName)
+{
+    if (layerName.isEmpty()) {
+        return m_activeInfoBox? m_activeInfoBox->layer(): NULL;
+    }
+    LayerInfoBox* box = m_SelectorMap.value(layerName, NULL);
+    return box? box->layer(): NULL;
+}
+
+/*
+ * Geometry queries in ODB++ units (inch, y up).  Scene coordinates only
+ * differ by the sign of y.
+ */
+QJsonObject ViewerWindow::runQuery(Layer* layer, const QJsonObject& request)
+{
+    QJsonObject response;
+    QString type = request["type"].toString();
+    LayerGeometry* geometry = layer->geometry();
+
+    auto toScene = [](const QJsonValue& v) {
+        QJsonObject p = v.toObject();
+        return QPointF(p["x"].toDouble(), -p["y"].toDouble());
+    };
+    auto toJson = [](const QPointF& p) {
+        QJsonObject obj;
+        obj["x"] = p.x();
+        obj["y"] = -p.y();
+        return obj;
+    };
+    auto featureAt = [&](const QJsonValue& v) {
+        if (v.isDouble()) {
+            return v.toInt();
+        }
+        QVector<int> hit = geometry->nearest(toScene(v), 1);
+        return hit.isEmpty()? -1: hit[0];
+    };
+
+    if (type == "nearest") {
+        QPointF p(request["x"].toDouble(), -request["y"].toDouble());
+        int k = qMax(1, request["k"].toInt(1));
+        qreal maxDistance = request["maxDistance"].toDouble(-1);
+
+        QVector<qreal> distances;
+        QVector<int> hits = geometry->nearest(p, k, maxDistance, &distances);
+
+        QJsonArray features;
+        for (int i = 0; i < hits.size(); ++i) {
+            QJsonObject obj = geometry->toJson(hits[i]);
+            obj["distance"] = distances[i];
+            features.append(obj);
+        }
+        response["features"] = features;
+    } else if (type == "clearance") {
+        // Features are given by id or by a point snapped to the nearest one
+        int a = featureAt(request["a"]);
+        int b = featureAt(request["b"]);
+        if (a < 0 || b < 0 || a >= geometry->count() ||
+            b >= geometry->count()) {
+            response["error"] = "Feature not found";
+            return response;
+        }
+
+        Proximity gap;
+        if (request["net"].toBool()) {
+            gap = geometry->netClearance(geometry->netOf(a), geometry->netOf(b));
+        } else {
+            gap = geometry->clearance(a, b);
+        }
+        if (!gap.isValid()) {
+            response["error"] = "Clearance undefined for these features";
+            return response;
+        }
+
+        response["a"] = geometry->toJson(a);
+        response["b"] = geometry->toJson(b);
+        response["distance"] = gap.distance;
+        response["pointA"] = toJson(gap.pa);
+        response["pointB"] = toJson(gap.pb);
+    } else if (type == "spacing") {
+        qreal minSpacing = request["minSpacing"].toDouble();
+        if (minSpacing <= 0) {
+            response["error"] = "minSpacing must be positive";
+            return response;
+        }
+
+        SpacingChecker checker(geometry);
+        QVector<SpacingChecker::Violation> violations =
+            checker.check(minSpacing);
+        response = checker.toJson(violations, minSpacing);
+
+        GraphicsLayerScene* scene =
+            dynamic_cast<GraphicsLayerScene*>(layer->layerScene());
+        if (scene && request["highlight"].toBool()) {
+            QList<Symbol*> symbols;
+            for (int i = 0; i < violations.size(); ++i) {
+                symbols.append(geometry->feature(violations[i].a).symbol);
+                symbols.append(geometry->feature(violations[i].b).symbol);
+            }
+            scene->highlightSymbols(symbols, Qt::magenta);
+        }
+    } else if (type == "copper") {
+        LayerCopper* copper = layer->copper();
+        response["area"] = copper->area();
+        response["polygons"] = copper->polygons().size();
+        response["islands"] = copper->islandCount();
+        response["tiles"] = copper->tileCount();
+    } else if (type == "density") {
+        qreal cellSize = request["cellSize"].toDouble();
+        if (!(cellSize > 0) || !qIsFinite(cellSize)) {
+            response["error"] = "cellSize must be a positive number";
+            return response;
+        }
+        // The grid is capped, so the reply's cellSize may be larger
+        CopperDensity density(layer->copper(), cellSize);
+        response = density.toJson();
+        response["requestedCellSize"] = cellSize;
+    } else {
+        response["error"] = QString("Unknown query type: %1").arg(type);
+    }
+
+    return response;
+}
+
 void ViewerWindow::startRestApiServer(quint16 port)
 {
     if (m_restApiServer) {
@@ -811,6 +1270,8 @@ void ViewerWindow::startRestApiServer(quint16 port)
         
         connect(m_restApiServer, &RestApiServer::captureRequest,
                 this, &ViewerWindow::handleCaptureRequest);
+        connect(m_restApiServer, &RestApiServer::queryRequest,
+                this, &ViewerWindow::handleQueryRequest);
     } else {
         qDebug() << "Failed to start REST API server on port" << port;
         LOG_ERROR(QString("Failed to start REST API server on port %1").arg(port));
@@ -941,45 +1402,128 @@ void ViewerWindow::on_actionLoadHighlight_triggered()
   }
 }
 
-void ViewerWindow::on_actionSelectTraceR1_triggered()
+GraphicsLayerScene* ViewerWindow::activeLayerScene(void)
 {
   if (m_activeInfoBox && m_activeInfoBox->layer()) {
-    GraphicsLayerScene* scene = dynamic_cast<GraphicsLayerScene*>(
+    return dynamic_cast<GraphicsLayerScene*>(
         m_activeInfoBox->layer()->layerScene());
-    
-    if (scene) {
-      scene->selectTracesR1();
-      qDebug() << "Selected traces with width < 6 mils";
-    }
+  }
+  return NULL;
+}
+
+void ViewerWindow::on_actionSelectTraceR1_triggered()
+{
+  GraphicsLayerScene* scene = activeLayerScene();
+  if (scene) {
+    int count = scene->selectTracesR1();
+    statusBar()->showMessage(tr("%1 traces <= 15 mils selected").arg(count),
+        3000);
   }
 }
 
 void ViewerWindow::on_actionSelectTraceR2_triggered()
 {
-  if (m_activeInfoBox && m_activeInfoBox->layer()) {
-    GraphicsLayerScene* scene = dynamic_cast<GraphicsLayerScene*>(
-        m_activeInfoBox->layer()->layerScene());
-    
-    if (scene) {
-      scene->selectTracesR2();
-      qDebug() << "Selected traces with width < 10 mils";
-    }
+  GraphicsLayerScene* scene = activeLayerScene();
+  if (scene) {
+    int count = scene->selectTracesR2();
+    statusBar()->showMessage(tr("%1 traces <= 20 mils selected").arg(count),
+        3000);
   }
 }
 
 void ViewerWindow::on_actionSelectTraceR3_triggered()
 {
-  if (m_activeInfoBox && m_activeInfoBox->layer()) {
-    GraphicsLayerScene* scene = dynamic_cast<GraphicsLayerScene*>(
-        m_activeInfoBox->layer()->layerScene());
-    
-    if (scene) {
-      scene->selectTracesR3();
-      qDebug() << "Selected traces with width < 15 mils";
-    }
+  GraphicsLayerScene* scene = activeLayerScene();
+  if (scene) {
+    int count = scene->selectTracesR3();
+    statusBar()->showMessage(tr("%1 traces <= 25 mils selected").arg(count),
+        3000);
+  }
+}
+
+void ViewerWindow::on_actionShowTraceWidthClasses_triggered()
+{
+  GraphicsLayerScene* scene = activeLayerScene();
+  if (scene) {
+    QList<qreal> thresholds;
+    thresholds << 0.015 << 0.020 << 0.025;
+    QList<QColor> colors;
+    colors << Qt::red << QColor(255, 165, 0) << Qt::yellow;
+
+    int count = scene->showTraceWidthClasses(thresholds, colors);
+    statusBar()->showMessage(tr("%1 traces classified (R1 red, R2 orange, "
+          "R3 yellow)").arg(count), 3000);
   }
 }
 
+void ViewerWindow::on_actionCheckSpacing_triggered()
+{
+  GraphicsLayerScene* scene = activeLayerScene();
+  if (!scene) {
+    return;
+  }
+
+  bool ok = false;
+  qreal mils = QInputDialog::getDouble(this, tr("Spacing Check"),
+      tr("Minimum spacing (mils):"), 5.0, 0.01, 1000.0, 2, &ok);
+  if (!ok) {
+    return;
+  }
+
+  QElapsedTimer timer;
+  timer.start();
+  QApplication::setOverrideCursor(Qt::WaitCursor);
+
+  LayerGeometry* geometry = m_activeInfoBox->layer()->geometry();
+  SpacingChecker checker(geometry);
+  QVector<SpacingChecker::Violation> violations = checker.check(mils / 1000.0);
+
+  QList<Symbol*> symbols;
+  for (int i = 0; i < violations.size(); ++i) {
+    symbols.append(geometry->feature(violations[i].a).symbol);
+    symbols.append(geometry->feature(violations[i].b).symbol);
+  }
+  scene->highlightSymbols(symbols, Qt::magenta);
+
+  QApplication::restoreOverrideCursor();
+  statusBar()->showMessage(tr("%1 spacing violations below %2 mils (%3 ms)")
+      .arg(violations.size()).arg(mils).arg(timer.elapsed()), 5000);
+}
+
+void ViewerWindow::on_actionCopperDensity_triggered()
+{
+  if (m_densityMap) {
+    ui->viewWidget->removeItem(m_densityMap);
+    delete m_densityMap;
+    m_densityMap = NULL;
+    return;
+  }
+
+  if (!m_activeInfoBox || !m_activeInfoBox->layer()) {
+    return;
+  }
+
+  bool ok = false;
+  qreal mils = QInputDialog::getDouble(this, tr("Copper Density"),
+      tr("Cell size (mils):"), 500.0, 1.0, 100000.0, 1, &ok);
+  if (!ok) {
+    return;
+  }
+
+  QElapsedTimer timer;
+  timer.start();
+  QApplication::setOverrideCursor(Qt::WaitCursor);
+
+  CopperDensity density(m_activeInfoBox->layer()->copper(), mils / 1000.0);
+  m_densityMap = new DensityMapItem(density);
+  ui->viewWidget->addItem(m_densityMap);
+
+  QApplication::restoreOverrideCursor();
+  statusBar()->showMessage(tr("Copper area %1 sq in, %2 x %3 cells (%4 ms)")
+      .arg(density.area()).arg(density.columns()).arg(density.rows())
+      .arg(timer.elapsed()), 5000);
+}
+
 void ViewerWindow::on_actionToggleHighlightColor_triggered()
 {
   if (m_highlightColor == QColor(0, 0, 255)) {
@@ -1002,83 +1546,63 @@ QColor ViewerWindow::getHighlightColor() const
   return m_highlightColor;
 }
 
-QString ViewerWindow::detectObjectAtCoordinate(const QImage &image, const QPointF &sceneCoord, 
-                                                const QRectF &sceneRect, const QRectF &targetRect)
+QString ViewerWindow::detectObjectAtCoordinate(const PickBuffer &picks,
+                                                const QPointF &sceneCoord,
+                                                Symbol **symbol)
 {
-    double scaleX = targetRect.width() / sceneRect.width();
-    double scaleY = targetRect.height() / sceneRect.height();
-    
-    int imgX = static_cast<int>((sceneCoord.x() - sceneRect.left()) * scaleX);
-    int imgY = static_cast<int>((sceneCoord.y() - sceneRect.top()) * scaleY);
-    
-    LOG_INFO(QString("Detecting color at scene(%1, %2) -> pixel(%3, %4)")
-             .arg(sceneCoord.x()).arg(sceneCoord.y()).arg(imgX).arg(imgY));
-    
-    if (imgX < 0 || imgX >= image.width() || imgY < 0 || imgY >= image.height()) {
-        LOG_WARNING(QString("Coordinate out of bounds: pixel(%1, %2), image size(%3, %4)")
-                   .arg(imgX).arg(imgY).arg(image.width()).arg(image.height()));
-        return "unknown";
-    }
-    
-    QMap<QRgb, int> colorCount;
-    int sampleSize = 5;
-    int halfSize = sampleSize / 2;
-    
-    for (int dy = -halfSize; dy <= halfSize; ++dy) {
-        for (int dx = -halfSize; dx <= halfSize; ++dx) {
-            int px = imgX + dx;
-            int py = imgY + dy;
-            
-            if (px >= 0 && px < image.width() && py >= 0 && py < image.height()) {
-                QRgb rgb = image.pixel(px, py);
-                colorCount[rgb]++;
-            }
+    QPoint pixel = picks.mapFromScene(sceneCoord);
+    
+    // Exact feature under the pixel, otherwise the dominant one in a 5x5 patch
+    const PickBuffer::Entry* entry = picks.at(pixel);
+    if (!entry) {
+        QList<const PickBuffer::Entry*> around =
+            picks.entriesIn(QRect(pixel - QPoint(2, 2), QSize(5, 5)));
+        if (!around.isEmpty()) {
+            entry = around.first();
         }
     }
     
-    QRgb bgRgb = ctx.bg_color.rgb();
-    QRgb dominantColor = bgRgb;
-    int maxCount = 0;
-    
-    for (auto it = colorCount.begin(); it != colorCount.end(); ++it) {
-        if (it.value() > maxCount && it.key() != bgRgb) {
-            dominantColor = it.key();
-            maxCount = it.value();
-        }
+    if (symbol) {
+        *symbol = entry? entry->symbol: nullptr;
     }
     
-    QColor detectedColor(dominantColor);
-    LOG_INFO(QString("Dominant color detected: RGB(%1, %2, %3), count: %4")
-             .arg(detectedColor.red()).arg(detectedColor.green()).arg(detectedColor.blue()).arg(maxCount));
-    
-    auto colorMatch = [](const QColor &c1, const QColor &c2, int tolerance = 30) -> bool {
-        return qAbs(c1.red() - c2.red()) <= tolerance &&
-               qAbs(c1.green() - c2.green()) <= tolerance &&
-               qAbs(c1.blue() - c2.blue()) <= tolerance;
-    };
-    
-    if (dominantColor == bgRgb || colorMatch(detectedColor, Qt::black, 10)) {
-        LOG_INFO("Detected: NONE (background/black)");
+    if (!entry) {
+        LOG_INFO("Detected: NONE (no feature at coordinate)");
         return "none";
     }
     
-    if (colorMatch(detectedColor, QColor(0, 0, 255), 40)) {
-        LOG_INFO("Detected: BETA COOPER (blue highlight)");
-        return "beta_cooper";
+    LOG_INFO(QString("Feature at coordinate: %1").arg(entry->symbol->infoText()));
+    
+    // Classify from the picked record itself, the brush colour depends on
+    // the highlight colour in use
+    TraceWidthClassifier* classifier =
+        TraceWidthClassifier::forDataStore(entry->features->dataStore());
+    if (!classifier || entry->feature < 0 ||
+        entry->feature >= classifier->count()) {
+        return "unknown";
     }
     
-    if (colorMatch(detectedColor, QColor(179, 0, 255), 40)) {
-        LOG_INFO("Detected: TRACE (purple highlight)");
+    if (classifier->isTrace(entry->feature)) {
+        LOG_INFO(QString("Trace width: %1")
+                 .arg(classifier->width(entry->feature)));
         return "trace";
     }
     
-    LOG_INFO(QString("Detected: UNKNOWN (unrecognized color RGB(%1, %2, %3))")
-             .arg(detectedColor.red()).arg(detectedColor.green()).arg(detectedColor.blue()));
-    return "unknown";
+    // Only positive copper surfaces are pours; pads, text, barcodes and
+    // the rest are reported as plain features
+    const Record* rec = PickBuffer::record(entry);
+    const SurfaceRecord* surface = dynamic_cast<const SurfaceRecord*>(rec);
+    LOG_INFO(QString("Record type: %1").arg(PickBuffer::recordType(rec)));
+    if (surface && surface->polarity == P) {
+        return "beta_cooper";
+    }
+    
+    return "feature";
 }
 
 bool ViewerWindow::navigateAndCapture(const QString &layerName, double x, double y, double zoom,
-                                     QString *outputPath, QByteArray *imageData, QString *detectedObject)
+                                     QString *outputPath, QByteArray *imageData, QString *detectedObject,
+                                     QJsonArray *features)
 {
     LOG_INFO(QString("navigateAndCapture: layer=%1, x=%2, y=%3, zoom=%4")
              .arg(layerName).arg(x).arg(y).arg(zoom));
@@ -1165,67 +1689,61 @@ bool ViewerWindow::navigateAndCapture(const QString &layerName, double x, double
     double traceWidth = -1.0;
     double traceAngle = 0.0;
     
+    // Feature ID buffer for the same view, used instead of sampling colours
+    PickBuffer picks;
+    ODBPPGraphicsScene* viewScene =
+        dynamic_cast<ODBPPGraphicsScene*>(ui->viewWidget->scene());
+    if (viewScene && (detectedObject || features)) {
+        QList<Layer*> layers;
+        QList<GraphicsLayer*> sceneLayers = viewScene->layers();
+        for (int i = 0; i < sceneLayers.size(); ++i) {
+            Layer* layer = dynamic_cast<Layer*>(sceneLayers[i]);
+            if (layer) {
+                layers.append(layer);
+            }
+        }
+        picks.render(layers, image.size(), sceneRect);
+    }
+    
+    if (features) {
+        QPoint pixel = picks.mapFromScene(sceneCoord);
+        QList<const PickBuffer::Entry*> entries =
+            picks.entriesIn(QRect(pixel - QPoint(2, 2), QSize(5, 5)));
+        for (int i = 0; i < entries.size(); ++i) {
+            features->append(picks.toJson(entries[i]));
+        }
+    }
+    
     if (detectedObject) {
-        objectType = detectObjectAtCoordinate(image, sceneCoord, sceneRect, targetRect);
+        Symbol* foundSymbol = nullptr;
+        objectType = detectObjectAtCoordinate(picks, sceneCoord, &foundSymbol);
         LOG_INFO(QString("Object detection result: %1").arg(objectType));
         
         // ========================================
         // NEW: If trace detected, measure width
         // ========================================
         if (objectType == "trace") {
-            LOG_INFO("Trace detected, attempting to get angle from Symbol...");
-            
-            Symbol* foundSymbol = nullptr;
-            
-            if (targetLayer && targetLayer->layer()) {
-                GraphicsLayerScene* layerScene = dynamic_cast<GraphicsLayerScene*>(
-                    targetLayer->layer()->layerScene());
-                
-                if (layerScene) {
-                    QList<QGraphicsItem*> itemsAtPoint = layerScene->items(sceneCoord);
-                    
-                    LOG_INFO(QString("Found %1 items at coordinate").arg(itemsAtPoint.size()));
-                    
-                    for (int i = 0; i < itemsAtPoint.size(); ++i) {
-                        QGraphicsItem* item = itemsAtPoint[i];
-                        
-                        Symbol* sym = dynamic_cast<Symbol*>(item);
-                        if (sym) {
-                            foundSymbol = sym;
-                            
-                            QString symbolInfo = sym->infoText();
-                            LOG_INFO(QString("Found Symbol: %1").arg(symbolInfo));
-                            
-                            // Get angle from Symbol
-                            qreal symAngle = sym->getAngle();
-                            if (symAngle >= 0.0) {
-                                traceAngle = symAngle;
-                                LOG_INFO(QString("Symbol angle: %1").arg(traceAngle));
-                            } else {
-                                LOG_WARNING("Symbol->getAngle() returned invalid value");
-                                traceAngle = 0.0;
-                            }
-                            break;
-                        }
-                    }
-                    
-                    if (!foundSymbol) {
-                        LOG_WARNING("No Symbol found at coordinate - will use angle=0");
-                        traceAngle = 0.0;
-                    }
+            if (foundSymbol) {
+                qreal symAngle = foundSymbol->getAngle();
+                if (symAngle >= 0.0) {
+                    traceAngle = symAngle;
+                    LOG_INFO(QString("Symbol angle: %1").arg(traceAngle));
                 } else {
-                    LOG_WARNING("Cannot access layer scene");
-                    traceAngle = 0.0;
+                    LOG_WARNING("Symbol->getAngle() returned invalid value");
                 }
-            } else {
-                LOG_WARNING("No target layer available");
-                traceAngle = 0.0;
             }
             
             // Measure width with NEW METHOD
             LOG_INFO(QString("Measuring width with angle=%1").arg(traceAngle));
             
-            traceWidth = measureTraceWidthImproved(image, sceneCoord, sceneRect, targetRect, traceAngle);
+            const PickBuffer::Entry* entry = picks.atScene(sceneCoord);
+            TraceWidthClassifier* classifier = entry?
+                TraceWidthClassifier::forDataStore(entry->features->dataStore()): nullptr;
+            if (classifier && classifier->isTrace(entry->feature)) {
+                traceWidth = classifier->width(entry->feature) * 25.4;
+            } else {
+                traceWidth = measureTraceWidthImproved(image, sceneCoord, sceneRect, targetRect, traceAngle);
+            }
             
             if (traceWidth > 0.0 && traceWidth < 50.0) {
                 double widthMils = traceWidth / 0.0254;
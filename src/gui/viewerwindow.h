@@ -24,6 +24,8 @@
 #define __MAINWINDOW_H__
 
 #include <QColor>
+#include <QHash>
+#include <QJsonArray>
 #include <QJsonObject>
 #include <QLabel>
 #include <QList>
@@ -35,13 +37,18 @@
 #include "context.h"
 #include "featurepropertiesdialog.h"
 #include "gotocoordinatedialog.h"
+#include "graphicslayerscene.h"
 #include "layerfeatures.h"
 #include "layerinfobox.h"
 #include "odbppgraphicsview.h"
+#include "pickbuffer.h"
 #include "structuredtextparser.h"
 #include "symbolcount.h"
 
 // Forward declarations
+class DensityMapItem;
+class JobWatcher;
+class QTimer;
 class RestApiServer;
 
 namespace Ui {
@@ -90,19 +97,28 @@ public slots:
   void on_actionShowStepRepeat_toggled(bool checked);
   void on_actionShowNotes_toggled(bool checked);
   void on_actionExportPNG_triggered(void);
+  void on_actionExportPolygons_triggered(void);
   void on_actionGoToCoordinate_triggered(void);
   void handleCaptureRequest(const QJsonObject &request);
+  void handleQueryRequest(const QJsonObject &request);
 
   //  NEW: Trace selection slots
   void on_actionSelectTraceR1_triggered();
   void on_actionSelectTraceR2_triggered();
   void on_actionSelectTraceR3_triggered();
+  void on_actionShowTraceWidthClasses_triggered();
+  void on_actionCheckSpacing_triggered();
+  void on_actionCopperDensity_triggered();
 
   void on_actionSaveHighlight_triggered();
   void on_actionLoadHighlight_triggered();
 
 protected:
   QColor nextColor(void);
+  GraphicsLayerScene* activeLayerScene(void);
+  Layer* queryLayer(const QString& layerName);
+  void demoteLayer(LayerInfoBox* box);
+  QJsonObject runQuery(Layer* layer, const QJsonObject& request);
 
 private slots:
   void toggleShowLayer(bool selected);
@@ -112,7 +128,12 @@ private slots:
   void updateCursorCoord(QPointF pos);
   void updateFeatureDetail(Symbol* symbol);
   void updateMeasureResult(QRectF rect);
+  void updateMeasureClearance(QPointF start, QPointF end);
   void on_actionToggleHighlightColor_triggered();
+  void reloadFeatures(FeaturesDataStore* oldDs, FeaturesDataStore* newDs,
+      const FeaturesDiff& diff);
+  void reloadStepAndRepeat(const QString& step);
+  void demoteColdLayers(void);
 
 private:
   Ui::ViewerWindow *ui;
@@ -131,6 +152,16 @@ private:
   FeaturePropertiesDialog* m_featurePropertiesDialog;
   GoToCoordinateDialog* m_goToCoordinateDialog;
   RestApiServer* m_restApiServer;
+  JobWatcher* m_jobWatcher;
+  DensityMapItem* m_densityMap;
+
+  /* Hidden layers are demoted after m_coldDelay s or above the ceiling */
+  QTimer* m_coldTimer;
+  QHash<LayerInfoBox*, qint64> m_hiddenSince;
+  QHash<LayerInfoBox*, GraphicsLayerScene::HighlightState> m_coldHighlights;
+  qint64 m_memoryCeiling;
+  int m_coldDelay;
+  bool m_coldSpill;
   QString findJobPath(const QString &jobName);
   void waitForRender(int milliseconds = 100);
   QPushButton* m_highlightColorButton;
@@ -139,8 +170,8 @@ public:
   QColor getHighlightColor() const;
 
 private:
-  QString detectObjectAtCoordinate(const QImage &image, const QPointF &sceneCoord, 
-                                   const QRectF &sceneRect, const QRectF &targetRect);
+  QString detectObjectAtCoordinate(const PickBuffer &picks, const QPointF &sceneCoord,
+                                   Symbol **symbol = nullptr);
   
   double measureTraceWidth(const QImage &image, const QPointF &sceneCoord,
                           const QRectF &sceneRect, const QRectF &targetRect,
@@ -153,7 +184,8 @@ private:
   // ONLY ONE declaration here, WITH default arguments
   bool navigateAndCapture(const QString &layerName, double x, double y, double zoom,
                          QString *outputPath = nullptr, QByteArray *imageData = nullptr,
-                         QString *detectedObject = nullptr);
+                         QString *detectedObject = nullptr,
+                         QJsonArray *features = nullptr);
 };
 
 #endif // __MAINWINDOW_H__
\ No newline at end of file
@@ -0,0 +1,427 @@
+/**
+ * @file   jobindex.cpp
+ * @author Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ *
+ * Copyright (C) 2012 - 2014 Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ * All Rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "jobindex.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "archiveloader.h"
+#include "compresseddevice.h"
+#include "logger.h"
+#include "parallel.h"
+#include "structuredtextparser.h"
+
+#define INDEX_MAGIC 0x51434958    /* "QCIX" */
+#define MAX_TOKENS 8
+
+static QDataStream& operator<<(QDataStream& out,
+    const JobIndex::Layer& layer)
+{
+  return out << layer.name << layer.type << layer.context << layer.polarity
+    << layer.startName << layer.endName;
+}
+
+static QDataStream& operator>>(QDataStream& in,
+    JobIndex::Layer& layer)
+{
+  return in >> layer.name >> layer.type >> layer.context >> layer.polarity
+    >> layer.startName >> layer.endName;
+}
+
+static QDataStream& operator<<(QDataStream& out,
+    const JobIndex::Features& f)
+{
+  return out << f.fileSize << f.dataSize << qint32(f.symbols)
+    << qint32(f.lines) << qint32(f.pads) << qint32(f.arcs) << qint32(f.texts)
+    << qint32(f.barcodes) << qint32(f.surfaces) << f.bbox;
+}
+
+static QDataStream& operator>>(QDataStream& in,
+    JobIndex::Features& f)
+{
+  qint32 counts[7];
+  in >> f.fileSize >> f.dataSize;
+  for (int i = 0; i < 7; ++i) {
+    in >> counts[i];
+  }
+  in >> f.bbox;
+  f.symbols = counts[0];
+  f.lines = counts[1];
+  f.pads = counts[2];
+  f.arcs = counts[3];
+  f.texts = counts[4];
+  f.barcodes = counts[5];
+  f.surfaces = counts[6];
+  return in;
+}
+
+JobIndex::JobIndex()
+{
+}
+
+QStringList JobIndex::layerNames(void) const
+{
+  QStringList names;
+  foreach (const Layer& layer, m_layers) {
+    names.append(layer.name);
+  }
+  return names;
+}
+
+bool JobIndex::hasFeatures(const QString& step, const QString& layer) const
+{
+  QHash<QString, Features>::const_iterator it = m_features.find(
+      step + "/" + layer);
+  return it != m_features.end() && it->dataSize > 0;
+}
+
+JobIndex::Features JobIndex::features(const QString& step,
+    const QString& layer) const
+{
+  return m_features.value(step + "/" + layer);
+}
+
+void JobIndex::setFeatures(const QString& step, const QString& layer,
+    const Features& features)
+{
+  m_features.insert(step + "/" + layer, features);
+}
+
+bool JobIndex::buildMatrix(ArchiveLoader* loader)
+{
+  StructuredTextParser parser(loader->dataPath("matrix/matrix"));
+  StructuredTextDataStore* ds = parser.parse();
+  if (!ds) {
+    m_errorString = "cannot parse matrix/matrix";
+    return false;
+  }
+
+  StructuredTextDataStore::BlockIterPair ip = ds->getBlocksByKey("STEP");
+  for (StructuredTextDataStore::BlockIter it = ip.first; it != ip.second;
+      ++it) {
+    m_steps.append(QString::fromStdString(it->second->get("NAME")).toLower());
+  }
+
+  ip = ds->getBlocksByKey("LAYER");
+  for (StructuredTextDataStore::BlockIter it = ip.first; it != ip.second;
+      ++it) {
+    Layer layer;
+    layer.name = QString::fromStdString(it->second->get("NAME")).toLower();
+    layer.type = QString::fromStdString(it->second->get("TYPE"));
+    layer.context = QString::fromStdString(it->second->get("CONTEXT"));
+    layer.polarity = QString::fromStdString(it->second->get("POLARITY"));
+    layer.startName = QString::fromStdString(it->second->get("START_NAME"))
+      .toLower();
+    layer.endName = QString::fromStdString(it->second->get("END_NAME"))
+      .toLower();
+    m_layers.append(layer);
+  }
+
+  delete ds;
+  return true;
+}
+
+bool JobIndex::build(ArchiveLoader* loader)
+{
+  m_steps.clear();
+  m_layers.clear();
+  m_features.clear();
+
+  if (!buildMatrix(loader)) {
+    return false;
+  }
+
+  // Resolve the files up front; the scan itself only needs a file name
+  QStringList keys, fileNames;
+  std::vector<Features> results;
+  foreach (const QString& step, m_steps) {
+    foreach (const Layer& layer, m_layers) {
+      QString base = QString("steps/%1/layers/%2/features").arg(step)
+        .arg(layer.name);
+      QString name;
+      if (loader->exists(base)) {
+        name = base;
+      } else if (loader->exists(base + ".Z")) {
+        name = base + ".Z";
+      } else if (loader->exists(base + ".z")) {
+        name = base + ".z";
+      } else {
+        continue;
+      }
+
+      Features features;
+      features.fileSize = loader->fileSize(name);
+      keys.append(step + "/" + layer.name);
+      fileNames.append(loader->absPath(name));
+      results.push_back(features);
+    }
+  }
+
+  Parallel::forRange(int(results.size()), 1, [&](int begin, int end) {
+    for (int i = begin; i < end; ++i) {
+      if (!scanFeatures(fileNames[i], results[i])) {
+        LOG_WARNING(QString("Incomplete features file: %1")
+            .arg(fileNames[i]));
+      }
+    }
+  });
+
+  for (int i = 0; i < keys.size(); ++i) {
+    m_features.insert(keys[i], results[i]);
+  }
+  return true;
+}
+
+bool JobIndex::scanFeatures(const QString& fileName, Features& features)
+{
+  CompressedDevice file(fileName);
+  if (!file.open(QIODevice::ReadOnly)) {
+    return false;
+  }
+
+  // Only the record type and its coordinates matter here, so split the
+  // line in place instead of going through the features grammar
+  char line[4096];
+  char* tokens[MAX_TOKENS];
+  qreal xmin = 0, ymin = 0, xmax = 0, ymax = 0;
+  qreal scale = 1.0;
+  bool empty = true;
+
+  for (;;) {
+    qint64 n = file.readLine(line, sizeof(line));
+    if (n <= 0) {
+      break;
+    }
+    features.dataSize += n;
+
+    if (line[n - 1] != '\n' && n == qint64(sizeof(line)) - 1) {
+      // Overlong line, only attribute text gets this long; drop the rest
+      char c;
+      while (file.getChar(&c) && c != '\n') {
+        ++features.dataSize;
+      }
+    }
+
+    int count = 0;
+    for (char* p = line; *p && count < MAX_TOKENS;) {
+      while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n') {
+        *p++ = 0;
+      }
+      if (!*p) {
+        break;
+      }
+      tokens[count++] = p;
+      while (*p && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n') {
+        ++p;
+      }
+    }
+    if (count == 0) {
+      continue;
+    }
+
+    const char* type = tokens[0];
+    int points = 0;
+    if (type[0] == '$') {
+      ++features.symbols;
+    } else if (!strcmp(type, "UNITS=MM") ||
+        (!strcmp(type, "U") && count > 1 && !strcmp(tokens[1], "MM"))) {
+      scale = 1 / 25.4;
+    } else if (!strcmp(type, "L")) {
+      ++features.lines;
+      points = 2;
+    } else if (!strcmp(type, "P")) {
+      ++features.pads;
+      points = 1;
+    } else if (!strcmp(type, "A")) {
+      ++features.arcs;
+      points = 3;
+    } else if (!strcmp(type, "T")) {
+      ++features.texts;
+      points = 1;
+    } else if (!strcmp(type, "B")) {
+      ++features.barcodes;
+      points = 1;
+    } else if (!strcmp(type, "S")) {
+      ++features.surfaces;
+    } else if (!strcmp(type, "OB") || !strcmp(type, "OS")) {
+      points = 1;
+    } else if (!strcmp(type, "OC")) {
+      points = 2;
+    }
+
+    for (int i = 0; i < points && 2 + 2 * i < count; ++i) {
+      qreal x = strtod(tokens[1 + 2 * i], NULL);
+      qreal y = strtod(tokens[2 + 2 * i], NULL);
+      if (empty) {
+        xmin = xmax = x;
+        ymin = ymax = y;
+        empty = false;
+      } else {
+        xmin = qMin(xmin, x);
+        xmax = qMax(xmax, x);
+        ymin = qMin(ymin, y);
+        ymax = qMax(ymax, y);
+      }
+    }
+  }
+
+  if (!empty) {
+    features.bbox = QRectF(QPointF(xmin * scale, ymin * scale),
+        QPointF(xmax * scale, ymax * scale));
+  }
+  return !file.hasError();
+}
+
+bool JobIndex::load(const QString& fileName)
+{
+  QFile file(fileName);
+  if (!file.open(QIODevice::ReadOnly)) {
+    m_errorString = file.errorString();
+    return false;
+  }
+
+  QDataStream in(&file);
+  in.setVersion(QDataStream::Qt_5_0);
+
+  quint32 magic, version;
+  in >> magic >> version;
+  if (magic != INDEX_MAGIC || version != VERSION) {
+    m_errorString = "not a job index of this version";
+    return false;
+  }
+
+  in >> m_stamp >> m_steps >> m_layers >> m_features;
+  if (in.status() != QDataStream::Ok) {
+    m_errorString = "truncated job index";
+    m_steps.clear();
+    m_layers.clear();
+    m_features.clear();
+    return false;
+  }
+  return true;
+}
+
+bool JobIndex::save(const QString& fileName) const
+{
+  QSaveFile file(fileName);
+  if (!file.open(QIODevice::WriteOnly)) {
+    const_cast<JobIndex*>(this)->m_errorString = file.errorString();
+    return false;
+  }
+
+  QDataStream out(&file);
+  out.setVersion(QDataStream::Qt_5_0);
+  out << quint32(INDEX_MAGIC) << quint32(VERSION) << m_stamp << m_steps
+    << m_layers << m_features;
+
+  if (!file.commit()) {
+    const_cast<JobIndex*>(this)->m_errorString = file.errorString();
+    return false;
+  }
+  return true;
+}
+
+QString JobIndex::indexPath(const QString& jobPath)
+{
+  QFileInfo info(jobPath);
+  if (info.isDir()) {
+    return info.absoluteFilePath() + "/.qcamber-index";
+  }
+  return info.absolutePath() + "/." + info.fileName() + ".qcamber-index";
+}
+
+QString JobIndex::stamp(const QString& jobPath)
+{
+  QFileInfo info(jobPath);
+  if (!info.isDir()) {
+    return QString("%1:%2").arg(info.size())
+      .arg(info.lastModified().toMSecsSinceEpoch());
+  }
+
+  // A job directory changes file by file: matrix/matrix plus every
+  // features file, in a stable order
+  QString root = info.absoluteFilePath();
+  QStringList files;
+  QString matrix = root + "/matrix/matrix";
+  foreach (const QString& suffix, QStringList() << "" << ".Z" << ".z") {
+    if (QFile::exists(matrix + suffix)) {
+      files.append(matrix + suffix);
+      break;
+    }
+  }
+
+  QStringList features;
+  QDirIterator it(root + "/steps", QStringList() << "features"
+      << "features.Z" << "features.z", QDir::Files,
+      QDirIterator::Subdirectories);
+  while (it.hasNext()) {
+    features.append(it.next());
+  }
+  features.sort();
+  files += features;
+
+  QCryptographicHash hash(QCryptographicHash::Sha1);
+  foreach (const QString& fileName, files) {
+    QFileInfo file(fileName);
+    hash.addData(QString("%1:%2:%3\n").arg(fileName.mid(root.size()))
+        .arg(file.size()).arg(file.lastModified().toMSecsSinceEpoch())
+        .toUtf8());
+  }
+  return QString("%1:%2").arg(files.size())
+    .arg(QString::fromLatin1(hash.result().toHex()));
+}
+
+JobIndex* JobIndex::open(const QString& jobPath, ArchiveLoader* loader)
+{
+  JobIndex* index = new JobIndex;
+  QString fileName = indexPath(jobPath);
+  QString current = stamp(jobPath);
+
+  if (index->load(fileName) && index->m_stamp == current) {
+    return index;
+  }
+
+  LOG_STEP(QString("Indexing job: %1").arg(jobPath));
+  if (!index->build(loader)) {
+    LOG_ERROR(QString("Cannot index `%1': %2").arg(jobPath,
+          index->errorString()));
+    delete index;
+    return NULL;
+  }
+
+  index->m_stamp = current;
+  if (!index->save(fileName)) {
+    LOG_WARNING(QString("Cannot write job index `%1': %2").arg(fileName,
+          index->errorString()));
+  }
+  return index;
+}
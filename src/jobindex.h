@@ -0,0 +1,123 @@
+/**
+ * @file   jobindex.h
+ * @author Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ *
+ * Copyright (C) 2012 - 2014 Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ * All Rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __JOBINDEX_H__
+#define __JOBINDEX_H__
+
+#include <QHash>
+#include <QList>
+#include <QRectF>
+#include <QString>
+#include <QStringList>
+
+class ArchiveLoader;
+
+/**
+ * Compact summary of one job: the matrix plus per step/layer statistics of
+ * the features files.
+ *
+ * The index is built once (at import, or the first time a job is opened)
+ * and stored next to the job, so the job list, the matrix table and the
+ * layer boxes can be filled without parsing matrix/matrix or touching a
+ * single features file.  It is rebuilt whenever the job's stamp (size and
+ * modification time of the archive, or of matrix/matrix and every features
+ * file of a job directory) no longer matches.
+ */
+class JobIndex {
+public:
+  struct Layer {
+    QString name;
+    QString type;
+    QString context;
+    QString polarity;
+    QString startName;
+    QString endName;
+  };
+
+  struct Features {
+    Features(): fileSize(0), dataSize(0), symbols(0), lines(0), pads(0),
+      arcs(0), texts(0), barcodes(0), surfaces(0) {}
+
+    int records(void) const
+    {
+      return lines + pads + arcs + texts + barcodes + surfaces;
+    }
+
+    qint64 fileSize;    /* bytes on disk, possibly compressed */
+    qint64 dataSize;    /* decoded bytes */
+    int symbols;
+    int lines;
+    int pads;
+    int arcs;
+    int texts;
+    int barcodes;
+    int surfaces;
+    QRectF bbox;        /* extent of feature coordinates, in inches */
+  };
+
+  JobIndex();
+
+  /* Parse the matrix and scan every features file; false on a bad job */
+  bool build(ArchiveLoader* loader);
+
+  bool load(const QString& fileName);
+  bool save(const QString& fileName) const;
+
+  QString errorString(void) const { return m_errorString; }
+
+  QStringList steps(void) const { return m_steps; }
+  QList<Layer> layers(void) const { return m_layers; }
+  QStringList layerNames(void) const;
+
+  bool hasFeatures(const QString& step, const QString& layer) const;
+  Features features(const QString& step, const QString& layer) const;
+  void setFeatures(const QString& step, const QString& layer,
+      const Features& features);
+
+  /* Statistics of one features file, false if it is unreadable or cut */
+  static bool scanFeatures(const QString& fileName, Features& features);
+
+  /* Where the index of the job at jobPath (directory or archive) lives */
+  static QString indexPath(const QString& jobPath);
+
+  /* Stamp identifying the current contents of the job at jobPath */
+  static QString stamp(const QString& jobPath);
+
+  /* The stored index if it is up to date, otherwise a freshly built one */
+  static JobIndex* open(const QString& jobPath, ArchiveLoader* loader);
+
+  enum {
+    VERSION = 1
+  };
+
+private:
+  bool buildMatrix(ArchiveLoader* loader);
+
+private:
+  QString m_stamp;
+  QStringList m_steps;
+  QList<Layer> m_layers;
+  QHash<QString, Features> m_features;
+  QString m_errorString;
+};
+
+#endif /* __JOBINDEX_H__ */
@@ -0,0 +1,270 @@
+/**
+ * @file   jobwatcher.cpp
+ * @author Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ *
+ * Copyright (C) 2012 - 2014 Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ * All Rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "jobwatcher.h"
+
+#include <QDateTime>
+#include <QFileInfo>
+#include <QRunnable>
+
+#include "archiveloader.h"
+#include "cachedparser.h"
+#include "context.h"
+#include "logger.h"
+
+/* Re-parse and diff one features file off the GUI thread */
+class ReparseTask: public QRunnable {
+public:
+  ReparseTask(JobWatcher* watcher, const QString& key,
+      const QString& fileName, FeaturesDataStore* oldDs):
+    m_watcher(watcher), m_key(key), m_fileName(fileName), m_oldDs(oldDs) {}
+
+  virtual void run(void)
+  {
+    JobIndex::Features features;
+    features.fileSize = QFileInfo(m_fileName).size();
+    JobIndex::scanFeatures(m_fileName, features);
+
+    // Cached parses are never modified and oldDs is acquired by the
+    // watcher, so reading it here is safe
+    FeaturesDataStore* newDs = NULL;
+    FeaturesDiff diff;
+    if (m_oldDs) {
+      FeaturesParser parser(m_fileName);
+      newDs = parser.parse();
+      if (newDs) {
+        diff = FeaturesDiff(m_oldDs, newDs);
+      }
+    }
+
+    JobWatcher* watcher = m_watcher;
+    QString key = m_key, fileName = m_fileName;
+    FeaturesDataStore* oldDs = m_oldDs;
+    QMetaObject::invokeMethod(watcher, [=]() {
+      watcher->reparseFinished(key, fileName, oldDs, newDs, diff, features);
+    }, Qt::QueuedConnection);
+  }
+
+private:
+  JobWatcher* m_watcher;
+  QString m_key;
+  QString m_fileName;
+  FeaturesDataStore* m_oldDs;
+};
+
+JobWatcher::JobWatcher(QObject* parent):
+  QObject(parent)
+{
+  // One worker is plenty and keeps parses of the same file in order
+  m_pool.setMaxThreadCount(1);
+
+  m_timer.setSingleShot(true);
+  m_timer.setInterval(SETTLE_DELAY);
+
+  connect(&m_watcher, SIGNAL(fileChanged(const QString&)), this,
+      SLOT(pathChanged(const QString&)));
+  connect(&m_watcher, SIGNAL(directoryChanged(const QString&)), this,
+      SLOT(pathChanged(const QString&)));
+  connect(&m_timer, SIGNAL(timeout()), this, SLOT(processChanges()));
+}
+
+JobWatcher::~JobWatcher()
+{
+  // Results still queued for this object are dropped along with it
+  m_pool.waitForDone();
+}
+
+void JobWatcher::watch(const QStringList& steps, const QStringList& layers)
+{
+  if (!ctx.loader || ctx.loader->isArchive()) {
+    return;
+  }
+
+  foreach (const QString& step, steps) {
+    Target header;
+    header.step = step;
+    m_targets[step] = header;
+    m_stamps[step] = stamp(header);
+    rewatch(header);
+
+    foreach (const QString& layer, layers) {
+      Target target;
+      target.step = step;
+      target.layer = layer;
+      QString key = step + "/" + layer;
+      m_targets[key] = target;
+      m_stamps[key] = stamp(target);
+      rewatch(target);
+    }
+  }
+  LOG_INFO(QString("Watching %1 files and directories for changes")
+      .arg(m_pathKeys.size()));
+}
+
+QString JobWatcher::relativePath(const Target& target) const
+{
+  if (target.layer.isEmpty()) {
+    return QString("steps/%1/stephdr").arg(target.step);
+  }
+  return QString("steps/%1/layers/%2/features").arg(target.step)
+    .arg(target.layer);
+}
+
+QString JobWatcher::stamp(const Target& target) const
+{
+  QFileInfo info(ctx.loader->dataPath(relativePath(target)));
+  if (!info.exists()) {
+    return QString();
+  }
+  return QString("%1:%2").arg(info.size())
+    .arg(info.lastModified().toMSecsSinceEpoch());
+}
+
+void JobWatcher::rewatch(const Target& target)
+{
+  // Exporters usually replace files rather than rewrite them, which ends a
+  // file watch; the directory watch catches that and the file is re-added
+  QString key = target.layer.isEmpty()? target.step:
+    target.step + "/" + target.layer;
+  QString fileName = ctx.loader->dataPath(relativePath(target));
+  QString dirName = QFileInfo(fileName).absolutePath();
+
+  QStringList paths;
+  paths << dirName;
+  if (QFile::exists(fileName)) {
+    paths << fileName;
+  }
+  foreach (const QString& path, paths) {
+    if (!m_watcher.files().contains(path) &&
+        !m_watcher.directories().contains(path) && QFileInfo::exists(path)) {
+      m_watcher.addPath(path);
+    }
+    m_pathKeys[path] = key;
+  }
+}
+
+void JobWatcher::pathChanged(const QString& path)
+{
+  QString key = m_pathKeys.value(path);
+  if (key.isEmpty()) {
+    return;
+  }
+  m_changed.insert(key);
+  m_timer.start();
+}
+
+void JobWatcher::processChanges(void)
+{
+  QSet<QString> changed = m_changed;
+  m_changed.clear();
+
+  foreach (const QString& key, changed) {
+    const Target target = m_targets.value(key);
+    rewatch(target);
+
+    QString current = stamp(target);
+    if (current == m_stamps.value(key)) {
+      continue;
+    }
+    m_stamps[key] = current;
+
+    if (target.layer.isEmpty()) {
+      LOG_STEP(QString("Step header of %1 changed").arg(target.step));
+      foreach (const QString& name, QStringList() << "" << ".Z" << ".z") {
+        CachedStructuredTextParser::replace(ctx.loader->absPath(
+              relativePath(target) + name), NULL);
+      }
+      emit stepHeaderChanged(target.step);
+    } else if (!current.isEmpty()) {
+      reparse(key);
+    }
+  }
+}
+
+void JobWatcher::reparse(const QString& key)
+{
+  if (m_running.contains(key)) {
+    m_rerun.insert(key);
+    return;
+  }
+
+  const Target target = m_targets.value(key);
+  QString rel = relativePath(target);
+  QString fileName = ctx.loader->dataPath(rel);
+
+  // The export may have switched between plain and compressed storage, so
+  // look for a cached parse under any name of the file
+  FeaturesDataStore* oldDs = NULL;
+  foreach (const QString& name, QStringList() << "" << ".Z" << ".z") {
+    QString cachedName = ctx.loader->absPath(rel + name);
+    FeaturesDataStore* ds = CachedFeaturesParser::cached(cachedName);
+    if (ds && !oldDs) {
+      // Kept alive for the diff until reparseFinished()
+      oldDs = ds;
+      CachedFeaturesParser::acquire(oldDs);
+    }
+    if (ds && cachedName != fileName) {
+      CachedFeaturesParser::replace(cachedName, NULL);
+    }
+  }
+
+  LOG_STEP(QString("Features of %1 changed, re-parsing").arg(key));
+  m_running.insert(key);
+  m_pool.start(new ReparseTask(this, key, fileName, oldDs));
+}
+
+void JobWatcher::reparseFinished(const QString& key, const QString& fileName,
+    FeaturesDataStore* oldDs, FeaturesDataStore* newDs,
+    const FeaturesDiff& diff, const JobIndex::Features& features)
+{
+  m_running.remove(key);
+  const Target target = m_targets.value(key);
+
+  JobIndex* index = ctx.loader->index();
+  if (index) {
+    index->setFeatures(target.step, target.layer, features);
+    if (!index->save(JobIndex::indexPath(ctx.loader->fileName()))) {
+      LOG_WARNING(QString("Cannot update job index: %1")
+          .arg(index->errorString()));
+    }
+  }
+
+  if (oldDs && !newDs) {
+    // Most likely caught in the middle of a write; the next change event
+    // brings another try
+    LOG_WARNING(QString("Cannot re-parse %1, keeping the previous features")
+        .arg(fileName));
+  } else if (newDs) {
+    LOG_INFO(QString("Features of %1: %2 added, %3 removed").arg(key)
+        .arg(diff.added()).arg(diff.removed()));
+    CachedFeaturesParser::replace(fileName, newDs);
+    emit featuresReloaded(oldDs, newDs, diff);
+  }
+
+  if (oldDs) {
+    CachedFeaturesParser::release(oldDs);
+  }
+
+  if (m_rerun.remove(key)) {
+    reparse(key);
+  }
+}
@@ -0,0 +1,108 @@
+/**
+ * @file   jobwatcher.h
+ * @author Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ *
+ * Copyright (C) 2012 - 2014 Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ * All Rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __JOBWATCHER_H__
+#define __JOBWATCHER_H__
+
+#include <QFileSystemWatcher>
+#include <QHash>
+#include <QObject>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+#include <QTimer>
+
+#include "featuresdatastore.h"
+#include "featuresdiff.h"
+#include "jobindex.h"
+
+/**
+ * Watches the features files and step headers of the open job so a CAM
+ * re-export shows up without reopening the job.
+ *
+ * Changes are collected until the files have been quiet for SETTLE_DELAY
+ * ms.  A changed features file that is in CachedFeaturesParser is then
+ * re-parsed and diffed against the cached parse on a worker thread; back on
+ * the GUI thread the cache entry is replaced and featuresReloaded() lets
+ * the open layers patch themselves.  The job index entry is refreshed for
+ * every changed features file.
+ *
+ * Only extracted jobs are watched; a mounted archive is read-only.
+ */
+class JobWatcher: public QObject {
+  Q_OBJECT
+
+public:
+  JobWatcher(QObject* parent = 0);
+  virtual ~JobWatcher();
+
+  /* Watch the given layers of every step in steps, plus the step headers */
+  void watch(const QStringList& steps, const QStringList& layers);
+
+  /* Whether a re-parse is pending or running */
+  bool isBusy(void) const {
+    return !m_changed.isEmpty() || !m_running.isEmpty();
+  }
+
+  enum {
+    SETTLE_DELAY = 500
+  };
+
+signals:
+  void featuresReloaded(FeaturesDataStore* oldDs, FeaturesDataStore* newDs,
+      const FeaturesDiff& diff);
+  void stepHeaderChanged(const QString& step);
+
+private slots:
+  void pathChanged(const QString& path);
+  void processChanges(void);
+
+private:
+  friend class ReparseTask;
+
+  struct Target {
+    QString step;
+    QString layer;      /* empty for the step header */
+  };
+
+  QString relativePath(const Target& target) const;
+  QString stamp(const Target& target) const;
+  void rewatch(const Target& target);
+  void reparse(const QString& key);
+  void reparseFinished(const QString& key, const QString& fileName,
+      FeaturesDataStore* oldDs, FeaturesDataStore* newDs,
+      const FeaturesDiff& diff, const JobIndex::Features& features);
+
+private:
+  QFileSystemWatcher m_watcher;
+  QTimer m_timer;
+  QThreadPool m_pool;
+  QHash<QString, Target> m_targets;       /* by key */
+  QHash<QString, QString> m_pathKeys;     /* watched path to key */
+  QHash<QString, QString> m_stamps;       /* by key */
+  QSet<QString> m_changed;
+  QSet<QString> m_running;
+  QSet<QString> m_rerun;
+};
+
+#endif /* __JOBWATCHER_H__ */
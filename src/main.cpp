@@ -22,11 +22,15 @@
 
 #include <QtWidgets>
 
+#include "arcgeometry.h"
 #include "code39.h"
 #include "context.h"
+#include "fixedpoint.h"
 #include "jobmanagerdialog.h"
+#include "layerstore.h"
 #include "logger.h"
 #include "settings.h"
+#include "spatialorder.h"
 
 int main(int argc, char *argv[])
 {
@@ -45,6 +49,26 @@ int main(int argc, char *argv[])
   ctx.bg_color = QColor(SETTINGS->get("Color", "BG").toString());
   LOG_INFO(QString("Background color set to: %1").arg(ctx.bg_color.name()));
 
+  ArcGeometry::setTolerance(
+      SETTINGS->get("System", "ArcTolerance").toDouble());
+
+  QString curve = SETTINGS->get("System", "SpatialOrder").toString();
+  if (curve == "hilbert") {
+    SpatialOrder::setCurve(SpatialOrder::Hilbert);
+  } else if (curve == "morton") {
+    SpatialOrder::setCurve(SpatialOrder::Morton);
+  }
+
+  FixedPoint::setResolution(
+      SETTINGS->get("System", "CoordinateResolution").toDouble());
+
+  QString store = SETTINGS->get("System", "LayerStore").toString();
+  if (store == "file") {
+    LayerStore::setMode(LayerStore::CacheFile,
+        SETTINGS->get("System", "LayerStoreDir").toString());
+  }
+  LOG_INFO(QString("Layer store: %1").arg(store.isEmpty()? "off": store));
+
   LOG_STEP("Creating main dialog");
   JobManagerDialog dialog;
   dialog.show();
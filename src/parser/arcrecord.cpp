@@ -29,6 +29,10 @@ ArcRecord::ArcRecord(FeaturesDataStore* ds, const QStringList& param,
     const AttribData& attr):
   Record(ds, attr)
 {
+  if (param.empty()) {
+    return;
+  }
+
   int i = 0;
   xs = param[++i].toDouble();
   ys = param[++i].toDouble();
@@ -31,6 +31,10 @@ BarcodeRecord::BarcodeRecord(FeaturesDataStore* ds, const QStringList& param,
     const AttribData& attr):
   TextRecord(ds, QStringList(), attr)
 {
+  if (param.empty()) {
+    return;
+  }
+
   int i = 0;
   x = param[++i].toDouble();
   y = param[++i].toDouble();
@@ -47,8 +47,13 @@ QPainterPath CharLineRecord::painterPath(qreal width_factor)
   qreal ex = xe, ey = ye;
   qreal dx = ex - sx, dy = ey - sy;
 
-  qreal a = qAtan2(dy, dx);
-  qreal rsina = radius * qSin(a), rcosa = radius * qCos(a);
+  // radius * sin and cos of the stroke direction, without the trigonometry
+  qreal len = qSqrt(dx * dx + dy * dy);
+  qreal rsina = 0, rcosa = radius;
+  if (len > 0) {
+    rsina = radius * dy / len;
+    rcosa = radius * dx / len;
+  }
 
   path.moveTo(sx + rsina, -(sy - rcosa));
   path.lineTo(sx - rsina, -(sy + rcosa));
@@ -67,6 +72,15 @@ QPainterPath CharLineRecord::painterPath(qreal width_factor)
   return path;
 }
 
+QRectF CharLineRecord::boundingRect(qreal width_factor) const
+{
+  // Both cap shapes span radius around the end points, and so does the
+  // body between them
+  qreal radius = width * width_factor / 2.0;
+  return QRectF(qMin(xs, xe) - radius, -qMax(ys, ye) - radius,
+      qAbs(xe - xs) + 2 * radius, qAbs(ye - ys) + 2 * radius);
+}
+
 CharRecord::CharRecord(FontDataStore* ds, const QStringList& param): ds(ds)
 {
   tchar = param[1].toLatin1()[0];
@@ -94,3 +108,13 @@ QPainterPath CharRecord::painterPath(qreal width_factor)
 
   return path;
 }
+
+QRectF CharRecord::boundingRect(qreal width_factor) const
+{
+  QRectF bounds;
+  for (QList<CharLineRecord*>::const_iterator it = lines.begin();
+      it != lines.end(); ++it) {
+    bounds |= (*it)->boundingRect(width_factor);
+  }
+  return bounds;
+}
@@ -202,53 +202,64 @@ struct code39map c39fm[] = {
   { 127, "%T" },
 };
 
-QMap<QChar, QString> Code39::s_patterns;
-QMap<QChar, unsigned> Code39::s_checksum;
-QMap<unsigned, QChar> Code39::s_checksum_inv;
-QMap<QChar, QString> Code39::s_fascmap;
+/* Length of a character pattern, without the gap that follows it */
+#define PATTERN_LENGTH 9
+
+const char* Code39::s_patterns[128];
+bool Code39::s_initialized = false;
 
 void Code39::initPatterns(void)
 {
+  if (s_initialized) {
+    return;
+  }
+
+  for (int c = 0; c < 128; ++c) {
+    s_patterns[c] = NULL;
+  }
   for (unsigned i = 0; i < sizeof(c39m) / sizeof(c39m[0]); ++i) {
-    s_patterns[c39m[i].tchar] = c39m[i].pattern;
-    s_checksum[c39m[i].tchar] = i;
-    s_checksum_inv[i] = c39m[i].tchar;
+    s_patterns[(int)c39m[i].tchar] = c39m[i].pattern;
   }
+  s_initialized = true;
+}
 
-  for (unsigned i = 0; i < sizeof(c39fm) / sizeof(c39fm[0]); ++i) {
-    s_fascmap[c39fm[i].tchar] = c39fm[i].pattern;
+void Code39::appendChar(QByteArray& pattern, char c)
+{
+  if (c >= 'a' && c <= 'z') {
+    c -= 'a' - 'A';
+  }
+  if (c >= 0 && s_patterns[(int)c]) {
+    pattern.append(s_patterns[(int)c], PATTERN_LENGTH);
+    pattern.append('w');
   }
 }
 
-QString Code39::encode(QString text, bool checksum, bool fasc)
+QByteArray Code39::encode(const QString& text, bool checksum, bool fasc)
 {
-  QString pattern = s_patterns['*'] + "w";
-  unsigned sum = 0;
+  initPatterns();
 
-  if (fasc) {
-    QString expended;
-    for (int i = 0; i < text.length(); ++i) {
-      expended += s_fascmap[text[i]];
-    }
-    text = expended;
-  } else {
-    text = text.toUpper();
-  }
+  // Full ASCII takes up to two symbols per character, plus start and stop
+  QByteArray pattern;
+  pattern.reserve((text.length() * 2 + 2) * (PATTERN_LENGTH + 1));
+  appendChar(pattern, '*');
 
   for (int i = 0; i < text.length(); ++i) {
-    if (s_patterns.find(text[i]) != s_patterns.end()) {
-      pattern += s_patterns[text[i]] + "w";
-      if (!fasc && checksum) {
-        sum += s_checksum[text[i]];
+    ushort u = text[i].unicode();
+    if (fasc) {
+      // c39fm is indexed by ASCII code
+      if (u < sizeof(c39fm) / sizeof(c39fm[0])) {
+        for (const char* p = c39fm[u].pattern; *p; ++p) {
+          appendChar(pattern, *p);
+        }
       }
+    } else if (u < 128) {
+      appendChar(pattern, char(u));
     }
   }
-  /*
-  if (checksum) {
-    pattern += "w" + s_patterns[s_checksum_inv[sum % 43]];
-  }
-  */
-  pattern += s_patterns['*'];
+  // The check character is not drawn
+  Q_UNUSED(checksum);
+
+  pattern.append(s_patterns[(int)'*'], PATTERN_LENGTH);
 
   return pattern;
 }
@@ -23,25 +23,30 @@
 #ifndef __CODE_39_H__
 #define __CODE_39_H__
 
-#include <QChar>
-#include <QMap>
+#include <QByteArray>
 #include <QString>
 
 struct code39map {
   char tchar;
-  QString pattern;
+  const char* pattern;
 };
 
+/**
+ * Code 39 encoder.  Patterns are spelled with W/N for wide and narrow bars
+ * and w/n for wide and narrow spaces.  The lookup tables are indexed by
+ * ASCII code, so encoding is a single pass without any map lookups.
+ */
 class Code39 {
 public:
   static void initPatterns(void);
-  static QString encode(QString text, bool checksum=false, bool fasc=false);
+  static QByteArray encode(const QString& text, bool checksum=false,
+      bool fasc=false);
 
 private:
-  static QMap<QChar, QString> s_patterns;
-  static QMap<QChar, unsigned> s_checksum;
-  static QMap<unsigned, QChar> s_checksum_inv;
-  static QMap<QChar, QString> s_fascmap;
+  static void appendChar(QByteArray& pattern, char c);
+
+  static const char* s_patterns[128];
+  static bool s_initialized;
 };
 
 #endif /* __CODE_39_H__ */
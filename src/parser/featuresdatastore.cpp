@@ -22,8 +22,13 @@
 
 #include "featuresdatastore.h"
 
+#include <QMutex>
+#include <QtAlgorithms>
 #include <QtDebug>
 
+static QList<FeaturesDataStore::DestroyHook> destroyHooks;
+static QMutex destroyHooksMutex;
+
 FeaturesDataStore::FeaturesDataStore():
   m_posSurfaceCount(0), m_posTextCount(0), m_negSurfaceCount(0),
   m_negTextCount(0)
@@ -32,11 +37,29 @@ FeaturesDataStore::FeaturesDataStore():
 
 FeaturesDataStore::~FeaturesDataStore()
 {
+  QList<DestroyHook> hooks;
+  {
+    QMutexLocker locker(&destroyHooksMutex);
+    hooks = destroyHooks;
+  }
+  for (int i = 0; i < hooks.size(); ++i) {
+    hooks[i](this);
+  }
+
+  // Runs the destructors only; the storage goes with m_arena
   for (int i = 0; i < m_records.size(); ++i) {
     delete m_records[i];
   }
 }
 
+void FeaturesDataStore::addDestroyHook(DestroyHook hook)
+{
+  QMutexLocker locker(&destroyHooksMutex);
+  if (!destroyHooks.contains(hook)) {
+    destroyHooks.append(hook);
+  }
+}
+
 void FeaturesDataStore::setJobName(const QString& name)
 {
   m_jobName = name.toUpper();
@@ -139,6 +162,80 @@ void FeaturesDataStore::putSurfaceRecord(SurfaceRecord* rec)
   }
 }
 
+/* Copy of rec in arena; surfaces take their polygons along */
+static Record* copyRecord(const Record* rec, RecordArena* arena)
+{
+  if (const LineRecord* r = dynamic_cast<const LineRecord*>(rec)) {
+    return new (arena) LineRecord(*r);
+  } else if (const PadRecord* r = dynamic_cast<const PadRecord*>(rec)) {
+    return new (arena) PadRecord(*r);
+  } else if (const ArcRecord* r = dynamic_cast<const ArcRecord*>(rec)) {
+    return new (arena) ArcRecord(*r);
+  } else if (const BarcodeRecord* r =
+      dynamic_cast<const BarcodeRecord*>(rec)) {
+    return new (arena) BarcodeRecord(*r);
+  } else if (const TextRecord* r = dynamic_cast<const TextRecord*>(rec)) {
+    return new (arena) TextRecord(*r);
+  } else if (const SurfaceRecord* r =
+      dynamic_cast<const SurfaceRecord*>(rec)) {
+    SurfaceRecord* copy = new (arena) SurfaceRecord(*r);
+    copy->currentRecord = NULL;
+    for (int i = 0; i < copy->polygons.size(); ++i) {
+      PolygonRecord* poly = new (arena) PolygonRecord(*r->polygons[i]);
+      for (int j = 0; j < poly->operations.size(); ++j) {
+        poly->operations[j] = new (arena) SurfaceOperation(
+            *poly->operations[j]);
+      }
+      copy->polygons[i] = poly;
+    }
+    return copy;
+  }
+  return NULL;
+}
+
+void FeaturesDataStore::relocate(const QVector<int>& order)
+{
+  if (order.size() != m_records.size()) {
+    return;
+  }
+
+  RecordArena arena;
+  QVector<Record*> copies(m_records.size(), NULL);
+  for (int i = 0; i < order.size(); ++i) {
+    copies[order[i]] = copyRecord(m_records[order[i]], &arena);
+    if (!copies[order[i]]) {
+      qDeleteAll(copies);
+      return;
+    }
+  }
+
+  for (int i = 0; i < m_records.size(); ++i) {
+    delete m_records[i];
+    m_records[i] = copies[i];
+  }
+  // The old storage goes away with arena
+  m_arena.swap(arena);
+  m_order = order;
+}
+
+QVector<int> FeaturesDataStore::drawOrder(void) const
+{
+  if (m_order.size() == m_records.size()) {
+    return m_order;
+  }
+  QVector<int> order(m_records.size());
+  for (int i = 0; i < order.size(); ++i) {
+    order[i] = i;
+  }
+  return order;
+}
+
+qint64 FeaturesDataStore::memoryUsage(void) const
+{
+  return qint64(m_arena.capacity()) + m_records.size() * sizeof(Record*) +
+    m_order.size() * sizeof(int);
+}
+
 void FeaturesDataStore::dump(void)
 {
   qDebug() << "=== Symbol names ===";
@@ -27,6 +27,7 @@
 #include <QMap>
 #include <QString>
 #include <QStringList>
+#include <QVector>
 
 #include "datastore.h"
 #include "structuredtextdatastore.h"
@@ -59,12 +60,37 @@ public:
   QString stepName(void) const { return m_stepName; }
   QString layerName(void) const { return m_layerName; }
   QString attrlist(QString name) { return m_attrlist[name]; }
+  const QMap<QString, QString>& attrlistMap(void) const { return m_attrlist; }
 
   const IDMapType& symbolNameMap(void) const { return m_symbolNameMap; }
   const IDMapType& attribNameMap(void) const { return m_attribNameMap; }
   const IDMapType& attribTextMap(void) const { return m_attribTextMap; }
   const QList<Record*> records(void) const { return m_records; }
 
+  /* Storage for this store's records, released with the store */
+  RecordArena* arena(void) { return &m_arena; }
+
+  /**
+   * Move the records in memory so that records()[order[0]],
+   * records()[order[1]], ... are laid out one after another.  records()
+   * keeps file order, so record indices stay valid; drawOrder() returns
+   * order from then on.
+   */
+  void relocate(const QVector<int>& order);
+
+  /* Record indices in the order to visit them, file order by default */
+  QVector<int> drawOrder(void) const;
+
+  /* Approximate heap footprint of the records, in bytes */
+  qint64 memoryUsage(void) const;
+
+  /**
+   * Run hook on every data store about to be destroyed, so caches kept
+   * elsewhere can drop what they built from it
+   */
+  typedef void (*DestroyHook)(FeaturesDataStore* ds);
+  static void addDestroyHook(DestroyHook hook);
+
   const CountMapType& posLineCountMap(void) const { return m_posLineCountMap; }
   const CountMapType& posPadCountMap(void) const { return m_posPadCountMap; }
   const CountMapType& posArcCountMap(void) const { return m_posArcCountMap; }
@@ -106,6 +132,8 @@ private:
   int m_negBarcodeCount;
 
   QList<Record*> m_records;
+  QVector<int> m_order;
+  RecordArena m_arena;
 };
 
 #endif /* __FEATURES_DATASTORE_H__ */
@@ -0,0 +1,110 @@
+/**
+ * @file   featuresdiff.cpp
+ * @author Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ *
+ * Copyright (C) 2012 - 2014 Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ * All Rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "featuresdiff.h"
+
+#include <QDataStream>
+#include <QHash>
+#include <QList>
+
+#include "featuresdatastore.h"
+#include "record.h"
+
+FeaturesDiff::FeaturesDiff():
+  m_added(0), m_removed(0)
+{
+}
+
+FeaturesDiff::FeaturesDiff(const FeaturesDataStore* from,
+    const FeaturesDataStore* to):
+  m_added(0), m_removed(0)
+{
+  const QList<Record*> oldRecords = from->records();
+  const QList<Record*> newRecords = to->records();
+
+  // Old records by value; each match consumes the earliest unused one
+  QHash<QByteArray, QList<int> > pool;
+  pool.reserve(oldRecords.size());
+  for (int i = 0; i < oldRecords.size(); ++i) {
+    pool[recordKey(from, oldRecords[i])].append(i);
+  }
+
+  m_sources.fill(-1, newRecords.size());
+  for (int i = 0; i < newRecords.size(); ++i) {
+    QHash<QByteArray, QList<int> >::iterator it = pool.find(
+        recordKey(to, newRecords[i]));
+    if (it == pool.end() || it->isEmpty()) {
+      ++m_added;
+      continue;
+    }
+    m_sources[i] = it->takeFirst();
+  }
+
+  m_removed = oldRecords.size() - (newRecords.size() - m_added);
+}
+
+QByteArray FeaturesDiff::recordKey(const FeaturesDataStore* ds,
+    const Record* rec)
+{
+  QByteArray key;
+  QDataStream out(&key, QIODevice::WriteOnly);
+  const FeaturesDataStore::IDMapType& symbols = ds->symbolNameMap();
+
+  // Symbol numbers are only indices into the file's symbol table, compare
+  // the names they resolve to instead
+  if (const LineRecord* line = dynamic_cast<const LineRecord*>(rec)) {
+    out << qint8('L') << line->xs << line->ys << line->xe << line->ye
+      << symbols.value(line->sym_num) << int(line->polarity) << line->dcode;
+  } else if (const PadRecord* pad = dynamic_cast<const PadRecord*>(rec)) {
+    out << qint8('P') << pad->x << pad->y << pad->sym_name
+      << int(pad->polarity) << pad->dcode << int(pad->orient);
+  } else if (const ArcRecord* arc = dynamic_cast<const ArcRecord*>(rec)) {
+    out << qint8('A') << arc->xs << arc->ys << arc->xe << arc->ye << arc->xc
+      << arc->yc << symbols.value(arc->sym_num) << int(arc->polarity)
+      << arc->dcode << arc->cw;
+  } else if (const BarcodeRecord* bar =
+      dynamic_cast<const BarcodeRecord*>(rec)) {
+    out << qint8('B') << bar->x << bar->y << bar->barcode << bar->font
+      << int(bar->polarity) << int(bar->orient) << bar->e << bar->w << bar->h
+      << bar->fasc << bar->cs << bar->bg << bar->astr << int(bar->astr_pos)
+      << bar->text;
+  } else if (const TextRecord* text = dynamic_cast<const TextRecord*>(rec)) {
+    out << qint8('T') << text->x << text->y << text->font
+      << int(text->polarity) << int(text->orient) << text->xsize << text->ysize
+      << text->width_factor << text->text << text->version;
+  } else if (const SurfaceRecord* surface =
+      dynamic_cast<const SurfaceRecord*>(rec)) {
+    out << qint8('S') << int(surface->polarity) << surface->dcode
+      << int(surface->polygons.size());
+    foreach (const PolygonRecord* poly, surface->polygons) {
+      out << poly->xbs << poly->ybs << int(poly->poly_type)
+        << int(poly->operations.size());
+      foreach (const SurfaceOperation* op, poly->operations) {
+        out << int(op->type) << op->x << op->y << op->xe << op->ye << op->xc
+          << op->yc << op->cw;
+      }
+    }
+  }
+
+  out << rec->attrib;
+  return key;
+}
@@ -0,0 +1,63 @@
+/**
+ * @file   featuresdiff.h
+ * @author Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ *
+ * Copyright (C) 2012 - 2014 Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ * All Rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __FEATURESDIFF_H__
+#define __FEATURESDIFF_H__
+
+#include <QByteArray>
+#include <QVector>
+
+class FeaturesDataStore;
+struct Record;
+
+/**
+ * Record-level difference between two parses of the same features file.
+ *
+ * Records are compared by value (type, coordinates, symbol name, polarity,
+ * attributes, ...), so a record that only moved within the file still
+ * matches.  Duplicated records are paired up in file order.
+ */
+class FeaturesDiff {
+public:
+  FeaturesDiff();
+  FeaturesDiff(const FeaturesDataStore* from, const FeaturesDataStore* to);
+
+  /**
+   * For every record of the new store, the index of the identical record
+   * in the old store, or -1 for an added record.
+   */
+  const QVector<int>& sources(void) const { return m_sources; }
+
+  int added(void) const { return m_added; }
+  int removed(void) const { return m_removed; }
+  bool isEmpty(void) const { return m_added == 0 && m_removed == 0; }
+
+  /* Byte string that is equal for records describing the same feature */
+  static QByteArray recordKey(const FeaturesDataStore* ds, const Record* rec);
+
+private:
+  QVector<int> m_sources;
+  int m_added;
+  int m_removed;
+};
+
+#endif /* __FEATURESDIFF_H__ */
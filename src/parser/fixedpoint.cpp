@@ -0,0 +1,83 @@
+/**
+ * @file   fixedpoint.cpp
+ * @author Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ *
+ * Copyright (C) 2012 - 2014 Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ * All Rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "fixedpoint.h"
+
+#include <cmath>
+
+#define DEFAULT_RESOLUTION 1e6
+
+qreal FixedPoint::s_resolution = DEFAULT_RESOLUTION;
+qreal FixedPoint::s_step = 1 / DEFAULT_RESOLUTION;
+
+FixedPoint FixedPoint::fromRaw(qint32 raw)
+{
+  FixedPoint p;
+  p.m_value = raw;
+  return p;
+}
+
+void FixedPoint::setResolution(qreal stepsPerUnit)
+{
+  if (stepsPerUnit > 0) {
+    s_resolution = stepsPerUnit;
+    s_step = 1 / stepsPerUnit;
+  }
+}
+
+/* Saturate rather than wrap, so a stray huge value stays far away */
+static qint32 saturate(qreal steps)
+{
+  if (std::isnan(steps)) {
+    return 0;
+  } else if (steps >= 2147483647.0) {
+    return 2147483647;
+  } else if (steps <= -2147483648.0) {
+    return -2147483647 - 1;
+  }
+  return qint32(steps);
+}
+
+qint32 FixedPoint::toRaw(qreal value)
+{
+  return saturate(std::floor(value * s_resolution + 0.5));
+}
+
+QRectF FixedRect::toRectF(void) const
+{
+  qreal l = FixedPoint::fromRaw(left);
+  qreal t = FixedPoint::fromRaw(top);
+  qreal r = FixedPoint::fromRaw(right);
+  qreal b = FixedPoint::fromRaw(bottom);
+  return QRectF(l, t, r - l, b - t);
+}
+
+FixedRect FixedRect::enclosing(const QRectF& rect)
+{
+  qreal res = FixedPoint::resolution();
+  FixedRect box;
+  box.left = saturate(std::floor(rect.left() * res));
+  box.top = saturate(std::floor(rect.top() * res));
+  box.right = saturate(std::ceil(rect.right() * res));
+  box.bottom = saturate(std::ceil(rect.bottom() * res));
+  return box;
+}
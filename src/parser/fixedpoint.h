@@ -0,0 +1,99 @@
+/**
+ * @file   fixedpoint.h
+ * @author Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ *
+ * Copyright (C) 2012 - 2014 Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ * All Rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __FIXEDPOINT_H__
+#define __FIXEDPOINT_H__
+
+#include <QDataStream>
+#include <QRectF>
+#include <QtGlobal>
+
+/**
+ * 32-bit fixed-point ordinate in the layer's native unit (inch or mm).
+ *
+ * Values are stored as a count of resolution() steps per unit, by default
+ * 10^6 (a micro-inch or a nanometer), which still covers +-2147 units.  It
+ * converts to and from qreal implicitly, so records can use it in place of
+ * a qreal field without touching the code that reads them.  The resolution
+ * is process-wide and must be set before any layer is parsed.
+ */
+class FixedPoint {
+public:
+  FixedPoint(void): m_value(0) {}
+  FixedPoint(qreal value): m_value(toRaw(value)) {}
+
+  operator qreal(void) const { return m_value * s_step; }
+
+  /* Exact integer value in resolution() steps */
+  qint32 raw(void) const { return m_value; }
+  static FixedPoint fromRaw(qint32 raw);
+
+  static void setResolution(qreal stepsPerUnit);
+  static qreal resolution(void) { return s_resolution; }
+
+private:
+  static qint32 toRaw(qreal value);
+
+  qint32 m_value;
+
+  static qreal s_resolution;
+  static qreal s_step;
+};
+
+inline QDataStream& operator<<(QDataStream& out, FixedPoint value)
+{
+  return out << value.raw();
+}
+
+/**
+ * Axis-aligned box in FixedPoint steps, edges included.  Bounding boxes and
+ * index builds compare and unite these with integer arithmetic only.
+ */
+struct FixedRect {
+  qint32 left, top, right, bottom;
+
+  QRectF toRectF(void) const;
+
+  /* Smallest box on the step grid containing rect */
+  static FixedRect enclosing(const QRectF& rect);
+};
+
+/**
+ * Storage type of record coordinates.  Building with QCAMBER_FIXED_COORDS
+ * (qmake CONFIG+=fixed_coords) halves their size; code that only needs a
+ * qreal reads them as before.  Kernels that can work on the stored value
+ * directly use OrdinateValue and ordinateValue(), which are the exact step
+ * count in fixed mode and the qreal itself otherwise.
+ */
+#ifdef QCAMBER_FIXED_COORDS
+typedef FixedPoint Ordinate;
+typedef qint32 OrdinateValue;
+
+inline OrdinateValue ordinateValue(FixedPoint value) { return value.raw(); }
+#else
+typedef qreal Ordinate;
+typedef qreal OrdinateValue;
+
+inline OrdinateValue ordinateValue(qreal value) { return value; }
+#endif
+
+#endif /* __FIXEDPOINT_H__ */
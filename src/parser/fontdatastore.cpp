@@ -22,6 +22,16 @@
 
 #include "fontdatastore.h"
 
+#include <QTransform>
+
+/* Path elements kept in the layout cache, roughly 24 bytes each */
+#define MAX_LAYOUT_ELEMENTS (1024 * 1024)
+
+FontDataStore::FontDataStore(void): m_layouts(MAX_LAYOUT_ELEMENTS)
+{
+
+}
+
 void FontDataStore::putXSize(qreal xsize)
 {
   m_xsize = xsize;
@@ -59,7 +69,75 @@ qreal FontDataStore::ysize(void)
 
 CharRecord* FontDataStore::charRecord(const char tchar)
 {
-  return m_records[tchar];
+  return m_records.value(tchar);
+}
+
+QPainterPath FontDataStore::glyph(const char tchar, qreal width_factor)
+{
+  QPair<char, qreal> key(tchar, width_factor);
+  QHash<QPair<char, qreal>, QPainterPath>::const_iterator it =
+    m_glyphs.find(key);
+  if (it != m_glyphs.end()) {
+    return it.value();
+  }
+
+  CharRecord* rec = charRecord(tchar);
+  QPainterPath path = rec? rec->painterPath(width_factor): QPainterPath();
+  m_glyphs.insert(key, path);
+  return path;
+}
+
+QPainterPath FontDataStore::layout(const QString& text, qreal xsize,
+    qreal ysize, qreal width_factor)
+{
+  TextLayoutKey key = { text, xsize, ysize, width_factor };
+  QPainterPath* cached = m_layouts.object(key);
+  if (cached) {
+    return *cached;
+  }
+
+  QPainterPath path;
+  path.setFillRule(Qt::WindingFill);
+
+  QTransform mat(xsize / m_xsize, 0, 0, ysize / m_ysize, 0, 0);
+  for (int i = 0; i < text.length(); ++i) {
+    QPainterPath g = glyph(text[i].toLatin1(), width_factor);
+    if (!g.isEmpty()) {
+      path.addPath(mat.map(g));
+    }
+    mat.translate(m_xsize + m_offset, 0);
+  }
+
+  QRectF b = path.boundingRect();
+  path.translate(-b.x(), -(b.y() + b.height()));
+
+  m_layouts.insert(key, new QPainterPath(path),
+      qMax(1, path.elementCount()));
+  return path;
+}
+
+QRectF FontDataStore::layoutBounds(const QString& text, qreal xsize,
+    qreal ysize, qreal width_factor)
+{
+  QRectF bounds;
+  QTransform mat(xsize / m_xsize, 0, 0, ysize / m_ysize, 0, 0);
+  for (int i = 0; i < text.length(); ++i) {
+    QPair<char, qreal> key(text[i].toLatin1(), width_factor);
+    QHash<QPair<char, qreal>, QRectF>::const_iterator it =
+      m_glyphBounds.find(key);
+    if (it == m_glyphBounds.end()) {
+      CharRecord* rec = charRecord(key.first);
+      it = m_glyphBounds.insert(key,
+          rec? rec->boundingRect(width_factor): QRectF());
+    }
+    if (!it.value().isNull()) {
+      bounds |= mat.mapRect(it.value());
+    }
+    mat.translate(m_xsize + m_offset, 0);
+  }
+
+  // Same placement as layout()
+  return QRectF(0, -bounds.height(), bounds.width(), bounds.height());
 }
 
 void FontDataStore::dump(void)
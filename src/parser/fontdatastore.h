@@ -23,11 +23,33 @@
 #ifndef __FONT_DATASTORE_H__
 #define __FONT_DATASTORE_H__
 
+#include <QCache>
+#include <QHash>
+#include <QPainterPath>
+
 #include "datastore.h"
 #include "record.h"
 
+struct TextLayoutKey {
+  QString text;
+  qreal xsize, ysize;
+  qreal width_factor;
+
+  bool operator==(const TextLayoutKey& o) const {
+    return text == o.text && xsize == o.xsize && ysize == o.ysize &&
+      width_factor == o.width_factor;
+  }
+};
+
+inline size_t qHash(const TextLayoutKey& key, size_t seed = 0)
+{
+  return qHashMulti(seed, key.text, key.xsize, key.ysize, key.width_factor);
+}
+
 class FontDataStore: public DataStore {
 public:
+  FontDataStore(void);
+
   void putXSize(qreal xsize);
   void putYSize(qreal ysize);
   void putOffset(qreal offset);
@@ -38,12 +60,31 @@ public:
   qreal ysize(void);
   CharRecord* charRecord(const char tchar);
 
+  /* Stroked outline of tchar, built once per width factor */
+  QPainterPath glyph(const char tchar, qreal width_factor);
+
+  /**
+   * Outline of text set in xsize by ysize characters, moved so its bottom
+   * left corner is at the origin.  Identical texts share one path while
+   * it is among the recently used layouts.
+   */
+  QPainterPath layout(const QString& text, qreal xsize, qreal ysize,
+      qreal width_factor);
+
+  /* Bounds of layout(), from the glyph boxes without building the path */
+  QRectF layoutBounds(const QString& text, qreal xsize, qreal ysize,
+      qreal width_factor);
+
   virtual void dump(void);
 
 private:
   qreal m_xsize, m_ysize;
   qreal m_offset;
   QMap<char, CharRecord*> m_records;
+  QHash<QPair<char, qreal>, QPainterPath> m_glyphs;
+  QHash<QPair<char, qreal>, QRectF> m_glyphBounds;
+  /* Least recently used layouts go first, costed by path elements */
+  QCache<TextLayoutKey, QPainterPath> m_layouts;
 };
 
 #endif /* __FONT_DATASTORE_H__ */
@@ -0,0 +1,896 @@
+/**
+ * @file   layerstore.cpp
+ * @author Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ *
+ * Copyright (C) 2012 - 2014 Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ * All Rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "layerstore.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QMutex>
+#include <QSaveFile>
+#include <QTemporaryFile>
+#include <QStandardPaths>
+#include <QVector>
+
+#include <climits>
+#include <cstring>
+
+#include "featuresdatastore.h"
+#include "record.h"
+
+#define STORE_MAGIC "QCLSTORE"
+#define STORE_VERSION 2
+#define NO_STRING 0xffffffffu
+
+namespace {
+
+enum Section {
+  STRINGS = 0,
+  CHARS,
+  SYMBOL_NAMES,
+  ATTRIB_NAMES,
+  ATTRIB_TEXTS,
+  ATTRLIST,
+  RECORDS,
+  ATTRIBS,
+  LINES,
+  PADS,
+  ARCS,
+  TEXTS,
+  BARCODES,
+  SURFACES,
+  POLYGONS,
+  OPERATIONS,
+  ORDER,
+  SECTION_COUNT
+};
+
+enum RecordType {
+  LINE = 0,
+  PAD,
+  ARC,
+  TEXT,
+  BARCODE,
+  SURFACE
+};
+
+struct StoredString {
+  quint32 offset;       /* into CHARS */
+  quint32 length;
+};
+
+struct StoredId {
+  qint32 id;
+  quint32 string;
+};
+
+struct StoredPair {
+  quint32 key;
+  quint32 value;
+};
+
+struct StoredRecord {
+  quint32 type;
+  quint32 index;        /* into the table of its type */
+};
+
+struct StoredAttribs {
+  quint32 first;        /* into ATTRIBS */
+  quint32 count;
+};
+
+struct StoredLine {
+  double xs, ys, xe, ye;
+  qint32 sym_num, polarity, dcode;
+  StoredAttribs attribs;
+};
+
+struct StoredPad {
+  double x, y;
+  qint32 sym_num, polarity, dcode, orient;
+  StoredAttribs attribs;
+};
+
+struct StoredArc {
+  double xs, ys, xe, ye, xc, yc;
+  qint32 sym_num, polarity, dcode, cw;
+  StoredAttribs attribs;
+};
+
+struct StoredText {
+  double x, y, xsize, ysize, width_factor;
+  quint32 font, text;
+  qint32 polarity, orient, version;
+  StoredAttribs attribs;
+};
+
+struct StoredBarcode {
+  double x, y, w, h;
+  quint32 barcode, font, e, text;
+  qint32 polarity, orient, astr_pos;
+  quint8 fasc, cs, bg, astr;
+  StoredAttribs attribs;
+};
+
+struct StoredSurface {
+  qint32 polarity, dcode;
+  quint32 firstPolygon, polygonCount;
+  StoredAttribs attribs;
+};
+
+struct StoredPolygon {
+  double xbs, ybs;
+  qint32 poly_type;
+  quint32 firstOperation, operationCount;
+};
+
+struct StoredOperation {
+  double x, y, xe, ye, xc, yc;
+  qint32 type, cw;
+};
+
+struct StoreHeader {
+  char magic[8];
+  quint32 version;
+  quint32 layout;
+  quint64 size;
+  quint32 stamp;
+  quint32 jobName, stepName, layerName;
+  struct {
+    quint64 offset;
+    quint64 count;
+  } sections[SECTION_COUNT];
+};
+
+/* Element size of every section */
+const size_t sectionSizes[SECTION_COUNT] = {
+  sizeof(StoredString), 2, sizeof(StoredId), sizeof(StoredId),
+  sizeof(StoredId), sizeof(StoredPair), sizeof(StoredRecord),
+  sizeof(StoredPair), sizeof(StoredLine), sizeof(StoredPad),
+  sizeof(StoredArc), sizeof(StoredText), sizeof(StoredBarcode),
+  sizeof(StoredSurface), sizeof(StoredPolygon), sizeof(StoredOperation),
+  sizeof(quint32)
+};
+
+/* Changes whenever a stored structure changes size */
+quint32 layoutId(void)
+{
+  return quint32(sizeof(StoreHeader) ^ (sizeof(StoredLine) << 4) ^
+      (sizeof(StoredPad) << 8) ^ (sizeof(StoredArc) << 12) ^
+      (sizeof(StoredText) << 16) ^ (sizeof(StoredBarcode) << 20) ^
+      (sizeof(StoredSurface) << 24) ^ (sizeof(StoredPolygon) << 26) ^
+      (sizeof(StoredOperation) << 28));
+}
+
+class StoreWriter {
+public:
+  quint32 string(const QString& s)
+  {
+    QHash<QString, quint32>::const_iterator it = m_strings.find(s);
+    if (it != m_strings.end()) {
+      return it.value();
+    }
+    StoredString stored = { quint32(m_chars.size() / 2), quint32(s.size()) };
+    m_chars.append((const char*)s.utf16(), s.size() * 2);
+    quint32 index = m_strings.size();
+    append(STRINGS, stored);
+    m_strings.insert(s, index);
+    return index;
+  }
+
+  StoredAttribs attribs(const AttribData& attrib)
+  {
+    StoredAttribs stored = { quint32(m_counts[ATTRIBS]),
+      quint32(attrib.size()) };
+    for (AttribData::const_iterator it = attrib.begin(); it != attrib.end();
+        ++it) {
+      StoredPair pair = { string(it.key()), string(it.value()) };
+      append(ATTRIBS, pair);
+    }
+    return stored;
+  }
+
+  void ids(Section section, const FeaturesDataStore::IDMapType& map)
+  {
+    for (FeaturesDataStore::IDMapType::const_iterator it = map.begin();
+        it != map.end(); ++it) {
+      StoredId id = { it.key(), string(it.value()) };
+      append(section, id);
+    }
+  }
+
+  template <typename T> quint32 append(Section section, const T& item)
+  {
+    m_sections[section].append((const char*)&item, sizeof(T));
+    return quint32(m_counts[section]++);
+  }
+
+  QByteArray finish(StoreHeader& header)
+  {
+    m_sections[CHARS] = m_chars;
+    m_counts[CHARS] = m_chars.size() / 2;
+
+    quint64 offset = (sizeof(StoreHeader) + 7) & ~quint64(7);
+    for (int i = 0; i < SECTION_COUNT; ++i) {
+      header.sections[i].offset = offset;
+      header.sections[i].count = m_counts[i];
+      offset = (offset + m_sections[i].size() + 7) & ~quint64(7);
+    }
+    header.size = offset;
+
+    QByteArray image(int(offset), '\0');
+    memcpy(image.data(), &header, sizeof(header));
+    for (int i = 0; i < SECTION_COUNT; ++i) {
+      memcpy(image.data() + header.sections[i].offset,
+          m_sections[i].constData(), m_sections[i].size());
+    }
+    return image;
+  }
+
+private:
+  QHash<QString, quint32> m_strings;
+  QByteArray m_chars;
+  QByteArray m_sections[SECTION_COUNT];
+  quint64 m_counts[SECTION_COUNT] = {};
+};
+
+} /* namespace */
+
+LayerStore::LayerStore(const char* data, qint64 size):
+  m_data(data), m_size(size)
+{
+}
+
+template <typename T>
+const T* LayerStore::section(int id, quint32* count) const
+{
+  const StoreHeader* header = (const StoreHeader*)m_data;
+  *count = quint32(header->sections[id].count);
+  return (const T*)(m_data + header->sections[id].offset);
+}
+
+QString LayerStore::string(quint32 index) const
+{
+  quint32 count, chars;
+  const StoredString* strings = section<StoredString>(STRINGS, &count);
+  const ushort* data = section<ushort>(CHARS, &chars);
+  if (index >= count || strings[index].offset > chars ||
+      strings[index].length > chars - strings[index].offset) {
+    return QString();
+  }
+  return QString::fromUtf16((const char16_t*)(data + strings[index].offset),
+      strings[index].length);
+}
+
+bool LayerStore::isValid(const QString& stamp) const
+{
+  if (m_size < qint64(sizeof(StoreHeader))) {
+    return false;
+  }
+
+  const StoreHeader* header = (const StoreHeader*)m_data;
+  if (memcmp(header->magic, STORE_MAGIC, 8) != 0 ||
+      header->version != STORE_VERSION || header->layout != layoutId() ||
+      header->size > quint64(m_size)) {
+    return false;
+  }
+
+  for (int i = 0; i < SECTION_COUNT; ++i) {
+    if (header->sections[i].offset > header->size ||
+        header->sections[i].count > (header->size -
+          header->sections[i].offset) / sectionSizes[i]) {
+      return false;
+    }
+  }
+
+  return string(header->stamp) == stamp && hasValidIndices();
+}
+
+/* Attribute range of a record, in bounds of ATTRIBS */
+static inline bool inRange(const StoredAttribs& attribs, quint32 total)
+{
+  return attribs.first <= total && attribs.count <= total - attribs.first;
+}
+
+bool LayerStore::hasValidIndices(void) const
+{
+  quint32 nAttribs, nLines, nPads, nArcs, nTexts, nBarcodes, nSurfaces;
+  quint32 nPolygons, nOperations, nRecords, nOrder;
+  section<StoredPair>(ATTRIBS, &nAttribs);
+  const StoredLine* lines = section<StoredLine>(LINES, &nLines);
+  const StoredPad* pads = section<StoredPad>(PADS, &nPads);
+  const StoredArc* arcs = section<StoredArc>(ARCS, &nArcs);
+  const StoredText* texts = section<StoredText>(TEXTS, &nTexts);
+  const StoredBarcode* barcodes = section<StoredBarcode>(BARCODES,
+      &nBarcodes);
+  const StoredSurface* surfaces = section<StoredSurface>(SURFACES,
+      &nSurfaces);
+  const StoredPolygon* polygons = section<StoredPolygon>(POLYGONS,
+      &nPolygons);
+  section<StoredOperation>(OPERATIONS, &nOperations);
+  const StoredRecord* records = section<StoredRecord>(RECORDS, &nRecords);
+  const quint32* order = section<quint32>(ORDER, &nOrder);
+
+  for (quint32 i = 0; i < nRecords; ++i) {
+    quint32 k = records[i].index;
+    bool ok;
+    switch (records[i].type) {
+    case LINE: ok = k < nLines && inRange(lines[k].attribs, nAttribs); break;
+    case PAD: ok = k < nPads && inRange(pads[k].attribs, nAttribs); break;
+    case ARC: ok = k < nArcs && inRange(arcs[k].attribs, nAttribs); break;
+    case TEXT: ok = k < nTexts && inRange(texts[k].attribs, nAttribs); break;
+    case BARCODE:
+      ok = k < nBarcodes && inRange(barcodes[k].attribs, nAttribs);
+      break;
+    case SURFACE: {
+      ok = k < nSurfaces && inRange(surfaces[k].attribs, nAttribs);
+      if (!ok) {
+        break;
+      }
+      const StoredSurface& s = surfaces[k];
+      ok = s.firstPolygon <= nPolygons &&
+        s.polygonCount <= nPolygons - s.firstPolygon;
+      for (quint32 p = 0; ok && p < s.polygonCount; ++p) {
+        const StoredPolygon& sp = polygons[s.firstPolygon + p];
+        ok = sp.firstOperation <= nOperations &&
+          sp.operationCount <= nOperations - sp.firstOperation;
+      }
+      break;
+    }
+    default:
+      ok = false;
+      break;
+    }
+    if (!ok) {
+      return false;
+    }
+  }
+
+  // A draw order is a permutation of the records
+  if (nOrder == 0) {
+    return true;
+  }
+  if (nOrder != nRecords) {
+    return false;
+  }
+  QVector<bool> seen(int(nRecords), false);
+  for (quint32 i = 0; i < nOrder; ++i) {
+    if (order[i] >= nRecords || seen[int(order[i])]) {
+      return false;
+    }
+    seen[int(order[i])] = true;
+  }
+  return true;
+}
+
+QByteArray LayerStore::build(const FeaturesDataStore* ds,
+    const QString& stamp)
+{
+  StoreWriter writer;
+  StoreHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, STORE_MAGIC, 8);
+  header.version = STORE_VERSION;
+  header.layout = layoutId();
+  header.stamp = writer.string(stamp);
+  header.jobName = writer.string(ds->jobName());
+  header.stepName = writer.string(ds->stepName());
+  header.layerName = writer.string(ds->layerName());
+
+  writer.ids(SYMBOL_NAMES, ds->symbolNameMap());
+  writer.ids(ATTRIB_NAMES, ds->attribNameMap());
+  writer.ids(ATTRIB_TEXTS, ds->attribTextMap());
+
+  const QMap<QString, QString>& attrlist = ds->attrlistMap();
+  for (QMap<QString, QString>::const_iterator it = attrlist.begin();
+      it != attrlist.end(); ++it) {
+    StoredPair pair = { writer.string(it.key()), writer.string(it.value()) };
+    writer.append(ATTRLIST, pair);
+  }
+
+  int written = 0;
+  foreach (const Record* rec, ds->records()) {
+    StoredRecord stored;
+    if (const LineRecord* r = dynamic_cast<const LineRecord*>(rec)) {
+      StoredLine line = { r->xs, r->ys, r->xe, r->ye, r->sym_num,
+        r->polarity, r->dcode, writer.attribs(r->attrib) };
+      stored.type = LINE;
+      stored.index = writer.append(LINES, line);
+    } else if (const PadRecord* r = dynamic_cast<const PadRecord*>(rec)) {
+      StoredPad pad = { r->x, r->y, r->sym_num, r->polarity, r->dcode,
+        r->orient, writer.attribs(r->attrib) };
+      stored.type = PAD;
+      stored.index = writer.append(PADS, pad);
+    } else if (const ArcRecord* r = dynamic_cast<const ArcRecord*>(rec)) {
+      StoredArc arc = { r->xs, r->ys, r->xe, r->ye, r->xc, r->yc, r->sym_num,
+        r->polarity, r->dcode, r->cw, writer.attribs(r->attrib) };
+      stored.type = ARC;
+      stored.index = writer.append(ARCS, arc);
+    } else if (const BarcodeRecord* r =
+        dynamic_cast<const BarcodeRecord*>(rec)) {
+      StoredBarcode bar = { r->x, r->y, r->w, r->h, writer.string(r->barcode),
+        writer.string(r->font), writer.string(r->e), writer.string(r->text),
+        r->polarity, r->orient, r->astr_pos, r->fasc, r->cs, r->bg, r->astr,
+        writer.attribs(r->attrib) };
+      stored.type = BARCODE;
+      stored.index = writer.append(BARCODES, bar);
+    } else if (const TextRecord* r = dynamic_cast<const TextRecord*>(rec)) {
+      StoredText text = { r->x, r->y, r->xsize, r->ysize, r->width_factor,
+        writer.string(r->font), writer.string(r->text), r->polarity,
+        r->orient, r->version, writer.attribs(r->attrib) };
+      stored.type = TEXT;
+      stored.index = writer.append(TEXTS, text);
+    } else if (const SurfaceRecord* r =
+        dynamic_cast<const SurfaceRecord*>(rec)) {
+      StoredSurface surface = { r->polarity, r->dcode, 0,
+        quint32(r->polygons.size()), writer.attribs(r->attrib) };
+      for (int i = 0; i < r->polygons.size(); ++i) {
+        const PolygonRecord* p = r->polygons[i];
+        StoredPolygon poly = { p->xbs, p->ybs, p->poly_type, 0,
+          quint32(p->operations.size()) };
+        for (int j = 0; j < p->operations.size(); ++j) {
+          const SurfaceOperation* o = p->operations[j];
+          StoredOperation op = { o->x, o->y, o->xe, o->ye, o->xc, o->yc,
+            o->type, o->cw };
+          quint32 index = writer.append(OPERATIONS, op);
+          if (j == 0) {
+            poly.firstOperation = index;
+          }
+        }
+        quint32 index = writer.append(POLYGONS, poly);
+        if (i == 0) {
+          surface.firstPolygon = index;
+        }
+      }
+      stored.type = SURFACE;
+      stored.index = writer.append(SURFACES, surface);
+    } else {
+      continue;
+    }
+    writer.append(RECORDS, stored);
+    ++written;
+  }
+
+  // The draw order only means something if every record made it in
+  const QVector<int> order = ds->drawOrder();
+  bool sorted = true;
+  for (int i = 0; i < order.size() && sorted; ++i) {
+    sorted = (order[i] == i);
+  }
+  if (!sorted && written == order.size()) {
+    for (int i = 0; i < order.size(); ++i) {
+      writer.append(ORDER, quint32(order[i]));
+    }
+  }
+
+  return writer.finish(header);
+}
+
+/**
+ * Every 64-bit word of an image past the header is coded as the zigzagged
+ * difference to the same field of the previous element of its section, in
+ * LEB128 varint form.  Consecutive records are mostly of similar size and
+ * position, so the differences are small.  strides lists, for every word,
+ * how many words back that field is, 0 if there is none.
+ */
+static QVector<quint32> packStrides(const StoreHeader* header)
+{
+  QVector<quint32> strides(int(header->size / 8), 0);
+  for (int i = 0; i < SECTION_COUNT; ++i) {
+    quint64 begin = header->sections[i].offset / 8;
+    quint64 end = (header->sections[i].offset +
+        header->sections[i].count * sectionSizes[i] + 7) / 8;
+    end = qMin(end, quint64(strides.size()));
+    quint32 stride = quint32(qMax(sectionSizes[i] / 8, size_t(1)));
+    for (quint64 w = begin + stride; w < end; ++w) {
+      strides[int(w)] = stride;
+    }
+  }
+  return strides;
+}
+
+QByteArray LayerStore::pack(const QByteArray& image)
+{
+  const StoreHeader* header = (const StoreHeader*)image.constData();
+  const quint64* words = (const quint64*)image.constData();
+  QVector<quint32> strides = packStrides(header);
+  int first = int(header->sections[0].offset / 8);
+
+  QByteArray packed;
+  packed.reserve(image.size() / 2);
+  packed.append(image.constData(), first * 8);
+  for (int i = first; i < strides.size(); ++i) {
+    quint64 delta = words[i] - (strides[i]? words[i - strides[i]]: 0);
+    quint64 zigzag = (delta << 1) ^ (quint64(qint64(delta) >> 63));
+    while (zigzag >= 0x80) {
+      packed.append(char(zigzag | 0x80));
+      zigzag >>= 7;
+    }
+    packed.append(char(zigzag));
+  }
+  return qCompress(packed, 1);
+}
+
+QByteArray LayerStore::unpack(const QByteArray& data)
+{
+  QByteArray packed = qUncompress(data);
+  if (packed.size() < int(sizeof(StoreHeader))) {
+    return QByteArray();
+  }
+
+  const StoreHeader* header = (const StoreHeader*)packed.constData();
+  int first = int(header->sections[0].offset / 8);
+  if (header->size % 8 || header->size > quint64(INT_MAX) ||
+      first * 8 > packed.size() || quint64(first * 8) > header->size) {
+    return QByteArray();
+  }
+  QVector<quint32> strides = packStrides(header);
+
+  QByteArray image(int(header->size), '\0');
+  memcpy(image.data(), packed.constData(), first * 8);
+  quint64* words = (quint64*)image.data();
+  const uchar* in = (const uchar*)packed.constData() + first * 8;
+  const uchar* end = (const uchar*)packed.constData() + packed.size();
+  for (int i = first; i < strides.size(); ++i) {
+    quint64 zigzag = 0;
+    for (int shift = 0; ; shift += 7) {
+      if (in == end || shift > 63) {
+        return QByteArray();
+      }
+      zigzag |= quint64(*in & 0x7f) << shift;
+      if (!(*in++ & 0x80)) {
+        break;
+      }
+    }
+    quint64 delta = (zigzag >> 1) ^ (0 - (zigzag & 1));
+    words[i] = delta + (strides[i]? words[i - strides[i]]: 0);
+  }
+  return image;
+}
+
+FeaturesDataStore* LayerStore::toDataStore(void) const
+{
+  const StoreHeader* header = (const StoreHeader*)m_data;
+  quint32 count;
+
+  FeaturesDataStore* ds = new FeaturesDataStore;
+  ds->setJobName(string(header->jobName));
+  ds->setStepName(string(header->stepName));
+  ds->setLayerName(string(header->layerName));
+
+  const StoredPair* attrlist = section<StoredPair>(ATTRLIST, &count);
+  for (quint32 i = 0; i < count; ++i) {
+    ds->putAttrlistItem(string(attrlist[i].key), string(attrlist[i].value));
+  }
+
+  const StoredId* ids = section<StoredId>(SYMBOL_NAMES, &count);
+  for (quint32 i = 0; i < count; ++i) {
+    ds->putSymbolName(ids[i].id, string(ids[i].string));
+  }
+  ids = section<StoredId>(ATTRIB_NAMES, &count);
+  for (quint32 i = 0; i < count; ++i) {
+    ds->putAttribName(ids[i].id, string(ids[i].string));
+  }
+  ids = section<StoredId>(ATTRIB_TEXTS, &count);
+  for (quint32 i = 0; i < count; ++i) {
+    ds->putAttribText(ids[i].id, string(ids[i].string));
+  }
+
+  quint32 n;
+  const StoredPair* attribs = section<StoredPair>(ATTRIBS, &n);
+  const StoredLine* lines = section<StoredLine>(LINES, &n);
+  const StoredPad* pads = section<StoredPad>(PADS, &n);
+  const StoredArc* arcs = section<StoredArc>(ARCS, &n);
+  const StoredText* texts = section<StoredText>(TEXTS, &n);
+  const StoredBarcode* barcodes = section<StoredBarcode>(BARCODES, &n);
+  const StoredSurface* surfaces = section<StoredSurface>(SURFACES, &n);
+  const StoredPolygon* polygons = section<StoredPolygon>(POLYGONS, &n);
+  const StoredOperation* operations = section<StoredOperation>(OPERATIONS,
+      &n);
+
+  // Records are created with an empty parameter list, which leaves their
+  // fields for us to fill in
+  const QStringList none;
+  const StoredRecord* records = section<StoredRecord>(RECORDS, &count);
+  for (quint32 i = 0; i < count; ++i) {
+    quint32 k = records[i].index;
+    const StoredAttribs* stored = NULL;
+    switch (records[i].type) {
+    case LINE: stored = &lines[k].attribs; break;
+    case PAD: stored = &pads[k].attribs; break;
+    case ARC: stored = &arcs[k].attribs; break;
+    case TEXT: stored = &texts[k].attribs; break;
+    case BARCODE: stored = &barcodes[k].attribs; break;
+    case SURFACE: stored = &surfaces[k].attribs; break;
+    default: continue;
+    }
+
+    AttribData attrib;
+    for (quint32 j = 0; j < stored->count; ++j) {
+      const StoredPair& pair = attribs[stored->first + j];
+      attrib.insert(string(pair.key), string(pair.value));
+    }
+
+    switch (records[i].type) {
+    case LINE: {
+      const StoredLine& s = lines[k];
+      LineRecord* r = new (ds->arena()) LineRecord(ds, none, attrib);
+      r->xs = s.xs; r->ys = s.ys; r->xe = s.xe; r->ye = s.ye;
+      r->sym_num = s.sym_num;
+      r->polarity = (Polarity)s.polarity;
+      r->dcode = s.dcode;
+      ds->putLine(r);
+      break;
+    }
+    case PAD: {
+      const StoredPad& s = pads[k];
+      PadRecord* r = new (ds->arena()) PadRecord(ds, none, attrib);
+      r->x = s.x; r->y = s.y;
+      r->sym_num = s.sym_num;
+      r->polarity = (Polarity)s.polarity;
+      r->dcode = s.dcode;
+      r->orient = (Orient)s.orient;
+      r->sym_name = ds->symbolNameMap()[r->sym_num];
+      ds->putPad(r);
+      break;
+    }
+    case ARC: {
+      const StoredArc& s = arcs[k];
+      ArcRecord* r = new (ds->arena()) ArcRecord(ds, none, attrib);
+      r->xs = s.xs; r->ys = s.ys; r->xe = s.xe; r->ye = s.ye;
+      r->xc = s.xc; r->yc = s.yc;
+      r->sym_num = s.sym_num;
+      r->polarity = (Polarity)s.polarity;
+      r->dcode = s.dcode;
+      r->cw = s.cw;
+      ds->putArc(r);
+      break;
+    }
+    case TEXT: {
+      const StoredText& s = texts[k];
+      TextRecord* r = new (ds->arena()) TextRecord(ds, none, attrib);
+      r->x = s.x; r->y = s.y;
+      r->font = string(s.font);
+      r->polarity = (Polarity)s.polarity;
+      r->orient = (Orient)s.orient;
+      r->xsize = s.xsize; r->ysize = s.ysize;
+      r->width_factor = s.width_factor;
+      r->text = string(s.text);
+      r->version = s.version;
+      ds->putText(r);
+      break;
+    }
+    case BARCODE: {
+      const StoredBarcode& s = barcodes[k];
+      BarcodeRecord* r = new (ds->arena()) BarcodeRecord(ds, none, attrib);
+      r->x = s.x; r->y = s.y;
+      r->barcode = string(s.barcode);
+      r->font = string(s.font);
+      r->polarity = (Polarity)s.polarity;
+      r->orient = (Orient)s.orient;
+      r->e = string(s.e);
+      r->w = s.w; r->h = s.h;
+      r->fasc = s.fasc; r->cs = s.cs; r->bg = s.bg; r->astr = s.astr;
+      r->astr_pos = (BarcodeRecord::AstrPos)s.astr_pos;
+      r->text = string(s.text);
+      ds->putBarcode(r);
+      break;
+    }
+    case SURFACE: {
+      const StoredSurface& s = surfaces[k];
+      SurfaceRecord* r = new (ds->arena()) SurfaceRecord(ds, none, attrib);
+      r->polarity = (Polarity)s.polarity;
+      r->dcode = s.dcode;
+      for (quint32 p = 0; p < s.polygonCount; ++p) {
+        const StoredPolygon& sp = polygons[s.firstPolygon + p];
+        PolygonRecord* poly = new (ds->arena()) PolygonRecord(none);
+        poly->xbs = sp.xbs; poly->ybs = sp.ybs;
+        poly->poly_type = (PolygonRecord::PolyType)sp.poly_type;
+        for (quint32 o = 0; o < sp.operationCount; ++o) {
+          const StoredOperation& so = operations[sp.firstOperation + o];
+          SurfaceOperation* op = new (ds->arena()) SurfaceOperation;
+          op->type = (SurfaceOperation::OpType)so.type;
+          op->x = so.x; op->y = so.y;
+          op->xe = so.xe; op->ye = so.ye;
+          op->xc = so.xc; op->yc = so.yc;
+          op->cw = so.cw;
+          poly->operations.append(op);
+        }
+        r->polygons.append(poly);
+      }
+      r->currentRecord = NULL;
+      ds->putSurfaceRecord(r);
+      break;
+    }
+    }
+  }
+
+  const quint32* order = section<quint32>(ORDER, &count);
+  if (count > 0) {
+    ds->relocate(QVector<int>(order, order + count));
+  }
+
+  return ds;
+}
+
+/* Store configuration */
+static QMutex storeMutex;
+static LayerStore::Mode storeMode = LayerStore::Off;
+static QString storeDir;
+
+/* Layers taken out of memory: packed images or spilled scratch files */
+struct ColdLayer {
+  QByteArray packed;
+  QTemporaryFile* spill;
+};
+static QHash<QString, ColdLayer> coldLayers;
+static qint64 coldSize = 0;
+
+void LayerStore::setMode(Mode mode, const QString& dir)
+{
+  QMutexLocker locker(&storeMutex);
+  storeMode = mode;
+  storeDir = dir;
+  if (storeDir.isEmpty()) {
+    storeDir = QStandardPaths::writableLocation(
+        QStandardPaths::CacheLocation) + "/layerstore";
+  }
+  if (mode == CacheFile) {
+    QDir().mkpath(storeDir);
+  }
+}
+
+LayerStore::Mode LayerStore::mode(void)
+{
+  QMutexLocker locker(&storeMutex);
+  return storeMode;
+}
+
+static QString sourceStamp(const QString& fileName)
+{
+  QFileInfo info(fileName);
+  if (!info.isFile()) {
+    return QString();
+  }
+  return QString("%1:%2:%3").arg(info.absoluteFilePath()).arg(info.size())
+    .arg(info.lastModified().toMSecsSinceEpoch());
+}
+
+static QString storeKey(const QString& fileName)
+{
+  QByteArray path = QFileInfo(fileName).absoluteFilePath().toUtf8();
+  return QString::fromLatin1(QCryptographicHash::hash(path,
+        QCryptographicHash::Sha1).toHex());
+}
+
+static QString cacheFileName(const QString& fileName)
+{
+  QMutexLocker locker(&storeMutex);
+  return storeDir + "/" + storeKey(fileName) + ".qls";
+}
+
+/* Take the demoted copy of fileName back, if there is a current one */
+static FeaturesDataStore* restore(const QString& fileName,
+    const QString& stamp)
+{
+  QMutexLocker locker(&storeMutex);
+  if (!coldLayers.contains(fileName)) {
+    return NULL;
+  }
+  ColdLayer cold = coldLayers.take(fileName);
+  coldSize -= cold.packed.size();
+  locker.unlock();
+
+  FeaturesDataStore* ds = NULL;
+  if (cold.spill) {
+    uchar* data = cold.spill->map(0, cold.spill->size());
+    if (data) {
+      LayerStore store((const char*)data, cold.spill->size());
+      ds = store.isValid(stamp)? store.toDataStore(): NULL;
+      cold.spill->unmap(data);
+    }
+    delete cold.spill;
+  } else {
+    QByteArray image = LayerStore::unpack(cold.packed);
+    LayerStore store(image.constData(), image.size());
+    ds = store.isValid(stamp)? store.toDataStore(): NULL;
+  }
+  return ds;
+}
+
+void LayerStore::demote(const QString& fileName, const FeaturesDataStore* ds,
+    bool spill)
+{
+  QByteArray image = build(ds, sourceStamp(fileName));
+  ColdLayer cold = { QByteArray(), NULL };
+  if (spill) {
+    cold.spill = new QTemporaryFile(QDir::tempPath() +
+        "/qcamber-spill-XXXXXX.qls");
+    if (!cold.spill->open() || cold.spill->write(image) != image.size() ||
+        !cold.spill->flush()) {
+      delete cold.spill;
+      cold.spill = NULL;
+    }
+  }
+  if (!cold.spill) {
+    cold.packed = pack(image);
+  }
+
+  QMutexLocker locker(&storeMutex);
+  ColdLayer old = coldLayers.take(fileName);
+  coldSize -= old.packed.size();
+  delete old.spill;
+  coldLayers.insert(fileName, cold);
+  coldSize += cold.packed.size();
+}
+
+qint64 LayerStore::demotedSize(void)
+{
+  QMutexLocker locker(&storeMutex);
+  return coldSize;
+}
+
+FeaturesDataStore* LayerStore::load(const QString& fileName)
+{
+  Mode mode = LayerStore::mode();
+  QString stamp = sourceStamp(fileName);
+  FeaturesDataStore* cold = restore(fileName, stamp);
+  if (cold) {
+    return cold;
+  }
+  if (mode == Off || stamp.isEmpty()) {
+    return NULL;
+  }
+
+  QFile file(cacheFileName(fileName));
+  if (!file.open(QIODevice::ReadOnly)) {
+    return NULL;
+  }
+  const uchar* data = file.map(0, file.size());
+  if (!data) {
+    return NULL;
+  }
+  LayerStore store((const char*)data, file.size());
+  FeaturesDataStore* ds = store.isValid(stamp)? store.toDataStore(): NULL;
+  file.unmap((uchar*)data);
+  return ds;
+}
+
+void LayerStore::save(const QString& fileName, const FeaturesDataStore* ds)
+{
+  Mode mode = LayerStore::mode();
+  QString stamp = sourceStamp(fileName);
+  if (mode == Off || stamp.isEmpty() || !ds) {
+    return;
+  }
+
+  QByteArray image = build(ds, stamp);
+
+  QSaveFile file(cacheFileName(fileName));
+  if (file.open(QIODevice::WriteOnly)) {
+    file.write(image);
+    file.commit();
+  }
+}
@@ -0,0 +1,100 @@
+/**
+ * @file   layerstore.h
+ * @author Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ *
+ * Copyright (C) 2012 - 2014 Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ * All Rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __LAYERSTORE_H__
+#define __LAYERSTORE_H__
+
+#include <QByteArray>
+#include <QString>
+
+class FeaturesDataStore;
+
+/**
+ * Immutable binary image of a parsed features file.
+ *
+ * The image is a header followed by flat arrays (records in file order,
+ * one table per record type, polygons, surface operations, attributes and
+ * a deduplicated string table, plus the draw order when it is not file
+ * order).  Everything refers to everything else by array index, never by
+ * pointer, so an image can be read in place at any address, e.g. from a
+ * mapped cache file.  It serves as an on-disk parse cache; a second viewer
+ * on the same job, or this one later on, builds its data store from the
+ * image instead of tokenizing the file again.  Every process still builds
+ * its own records, so the cache saves parsing time, not memory.
+ *
+ * Images are only valid for the build that wrote them; the header carries
+ * the record layout and the size and time stamp of the source file.
+ */
+class LayerStore {
+public:
+  typedef enum { Off = 0, CacheFile } Mode;
+
+  /* View of an image at data; the memory must outlive the view */
+  LayerStore(const char* data, qint64 size);
+
+  /**
+   * True if the image is complete, was written for source stamp and every
+   * index in it is in bounds
+   */
+  bool isValid(const QString& stamp) const;
+  FeaturesDataStore* toDataStore(void) const;
+
+  static QByteArray build(const FeaturesDataStore* ds, const QString& stamp);
+
+  /**
+   * Where parsed layers are cached; Off (the default) disables the store.
+   * dir is the cache file directory for CacheFile.
+   */
+  static void setMode(Mode mode, const QString& dir = QString());
+  static Mode mode(void);
+
+  /**
+   * Data store for fileName from a demoted copy or the cache file, NULL
+   * on a miss
+   */
+  static FeaturesDataStore* load(const QString& fileName);
+  static void save(const QString& fileName, const FeaturesDataStore* ds);
+
+  /**
+   * Keep a layer that is no longer resident in compact form, either packed
+   * in memory or spilled to a scratch file that load() maps back in.  This
+   * works whatever the mode; the copy is dropped when it is loaded again.
+   */
+  static void demote(const QString& fileName, const FeaturesDataStore* ds,
+      bool spill);
+  /* Memory held by packed demoted layers, in bytes */
+  static qint64 demotedSize(void);
+
+  /* Delta and varint coding of an image, then deflated */
+  static QByteArray pack(const QByteArray& image);
+  static QByteArray unpack(const QByteArray& packed);
+
+private:
+  template <typename T> const T* section(int id, quint32* count) const;
+  bool hasValidIndices(void) const;
+  QString string(quint32 index) const;
+
+  const char* m_data;
+  qint64 m_size;
+};
+
+#endif /* __LAYERSTORE_H__ */
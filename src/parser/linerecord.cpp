@@ -31,6 +31,10 @@ LineRecord::LineRecord(FeaturesDataStore* ds, const QStringList& param,
     const AttribData& attr):
   Record(ds, attr)
 {
+  if (param.empty()) {
+    return;
+  }
+
   int i = 0;
   xs = param[++i].toDouble();
   ys = param[++i].toDouble();
@@ -23,6 +23,8 @@
 #ifndef __CACHED_PARSER_H__
 #define __CACHED_PARSER_H__
 
+#include <QHash>
+#include <QList>
 #include <QMap>
 #include <QString>
 
@@ -38,12 +40,38 @@ public:
   virtual ~CachedParser();
   static D* parse(QString filename);
 
+  /* The cached result for filename, NULL if it has not been parsed */
+  static D* cached(QString filename);
+
+  /**
+   * Serve ds for filename from now on; NULL makes the next parse() read
+   * the file again.  The previous result is deleted right away when it is
+   * not acquired, otherwise once its last user releases it.
+   */
+  static void replace(QString filename, D* ds);
+
+  /* Users of a result keep it alive across replace() while acquired */
+  static void acquire(D* ds);
+  static void release(D* ds);
+
+  /**
+   * Drop filename from the cache and hand its result to the caller, who
+   * deletes it once nothing uses it; the next parse() reads it again.
+   */
+  static D* evict(QString filename);
+
+  /* Name ds is cached under, empty if it is not */
+  static QString fileName(D* ds);
+
 private:
+  static CachedParser<P, D>* instance(void);
   D* realParse(QString filename);
 
 private:
   static CachedParser<P, D>* m_instance;
   QMap<QString, D*> m_cache;
+  QList<D*> m_retired;
+  QHash<D*, int> m_refs;
 };
 
 template <typename P, typename D>
@@ -56,17 +84,85 @@ CachedParser<P, D>::~CachedParser<P, D>()
       it != m_cache.end(); ++it) {
     delete it.value();
   }
+  for (int i = 0; i < m_retired.size(); ++i) {
+    delete m_retired[i];
+  }
   m_instance = NULL;
 }
 
 template <typename P, typename D>
-D* CachedParser<P, D>::parse(QString filename)
+CachedParser<P, D>* CachedParser<P, D>::instance(void)
 {
   if (!m_instance) {
     m_instance = new CachedParser<P, D>;
   }
+  return m_instance;
+}
 
-  return m_instance->realParse(filename);
+template <typename P, typename D>
+D* CachedParser<P, D>::parse(QString filename)
+{
+  return instance()->realParse(filename);
+}
+
+template <typename P, typename D>
+D* CachedParser<P, D>::cached(QString filename)
+{
+  return instance()->m_cache.value(filename, NULL);
+}
+
+template <typename P, typename D>
+void CachedParser<P, D>::replace(QString filename, D* ds)
+{
+  CachedParser<P, D>* self = instance();
+  D* old = self->m_cache.take(filename);
+  if (ds) {
+    self->m_cache[filename] = ds;
+  }
+  if (old && old != ds) {
+    if (self->m_refs.value(old, 0) > 0) {
+      self->m_retired.append(old);
+    } else {
+      delete old;
+    }
+  }
+}
+
+template <typename P, typename D>
+void CachedParser<P, D>::acquire(D* ds)
+{
+  if (ds) {
+    ++instance()->m_refs[ds];
+  }
+}
+
+template <typename P, typename D>
+void CachedParser<P, D>::release(D* ds)
+{
+  CachedParser<P, D>* self = instance();
+  typename QHash<D*, int>::iterator it = self->m_refs.find(ds);
+  if (it == self->m_refs.end()) {
+    return;
+  }
+  if (--it.value() > 0) {
+    return;
+  }
+  self->m_refs.erase(it);
+  if (self->m_retired.removeOne(ds)) {
+    delete ds;
+  }
+}
+
+template <typename P, typename D>
+D* CachedParser<P, D>::evict(QString filename)
+{
+  return instance()->m_cache.take(filename);
+}
+
+template <typename P, typename D>
+QString CachedParser<P, D>::fileName(D* ds)
+{
+  return instance()->m_cache.key(ds);
 }
 
 template <typename P, typename D>
@@ -28,6 +28,9 @@
 #include <QtCore>
 #include <QtDebug>
 
+#include "compresseddevice.h"
+#include "layerstore.h"
+#include "spatialorder.h"
 #include "structuredtextparser.h"
 #include "record.h"
 
@@ -40,9 +43,25 @@ FeaturesParser::~FeaturesParser()
 {
 }
 
+/* Lay the records out along the configured space-filling curve */
+static FeaturesDataStore* spatiallyOrdered(FeaturesDataStore* ds)
+{
+  SpatialOrder::Curve curve = SpatialOrder::curve();
+  if (curve != SpatialOrder::Off) {
+    ds->relocate(SpatialOrder::permutation(ds->records(), curve));
+  }
+  return ds;
+}
+
 FeaturesDataStore* FeaturesParser::parse(void)
 {
-  QFile file(m_fileName);
+  // Another viewer may already have parsed this layer
+  FeaturesDataStore* shared = LayerStore::load(m_fileName);
+  if (shared) {
+    return spatiallyOrdered(shared);
+  }
+
+  CompressedDevice file(m_fileName);
   if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
     qDebug("parse: can't open `%s' for reading", qPrintable(m_fileName));
     return NULL;
@@ -52,7 +71,8 @@ FeaturesDataStore* FeaturesParser::parse(void)
   m_ds = ds;
 
   // layer feature related
-  QRegularExpression rx("^.*/([^/]+)/steps/([^/]+)/layers/([^/]+)/features$");
+  QRegularExpression rx("^.*/([^/]+)/steps/([^/]+)/layers/([^/]+)/"
+      "features(\\.[zZ])?$");
   QRegularExpressionMatch m = rx.match(m_fileName);
   if (m.hasMatch()) {
     QStringList caps = m.capturedTexts();
@@ -118,7 +138,9 @@ FeaturesDataStore* FeaturesParser::parse(void)
       surface = true;
     }
   }
-  return ds;
+
+  LayerStore::save(m_fileName, ds);
+  return spatiallyOrdered(ds);
 }
 
 void FeaturesParser::putAttrlist(const StructuredTextDataStore* ds)
@@ -166,7 +188,7 @@ void FeaturesParser::parseLine(const QString& line)
   AttribData attrib;
   parseAttributes(line, &param, &attrib);
 
-  LineRecord* rec = new LineRecord(m_ds, param, attrib);
+  LineRecord* rec = new (m_ds->arena()) LineRecord(m_ds, param, attrib);
   m_ds->putLine(rec);
 }
 
@@ -176,7 +198,7 @@ void FeaturesParser::parsePad(const QString& line)
   AttribData attrib;
   parseAttributes(line, &param, &attrib);
 
-  PadRecord* rec = new PadRecord(m_ds, param, attrib);
+  PadRecord* rec = new (m_ds->arena()) PadRecord(m_ds, param, attrib);
   m_ds->putPad(rec);
 }
 
@@ -186,7 +208,7 @@ void FeaturesParser::parseArc(const QString& line)
   AttribData attrib;
   parseAttributes(line, &param, &attrib);
 
-  ArcRecord* rec = new ArcRecord(m_ds, param, attrib);
+  ArcRecord* rec = new (m_ds->arena()) ArcRecord(m_ds, param, attrib);
   m_ds->putArc(rec);
 }
 
@@ -196,7 +218,7 @@ void FeaturesParser::parseText(const QString& line)
   AttribData attrib;
   parseAttributes(line, &param, &attrib);
 
-  TextRecord* rec = new TextRecord(m_ds, param, attrib);
+  TextRecord* rec = new (m_ds->arena()) TextRecord(m_ds, param, attrib);
   m_ds->putText(rec);
 }
 
@@ -206,7 +228,7 @@ void FeaturesParser::parseBarcode(const QString& line)
   AttribData attrib;
   parseAttributes(line, &param, &attrib);
 
-  BarcodeRecord* rec = new BarcodeRecord(m_ds, param, attrib);
+  BarcodeRecord* rec = new (m_ds->arena()) BarcodeRecord(m_ds, param, attrib);
   m_ds->putBarcode(rec);
 }
 
@@ -216,7 +238,7 @@ void FeaturesParser::parseSurfaceStart(const QString& line)
   AttribData attrib;
   parseAttributes(line, &param, &attrib);
 
-  SurfaceRecord* rec = new SurfaceRecord(m_ds, param, attrib);
+  SurfaceRecord* rec = new (m_ds->arena()) SurfaceRecord(m_ds, param, attrib);
   m_currentSurface = rec;
   m_ds->putSurfaceRecord(rec);
 }
@@ -228,18 +250,18 @@ void FeaturesParser::parseSurfaceLineData(const QString& line)
   parseAttributes(line, &param, &attrib);
 
   if (line.startsWith("OB")) {
-    PolygonRecord* rec = new PolygonRecord(param);
+    PolygonRecord* rec = new (m_ds->arena()) PolygonRecord(param);
     m_currentSurface->polygons.append(rec);
     m_currentSurface->currentRecord = rec;
   } else if (line.startsWith("OS")) {
-    SurfaceOperation* op = new SurfaceOperation;
+    SurfaceOperation* op = new (m_ds->arena()) SurfaceOperation;
     int i = 0;
     op->type = SurfaceOperation::SEGMENT;
     op->x = param[++i].toDouble();
     op->y = param[++i].toDouble();
     m_currentSurface->currentRecord->operations.append(op);
   } else if (line.startsWith("OC")) {
-    SurfaceOperation* op = new SurfaceOperation;
+    SurfaceOperation* op = new (m_ds->arena()) SurfaceOperation;
     int i = 0;
     op->type = SurfaceOperation::CURVE;
     op->xe = param[++i].toDouble();
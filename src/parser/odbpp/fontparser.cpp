@@ -23,7 +23,8 @@
 #include "fontparser.h"
 
 #include <QDebug>
-#include <QFile>
+
+#include "compresseddevice.h"
 
 FontParser::FontParser(const QString& filename): Parser(filename)
 {
@@ -36,7 +37,7 @@ FontParser::~FontParser()
 FontDataStore* FontParser::parse(void)
 {
   FontDataStore* ds = new FontDataStore;
-  QFile file(m_fileName);
+  CompressedDevice file(m_fileName);
 
   if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
     qDebug("parse: can't open `%s' for reading", qPrintable(m_fileName));
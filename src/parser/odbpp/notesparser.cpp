@@ -24,6 +24,8 @@
 
 #include <QtCore>
 
+#include "compresseddevice.h"
+
 NotesParser::NotesParser(const QString& filename): Parser(filename)
 {
 }
@@ -34,7 +36,7 @@ NotesParser::~NotesParser()
 
 NotesDataStore* NotesParser::parse(void)
 {
-  QFile file(m_fileName);
+  CompressedDevice file(m_fileName);
   if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
     qDebug("parse: can't open `%s' for reading", qPrintable(m_fileName));
     return NULL;
@@ -23,21 +23,29 @@
 #include "structuredtextparser.h"
 
 #include <QDebug>
+#include <QMutex>
 #include <QSysInfo>
 
+#include "compresseddevice.h"
 #include "yyheader.h"
 #include "db.tab.h"
 
 extern struct yycontext yyctx;
 extern int yyparse (void);
-extern FILE* yyin;
+
+/* The scanner and yyctx are global; layers may be re-parsed off the GUI
+ * thread, so only one structured text file is parsed at a time */
+static QMutex yyMutex;
+
+int yyread(char* buf, int max_size)
+{
+  qint64 n = yyctx.input? yyctx.input->read(buf, max_size): 0;
+  return n > 0? int(n): 0;
+}
 
 StructuredTextParser::StructuredTextParser(const QString& filename):
   Parser(filename)
 {
-#ifdef Q_OS_WIN
-  m_fileName.replace("/", "\\");
-#endif
 }
 
 StructuredTextParser::~StructuredTextParser()
@@ -46,21 +54,19 @@ StructuredTextParser::~StructuredTextParser()
 
 StructuredTextDataStore* StructuredTextParser::parse(void)
 {
-#ifdef Q_OS_WIN
-  // Use wide-char fopen on Windows to support Unicode file paths
-  std::wstring wpath = m_fileName.toStdWString();
-  yyin = _wfopen(wpath.c_str(), L"r");
-#else
-  yyin = fopen(m_fileName.toLocal8Bit().constData(), "r");
-#endif
-
-  if (yyin == NULL) {
+  // QFile handles Unicode paths on every platform, and the device decodes
+  // compressed files while the scanner consumes them
+  CompressedDevice file(m_fileName);
+  if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
     qDebug("parse: can't open `%s' for reading", qPrintable(m_fileName));
     return NULL;
   }
 
+  QMutexLocker locker(&yyMutex);
+  yyctx.input = &file;
   yyctx.stds = new StructuredTextDataStore;
   yyparse();
+  yyctx.input = NULL;
 
   return yyctx.stds;
 }
@@ -39,8 +39,14 @@
 
 #include "structuredtextparser.h"
 
+class QIODevice;
+
 struct yycontext {
 	StructuredTextDataStore* stds;
+	QIODevice* input;
 };
 
+/* Feed the scanner from yyctx.input instead of yyin */
+int yyread(char* buf, int max_size);
+
 #endif /* __YY_HEADER_H__ */
\ No newline at end of file
@@ -29,12 +29,17 @@
 #include <QTransform>
 
 #include "featuresdatastore.h"
-#include "symbolfactory.h"
+#include "padsymbol.h"
+#include "symbolpool.h"
 
 PadRecord::PadRecord(FeaturesDataStore* ds, const QStringList& param,
     const AttribData& attr):
   Record(ds, attr)
 {
+  if (param.empty()) {
+    return;
+  }
+
   int i = 0;
   x = param[++i].toDouble();
   y = param[++i].toDouble();
@@ -47,7 +52,9 @@ PadRecord::PadRecord(FeaturesDataStore* ds, const QStringList& param,
 
 Symbol* PadRecord::createSymbol(void) const
 {
-  Symbol* symbol = SymbolFactory::create(sym_name, polarity, attrib);
+  // Pads share the geometry of their symbol with all other pads using it
+  Symbol* symbol = new PadSymbol(SYMBOLPOOL->geometry(sym_name), sym_name,
+      polarity, attrib);
   symbol->setPos(x, -y);
 
   if (orient >= M_0) {
@@ -1,17 +1,27 @@
 include (odbpp/odbpp.pri)
 
+# Store record coordinates as 32-bit fixed point, see fixedpoint.h:
+#   qmake CONFIG+=fixed_coords
+fixed_coords: DEFINES += QCAMBER_FIXED_COORDS
+
 HEADERS += \
   parser/parser.h \
   parser/record.h \
+  parser/recordarena.h \
   parser/code39.h \
   parser/featuresdatastore.h \
+  parser/featuresdiff.h \
+  parser/fixedpoint.h \
   parser/fontdatastore.h \
+  parser/layerstore.h \
   parser/datastore.h \
   parser/notesdatastore.h \
+  parser/spatialorder.h \
   parser/structuredtextdatastore.h
 
 SOURCES += \
   parser/parser.cpp \
+  parser/recordarena.cpp \
   parser/surfacerecord.cpp \
   parser/textrecord.cpp \
   parser/padrecord.cpp \
@@ -22,6 +32,10 @@ SOURCES += \
   parser/noterecord.cpp \
   parser/code39.cpp \
   parser/featuresdatastore.cpp \
+  parser/featuresdiff.cpp \
+  parser/fixedpoint.cpp \
   parser/fontdatastore.cpp \
+  parser/layerstore.cpp \
   parser/notesdatastore.cpp \
+  parser/spatialorder.cpp \
   parser/structuredtextdatastore.cpp
@@ -29,6 +29,8 @@
 #include <QString>
 #include <QStringList>
 
+#include "fixedpoint.h"
+#include "recordarena.h"
 #include "symbol.h"
 
 class Features;
@@ -47,24 +49,24 @@ struct Record {
 };
 
 
-struct LineRecord: public Record {
+struct LineRecord: public Record, public ArenaObject {
   LineRecord(FeaturesDataStore* ds, const QStringList& param,
       const AttribData& attr);
   virtual Symbol* createSymbol(void) const;
 
-  qreal xs, ys;
-  qreal xe, ye;
+  Ordinate xs, ys;
+  Ordinate xe, ye;
   int sym_num;
   Polarity polarity;
   int dcode;
 };
 
-struct PadRecord: public Record {
+struct PadRecord: public Record, public ArenaObject {
   PadRecord(FeaturesDataStore* ds, const QStringList& param,
       const AttribData& attr);
   virtual Symbol* createSymbol(void) const;
 
-  qreal x, y;
+  Ordinate x, y;
   int sym_num;
   Polarity polarity;
   int dcode;
@@ -72,21 +74,21 @@ struct PadRecord: public Record {
   QString sym_name;
 };
 
-struct ArcRecord: public Record {
+struct ArcRecord: public Record, public ArenaObject {
   ArcRecord(FeaturesDataStore* ds, const QStringList& param,
       const AttribData& attr);
   virtual Symbol* createSymbol(void) const;
 
-  qreal xs, ys;
-  qreal xe, ye;
-  qreal xc, yc;
+  Ordinate xs, ys;
+  Ordinate xe, ye;
+  Ordinate xc, yc;
   int sym_num;
   Polarity polarity;
   int dcode;
   bool cw;
 };
 
-struct TextRecord: public Record {
+struct TextRecord: public Record, public ArenaObject {
   TextRecord(FeaturesDataStore* ds, const QStringList& param,
       const AttribData& attr);
   virtual Symbol* createSymbol(void) const;
@@ -94,7 +96,7 @@ struct TextRecord: public Record {
   void setTransform(Symbol* symbol) const;
   virtual QString dynamicText(QString);
 
-  qreal x, y;
+  Ordinate x, y;
   QString font;
   Polarity polarity;
   Orient orient;
@@ -121,29 +123,31 @@ struct BarcodeRecord: public TextRecord {
   AstrPos astr_pos;
 };
 
-struct SurfaceOperation {
+struct SurfaceOperation: public ArenaObject {
   typedef enum { SEGMENT = 0, CURVE } OpType;
 
   OpType type;
-  qreal x, y;
-  qreal xe, ye;
-  qreal xc, yc;
+  Ordinate x, y;
+  Ordinate xe, ye;
+  Ordinate xc, yc;
   bool cw;
 };
 
-struct PolygonRecord {
+struct PolygonRecord: public ArenaObject {
   typedef enum { I = 0, H } PolyType;
 
   PolygonRecord(const QStringList& param);
   virtual ~PolygonRecord();
   virtual QPainterPath painterPath(void);
+  /* Bounds of painterPath(), from the contour without building it */
+  QRectF boundingRect(void) const;
 
-  qreal xbs, ybs;
+  Ordinate xbs, ybs;
   PolyType poly_type;
   QList<SurfaceOperation*> operations;
 };
 
-struct SurfaceRecord: public Record {
+struct SurfaceRecord: public Record, public ArenaObject {
   SurfaceRecord(FeaturesDataStore* ds, const QStringList& param,
       const AttribData& attr);
   virtual ~SurfaceRecord();
@@ -160,6 +164,7 @@ struct CharLineRecord {
 
   CharLineRecord(const QStringList& param);
   QPainterPath painterPath(qreal width_factor);
+  QRectF boundingRect(qreal width_factor) const;
 
   qreal xs, ys;
   qreal xe, ye;
@@ -173,6 +178,7 @@ struct CharRecord {
   virtual ~CharRecord();
 
   QPainterPath painterPath(qreal width_factor);
+  QRectF boundingRect(qreal width_factor) const;
 
   FontDataStore* ds;
   char tchar;
@@ -0,0 +1,92 @@
+/**
+ * @file   recordarena.cpp
+ * @author Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ *
+ * Copyright (C) 2012 - 2014 Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ * All Rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "recordarena.h"
+
+#include <cstdlib>
+#include <new>
+#include <utility>
+
+#define FIRST_BLOCK_SIZE (16 * 1024)
+#define MAX_BLOCK_SIZE (1024 * 1024)
+#define ALIGNMENT alignof(std::max_align_t)
+
+struct RecordArena::Block {
+  Block* next;
+};
+
+/* Keeps the first byte handed out from a block suitably aligned */
+static const size_t HEADER_SIZE =
+  (sizeof(void*) + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+
+RecordArena::RecordArena():
+  m_block(NULL), m_next(NULL), m_end(NULL), m_blockSize(FIRST_BLOCK_SIZE),
+  m_capacity(0)
+{
+}
+
+RecordArena::~RecordArena()
+{
+  while (m_block) {
+    Block* next = m_block->next;
+    free(m_block);
+    m_block = next;
+  }
+}
+
+void* RecordArena::allocate(size_t size)
+{
+  size = (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+  if (size_t(m_end - m_next) < size) {
+    // Blocks double up to MAX_BLOCK_SIZE so small layers stay small; an
+    // oversized request gets a block of its own
+    size_t blockSize = m_blockSize;
+    if (blockSize < size + HEADER_SIZE) {
+      blockSize = size + HEADER_SIZE;
+    } else if (m_blockSize < MAX_BLOCK_SIZE) {
+      m_blockSize *= 2;
+    }
+
+    Block* block = (Block*)malloc(blockSize);
+    if (!block) {
+      throw std::bad_alloc();
+    }
+    block->next = m_block;
+    m_block = block;
+    m_next = (char*)block + HEADER_SIZE;
+    m_end = (char*)block + blockSize;
+    m_capacity += blockSize;
+  }
+
+  void* p = m_next;
+  m_next += size;
+  return p;
+}
+
+void RecordArena::swap(RecordArena& other)
+{
+  std::swap(m_block, other.m_block);
+  std::swap(m_next, other.m_next);
+  std::swap(m_end, other.m_end);
+  std::swap(m_blockSize, other.m_blockSize);
+  std::swap(m_capacity, other.m_capacity);
+}
@@ -0,0 +1,77 @@
+/**
+ * @file   recordarena.h
+ * @author Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ *
+ * Copyright (C) 2012 - 2014 Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ * All Rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __RECORDARENA_H__
+#define __RECORDARENA_H__
+
+#include <cstddef>
+
+/**
+ * Monotonic allocator for the records of one data store.
+ *
+ * Memory is handed out from a chain of large blocks and only returned when
+ * the arena itself is destroyed, so parsing a layer costs a few dozen
+ * allocations instead of one per record and per surface vertex, and
+ * closing it costs as many frees.  Not thread-safe; a data store is filled
+ * by one thread at a time.
+ */
+class RecordArena {
+public:
+  RecordArena();
+  ~RecordArena();
+
+  void* allocate(size_t size);
+
+  /* Exchange the blocks of two arenas, e.g. after copying into a new one */
+  void swap(RecordArena& other);
+
+  /* Bytes held in blocks, used or not */
+  size_t capacity(void) const { return m_capacity; }
+
+private:
+  RecordArena(const RecordArena&);
+  RecordArena& operator=(const RecordArena&);
+
+  struct Block;
+
+  Block* m_block;
+  char* m_next;
+  char* m_end;
+  size_t m_blockSize;
+  size_t m_capacity;
+};
+
+/**
+ * Base for types that live in a RecordArena.  They can only be created
+ * with new (arena) T(...); delete still runs the destructor but leaves the
+ * storage to the arena.
+ */
+struct ArenaObject {
+  static void* operator new(size_t size, RecordArena* arena)
+  {
+    return arena->allocate(size);
+  }
+  static void operator delete(void*, RecordArena*) {}
+  static void operator delete(void*) {}
+};
+
+#endif /* __RECORDARENA_H__ */
@@ -0,0 +1,219 @@
+/**
+ * @file   spatialorder.cpp
+ * @author Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ *
+ * Copyright (C) 2012 - 2014 Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ * All Rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "spatialorder.h"
+
+#include <QAtomicInt>
+
+#include <algorithm>
+
+#include "record.h"
+
+#define GRID_BITS 16
+
+namespace SpatialOrder {
+
+static QAtomicInt currentCurve(Off);
+
+void setCurve(Curve curve)
+{
+  currentCurve.storeRelaxed(curve);
+}
+
+Curve curve(void)
+{
+  return (Curve)currentCurve.loadRelaxed();
+}
+
+quint32 mortonIndex(quint32 x, quint32 y)
+{
+  // Spread the 16 bits of each ordinate over every other bit
+  static const quint32 masks[] = {
+    0x55555555, 0x33333333, 0x0f0f0f0f, 0x00ff00ff
+  };
+  for (int i = 3; i >= 0; --i) {
+    x = (x | (x << (1 << i))) & masks[i];
+    y = (y | (y << (1 << i))) & masks[i];
+  }
+  return x | (y << 1);
+}
+
+quint32 hilbertIndex(quint32 x, quint32 y)
+{
+  quint32 d = 0;
+  for (quint32 s = 1u << (GRID_BITS - 1); s > 0; s >>= 1) {
+    quint32 rx = (x & s)? 1: 0;
+    quint32 ry = (y & s)? 1: 0;
+    d += s * s * ((3 * rx) ^ ry);
+
+    // Rotate the quadrant so the curve stays continuous
+    if (ry == 0) {
+      if (rx == 1) {
+        x = s - 1 - (x & (s - 1));
+        y = s - 1 - (y & (s - 1));
+      }
+      quint32 t = x;
+      x = y;
+      y = t;
+    }
+    x &= s - 1;
+    y &= s - 1;
+  }
+  return d;
+}
+
+/* Midpoint in stored ordinate values, exact step counts in fixed mode */
+static OrdinateValue mid(OrdinateValue a, OrdinateValue b)
+{
+#ifdef QCAMBER_FIXED_COORDS
+  return OrdinateValue(((qint64)a + b) / 2);
+#else
+  return (a + b) / 2;
+#endif
+}
+
+/* Grid cell of v on [lo, hi] */
+static quint32 cell(OrdinateValue v, OrdinateValue lo, OrdinateValue hi)
+{
+  const qint64 cells = (1 << GRID_BITS) - 1;
+#ifdef QCAMBER_FIXED_COORDS
+  qint64 span = (qint64)hi - lo;
+  return (span > 0)? quint32(((qint64)v - lo) * cells / span): 0;
+#else
+  return (hi > lo)? quint32((v - lo) * (cells / (hi - lo))): 0;
+#endif
+}
+
+struct Centre {
+  OrdinateValue x, y;
+};
+
+static Centre centre(const Record* rec)
+{
+  Centre c = { 0, 0 };
+  if (const LineRecord* line = dynamic_cast<const LineRecord*>(rec)) {
+    c.x = mid(ordinateValue(line->xs), ordinateValue(line->xe));
+    c.y = mid(ordinateValue(line->ys), ordinateValue(line->ye));
+  } else if (const PadRecord* pad = dynamic_cast<const PadRecord*>(rec)) {
+    c.x = ordinateValue(pad->x);
+    c.y = ordinateValue(pad->y);
+  } else if (const ArcRecord* arc = dynamic_cast<const ArcRecord*>(rec)) {
+    c.x = mid(ordinateValue(arc->xs), ordinateValue(arc->xe));
+    c.y = mid(ordinateValue(arc->ys), ordinateValue(arc->ye));
+  } else if (const TextRecord* text = dynamic_cast<const TextRecord*>(rec)) {
+    c.x = ordinateValue(text->x);
+    c.y = ordinateValue(text->y);
+  } else if (const SurfaceRecord* surface =
+      dynamic_cast<const SurfaceRecord*>(rec)) {
+    // Centre of the contour vertices; arcs bulging out do not matter here
+    OrdinateValue left = 0, right = 0, top = 0, bottom = 0;
+    bool first = true;
+    foreach (const PolygonRecord* poly, surface->polygons) {
+      OrdinateValue x = ordinateValue(poly->xbs);
+      OrdinateValue y = ordinateValue(poly->ybs);
+      for (int i = -1; i < poly->operations.size(); ++i) {
+        if (i >= 0) {
+          const SurfaceOperation* op = poly->operations[i];
+          bool segment = (op->type == SurfaceOperation::SEGMENT);
+          x = ordinateValue(segment? op->x: op->xe);
+          y = ordinateValue(segment? op->y: op->ye);
+        }
+        if (first) {
+          left = right = x;
+          top = bottom = y;
+          first = false;
+        }
+        left = qMin(left, x);
+        right = qMax(right, x);
+        top = qMin(top, y);
+        bottom = qMax(bottom, y);
+      }
+    }
+    c.x = mid(left, right);
+    c.y = mid(top, bottom);
+  }
+  return c;
+}
+
+static Polarity polarity(const Record* rec)
+{
+  if (const LineRecord* line = dynamic_cast<const LineRecord*>(rec)) {
+    return line->polarity;
+  } else if (const PadRecord* pad = dynamic_cast<const PadRecord*>(rec)) {
+    return pad->polarity;
+  } else if (const ArcRecord* arc = dynamic_cast<const ArcRecord*>(rec)) {
+    return arc->polarity;
+  } else if (const TextRecord* text = dynamic_cast<const TextRecord*>(rec)) {
+    return text->polarity;
+  } else if (const SurfaceRecord* surface =
+      dynamic_cast<const SurfaceRecord*>(rec)) {
+    return surface->polarity;
+  }
+  return P;
+}
+
+QVector<int> permutation(const QList<Record*>& records, Curve curve)
+{
+  QVector<int> order(records.size());
+  for (int i = 0; i < order.size(); ++i) {
+    order[i] = i;
+  }
+  if (curve == Off || records.isEmpty()) {
+    return order;
+  }
+
+  QVector<Centre> centres(records.size());
+  for (int i = 0; i < records.size(); ++i) {
+    centres[i] = centre(records[i]);
+  }
+  OrdinateValue left = centres[0].x, right = left;
+  OrdinateValue top = centres[0].y, bottom = top;
+  foreach (const Centre& c, centres) {
+    left = qMin(left, c.x);
+    right = qMax(right, c.x);
+    top = qMin(top, c.y);
+    bottom = qMax(bottom, c.y);
+  }
+
+  // Quantize the centres onto the grid spanning the layer
+  QVector<quint32> keys(records.size());
+  for (int i = 0; i < records.size(); ++i) {
+    quint32 x = cell(centres[i].x, left, right);
+    quint32 y = cell(centres[i].y, top, bottom);
+    keys[i] = (curve == Hilbert)? hilbertIndex(x, y): mortonIndex(x, y);
+  }
+
+  int begin = 0;
+  while (begin < records.size()) {
+    Polarity p = polarity(records[begin]);
+    int end = begin + 1;
+    while (end < records.size() && polarity(records[end]) == p) {
+      ++end;
+    }
+    std::stable_sort(order.begin() + begin, order.begin() + end,
+        [&keys](int a, int b) { return keys[a] < keys[b]; });
+    begin = end;
+  }
+  return order;
+}
+
+} /* namespace SpatialOrder */
@@ -0,0 +1,60 @@
+/**
+ * @file   spatialorder.h
+ * @author Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ *
+ * Copyright (C) 2012 - 2014 Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ * All Rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __SPATIALORDER_H__
+#define __SPATIALORDER_H__
+
+#include <QList>
+#include <QVector>
+
+struct Record;
+
+/**
+ * Space-filling-curve ordering of feature records.
+ *
+ * Features are drawn in file order, and a negative feature only clears what
+ * was drawn before it, so reordering is confined to runs of records of the
+ * same polarity: within a run the result does not depend on the order.
+ * Each run is sorted by the curve index of its records' centres, which
+ * puts features that are close on the board close in memory as well.
+ */
+namespace SpatialOrder {
+
+typedef enum { Off = 0, Morton, Hilbert } Curve;
+
+/* Curve used for newly parsed layers; Off (the default) keeps file order */
+void setCurve(Curve curve);
+Curve curve(void);
+
+/**
+ * Permutation of [0, records.size()): the i-th entry is the file index of
+ * the record that comes i-th along the curve.
+ */
+QVector<int> permutation(const QList<Record*>& records, Curve curve);
+
+/* Index of cell (x, y) along a curve over a 65536 x 65536 grid */
+quint32 mortonIndex(quint32 x, quint32 y);
+quint32 hilbertIndex(quint32 x, quint32 y);
+
+} /* namespace SpatialOrder */
+
+#endif /* __SPATIALORDER_H__ */
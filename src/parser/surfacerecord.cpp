@@ -25,12 +25,17 @@
 #include <QtCore>
 #include <QPainterPath>
 
+#include "arcgeometry.h"
 #include "featuresdatastore.h"
 #include "macros.h"
 #include "surfacesymbol.h"
 
 PolygonRecord::PolygonRecord(const QStringList& param)
 {
+  if (param.empty()) {
+    return;
+  }
+
   int i = 0;
   xbs = param[++i].toDouble();
   ybs = param[++i].toDouble();
@@ -39,10 +44,7 @@ PolygonRecord::PolygonRecord(const QStringList& param)
 
 PolygonRecord::~PolygonRecord()
 {
-  for (QList<SurfaceOperation*>::iterator it = operations.begin();
-      it != operations.end(); ++it) {
-    delete *it;
-  }
+  // Operations are plain data in the data store's arena
 }
 
 QPainterPath PolygonRecord::painterPath(void)
@@ -53,6 +55,7 @@ QPainterPath PolygonRecord::painterPath(void)
   lx = xbs; ly = ybs;
   path.moveTo(lx, -ly);
 
+  QPolygonF arc;
   for (QList<SurfaceOperation*>::iterator it = operations.begin();
       it != operations.end(); ++it) {
     SurfaceOperation* op = *it;
@@ -60,41 +63,56 @@ QPainterPath PolygonRecord::painterPath(void)
       lx = op->x; ly = op->y;
       path.lineTo(lx, -ly);
     } else if (op->type == SurfaceOperation::CURVE) {
-      qreal sx = lx, sy = ly;
-      qreal ex = op->xe, ey = op->ye;
-      qreal cx = op->xc, cy = op->yc;
-
-      qreal sax = sx - cx, say = sy - cy;
-      qreal eax = ex - cx, eay = ey - cy;
-
-      qreal r = qSqrt(sax * sax + say * say);
-
-      qreal sa = qAtan2(say, sax);
-      qreal ea = qAtan2(eay, eax);
-
-      if (op->cw) {
-        if (sa <= ea) {
-          sa += 2 * M_PI;
-        }
-      } else {
-        if (ea <= sa) {
-          ea += 2 * M_PI;
-        }
+      arc.clear();
+      ArcGeometry::appendRecordArc(arc, lx, ly, op->xe, op->ye, op->xc,
+          op->yc, op->cw, ArcGeometry::tolerance());
+      for (int i = 1; i < arc.size(); ++i) {
+        path.lineTo(arc[i]);
       }
-
-      path.arcTo(QRectF(cx -r, -cy -r, r *2, r *2), sa * R2D, (ea - sa) * R2D);
-      path.lineTo(ex, -ey);
-      lx = ex; ly = ey;
+      lx = op->xe; ly = op->ye;
     }
   }
   path.closeSubpath();
   return path;
 }
 
+QRectF PolygonRecord::boundingRect(void) const
+{
+  qreal lx = xbs, ly = ybs;
+  qreal left = lx, right = lx, bottom = ly, top = ly;
+
+  for (QList<SurfaceOperation*>::const_iterator it = operations.begin();
+      it != operations.end(); ++it) {
+    const SurfaceOperation* op = *it;
+    if (op->type == SurfaceOperation::SEGMENT) {
+      lx = op->x; ly = op->y;
+      left = qMin(left, lx);
+      right = qMax(right, lx);
+      bottom = qMin(bottom, ly);
+      top = qMax(top, ly);
+    } else if (op->type == SurfaceOperation::CURVE) {
+      QRectF arc = ArcGeometry::bounds(lx, ly, op->xe, op->ye, op->xc, op->yc,
+          op->cw);
+      left = qMin(left, arc.left());
+      right = qMax(right, arc.right());
+      bottom = qMin(bottom, arc.top());
+      top = qMax(top, arc.bottom());
+      lx = op->xe; ly = op->ye;
+    }
+  }
+
+  return ArcGeometry::flipped(QRectF(left, bottom, right - left,
+        top - bottom));
+}
+
 SurfaceRecord::SurfaceRecord(FeaturesDataStore* ds, const QStringList& param,
     const AttribData& attr):
   Record(ds, attr)
 {
+  if (param.empty()) {
+    return;
+  }
+
   int i = 0;
   polarity = (param[++i] == "P")? P: N;
   dcode = param[++i].toInt();
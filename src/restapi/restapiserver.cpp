@@ -141,6 +141,20 @@ void RestApiServer::handleHttpRequest(QTcpSocket *socket, const QByteArray &requ
         
         return;  // Exit sớm, giữ connection mở
     }
+    else if (method == "POST" && path == "/api/query") {
+        QJsonObject json = parseJsonBody(body);
+
+        QString requestId = json["requestId"].toString();
+        if (requestId.isEmpty()) {
+            requestId = generateRequestId();
+            json["requestId"] = requestId;
+        }
+
+        // Answered synchronously by sendQueryResponse()
+        m_requestClients[requestId] = socket;
+        emit queryRequest(json);
+        return;
+    }
     else if (method == "GET" && path == "/api/status") {
         QJsonObject response;
         response["status"] = "ok";
@@ -162,6 +176,7 @@ void RestApiServer::sendHttpResponse(QTcpSocket *socket, int statusCode,
     QString statusText;
     switch (statusCode) {
         case 200: statusText = "OK"; break;
+        case 400: statusText = "Bad Request"; break;
         case 404: statusText = "Not Found"; break;
         case 500: statusText = "Internal Server Error"; break;
         default: statusText = "Unknown";
@@ -246,6 +261,23 @@ void RestApiServer::sendCaptureResponse(const QString &requestId,
     });
 }
 
+void RestApiServer::sendQueryResponse(const QString &requestId,
+                                      const QJsonObject &result)
+{
+    QTcpSocket *socket = m_requestClients.value(requestId, nullptr);
+    if (!socket) {
+        qDebug() << "ERROR: Client socket not found for query:" << requestId;
+        return;
+    }
+
+    if (socket->state() == QTcpSocket::ConnectedState) {
+        int status = result.contains("error")? 400: 200;
+        sendHttpResponse(socket, status, "application/json",
+                         QJsonDocument(result).toJson());
+    }
+    cleanupClient(requestId);
+}
+
 QString RestApiServer::generateRequestId()
 {
     QString timestamp = QString::number(QDateTime::currentMSecsSinceEpoch());
@@ -21,6 +21,7 @@ public:
 
 signals:
     void captureRequest(const QJsonObject &request);
+    void queryRequest(const QJsonObject &request);
     void clientConnected(const QString &clientInfo);
     void clientDisconnected(const QString &clientInfo);
 
@@ -31,6 +32,7 @@ private slots:
 
 public slots:
     void sendCaptureResponse(const QString &requestId, const QByteArray &imageData, const QJsonObject &metadata);
+    void sendQueryResponse(const QString &requestId, const QJsonObject &result);
 
 private:
     void handleHttpRequest(QTcpSocket *socket, const QByteArray &requestData);
@@ -24,32 +24,19 @@
 
 #include <QtWidgets>
 
+#include "arcgeometry.h"
 #include "featuresparser.h"
 #include "macros.h"
 
 static void addArc(QPainterPath& path, qreal sx, qreal sy,
     qreal ex, qreal ey, qreal cx, qreal cy, bool cw)
 {
-  qreal sax = sx - cx, say = sy - cy;
-  qreal eax = ex - cx, eay = ey - cy;
-
-  qreal r = qSqrt(sax * sax + say * say);
-
-  qreal sa = qAtan2(say, sax);
-  qreal ea = qAtan2(eay, eax);
-
-  if (cw) {
-    if (sa <= ea) {
-      sa += 2 * M_PI;
-    }
-  } else {
-    if (ea <= sa) {
-      ea += 2 * M_PI;
-    }
+  QPolygonF arc;
+  ArcGeometry::appendRecordArc(arc, sx, sy, ex, ey, cx, cy, cw,
+      ArcGeometry::tolerance());
+  for (int i = 1; i < arc.size(); ++i) {
+    path.lineTo(arc[i]);
   }
-
-  path.arcTo(QRectF(cx -r, -cy -r, r *2, r *2), sa * R2D, (ea - sa) * R2D);
-  path.lineTo(ex, -ey);
 }
 
 ArcSymbol::ArcSymbol(const ArcRecord* rec):
@@ -67,7 +54,10 @@ ArcSymbol::ArcSymbol(const ArcRecord* rec):
   m_sym_name = static_cast<FeaturesDataStore*>(rec->ds)->\
                symbolNameMap()[rec->sym_num];
 
-  m_bounding = painterPath().boundingRect();
+  // The round brush widens the arc by half its diameter all around
+  qreal hr = m_sym_name.right(m_sym_name.length() -1).toDouble() / 2000.0;
+  m_bounding = ArcGeometry::flipped(ArcGeometry::bounds(m_xs, m_ys, m_xe,
+        m_ye, m_xc, m_yc, m_cw)).adjusted(-hr, -hr, hr, hr);
 }
 
 QString ArcSymbol::infoText(void)
@@ -22,13 +22,47 @@
 
 #include "barcodesymbol.h"
 
+#include <QCache>
 #include <QtWidgets>
 #include <QTransform>
 
 #include "code39.h"
 #include "context.h"
+#include "fontdatastore.h"
 #include "fontparser.h"
 
+/* Gap between the bars and the human readable text */
+#define ASTR_GAP 0.03
+
+/* Path elements kept in the outline cache, roughly 24 bytes each */
+#define MAX_GEOMETRY_ELEMENTS (256 * 1024)
+
+struct BarcodeKey {
+  QString text;
+  FontDataStore* font;
+  qreal w, h;
+  bool fasc, cs, astr;
+  int astr_pos;
+
+  bool operator==(const BarcodeKey& o) const {
+    return text == o.text && font == o.font && w == o.w && h == o.h &&
+      fasc == o.fasc && cs == o.cs && astr == o.astr &&
+      astr_pos == o.astr_pos;
+  }
+};
+
+inline size_t qHash(const BarcodeKey& key, size_t seed = 0)
+{
+  return qHashMulti(seed, key.text, key.font, key.w, key.h, key.fasc,
+      key.cs, key.astr, key.astr_pos);
+}
+
+/**
+ * Outlines of recently drawn barcodes, since panels repeat the same ones.
+ * Least recently used outlines go first, costed by path elements.
+ */
+static QCache<BarcodeKey, QPainterPath> s_geometry(MAX_GEOMETRY_ELEMENTS);
+
 BarcodeSymbol::BarcodeSymbol(const BarcodeRecord* rec):
   TextSymbol(NULL)
 {
@@ -53,7 +87,29 @@ BarcodeSymbol::BarcodeSymbol(const BarcodeRecord* rec):
   m_astr_pos = rec->astr_pos;
   m_attrib = rec->attrib;
 
-  m_bounding = painterPath().boundingRect();
+  // Bars from the module widths, text from the glyph boxes
+  QByteArray bars = Code39::encode(m_text, m_cs, m_fasc);
+  qreal width = 0;
+  for (int i = 0; i < bars.size(); ++i) {
+    width += (bars[i] == 'W' || bars[i] == 'w')? m_w * 3: m_w;
+  }
+  m_bounding = QRectF(0, -m_h, width, m_h);
+
+  FontDataStore* ds = m_astr? fontDataStore(): NULL;
+  if (ds) {
+    QRectF tb = ds->layoutBounds(m_text, m_xsize, m_ysize, m_width_factor);
+    m_bounding |= tb.translated(textOffset(m_bounding, tb));
+  }
+}
+
+QPointF BarcodeSymbol::textOffset(const QRectF& bars, const QRectF& text)
+{
+  qreal ox = (bars.width() - text.width()) / 2.0;
+  if (m_astr_pos == BarcodeRecord::T) {
+    return QPointF(ox, -m_h - ASTR_GAP);
+  } else {
+    return QPointF(ox, text.height() + ASTR_GAP);
+  }
 }
 
 QString BarcodeSymbol::infoText(void)
@@ -92,13 +148,11 @@ QString BarcodeSymbol::longInfoText(void)
 void BarcodeSymbol::paint(QPainter *painter, const QStyleOptionGraphicsItem*,
     QWidget*)
 {
-  QPainterPath path = painterPath();
-
   if (m_bg) {
     painter->setPen(QPen(ctx.bg_color, 0));
     painter->setBrush(ctx.bg_color);
 
-    QRectF b = path.boundingRect();
+    QRectF b = m_bounding;
     const qreal offset = 0.1;
     b.setX(b.x() - offset);
     b.setWidth(b.width() + offset * 2);
@@ -107,20 +161,27 @@ void BarcodeSymbol::paint(QPainter *painter, const QStyleOptionGraphicsItem*,
 
   painter->setPen(m_pen);
   painter->setBrush(m_brush);
-  painter->drawPath(path);
+  painter->drawPath(painterPath());
 }
 
 QPainterPath BarcodeSymbol::painterPath(void)
 {
+  BarcodeKey key = { m_text, m_astr? fontDataStore(): NULL, m_w, m_h,
+    m_fasc, m_cs, m_astr, m_astr_pos };
+  QPainterPath* cached = s_geometry.object(key);
+  if (cached) {
+    return *cached;
+  }
+
   QPainterPath path;
-  QString bar_pattern = Code39::encode(m_text, m_cs, m_fasc);
+  QByteArray bar_pattern = Code39::encode(m_text, m_cs, m_fasc);
 
   qreal offset = 0;
   qreal narrow = m_w;
   qreal wide = narrow * 3;
 
-  for (int i = 0; i < bar_pattern.length(); ++i) {
-    switch (bar_pattern[i].toLatin1()) {
+  for (int i = 0; i < bar_pattern.size(); ++i) {
+    switch (bar_pattern[i]) {
       case 'W':
         path.addRect(offset, 0, wide, -m_h);
         offset += wide;
@@ -139,24 +200,14 @@ QPainterPath BarcodeSymbol::painterPath(void)
   }
 
   if (m_astr) {
-    // Save current orientation to generate normal orientation text
-    Orient orient_bak = m_orient;
-    m_orient = N_0;
+    // The text is laid out upright; the item transform orients both
     QPainterPath p = TextSymbol::painterPath();
-    // restore orientation
-    m_orient = orient_bak;
-    QRectF tb = p.boundingRect();
-    QRectF bb = path.boundingRect();
-    qreal ox = (bb.width() - tb.width()) / 2.0;
-
-    if (m_astr_pos == BarcodeRecord::T) {
-      p.translate(ox, -m_h -0.03);
-    } else {
-      p.translate(ox, tb.height() + 0.03);
-    }
+    p.translate(textOffset(path.boundingRect(), p.boundingRect()));
     path.addPath(p);
   }
   path.setFillRule(Qt::WindingFill);
 
+  s_geometry.insert(key, new QPainterPath(path),
+      qMax(1, path.elementCount()));
   return path;
 }
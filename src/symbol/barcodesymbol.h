@@ -41,6 +41,9 @@ public:
   virtual QPainterPath painterPath(void);
 
 private:
+  /* Where the human readable text goes relative to the bars */
+  QPointF textOffset(const QRectF& bars, const QRectF& text);
+
   QString m_barcode;
   QString m_e;
   qreal m_w, m_h;
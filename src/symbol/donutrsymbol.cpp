@@ -26,29 +26,69 @@
 
 #include "macros.h"
 
+#include "arcgeometry.h"
+
+static bool parseDefinition(const QString& def, SymbolParam* caps)
+{
+  const ushort* s = def.utf16();
+  const int n = def.length();
+  int i = 0;
+
+  if (n - i < 7 || s[i] != 'd' || s[i + 1] != 'o' || s[i + 2] != 'n' ||
+      s[i + 3] != 'u' || s[i + 4] != 't' || s[i + 5] != '_' ||
+      s[i + 6] != 'r') {
+    return false;
+  }
+  i += 7;
+  const int c1 = i;
+  while (i < n && ((s[i] >= '0' && s[i] <= '9') || s[i] == '.')) {
+    ++i;
+  }
+  if (i == c1) {
+    return false;
+  }
+  caps[1] = SymbolParam(s + c1, i - c1);
+  if (i >= n || s[i] != 'x') {
+    return false;
+  }
+  ++i;
+  const int c2 = i;
+  while (i < n && ((s[i] >= '0' && s[i] <= '9') || s[i] == '.')) {
+    ++i;
+  }
+  if (i == c2) {
+    return false;
+  }
+  caps[2] = SymbolParam(s + c2, i - c2);
+
+  caps[0] = SymbolParam(s, n);
+  return i == n;
+}
 
 DonutRSymbol::DonutRSymbol(const QString& def, const Polarity& polarity,
     const AttribData& attrib):
     Symbol(def, "donut_r([0-9.]+)x([0-9.]+)", polarity, attrib), m_def(def)
 {
-  QRegularExpression rx(m_pattern);
-  QRegularExpressionMatch m = rx.match(def);
-  if (!m.hasMatch())
+  SymbolParam caps[3];
+  if (!parseDefinition(def, caps))
     throw InvalidSymbolException(def.toLatin1());
 
-  QStringList caps = m.capturedTexts();
   m_od = caps[1].toDouble() / 1000.0;
   m_id = caps[2].toDouble() / 1000.0;
 
-  m_bounding = painterPath().boundingRect();
+  m_bounding = QRectF(-m_od / 2, -m_od / 2, m_od, m_od);
 }
 
 QPainterPath DonutRSymbol::painterPath(void)
 {
   QPainterPath path;
 
-  path.addEllipse(-m_od / 2, -m_od / 2, m_od, m_od);
-  path.addEllipse(-m_id / 2, -m_id / 2, m_id, m_id);
+  path.addPolygon(ArcGeometry::circle(QPointF(0, 0), m_od / 2,
+      ArcGeometry::tolerance()));
+  path.closeSubpath();
+  path.addPolygon(ArcGeometry::circle(QPointF(0, 0), m_id / 2,
+      ArcGeometry::tolerance()));
+  path.closeSubpath();
 
   return path;
 }
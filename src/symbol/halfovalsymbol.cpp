@@ -27,20 +27,58 @@
 #include "macros.h"
 
 
+static bool parseDefinition(const QString& def, SymbolParam* caps)
+{
+  const ushort* s = def.utf16();
+  const int n = def.length();
+  int i = 0;
+
+  if (n - i < 6 || s[i] != 'o' || s[i + 1] != 'v' || s[i + 2] != 'a' ||
+      s[i + 3] != 'l' || s[i + 4] != '_' || s[i + 5] != 'h') {
+    return false;
+  }
+  i += 6;
+  const int c1 = i;
+  while (i < n && ((s[i] >= '0' && s[i] <= '9') || s[i] == '.')) {
+    ++i;
+  }
+  if (i == c1) {
+    return false;
+  }
+  caps[1] = SymbolParam(s + c1, i - c1);
+  if (i >= n || s[i] != 'x') {
+    return false;
+  }
+  ++i;
+  const int c2 = i;
+  while (i < n && ((s[i] >= '0' && s[i] <= '9') || s[i] == '.')) {
+    ++i;
+  }
+  if (i == c2) {
+    return false;
+  }
+  caps[2] = SymbolParam(s + c2, i - c2);
+
+  caps[0] = SymbolParam(s, n);
+  return i == n;
+}
+
 HalfOvalSymbol::HalfOvalSymbol(const QString& def, const Polarity& polarity,
     const AttribData& attrib):
     Symbol(def, "oval_h([0-9.]+)x([0-9.]+)", polarity, attrib), m_def(def)
 {
-  QRegularExpression rx(m_pattern);
-  QRegularExpressionMatch m = rx.match(def);
-  if (!m.hasMatch())
+  SymbolParam caps[3];
+  if (!parseDefinition(def, caps))
     throw InvalidSymbolException(def.toLatin1());
 
-  QStringList caps = m.capturedTexts();
   m_w = caps[1].toDouble() / 1000.0;
   m_h = caps[2].toDouble() / 1000.0;
 
-  m_bounding = painterPath().boundingRect();
+  if (m_w > m_h) {
+    m_bounding = QRectF(m_h - m_w, -m_h / 2, m_w, m_h);
+  } else {
+    m_bounding = QRectF(-m_w / 2, -m_w, m_w, m_h);
+  }
 }
 
 QPainterPath HalfOvalSymbol::painterPath(void)
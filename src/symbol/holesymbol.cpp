@@ -26,30 +26,89 @@
 
 #include "macros.h"
 
+#include "arcgeometry.h"
+
+static bool parseDefinition(const QString& def, SymbolParam* caps)
+{
+  const ushort* s = def.utf16();
+  const int n = def.length();
+  int i = 0;
+
+  if (n - i < 4 || s[i] != 'h' || s[i + 1] != 'o' || s[i + 2] != 'l' ||
+      s[i + 3] != 'e') {
+    return false;
+  }
+  i += 4;
+  const int c1 = i;
+  while (i < n && ((s[i] >= '0' && s[i] <= '9') || s[i] == '.')) {
+    ++i;
+  }
+  if (i == c1) {
+    return false;
+  }
+  caps[1] = SymbolParam(s + c1, i - c1);
+  if (i >= n || s[i] != 'x') {
+    return false;
+  }
+  ++i;
+  const int c2 = i;
+  if (i >= n || !(s[i] == 'p' || s[i] == 'n' || s[i] == 'v')) {
+    return false;
+  }
+  ++i;
+  caps[2] = SymbolParam(s + c2, i - c2);
+  if (i >= n || s[i] != 'x') {
+    return false;
+  }
+  ++i;
+  const int c3 = i;
+  while (i < n && ((s[i] >= '0' && s[i] <= '9') || s[i] == '.')) {
+    ++i;
+  }
+  if (i == c3) {
+    return false;
+  }
+  caps[3] = SymbolParam(s + c3, i - c3);
+  if (i >= n || s[i] != 'x') {
+    return false;
+  }
+  ++i;
+  const int c4 = i;
+  while (i < n && ((s[i] >= '0' && s[i] <= '9') || s[i] == '.')) {
+    ++i;
+  }
+  if (i == c4) {
+    return false;
+  }
+  caps[4] = SymbolParam(s + c4, i - c4);
+
+  caps[0] = SymbolParam(s, n);
+  return i == n;
+}
 
 HoleSymbol::HoleSymbol(const QString& def, const Polarity& polarity,
     const AttribData& attrib):
     Symbol(def, "hole([0-9.]+)x([pnv])x([0-9.]+)x([0-9.]+)", polarity, attrib), m_def(def)
 {
-  QRegularExpression rx(m_pattern);
-  QRegularExpressionMatch m = rx.match(def);
-  if (!m.hasMatch())
+  SymbolParam caps[5];
+  if (!parseDefinition(def, caps))
     throw InvalidSymbolException(def.toLatin1());
 
-  QStringList caps = m.capturedTexts();
   m_r = caps[1].toDouble() / 1000.0 / 2;
   m_p = caps[2];
   m_tp = caps[3].toDouble() / 1000.0;
   m_tm = caps[4].toDouble() / 1000.0;
 
-  m_bounding = painterPath().boundingRect();
+  m_bounding = QRectF(-m_r, -m_r, 2 * m_r, 2 * m_r);
 }
 
 QPainterPath HoleSymbol::painterPath(void)
 {
   QPainterPath path;
 
-  path.addEllipse(QPointF(0, 0), m_r, m_r);
+  path.addPolygon(ArcGeometry::circle(QPointF(0, 0), m_r,
+      ArcGeometry::tolerance()));
+  path.closeSubpath();
 
   return path;
 }
@@ -27,21 +27,67 @@
 #include "macros.h"
 
 
+static bool parseDefinition(const QString& def, SymbolParam* caps)
+{
+  const ushort* s = def.utf16();
+  const int n = def.length();
+  int i = 0;
+
+  if (n - i < 5 || s[i] != 'h' || s[i + 1] != 'e' || s[i + 2] != 'x' ||
+      s[i + 3] != '_' || s[i + 4] != 'l') {
+    return false;
+  }
+  i += 5;
+  const int c1 = i;
+  while (i < n && ((s[i] >= '0' && s[i] <= '9') || s[i] == '.')) {
+    ++i;
+  }
+  if (i == c1) {
+    return false;
+  }
+  caps[1] = SymbolParam(s + c1, i - c1);
+  if (i >= n || s[i] != 'x') {
+    return false;
+  }
+  ++i;
+  const int c2 = i;
+  while (i < n && ((s[i] >= '0' && s[i] <= '9') || s[i] == '.')) {
+    ++i;
+  }
+  if (i == c2) {
+    return false;
+  }
+  caps[2] = SymbolParam(s + c2, i - c2);
+  if (i >= n || s[i] != 'x') {
+    return false;
+  }
+  ++i;
+  const int c3 = i;
+  while (i < n && ((s[i] >= '0' && s[i] <= '9') || s[i] == '.')) {
+    ++i;
+  }
+  if (i == c3) {
+    return false;
+  }
+  caps[3] = SymbolParam(s + c3, i - c3);
+
+  caps[0] = SymbolParam(s, n);
+  return i == n;
+}
+
 HorizontalHexagonSymbol::HorizontalHexagonSymbol(const QString& def, const Polarity& polarity,
     const AttribData& attrib):
     Symbol(def, "hex_l([0-9.]+)x([0-9.]+)x([0-9.]+)", polarity, attrib), m_def(def)
 {
-  QRegularExpression rx(m_pattern);
-  QRegularExpressionMatch m = rx.match(def);
-  if (!m.hasMatch())
+  SymbolParam caps[4];
+  if (!parseDefinition(def, caps))
     throw InvalidSymbolException(def.toLatin1());
 
-  QStringList caps = m.capturedTexts();
   m_w = caps[1].toDouble() / 1000.0;
   m_h = caps[2].toDouble() / 1000.0;
   m_r = caps[3].toDouble() / 1000.0;
 
-  m_bounding = painterPath().boundingRect();
+  m_bounding = QRectF(-m_w / 2, -m_h / 2, m_w, m_h);
 }
 
 QPainterPath HorizontalHexagonSymbol::painterPath(void)
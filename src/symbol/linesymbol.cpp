@@ -49,7 +49,18 @@ LineSymbol::LineSymbol(const LineRecord* rec):
     m_ye = tmp;
   }
 
-  m_bounding = painterPath().boundingRect();
+  // Brush at both ends, joined by a body as wide as the brush is high
+  QRectF brush = SYMBOLPOOL->geometry(m_sym_name)->bounding;
+  qreal radius = brush.height() / 2;
+  qreal dx = m_xe - m_xs, dy = m_ye - m_ys;
+  qreal len = qSqrt(dx * dx + dy * dy);
+  qreal rx = (len > 0)? qAbs(radius * dy / len): 0;
+  qreal ry = (len > 0)? qAbs(radius * dx / len): radius;
+
+  m_bounding = QRectF(m_xs - rx, -qMax(m_ys, m_ye) - ry, dx + 2 * rx,
+      qAbs(dy) + 2 * ry);
+  m_bounding |= brush.translated(m_xs, -m_ys);
+  m_bounding |= brush.translated(m_xe, -m_ye);
 }
 
 QString LineSymbol::infoText(void)
@@ -87,14 +98,14 @@ QPainterPath LineSymbol::painterPath()
   // Set winding fill
   path.setFillRule(Qt::WindingFill);
 
-  Symbol *symbol = SYMBOLPOOL->get(m_sym_name, m_polarity, m_attrib);
-  QPainterPath symbolPath = symbol->painterPath();
-  if (symbolPath.boundingRect().height() != symbolPath.boundingRect().width()) {
+  const SymbolGeometry* brush = SYMBOLPOOL->geometry(m_sym_name);
+  QPainterPath symbolPath = brush->painterPath();
+  if (brush->bounding.height() != brush->bounding.width()) {
     qDebug() << m_sym_name << "is not a symmetrics symbol, but we'll still "
       "try to draw lines with it";
   }
 
-  qreal radius = (qreal)symbolPath.boundingRect().height() / 2;
+  qreal radius = brush->bounding.height() / 2;
 
   qreal sx = m_xs, sy = m_ys;
   qreal ex = m_xe, ey = m_ye;
@@ -26,18 +26,99 @@
 
 #include "macros.h"
 
-#include "context.h"
+
+static bool parseDefinition(const QString& def, SymbolParam* caps)
+{
+  const ushort* s = def.utf16();
+  const int n = def.length();
+  int i = 0;
+
+  if (n - i < 5 || s[i] != 'm' || s[i + 1] != 'o' || s[i + 2] != 'i' ||
+      s[i + 3] != 'r' || s[i + 4] != 'e') {
+    return false;
+  }
+  i += 5;
+  const int c1 = i;
+  while (i < n && ((s[i] >= '0' && s[i] <= '9') || s[i] == '.')) {
+    ++i;
+  }
+  if (i == c1) {
+    return false;
+  }
+  caps[1] = SymbolParam(s + c1, i - c1);
+  if (i >= n || s[i] != 'x') {
+    return false;
+  }
+  ++i;
+  const int c2 = i;
+  while (i < n && ((s[i] >= '0' && s[i] <= '9') || s[i] == '.')) {
+    ++i;
+  }
+  if (i == c2) {
+    return false;
+  }
+  caps[2] = SymbolParam(s + c2, i - c2);
+  if (i >= n || s[i] != 'x') {
+    return false;
+  }
+  ++i;
+  const int c3 = i;
+  while (i < n && ((s[i] >= '0' && s[i] <= '9') || s[i] == '.')) {
+    ++i;
+  }
+  if (i == c3) {
+    return false;
+  }
+  caps[3] = SymbolParam(s + c3, i - c3);
+  if (i >= n || s[i] != 'x') {
+    return false;
+  }
+  ++i;
+  const int c4 = i;
+  while (i < n && ((s[i] >= '0' && s[i] <= '9') || s[i] == '.')) {
+    ++i;
+  }
+  if (i == c4) {
+    return false;
+  }
+  caps[4] = SymbolParam(s + c4, i - c4);
+  if (i >= n || s[i] != 'x') {
+    return false;
+  }
+  ++i;
+  const int c5 = i;
+  while (i < n && ((s[i] >= '0' && s[i] <= '9') || s[i] == '.')) {
+    ++i;
+  }
+  if (i == c5) {
+    return false;
+  }
+  caps[5] = SymbolParam(s + c5, i - c5);
+  if (i >= n || s[i] != 'x') {
+    return false;
+  }
+  ++i;
+  const int c6 = i;
+  while (i < n && ((s[i] >= '0' && s[i] <= '9') || s[i] == '.')) {
+    ++i;
+  }
+  if (i == c6) {
+    return false;
+  }
+  caps[6] = SymbolParam(s + c6, i - c6);
+
+  caps[0] = SymbolParam(s, n);
+  return i == n;
+}
 
 MoireSymbol::MoireSymbol(const QString& def, const Polarity& polarity,
     const AttribData& attrib):
     Symbol(def, "moire([0-9.]+)x([0-9.]+)x([0-9.]+)x([0-9.]+)x([0-9.]+)x([0-9.]+)", polarity, attrib), m_def(def)
 {
-  QRegularExpression rx(m_pattern);
-  QRegularExpressionMatch m = rx.match(def);
-  if (!m.hasMatch())
+  SymbolParam caps[7];
+  if (!parseDefinition(def, caps))
     throw InvalidSymbolException(def.toLatin1());
 
-  QStringList caps = m.capturedTexts();
   m_rw = caps[1].toDouble() / 1000.0;
   m_rg = caps[2].toDouble() / 1000.0;
   m_nr = caps[3].toInt();
@@ -45,7 +126,10 @@ MoireSymbol::MoireSymbol(const QString& def, const Polarity& polarity,
   m_ll = caps[5].toDouble() / 1000.0;
   m_la = caps[6].toDouble() / 1000.0;
 
-  m_bounding = painterPath().boundingRect();
+  // Outermost ring or the end of the cross hair, whichever is further out
+  qreal ring = m_nr? m_rw + m_nr * (m_rg + m_rw / 2): m_rw / 2;
+  qreal half = qMax(ring, (m_ll + m_lw) / 2);
+  m_bounding = QRectF(-half, -half, 2 * half, 2 * half);
 }
 
 QPainterPath MoireSymbol::painterPath(void)
@@ -81,18 +165,10 @@ QPainterPath MoireSymbol::painterPath(void)
   return path;
 }
 
-void MoireSymbol::paint(QPainter *painter,
-    const QStyleOptionGraphicsItem *, QWidget *)
+void MoireSymbol::drawShape(QPainter* painter, const QPainterPath&)
 {
-  if (m_polarity == P) {
-    painter->setPen(m_pen);
-    painter->setBrush(m_brush);
-  } else {
-    painter->setPen(QPen(ctx.bg_color, 0));
-    painter->setBrush(ctx.bg_color);
-  }
-
-  painterPath();
+  // Rings and cross hair overlap, draw them separately so the overlap is not
+  // punched out
   painter->drawPath(m_circlePath);
   painter->drawPath(m_linePath);
 }
@@ -32,8 +32,7 @@ public:
       const AttribData& attrib);
 
   virtual QPainterPath painterPath(void);
-  virtual void paint(QPainter *painter, const QStyleOptionGraphicsItem *option,
-      QWidget *widget);
+  virtual void drawShape(QPainter* painter, const QPainterPath& path);
 
 protected:
 
@@ -27,19 +27,41 @@
 #include "macros.h"
 
 
+static bool parseDefinition(const QString& def, SymbolParam* caps)
+{
+  const ushort* s = def.utf16();
+  const int n = def.length();
+  int i = 0;
+
+  if (n - i < 4 || s[i] != 'n' || s[i + 1] != 'u' || s[i + 2] != 'l' ||
+      s[i + 3] != 'l') {
+    return false;
+  }
+  i += 4;
+  const int c1 = i;
+  while (i < n && ((s[i] >= '0' && s[i] <= '9') || s[i] == '.')) {
+    ++i;
+  }
+  if (i == c1) {
+    return false;
+  }
+  caps[1] = SymbolParam(s + c1, i - c1);
+
+  caps[0] = SymbolParam(s, n);
+  return i == n;
+}
+
 NullSymbol::NullSymbol(const QString& def, const Polarity& polarity,
     const AttribData& attrib):
     Symbol(def, "null([0-9.]+)", polarity, attrib), m_def(def)
 {
-  QRegularExpression rx(m_pattern);
-  QRegularExpressionMatch m = rx.match(def);
-  if (!m.hasMatch())
+  SymbolParam caps[2];
+  if (!parseDefinition(def, caps))
     throw InvalidSymbolException(def.toLatin1());
 
-  QStringList caps = m.capturedTexts();
   m_ext = caps[1].toInt();
 
-  m_bounding = painterPath().boundingRect();
+  m_bounding = QRectF();
 }
 
 QPainterPath NullSymbol::painterPath(void)
@@ -0,0 +1,46 @@
+/**
+ * @file   padsymbol.cpp
+ * @author Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ *
+ * Copyright (C) 2012 - 2014 Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ * All Rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "padsymbol.h"
+
+#include "symbolpool.h"
+
+PadSymbol::PadSymbol(const SymbolGeometry* geometry, const QString& def,
+    const Polarity& polarity, const AttribData& attrib):
+  Symbol(def, QString(), polarity, attrib), m_geometry(geometry)
+{
+  m_bounding = geometry->bounding;
+}
+
+QPainterPath PadSymbol::painterPath(void)
+{
+  return m_geometry->painterPath();
+}
+
+void PadSymbol::drawShape(QPainter* painter, const QPainterPath& path)
+{
+  if (m_geometry->shape) {
+    m_geometry->shape->drawShape(painter, path);
+  } else {
+    painter->drawPath(path);
+  }
+}
@@ -27,32 +27,115 @@
 #include "macros.h"
 
 
+static bool parseDefinition(const QString& def, SymbolParam* caps)
+{
+  const ushort* s = def.utf16();
+  const int n = def.length();
+  int i = 0;
+
+  if (n - i < 4 || s[i] != 'r' || s[i + 1] != 'e' || s[i + 2] != 'c' ||
+      s[i + 3] != 't') {
+    return false;
+  }
+  i += 4;
+  const int c1 = i;
+  while (i < n && ((s[i] >= '0' && s[i] <= '9') || s[i] == '.')) {
+    ++i;
+  }
+  if (i == c1) {
+    return false;
+  }
+  caps[1] = SymbolParam(s + c1, i - c1);
+  if (i >= n || s[i] != 'x') {
+    return false;
+  }
+  ++i;
+  const int c2 = i;
+  while (i < n && ((s[i] >= '0' && s[i] <= '9') || s[i] == '.')) {
+    ++i;
+  }
+  if (i == c2) {
+    return false;
+  }
+  caps[2] = SymbolParam(s + c2, i - c2);
+  do {
+    const int m1 = i;
+    const int c3 = i;
+    if (i >= n || s[i] != 'x') {
+      i = m1;
+      caps[3] = SymbolParam();
+      caps[4] = SymbolParam();
+      caps[5] = SymbolParam();
+      break;
+    }
+    ++i;
+    if (i >= n || !(s[i] == 'c' || s[i] == 'r')) {
+      i = m1;
+      caps[3] = SymbolParam();
+      caps[4] = SymbolParam();
+      caps[5] = SymbolParam();
+      break;
+    }
+    ++i;
+    caps[3] = SymbolParam(s + c3, i - c3);
+    const int c4 = i;
+    while (i < n && ((s[i] >= '0' && s[i] <= '9') || s[i] == '.')) {
+      ++i;
+    }
+    if (i == c4) {
+      i = m1;
+      caps[3] = SymbolParam();
+      caps[4] = SymbolParam();
+      caps[5] = SymbolParam();
+      break;
+    }
+    caps[4] = SymbolParam(s + c4, i - c4);
+    do {
+      const int m2 = i;
+      if (i >= n || s[i] != 'x') {
+        i = m2;
+        caps[5] = SymbolParam();
+        break;
+      }
+      ++i;
+      const int c5 = i;
+      while (i < n && s[i] >= '1' && s[i] <= '4') {
+        ++i;
+      }
+      if (i == c5) {
+        i = m2;
+        caps[5] = SymbolParam();
+        break;
+      }
+      caps[5] = SymbolParam(s + c5, i - c5);
+    } while (0);
+  } while (0);
+
+  caps[0] = SymbolParam(s, n);
+  return i == n;
+}
+
 RectangleSymbol::RectangleSymbol(const QString& def, const Polarity& polarity,
     const AttribData& attrib):
     Symbol(def, "rect([0-9.]+)x([0-9.]+)(?:(x[cr])([0-9.]+)(?:x([1-4]+))?)?", polarity, attrib), m_def(def)
 {
-  QRegularExpression rx(m_pattern);
-  QRegularExpressionMatch m = rx.match(def);
-  if (!m.hasMatch())
+  SymbolParam caps[6];
+  if (!parseDefinition(def, caps))
     throw InvalidSymbolException(def.toLatin1());
 
-  QStringList caps = m.capturedTexts();
   m_w = caps[1].toDouble() / 1000.0;
   m_h = caps[2].toDouble() / 1000.0;
-  if (caps.count() > 4) {
-    if (caps[3] == "xr") {
-      m_rad = caps[4].toDouble() / 1000.0;
-      m_type = ROUNDED;
-    } else if (caps[3] == "xc") {
-      m_rad = caps[4].toDouble() / 1000.0;
-      m_type = CHAMFERED;
-    }
-  }
-  else {
+  if (caps[3] == "xr") {
+    m_rad = caps[4].toDouble() / 1000.0;
+    m_type = ROUNDED;
+  } else if (caps[3] == "xc") {
+    m_rad = caps[4].toDouble() / 1000.0;
+    m_type = CHAMFERED;
+  } else {
     m_rad = 0;
     m_type = NORMAL;
   }
-  if (caps.count() > 5) {
+  if (caps[5].length()) {
     m_corners = 0;
     QByteArray cors = caps[5].toLatin1();
     for (int i = 0; i < cors.size(); ++i) {
@@ -62,7 +145,7 @@ RectangleSymbol::RectangleSymbol(const QString& def, const Polarity& polarity,
     m_corners = 15;
   }
 
-  m_bounding = painterPath().boundingRect();
+  m_bounding = QRectF(-m_w / 2, -m_h / 2, m_w, m_h);
 }
 
 QPainterPath RectangleSymbol::painterPath(void)
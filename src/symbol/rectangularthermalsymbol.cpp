@@ -27,16 +27,98 @@
 #include "macros.h"
 
 
+static bool parseDefinition(const QString& def, SymbolParam* caps)
+{
+  const ushort* s = def.utf16();
+  const int n = def.length();
+  int i = 0;
+
+  if (n - i < 6 || s[i] != 'r' || s[i + 1] != 'c' || s[i + 2] != '_' ||
+      s[i + 3] != 't' || s[i + 4] != 'h' || s[i + 5] != 's') {
+    return false;
+  }
+  i += 6;
+  const int c1 = i;
+  while (i < n && ((s[i] >= '0' && s[i] <= '9') || s[i] == '.')) {
+    ++i;
+  }
+  if (i == c1) {
+    return false;
+  }
+  caps[1] = SymbolParam(s + c1, i - c1);
+  if (i >= n || s[i] != 'x') {
+    return false;
+  }
+  ++i;
+  const int c2 = i;
+  while (i < n && ((s[i] >= '0' && s[i] <= '9') || s[i] == '.')) {
+    ++i;
+  }
+  if (i == c2) {
+    return false;
+  }
+  caps[2] = SymbolParam(s + c2, i - c2);
+  if (i >= n || s[i] != 'x') {
+    return false;
+  }
+  ++i;
+  const int c3 = i;
+  while (i < n && ((s[i] >= '0' && s[i] <= '9') || s[i] == '.')) {
+    ++i;
+  }
+  if (i == c3) {
+    return false;
+  }
+  caps[3] = SymbolParam(s + c3, i - c3);
+  if (i >= n || s[i] != 'x') {
+    return false;
+  }
+  ++i;
+  const int c4 = i;
+  while (i < n && ((s[i] >= '0' && s[i] <= '9') || s[i] == '.')) {
+    ++i;
+  }
+  if (i == c4) {
+    return false;
+  }
+  caps[4] = SymbolParam(s + c4, i - c4);
+  if (i >= n || s[i] != 'x') {
+    return false;
+  }
+  ++i;
+  const int c5 = i;
+  while (i < n && ((s[i] >= '0' && s[i] <= '9') || s[i] == '.')) {
+    ++i;
+  }
+  if (i == c5) {
+    return false;
+  }
+  caps[5] = SymbolParam(s + c5, i - c5);
+  if (i >= n || s[i] != 'x') {
+    return false;
+  }
+  ++i;
+  const int c6 = i;
+  while (i < n && ((s[i] >= '0' && s[i] <= '9') || s[i] == '.')) {
+    ++i;
+  }
+  if (i == c6) {
+    return false;
+  }
+  caps[6] = SymbolParam(s + c6, i - c6);
+
+  caps[0] = SymbolParam(s, n);
+  return i == n;
+}
+
 RectangularThermalSymbol::RectangularThermalSymbol(const QString& def, const Polarity& polarity,
     const AttribData& attrib):
     Symbol(def, "rc_ths([0-9.]+)x([0-9.]+)x([0-9.]+)x([0-9.]+)x([0-9.]+)x([0-9.]+)", polarity, attrib), m_def(def)
 {
-  QRegularExpression rx(m_pattern);
-  QRegularExpressionMatch m = rx.match(def);
-  if (!m.hasMatch())
+  SymbolParam caps[7];
+  if (!parseDefinition(def, caps))
     throw InvalidSymbolException(def.toLatin1());
 
-  QStringList caps = m.capturedTexts();
   m_w = caps[1].toDouble() / 1000.0;
   m_h = caps[2].toDouble() / 1000.0;
   m_angle = caps[3].toDouble();
@@ -44,7 +126,7 @@ RectangularThermalSymbol::RectangularThermalSymbol(const QString& def, const Pol
   m_gap = caps[5].toDouble() / 1000.0;
   m_air_gap = caps[6].toDouble() / 1000.0;
 
-  m_bounding = painterPath().boundingRect();
+  m_bounding = QRectF(-m_w / 2, -m_h / 2, m_w, m_h);
 }
 
 QPainterPath RectangularThermalSymbol::painterPath(void)
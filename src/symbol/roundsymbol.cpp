@@ -26,27 +26,51 @@
 
 #include "macros.h"
 
+#include "arcgeometry.h"
+
+static bool parseDefinition(const QString& def, SymbolParam* caps)
+{
+  const ushort* s = def.utf16();
+  const int n = def.length();
+  int i = 0;
+
+  if (i >= n || s[i] != 'r') {
+    return false;
+  }
+  ++i;
+  const int c1 = i;
+  while (i < n && ((s[i] >= '0' && s[i] <= '9') || s[i] == '.')) {
+    ++i;
+  }
+  if (i == c1) {
+    return false;
+  }
+  caps[1] = SymbolParam(s + c1, i - c1);
+
+  caps[0] = SymbolParam(s, n);
+  return i == n;
+}
 
 RoundSymbol::RoundSymbol(const QString& def, const Polarity& polarity,
     const AttribData& attrib):
     Symbol(def, "r([0-9.]+)", polarity, attrib), m_def(def)
 {
-  QRegularExpression rx(m_pattern);
-  QRegularExpressionMatch m = rx.match(def);
-  if (!m.hasMatch())
+  SymbolParam caps[2];
+  if (!parseDefinition(def, caps))
     throw InvalidSymbolException(def.toLatin1());
 
-  QStringList caps = m.capturedTexts();
   m_r = caps[1].toDouble() / 1000.0 / 2.0;
 
-  m_bounding = painterPath().boundingRect();
+  m_bounding = QRectF(-m_r, -m_r, 2 * m_r, 2 * m_r);
 }
 
 QPainterPath RoundSymbol::painterPath(void)
 {
   QPainterPath path;
 
-  path.addEllipse(QPointF(0, 0), m_r, m_r);
+  path.addPolygon(ArcGeometry::circle(QPointF(0, 0), m_r,
+      ArcGeometry::tolerance()));
+  path.closeSubpath();
 
   return path;
 }
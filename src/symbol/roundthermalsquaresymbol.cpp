@@ -26,24 +26,94 @@
 
 #include "macros.h"
 
+#include "arcgeometry.h"
+
+static bool parseDefinition(const QString& def, SymbolParam* caps)
+{
+  const ushort* s = def.utf16();
+  const int n = def.length();
+  int i = 0;
+
+  if (n - i < 3 || s[i] != 't' || s[i + 1] != 'h' || s[i + 2] != 's') {
+    return false;
+  }
+  i += 3;
+  const int c1 = i;
+  while (i < n && ((s[i] >= '0' && s[i] <= '9') || s[i] == '.')) {
+    ++i;
+  }
+  if (i == c1) {
+    return false;
+  }
+  caps[1] = SymbolParam(s + c1, i - c1);
+  if (i >= n || s[i] != 'x') {
+    return false;
+  }
+  ++i;
+  const int c2 = i;
+  while (i < n && ((s[i] >= '0' && s[i] <= '9') || s[i] == '.')) {
+    ++i;
+  }
+  if (i == c2) {
+    return false;
+  }
+  caps[2] = SymbolParam(s + c2, i - c2);
+  if (i >= n || s[i] != 'x') {
+    return false;
+  }
+  ++i;
+  const int c3 = i;
+  while (i < n && ((s[i] >= '0' && s[i] <= '9') || s[i] == '.')) {
+    ++i;
+  }
+  if (i == c3) {
+    return false;
+  }
+  caps[3] = SymbolParam(s + c3, i - c3);
+  if (i >= n || s[i] != 'x') {
+    return false;
+  }
+  ++i;
+  const int c4 = i;
+  while (i < n && ((s[i] >= '0' && s[i] <= '9') || s[i] == '.')) {
+    ++i;
+  }
+  if (i == c4) {
+    return false;
+  }
+  caps[4] = SymbolParam(s + c4, i - c4);
+  if (i >= n || s[i] != 'x') {
+    return false;
+  }
+  ++i;
+  const int c5 = i;
+  while (i < n && ((s[i] >= '0' && s[i] <= '9') || s[i] == '.')) {
+    ++i;
+  }
+  if (i == c5) {
+    return false;
+  }
+  caps[5] = SymbolParam(s + c5, i - c5);
+
+  caps[0] = SymbolParam(s, n);
+  return i == n;
+}
 
 RoundThermalSquareSymbol::RoundThermalSquareSymbol(const QString& def, const Polarity& polarity,
     const AttribData& attrib):
     Symbol(def, "ths([0-9.]+)x([0-9.]+)x([0-9.]+)x([0-9.]+)x([0-9.]+)", polarity, attrib), m_def(def)
 {
-  QRegularExpression rx(m_pattern);
-  QRegularExpressionMatch m = rx.match(def);
-  if (!m.hasMatch())
+  SymbolParam caps[6];
+  if (!parseDefinition(def, caps))
     throw InvalidSymbolException(def.toLatin1());
 
-  QStringList caps = m.capturedTexts();
   m_od = caps[1].toDouble() / 1000.0;
   m_id = caps[2].toDouble() / 1000.0;
   m_angle = caps[3].toDouble();
   m_num_spokes = caps[4].toInt();
   m_gap = caps[5].toDouble() / 1000.0;
 
-  m_bounding = painterPath().boundingRect();
+  m_bounding = QRectF(-m_od / 2, -m_od / 2, m_od, m_od);
 }
 
 QPainterPath RoundThermalSquareSymbol::painterPath(void)
@@ -58,11 +128,16 @@ QPainterPath RoundThermalSquareSymbol::painterPath(void)
   qreal _outer_start_angle = m_angle + _half_outer_gap_angle;
   qreal _outer_pie_angle = _pie_angle - 2 * _half_outer_gap_angle;
 
+  // Angles count counter-clockwise on screen, where y points down
+  qreal tolerance = ArcGeometry::tolerance();
   for( int pie_id= 0; pie_id != m_num_spokes; ++pie_id ){
-    path.arcMoveTo( -m_od / 2, -m_od / 2, m_od, m_od, _outer_start_angle );
-    path.arcTo( -m_od / 2, -m_od / 2, m_od, m_od, _outer_start_angle, _outer_pie_angle );
-    path.arcTo( -m_id / 2, -m_id / 2, m_id, m_id, _inner_start_angle + _inner_pie_angle, 0 );
-    path.arcTo( -m_id / 2, -m_id / 2, m_id, m_id, _inner_start_angle + _inner_pie_angle, -_inner_pie_angle );
+    QPolygonF ring;
+    ArcGeometry::appendArc(ring, QPointF(0, 0), m_od / 2,
+        -_outer_start_angle * D2R, -_outer_pie_angle * D2R, tolerance);
+    ArcGeometry::appendArc(ring, QPointF(0, 0), m_id / 2,
+        -(_inner_start_angle + _inner_pie_angle) * D2R,
+        _inner_pie_angle * D2R, tolerance);
+    path.addPolygon(ring);
     path.closeSubpath();
     _inner_start_angle += _pie_angle;
     _outer_start_angle += _pie_angle;
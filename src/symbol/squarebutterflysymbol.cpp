@@ -27,19 +27,40 @@
 #include "macros.h"
 
 
+static bool parseDefinition(const QString& def, SymbolParam* caps)
+{
+  const ushort* s = def.utf16();
+  const int n = def.length();
+  int i = 0;
+
+  if (n - i < 3 || s[i] != 'b' || s[i + 1] != 'f' || s[i + 2] != 's') {
+    return false;
+  }
+  i += 3;
+  const int c1 = i;
+  while (i < n && ((s[i] >= '0' && s[i] <= '9') || s[i] == '.')) {
+    ++i;
+  }
+  if (i == c1) {
+    return false;
+  }
+  caps[1] = SymbolParam(s + c1, i - c1);
+
+  caps[0] = SymbolParam(s, n);
+  return i == n;
+}
+
 SquareButterflySymbol::SquareButterflySymbol(const QString& def, const Polarity& polarity,
     const AttribData& attrib):
     Symbol(def, "bfs([0-9.]+)", polarity, attrib), m_def(def)
 {
-  QRegularExpression rx(m_pattern);
-  QRegularExpressionMatch m = rx.match(def);
-  if (!m.hasMatch())
+  SymbolParam caps[2];
+  if (!parseDefinition(def, caps))
     throw InvalidSymbolException(def.toLatin1());
 
-  QStringList caps = m.capturedTexts();
   m_s = caps[1].toDouble() / 1000.0;
 
-  m_bounding = painterPath().boundingRect();
+  m_bounding = QRectF(-m_s / 2, -m_s / 2, m_s, m_s);
 }
 
 QPainterPath SquareButterflySymbol::painterPath(void)
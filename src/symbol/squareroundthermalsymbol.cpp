@@ -26,25 +26,95 @@
 
 #include "macros.h"
 
-#include "context.h"
+#include "arcgeometry.h"
+
+static bool parseDefinition(const QString& def, SymbolParam* caps)
+{
+  const ushort* s = def.utf16();
+  const int n = def.length();
+  int i = 0;
+
+  if (n - i < 6 || s[i] != 's' || s[i + 1] != 'r' || s[i + 2] != '_' ||
+      s[i + 3] != 't' || s[i + 4] != 'h' || s[i + 5] != 's') {
+    return false;
+  }
+  i += 6;
+  const int c1 = i;
+  while (i < n && ((s[i] >= '0' && s[i] <= '9') || s[i] == '.')) {
+    ++i;
+  }
+  if (i == c1) {
+    return false;
+  }
+  caps[1] = SymbolParam(s + c1, i - c1);
+  if (i >= n || s[i] != 'x') {
+    return false;
+  }
+  ++i;
+  const int c2 = i;
+  while (i < n && ((s[i] >= '0' && s[i] <= '9') || s[i] == '.')) {
+    ++i;
+  }
+  if (i == c2) {
+    return false;
+  }
+  caps[2] = SymbolParam(s + c2, i - c2);
+  if (i >= n || s[i] != 'x') {
+    return false;
+  }
+  ++i;
+  const int c3 = i;
+  while (i < n && ((s[i] >= '0' && s[i] <= '9') || s[i] == '.')) {
+    ++i;
+  }
+  if (i == c3) {
+    return false;
+  }
+  caps[3] = SymbolParam(s + c3, i - c3);
+  if (i >= n || s[i] != 'x') {
+    return false;
+  }
+  ++i;
+  const int c4 = i;
+  while (i < n && ((s[i] >= '0' && s[i] <= '9') || s[i] == '.')) {
+    ++i;
+  }
+  if (i == c4) {
+    return false;
+  }
+  caps[4] = SymbolParam(s + c4, i - c4);
+  if (i >= n || s[i] != 'x') {
+    return false;
+  }
+  ++i;
+  const int c5 = i;
+  while (i < n && ((s[i] >= '0' && s[i] <= '9') || s[i] == '.')) {
+    ++i;
+  }
+  if (i == c5) {
+    return false;
+  }
+  caps[5] = SymbolParam(s + c5, i - c5);
+
+  caps[0] = SymbolParam(s, n);
+  return i == n;
+}
 
 SquareRoundThermalSymbol::SquareRoundThermalSymbol(const QString& def, const Polarity& polarity,
     const AttribData& attrib):
     Symbol(def, "sr_ths([0-9.]+)x([0-9.]+)x([0-9.]+)x([0-9.]+)x([0-9.]+)", polarity, attrib), m_def(def)
 {
-  QRegularExpression rx(m_pattern);
-  QRegularExpressionMatch m = rx.match(def);
-  if (!m.hasMatch())
+  SymbolParam caps[6];
+  if (!parseDefinition(def, caps))
     throw InvalidSymbolException(def.toLatin1());
 
-  QStringList caps = m.capturedTexts();
   m_od = caps[1].toDouble() / 1000.0;
   m_id = caps[2].toDouble() / 1000.0;
   m_angle = caps[3].toDouble();
   m_num_spokes = caps[4].toInt();
   m_gap = caps[5].toDouble() / 1000.0;
 
-  m_bounding = painterPath().boundingRect();
+  m_bounding = QRectF(-m_od / 2, -m_od / 2, m_od, m_od);
 }
 
 QPainterPath SquareRoundThermalSymbol::painterPath(void)
@@ -52,7 +122,9 @@ QPainterPath SquareRoundThermalSymbol::painterPath(void)
   QPainterPath path;
 
   path.addRect(-m_od / 2, -m_od / 2, m_od, m_od);
-  path.addEllipse(-m_id / 2, -m_id / 2, m_id, m_id);
+  path.addPolygon(ArcGeometry::circle(QPointF(0, 0), m_id / 2,
+      ArcGeometry::tolerance()));
+  path.closeSubpath();
 
   QPainterPath bar;
   bar.addRect(0, -m_gap / 2, m_od / qSqrt(1.8), m_gap);
@@ -76,18 +148,9 @@ QPainterPath SquareRoundThermalSymbol::painterPath(void)
   return path;
 }
 
-void SquareRoundThermalSymbol::paint(QPainter *painter,
-    const QStyleOptionGraphicsItem *, QWidget *)
+void SquareRoundThermalSymbol::drawShape(QPainter* painter,
+    const QPainterPath& path)
 {
-  if (m_polarity == P) {
-    painter->setClipPath(m_sub);
-    painter->setPen(m_pen);
-    painter->setBrush(m_brush);
-    painter->drawPath(painterPath());
-  } else {
-    painter->setClipPath(m_sub);
-    painter->setPen(QPen(ctx.bg_color, 0));
-    painter->setBrush(ctx.bg_color);
-    painter->drawPath(painterPath());
-  }
+  painter->setClipPath(m_sub);
+  painter->drawPath(path);
 }
@@ -38,7 +38,15 @@ SurfaceSymbol::SurfaceSymbol(const SurfaceRecord* rec):
   m_dcode = rec->dcode;
   m_polygons = rec->polygons;
 
-  m_bounding = painterPath().boundingRect();
+  for (QList<PolygonRecord*>::iterator it = m_polygons.begin();
+      it != m_polygons.end(); ++it) {
+    m_bounding |= (*it)->boundingRect();
+    if ((*it)->poly_type == PolygonRecord::I) {
+      ++m_islandCount;
+    } else {
+      ++m_holeCount;
+    }
+  }
 }
 
 QString SurfaceSymbol::infoText(void)
@@ -81,18 +89,9 @@ QPainterPath SurfaceSymbol::painterPath(void)
 {
   QPainterPath path;
 
-  m_islandCount = 0;
-  m_holeCount = 0;
-
   for (QList<PolygonRecord*>::iterator it = m_polygons.begin();
       it != m_polygons.end(); ++it) {
-    PolygonRecord* rec = (*it);
-    path.addPath(rec->painterPath());
-    if (rec->poly_type == PolygonRecord::I) {
-      ++m_islandCount;
-    } else {
-      ++m_holeCount;
-    }
+    path.addPath((*it)->painterPath());
   }
 
   return path;
@@ -38,6 +38,9 @@ public:
   virtual QString longInfoText(void);
   virtual QPainterPath painterPath(void);
 
+  /* Point at an identical record, e.g. of a re-parsed features file */
+  void rebind(const SurfaceRecord* rec) { m_polygons = rec->polygons; }
+
   //  NEW: Override getWidth() for trace filtering
   virtual qreal getWidth() const override;
   
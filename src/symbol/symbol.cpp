@@ -24,11 +24,86 @@
 
 #include <QDebug>
 #include <QGraphicsSceneMouseEvent>  
+#include <QStyleOptionGraphicsItem>
 
+#include "arcgeometry.h"
 #include "context.h"
 #include "odbppgraphicsscene.h"
 #include "graphicslayerscene.h"
 
+double SymbolParam::toDouble(void) const
+{
+  // Up to 15 digits both the mantissa and the power of ten are exact in a
+  // double, so the division rounds the same way QString::toDouble() does
+  static const double pow10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12,
+    1e13, 1e14, 1e15
+  };
+
+  qint64 mantissa = 0;
+  int digits = 0;
+  int decimals = -1;
+  for (int i = 0; i < m_size; ++i) {
+    ushort c = m_data[i];
+    if (c >= '0' && c <= '9') {
+      if (++digits > 15) {
+        return QString(*this).toDouble();
+      }
+      mantissa = mantissa * 10 + (c - '0');
+      if (decimals >= 0) {
+        ++decimals;
+      }
+    } else if (c == '.' && decimals < 0) {
+      decimals = 0;
+    } else {
+      return QString(*this).toDouble();
+    }
+  }
+  if (digits == 0) {
+    return QString(*this).toDouble();
+  }
+  return (decimals > 0)? mantissa / pow10[decimals]: double(mantissa);
+}
+
+int SymbolParam::toInt(void) const
+{
+  if (m_size == 0 || m_size > 9) {
+    return QString(*this).toInt();
+  }
+  int value = 0;
+  for (int i = 0; i < m_size; ++i) {
+    if (m_data[i] < '0' || m_data[i] > '9') {
+      return QString(*this).toInt();
+    }
+    value = value * 10 + (m_data[i] - '0');
+  }
+  return value;
+}
+
+QByteArray SymbolParam::toLatin1(void) const
+{
+  QByteArray result(m_size, Qt::Uninitialized);
+  for (int i = 0; i < m_size; ++i) {
+    result[i] = (m_data[i] < 256)? char(m_data[i]): '?';
+  }
+  return result;
+}
+
+SymbolParam::operator QString(void) const
+{
+  return QString(reinterpret_cast<const QChar*>(m_data), m_size);
+}
+
+bool SymbolParam::operator==(const char* str) const
+{
+  for (int i = 0; i < m_size; ++i) {
+    if (m_data[i] != (unsigned char)str[i]) {
+      return false;
+    }
+  }
+  return str[m_size] == '\0';
+}
+
 Symbol::Symbol(QString name, QString pattern, Polarity polarity,
     AttribData attr):
   m_name(name), m_pattern('^' + pattern + '$'), m_pen(QPen(Qt::red, 0)), m_brush(Qt::red),
@@ -136,7 +211,16 @@ void Symbol::paint(QPainter *painter, const QStyleOptionGraphicsItem */*option*/
     }
   }
 
-  painter->drawPath(painterPath());
+  // Curves only need to be as fine as the device pixels they land on
+  ArcGeometry::DrawTolerance tolerance(1.0 /
+      QStyleOptionGraphicsItem::levelOfDetailFromTransform(
+        painter->worldTransform()));
+  drawShape(painter, painterPath());
+}
+
+void Symbol::drawShape(QPainter* painter, const QPainterPath& path)
+{
+  painter->drawPath(path);
 }
 
 QPainterPath Symbol::painterPath(void)
@@ -167,27 +251,7 @@ void Symbol::mousePressEvent(QGraphicsSceneMouseEvent* event)
     return;
   }
 
-  Qt::KeyboardModifiers modifiers = event->modifiers();
-  bool selectConnected = (modifiers & Qt::ControlModifier);
-
-  if (selectConnected) {
-    s->selectConnectedSymbols(this);
-  } else {
-    if (m_selected) {
-      s->toggleSelection(this);
-    } else {
-      m_selected = true;
-      m_prevPen = m_pen;
-      m_prevBrush = m_brush;
-      
-      // UPDATED: Use dynamic highlight color from context
-      QColor highlightColor = ctx.highlight_color;
-      setPen(QPen(highlightColor, 0));
-      setBrush(highlightColor);
-      update();
-      s->toggleSelection(this);
-    }
-  }
+  s->pickSymbol(this, event->modifiers());
 }
 
 void Symbol::mouseDoubleClickEvent(QGraphicsSceneMouseEvent* /*event*/)
@@ -46,6 +46,28 @@ private:
   const char* m_msg;
 };
 
+/**
+ * A parameter captured from a symbol definition by the generated parsers.
+ * It points into the definition string, which must outlive it, so decoding
+ * a definition does not allocate.
+ */
+class SymbolParam {
+public:
+  SymbolParam(): m_data(NULL), m_size(0) {}
+  SymbolParam(const ushort* data, int size): m_data(data), m_size(size) {}
+
+  int length(void) const { return m_size; }
+  double toDouble(void) const;
+  int toInt(void) const;
+  QByteArray toLatin1(void) const;
+  operator QString(void) const;
+  bool operator==(const char* str) const;
+
+private:
+  const ushort* m_data;
+  int m_size;
+};
+
 class Symbol: public virtual QGraphicsItem {
 public:
   Symbol(QString name, QString pattern = QString(), Polarity polarity = P,
@@ -56,6 +78,8 @@ public:
   virtual QString infoText(void);
   virtual QString longInfoText(void);
   AttribData attrib(void);
+  Polarity polarity(void) const { return m_polarity; }
+  const QBrush& brush(void) const { return m_brush; }
 
   virtual void setPen(const QPen& pen);
   virtual void setBrush(const QBrush& brush);
@@ -93,6 +117,9 @@ public:
   virtual QRectF boundingRect() const;
   virtual void paint(QPainter *painter, const QStyleOptionGraphicsItem *option,
       QWidget *widget);
+
+  /* Draw path, the symbol's painterPath(), with the pen and brush set up */
+  virtual void drawShape(QPainter* painter, const QPainterPath& path);
   virtual QPainterPath shape() const {
     return const_cast<Symbol*>(this)->painterPath();
   };
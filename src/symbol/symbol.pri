@@ -13,6 +13,7 @@ HEADERS += \
   symbol/octagonsymbol.h \
   symbol/originsymbol.h \
   symbol/ovalsymbol.h \
+  symbol/padsymbol.h \
   symbol/rectanglesymbol.h \
   symbol/rectangularthermalopencornerssymbol.h \
   symbol/rectangularthermalsymbol.h \
@@ -50,6 +51,7 @@ SOURCES += \
   symbol/octagonsymbol.cpp \
   symbol/originsymbol.cpp \
   symbol/ovalsymbol.cpp \
+  symbol/padsymbol.cpp \
   symbol/rectanglesymbol.cpp \
   symbol/rectangularthermalopencornerssymbol.cpp \
   symbol/rectangularthermalsymbol.cpp \
@@ -62,6 +64,7 @@ SOURCES += \
   symbol/squarethermalopencornerssymbol.cpp \
   symbol/squarethermalsymbol.cpp \
   symbol/symbol.cpp \
+  symbol/symbolfactory.cpp \
   symbol/verticalhexagonsymbol.cpp \
   symbol/trianglesymbol.cpp \
   symbol/usersymbol.cpp \
@@ -0,0 +1,239 @@
+/**
+ * @file   symbolfactory.cpp
+ * @author Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ *
+ * Copyright (C) 2012 - 2014 Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ * All Rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "symbolfactory.h"
+
+Symbol* SymbolFactory::create(const QString& def, const Polarity& polarity,
+    const AttribData& attrib)
+{
+  Symbol* symbol = createStandard(def, polarity, attrib);
+  if (!symbol) {
+    symbol = new UserSymbol(def, polarity, attrib);
+  }
+  return symbol;
+}
+
+Symbol* SymbolFactory::createStandard(const QString& def,
+    const Polarity& polarity, const AttribData& attrib)
+{
+  // Standard symbols are a lower case name followed by their parameters,
+  // anything else is a user defined symbol
+  const ushort* s = def.utf16();
+  int n = 0;
+  while (n < def.length() && ((s[n] >= 'a' && s[n] <= 'z') || s[n] == '_' ||
+        s[n] == '+')) {
+    ++n;
+  }
+
+  if (n > 0) {
+    try {
+      switch (s[0]) {
+      case 'b':
+        if (s[1] == 'f') {
+          switch (s[2]) {
+          case 'r':
+            if (n == 3) {
+              return new ButterflySymbol(def, polarity, attrib);
+            }
+            break;
+          case 's':
+            if (n == 3) {
+              return new SquareButterflySymbol(def, polarity, attrib);
+            }
+            break;
+          }
+        }
+        break;
+      case 'd':
+        switch (s[1]) {
+        case 'i':
+          if (n == 2) {
+            return new DiamondSymbol(def, polarity, attrib);
+          }
+          break;
+        case 'o':
+          if (s[2] == 'n' && s[3] == 'u' && s[4] == 't' && s[5] == '_') {
+            switch (s[6]) {
+            case 'r':
+              if (n == 7) {
+                return new DonutRSymbol(def, polarity, attrib);
+              }
+              break;
+            case 's':
+              if (n == 7) {
+                return new DonutSSymbol(def, polarity, attrib);
+              }
+              break;
+            }
+          }
+          break;
+        }
+        break;
+      case 'e':
+        if (s[1] == 'l' && n == 2) {
+          return new EllipseSymbol(def, polarity, attrib);
+        }
+        break;
+      case 'h':
+        switch (s[1]) {
+        case 'e':
+          if (s[2] == 'x' && s[3] == '_') {
+            switch (s[4]) {
+            case 'l':
+              if (n == 5) {
+                return new HorizontalHexagonSymbol(def, polarity, attrib);
+              }
+              break;
+            case 's':
+              if (n == 5) {
+                return new VerticalHexagonSymbol(def, polarity, attrib);
+              }
+              break;
+            }
+          }
+          break;
+        case 'o':
+          if (s[2] == 'l' && s[3] == 'e' && n == 4) {
+            return new HoleSymbol(def, polarity, attrib);
+          }
+          break;
+        }
+        break;
+      case 'm':
+        if (s[1] == 'o' && s[2] == 'i' && s[3] == 'r' && s[4] == 'e' &&
+            n == 5) {
+          return new MoireSymbol(def, polarity, attrib);
+        }
+        break;
+      case 'n':
+        if (s[1] == 'u' && s[2] == 'l' && s[3] == 'l' && n == 4) {
+          return new NullSymbol(def, polarity, attrib);
+        }
+        break;
+      case 'o':
+        switch (s[1]) {
+        case 'c':
+          if (s[2] == 't' && n == 3) {
+            return new OctagonSymbol(def, polarity, attrib);
+          }
+          break;
+        case 'v':
+          if (s[2] == 'a' && s[3] == 'l') {
+            if (n == 4) {
+              return new OvalSymbol(def, polarity, attrib);
+            }
+            if (s[4] == '_' && s[5] == 'h' && n == 6) {
+              return new HalfOvalSymbol(def, polarity, attrib);
+            }
+          }
+          break;
+        }
+        break;
+      case 'r':
+        if (n == 1) {
+          return new RoundSymbol(def, polarity, attrib);
+        }
+        switch (s[1]) {
+        case 'c':
+          if (s[2] == '_' && s[3] == 't' && s[4] == 'h') {
+            switch (s[5]) {
+            case 'o':
+              if (n == 6) {
+                return new RectangularThermalOpenCornersSymbol(def,
+                    polarity, attrib);
+              }
+              break;
+            case 's':
+              if (n == 6) {
+                return new RectangularThermalSymbol(def, polarity, attrib);
+              }
+              break;
+            }
+          }
+          break;
+        case 'e':
+          if (s[2] == 'c' && s[3] == 't' && n == 4) {
+            return new RectangleSymbol(def, polarity, attrib);
+          }
+          break;
+        }
+        break;
+      case 's':
+        if (n == 1) {
+          return new SquareSymbol(def, polarity, attrib);
+        }
+        switch (s[1]) {
+        case '_':
+          if (s[2] == 't' && s[3] == 'h') {
+            switch (s[4]) {
+            case 'o':
+              if (n == 5) {
+                return new SquareThermalOpenCornersSymbol(def,
+                    polarity, attrib);
+              }
+              break;
+            case 's':
+              if (n == 5) {
+                return new SquareThermalSymbol(def, polarity, attrib);
+              }
+              break;
+            }
+          }
+          break;
+        case 'r':
+          if (s[2] == '_' && s[3] == 't' && s[4] == 'h' && s[5] == 's' &&
+              n == 6) {
+            return new SquareRoundThermalSymbol(def, polarity, attrib);
+          }
+          break;
+        }
+        break;
+      case 't':
+        switch (s[1]) {
+        case 'h':
+          switch (s[2]) {
+          case 'r':
+            if (n == 3) {
+              return new RoundThermalRoundSymbol(def, polarity, attrib);
+            }
+            break;
+          case 's':
+            if (n == 3) {
+              return new RoundThermalSquareSymbol(def, polarity, attrib);
+            }
+            break;
+          }
+          break;
+        case 'r':
+          if (s[2] == 'i' && n == 3) {
+            return new TriangleSymbol(def, polarity, attrib);
+          }
+          break;
+        }
+        break;
+      }
+    } catch (InvalidSymbolException&) {
+    }
+  }
+
+  return NULL;
+}
@@ -28,7 +28,7 @@
 #include "context.h"
 
 TextSymbol::TextSymbol(const TextRecord* rec):
-  Symbol("Text", "Text")
+  Symbol("Text", "Text"), m_fontDs(NULL)
 {
   if (rec == NULL) {
     return;
@@ -46,7 +46,10 @@ TextSymbol::TextSymbol(const TextRecord* rec):
   m_version = rec->version;
   m_attrib = rec->attrib;
 
-  m_bounding = painterPath().boundingRect();
+  FontDataStore* ds = fontDataStore();
+  if (ds) {
+    m_bounding = ds->layoutBounds(m_text, m_xsize, m_ysize, m_width_factor);
+  }
 }
 
 QString TextSymbol::infoText(void)
@@ -76,32 +79,26 @@ QString TextSymbol::longInfoText(void)
     .arg(m_font);
 }
 
-QPainterPath TextSymbol::painterPath(void)
+FontDataStore* TextSymbol::fontDataStore(void)
 {
-  QPainterPath path;
-
-  path.setFillRule(Qt::WindingFill);
+  // Barcodes set the font after construction, so remember which font the
+  // data store was looked up for
+  if (!m_fontDs || m_fontName != m_font) {
+    m_fontName = m_font;
+    m_fontDs = CachedFontParser::parse(ctx.loader->dataPath("fonts/" +
+          m_font));
+  }
+  return m_fontDs;
+}
 
-  QString filename = ctx.loader->absPath("fonts/" + m_font);
-  FontDataStore* ds = CachedFontParser::parse(filename);
-  if (!ds)
+QPainterPath TextSymbol::painterPath(void)
+{
+  FontDataStore* ds = fontDataStore();
+  if (!ds) {
+    QPainterPath path;
+    path.setFillRule(Qt::WindingFill);
     return path;
-
-  QTransform mat(m_xsize / ds->xsize(), 0, 0, m_ysize / ds->ysize(), 0, 0);
-
-  for (int i = 0; i < m_text.length(); ++i) {
-    CharRecord* rec = ds->charRecord(m_text[i].toLatin1());
-    if (rec) {
-      QPainterPath p = mat.map(rec->painterPath(m_width_factor));
-      path.addPath(p);
-    }
-    mat.translate(ds->xsize() + ds->offset(), 0);
   }
 
-  QRectF b = path.boundingRect();
-  QTransform mat2;
-  mat2.translate(-b.x(), -(b.y() + b.height()));
-  path = mat2.map(path);
-
-  return path;
+  return ds->layout(m_text, m_xsize, m_ysize, m_width_factor);
 }
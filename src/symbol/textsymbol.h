@@ -39,6 +39,8 @@ public:
   virtual QPainterPath painterPath(void);
 
 protected:
+  FontDataStore* fontDataStore(void);
+
   qreal m_x, m_y;
   QString m_font;
   Orient m_orient;
@@ -46,6 +48,10 @@ protected:
   qreal m_width_factor;
   QString m_text;
   int m_version;
+
+private:
+  FontDataStore* m_fontDs;
+  QString m_fontName;
 };
 
 #endif /* __TEXTSYMBOL_H__ */
@@ -26,25 +26,81 @@
 
 #include "cachedparser.h"
 #include "context.h"
+#include "polygonboolean.h"
+#include "symbolpool.h"
+
+/* Grid the polarity of user symbol features is resolved on */
+#define USER_SYMBOL_RESOLUTION 1e-6
 
 UserSymbol::UserSymbol(const QString& def, const Polarity& polarity,
     const AttribData& attrib):
-  Symbol(def, def, polarity, attrib), m_def(def)
+  Symbol(def, def, polarity, attrib), m_def(def),
+  m_geometry(SYMBOLPOOL->geometry(def))
+{
+  m_bounding = m_geometry->bounding;
+}
+
+UserSymbol::~UserSymbol()
+{
+}
+
+QPainterPath UserSymbol::painterPath(void)
+{
+  return m_geometry->painterPath();
+}
+
+QPainterPath UserSymbol::compile(const QString& def)
 {
+  QPainterPath result;
+  result.setFillRule(Qt::OddEvenFill);
+
   QString path = ctx.loader->featuresPath("symbols/" + def);
   FeaturesDataStore* ds = CachedFeaturesParser::parse(path);
-  
-  if (ds)
-    for (QList<Record*>::const_iterator it = ds->records().begin();
-        it != ds->records().end(); ++it) {
-      Symbol* symbol = (*it)->createSymbol();
-      addChild(symbol);
-      m_symbols.append(symbol);
+  if (!ds) {
+    return result;
+  }
+
+  // Features are resolved in file order, so a negative feature only erases
+  // what was drawn before it
+  const qreal scale = 1.0 / USER_SYMBOL_RESOLUTION;
+  QVector<PolygonBoolean::Subject> subjects;
+  for (QList<Record*>::const_iterator it = ds->records().begin();
+      it != ds->records().end(); ++it) {
+    Symbol* symbol = (*it)->createSymbol();
+    if (!symbol) {
+      continue;
     }
 
-  setHandlesChildEvents(true);
-}
+    QPainterPath shape = symbol->painterPath();
+    // Odd-even filling of overlapping subpaths would punch holes
+    if (shape.fillRule() == Qt::WindingFill) {
+      shape = shape.simplified();
+    }
+    PolygonBoolean::Subject subject;
+    subject.positive = (symbol->polarity() == P);
+    foreach (const QPolygonF& polygon,
+        shape.toSubpathPolygons(symbol->sceneTransform())) {
+      PolygonBoolean::IntPath ring = PolygonBoolean::toIntPath(polygon,
+          scale);
+      if (ring.size() >= 3) {
+        subject.rings.append(ring);
+      }
+    }
+    if (!subject.rings.isEmpty()) {
+      subjects.append(subject);
+    }
+    delete symbol;
+  }
 
-UserSymbol::~UserSymbol()
-{
+  foreach (const PolygonBoolean::Polygon& polygon,
+      PolygonBoolean::flatten(subjects)) {
+    result.addPolygon(PolygonBoolean::toPolygonF(polygon.outer, scale));
+    result.closeSubpath();
+    for (int i = 0; i < polygon.holes.size(); ++i) {
+      result.addPolygon(PolygonBoolean::toPolygonF(polygon.holes[i], scale));
+      result.closeSubpath();
+    }
+  }
+
+  return result;
 }
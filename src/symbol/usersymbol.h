@@ -27,15 +27,26 @@
 
 #include "record.h"
 
+struct SymbolGeometry;
+
+/**
+ * A symbol defined in the job's symbols directory.  The features are
+ * compiled once per definition into a path shared through SymbolPool.
+ */
 class UserSymbol: public Symbol {
 public:
   UserSymbol(const QString& def, const Polarity& polarity,
     const AttribData& attrib);
   virtual ~UserSymbol();
 
+  virtual QPainterPath painterPath(void);
+
+  /* Area covered by the features of def, with negative features erased */
+  static QPainterPath compile(const QString& def);
+
 private:
   QString m_def;
-  qreal m_d;
+  const SymbolGeometry* m_geometry;
 };
 
 #endif /* __USERSYMBOL_H__ */
@@ -22,9 +22,12 @@
 
 #include "symbolpool.h"
 
+#include "arcgeometry.h"
+#include "context.h"
+
 SymbolPool* SymbolPool::m_instance = NULL;
 
-SymbolPool::SymbolPool()
+SymbolPool::SymbolPool(): m_loader(NULL)
 {
 
 }
@@ -35,6 +38,11 @@ SymbolPool::~SymbolPool()
       it != m_cache.end(); ++it) {
     delete it.value();
   }
+  foreach (SymbolGeometry* geometry, m_geometry) {
+    delete geometry->shape;
+    delete geometry;
+  }
+  qDeleteAll(m_retired);
   m_instance = NULL;
 }
 
@@ -61,3 +69,72 @@ Symbol* SymbolPool::get(const QString& def, const Polarity& polarity,
 
   return symbol;
 }
+
+const SymbolGeometry* SymbolPool::geometry(const QString& def)
+{
+  // User symbols belong to the job they were compiled from.  Pads of the
+  // previous job may still be on screen, so their entries are kept alive
+  if (ctx.loader != m_loader) {
+    QHash<QString, SymbolGeometry*>::iterator it = m_geometry.begin();
+    while (it != m_geometry.end()) {
+      if (!it.value()->shape) {
+        m_retired.append(it.value());
+        it = m_geometry.erase(it);
+      } else {
+        ++it;
+      }
+    }
+    m_loader = ctx.loader;
+  }
+
+  QHash<QString, SymbolGeometry*>::const_iterator found =
+    m_geometry.find(def);
+  if (found != m_geometry.end()) {
+    return found.value();
+  }
+
+  // The entry goes in before a user symbol is compiled, so a symbol that
+  // refers to itself sees an empty shape instead of recursing forever
+  SymbolGeometry* geometry = new SymbolGeometry;
+  geometry->shape = SymbolFactory::createStandard(def, P, AttribData());
+  // Standard outlines are only built when first drawn, see painterPath()
+  m_geometry.insert(def, geometry);
+
+  if (geometry->shape) {
+    geometry->bounding = geometry->shape->boundingRect();
+  } else {
+    geometry->path = UserSymbol::compile(def);
+    geometry->bounding = geometry->path.boundingRect();
+  }
+  return geometry;
+}
+
+void SymbolPool::releaseUserSymbols(void)
+{
+  QHash<QString, SymbolGeometry*>::iterator it = m_geometry.begin();
+  while (it != m_geometry.end()) {
+    if (!it.value()->shape) {
+      delete it.value();
+      it = m_geometry.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  qDeleteAll(m_retired);
+  m_retired.clear();
+  m_loader = NULL;
+}
+
+const QPainterPath& SymbolGeometry::painterPath(void) const
+{
+  if (!shape) {
+    return path;
+  }
+
+  int band = ArcGeometry::currentBand();
+  QHash<int, QPainterPath>::const_iterator it = bands.find(band);
+  if (it == bands.end()) {
+    it = bands.insert(band, shape->painterPath());
+  }
+  return it.value();
+}
@@ -24,8 +24,30 @@
 #define __SYMBOL_POOL_H__
 
 #include "symbolfactory.h"
+#include <QHash>
+#include <QList>
 #include <QMap>
 
+class ArchiveLoader;
+
+/**
+ * Geometry of a symbol, shared by every pad using the same definition.
+ * Standard symbol entries live as long as the pool, user symbol entries
+ * until releaseUserSymbols().  The bounding box of a standard symbol
+ * comes straight from its parameters; its outline is only built once a pad
+ * using it is drawn, once per ArcGeometry tolerance band.
+ */
+struct SymbolGeometry {
+  Symbol* shape;        /* draws standard symbols, NULL for user symbols */
+  QRectF bounding;
+
+  /* Outline at the current ArcGeometry tolerance */
+  const QPainterPath& painterPath(void) const;
+
+  QPainterPath path;    /* compiled outline of a user symbol */
+  mutable QHash<int, QPainterPath> bands;
+};
+
 class SymbolPool {
 public:
   static SymbolPool* instance();
@@ -34,11 +56,23 @@ public:
   Symbol* get(const QString& def, const Polarity& polarity,
     const AttribData& attrib);
 
+  /**
+   * Shared geometry of def.  Anything that is not a standard symbol is
+   * compiled from the job's symbols directory, see UserSymbol::compile().
+   */
+  const SymbolGeometry* geometry(const QString& def);
+
+  /* Free user symbol geometry, once no pad of any job is left */
+  void releaseUserSymbols(void);
+
 private:
   SymbolPool();
 
   static SymbolPool* m_instance;
   QMap<QString, Symbol*> m_cache;
+  QHash<QString, SymbolGeometry*> m_geometry;
+  QList<SymbolGeometry*> m_retired;
+  ArchiveLoader* m_loader;
 };
 
 #define SYMBOLPOOL (SymbolPool::instance())
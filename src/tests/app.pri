@@ -0,0 +1,33 @@
+# Every application source except main.cpp, for the tests that need the
+# parser, symbol and view code together.
+
+QT += network
+
+include (../parser/parser.pri)
+include (../symbol/symbol.pri)
+include (../geometry/geometry.pri)
+include (../archive/archive.pri)
+include (../graphicsview/graphicsview.pri)
+include (../gui/gui.pri)
+include (../restapi/restapi.pri)
+
+HEADERS += \
+  archiveloader.h \
+  context.h \
+  jobindex.h \
+  jobwatcher.h \
+  logger.h \
+  macros.h \
+  settings.h \
+  symbolpool.h
+
+SOURCES += \
+  archiveloader.cpp \
+  context.cpp \
+  jobindex.cpp \
+  jobwatcher.cpp \
+  settings.cpp \
+  symbolpool.cpp
+
+RESOURCES += \
+  resources.qrc
@@ -0,0 +1,242 @@
+/**
+ * @file   test_arc_geometry.cpp
+ * @author Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ *
+ * Copyright (C) 2012 - 2014 Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ * All Rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <QtCore/qmath.h>
+
+#include <limits>
+
+#include "arcgeometry.h"
+#include "testcheck.h"
+
+using namespace ArcGeometry;
+
+#define EPSILON 1e-12
+
+static bool sameRect(const QRectF& a, qreal x, qreal y, qreal w, qreal h)
+{
+  return std::fabs(a.x() - x) < EPSILON && std::fabs(a.y() - y) < EPSILON &&
+    std::fabs(a.width() - w) < EPSILON &&
+    std::fabs(a.height() - h) < EPSILON;
+}
+
+static qreal distance(const QPointF& a, const QPointF& b)
+{
+  return qSqrt((a.x() - b.x()) * (a.x() - b.x()) +
+      (a.y() - b.y()) * (a.y() - b.y()));
+}
+
+static bool isPowerOfTwo(int n)
+{
+  return n > 0 && (n & (n - 1)) == 0;
+}
+
+/*
+ * Every point of ring is on the circle, and the middle of every chord is
+ * within tolerance of it
+ */
+static bool onCircle(const QPolygonF& ring, const QPointF& c, qreal r,
+    qreal tolerance)
+{
+  for (int i = 0; i < ring.size(); ++i) {
+    if (std::fabs(distance(ring[i], c) - r) > 1e-9) {
+      return false;
+    }
+    if (i > 0) {
+      QPointF mid = (ring[i - 1] + ring[i]) / 2;
+      if (r - distance(mid, c) > tolerance + 1e-12) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+static void testBounds(void)
+{
+  // Quarter arcs either way round
+  CHECK(sameRect(bounds(1, 0, 0, 1, 0, 0, false), 0, 0, 1, 1));
+  CHECK(sameRect(bounds(1, 0, 0, 1, 0, 0, true), -1, -1, 2, 2));
+  CHECK(sameRect(bounds(0, 1, 1, 0, 0, 0, true), 0, 0, 1, 1));
+  CHECK(sameRect(bounds(3, 2, 2, 3, 2, 2, false), 2, 2, 1, 1));
+
+  // Half arcs, and arcs starting or ending on an axis
+  CHECK(sameRect(bounds(1, 0, -1, 0, 0, 0, false), -1, 0, 2, 1));
+  CHECK(sameRect(bounds(1, 0, -1, 0, 0, 0, true), -1, -1, 2, 1));
+  CHECK(sameRect(bounds(0, 1, -1, 0, 0, 0, false), -1, 0, 1, 1));
+
+  // A short arc crossing no axis is the box of its end points
+  qreal c = qCos(0.2), s = qSin(0.2);
+  QRectF box = bounds(c, s, s, c, 0, 0, false);
+  CHECK(sameRect(box, s, s, c - s, c - s));
+
+  // Equal end points are a full circle
+  CHECK(sameRect(bounds(0.3, 0.4, 0.3, 0.4, 0, 0, false), -0.5, -0.5, 1,
+        1));
+  CHECK(sameRect(bounds(0.3, 0.4, 0.3, 0.4, 0, 0, true), -0.5, -0.5, 1, 1));
+
+  CHECK(sameRect(flipped(QRectF(0, 0, 1, 2)), 0, -2, 1, 2));
+  CHECK(sameRect(flipped(QRectF(-1, -3, 2, 1)), -1, 2, 2, 1));
+}
+
+static void testCircleSteps(void)
+{
+  CHECK(circleSteps(1e-5, 1e-4) == 4);
+  CHECK(circleSteps(1e-4, 1e-4) == 4);
+
+  int last = 4;
+  for (qreal tolerance = 1e-1; tolerance > 1e-9; tolerance /= 3) {
+    int n = circleSteps(1, tolerance);
+    CHECK(isPowerOfTwo(n) && n >= last);
+    // The chords keep within tolerance, unless the table ran out
+    CHECK(1 - qCos(M_PI / n) <= tolerance || n == 8192);
+    // and the next coarser grid would not have
+    CHECK(n == 4 || 1 - qCos(2 * M_PI / n) > tolerance);
+    last = n;
+  }
+  CHECK(last == 8192);
+
+  // Coarser grids are subsets of finer ones
+  QPolygonF coarse = circle(QPointF(0, 0), 1, 1e-2);
+  QPolygonF fine = circle(QPointF(0, 0), 1, 1e-3);
+  CHECK(coarse.size() * 2 <= fine.size());
+  int ratio = fine.size() / coarse.size();
+  for (int i = 0; i < coarse.size(); ++i) {
+    CHECK(coarse[i] == fine[i * ratio]);
+  }
+}
+
+static void testCircle(void)
+{
+  QPointF c(2, -1);
+  QPolygonF ring = circle(c, 0.5, 1e-4);
+  CHECK(ring.size() == circleSteps(0.5, 1e-4));
+  CHECK(onCircle(ring, c, 0.5, 1e-4));
+  CHECK(ring.first() == QPointF(2.5, -1));
+  CHECK_NEAR(ring[ring.size() / 4].x(), 2, EPSILON);
+  CHECK_NEAR(ring[ring.size() / 4].y(), -0.5, EPSILON);
+  CHECK(ring.first() != ring.last());
+}
+
+static void testRecordArc(void)
+{
+  const qreal tolerance = 1e-4;
+  unsigned seed = 7;
+  for (int i = 0; i < 200; ++i) {
+    seed = seed * 1664525u + 1013904223u;
+    qreal a = (seed >> 8) * (2 * M_PI / (1 << 24));
+    seed = seed * 1664525u + 1013904223u;
+    qreal b = (seed >> 8) * (2 * M_PI / (1 << 24));
+    qreal r = 0.01 + (seed & 0xff) / 64.0;
+    bool cw = seed & 0x100;
+
+    qreal sx = 1 + r * qCos(a), sy = 2 + r * qSin(a);
+    qreal ex = 1 + r * qCos(b), ey = 2 + r * qSin(b);
+    QPolygonF ring;
+    ring << QPointF(9, 9);
+    appendRecordArc(ring, sx, sy, ex, ey, 1, 2, cw, tolerance);
+
+    // Appended after what was there, end points exact and flipped
+    CHECK(ring.size() >= 3 && ring.first() == QPointF(9, 9));
+    CHECK(ring[1] == QPointF(sx, -sy));
+    CHECK(ring.last() == QPointF(ex, -ey));
+    ring.removeFirst();
+    CHECK(onCircle(ring, QPointF(1, -2), r, tolerance));
+
+    // Every point lies in the exact box
+    QRectF box = flipped(bounds(sx, sy, ex, ey, 1, 2, cw));
+    box.adjust(-1e-9, -1e-9, 1e-9, 1e-9);
+    bool inside = true;
+    for (int k = 0; k < ring.size(); ++k) {
+      inside = inside && box.contains(ring[k]);
+    }
+    CHECK(inside);
+  }
+
+  // Quarter arc counter-clockwise in ODB++ space turns the other way on
+  // screen
+  QPolygonF quarter;
+  appendRecordArc(quarter, 1, 0, 0, 1, 0, 0, false, 1e-2);
+  CHECK(quarter.first() == QPointF(1, 0) && quarter.last() == QPointF(0, -1));
+  for (int k = 1; k < quarter.size(); ++k) {
+    CHECK(quarter[k].x() <= quarter[k - 1].x());
+    CHECK(quarter[k].y() <= quarter[k - 1].y());
+  }
+  CHECK(quarter.size() == circleSteps(1, 1e-2) / 4 + 1);
+}
+
+static void testBands(void)
+{
+  CHECK(bandTolerance(0) == 1);
+  CHECK(bandTolerance(10) == 1.0 / 1024);
+
+  // A quarter pixel rounded down to a power of two, within the bands
+  CHECK(pixelBand(1.0 / 1024) == 12);
+  CHECK(pixelBand(0.75 / 1024) == 13);
+  CHECK(pixelBand(1) == MIN_BAND);
+  CHECK(pixelBand(1e6) == MIN_BAND);
+  CHECK(pixelBand(1e-30) == MAX_BAND);
+  CHECK(pixelBand(0) == MAX_BAND);
+  CHECK(pixelBand(std::numeric_limits<qreal>::quiet_NaN()) == MIN_BAND);
+  for (qreal pixel = 1e-6; pixel < 1e-2; pixel *= 1.37) {
+    int band = pixelBand(pixel);
+    CHECK(bandTolerance(band) <= pixel / 4);
+    CHECK(band == MIN_BAND || bandTolerance(band - 1) > pixel / 4);
+  }
+
+  // Painting scopes nest and restore the configured tolerance
+  qreal configured = tolerance();
+  CHECK(currentBand() == -1);
+  {
+    DrawTolerance outer(1.0 / 1024);
+    CHECK(currentBand() == 12);
+    CHECK(tolerance() == bandTolerance(12));
+    {
+      DrawTolerance inner(1);
+      CHECK(currentBand() == MIN_BAND);
+      CHECK(tolerance() == bandTolerance(MIN_BAND));
+    }
+    CHECK(currentBand() == 12);
+  }
+  CHECK(currentBand() == -1);
+  CHECK(tolerance() == configured);
+
+  setTolerance(0);
+  CHECK(tolerance() == configured);
+  setTolerance(1e-3);
+  CHECK(tolerance() == 1e-3);
+  {
+    DrawTolerance scope(1.0 / 1024);
+    CHECK(tolerance() == bandTolerance(12));
+  }
+  CHECK(tolerance() == 1e-3);
+  setTolerance(configured);
+}
+
+int main(void)
+{
+  testBounds();
+  testCircleSteps();
+  testCircle();
+  testRecordArc();
+  testBands();
+  return testFailures;
+}
@@ -0,0 +1,7 @@
+TARGET = test_arc_geometry
+
+include (tests.pri)
+
+SOURCES += \
+  tests/test_arc_geometry.cpp \
+  geometry/arcgeometry.cpp
@@ -0,0 +1,180 @@
+/**
+ * @file   test_code39.cpp
+ * @author Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ *
+ * Copyright (C) 2012 - 2014 Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ * All Rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <QByteArray>
+#include <QString>
+
+#include "code39.h"
+#include "testcheck.h"
+
+/* Symbol width including the gap after it */
+#define SYMBOL_LENGTH 10
+
+static const char* const CODE39_CHARS =
+  "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ-. $/+%";
+
+/* Symbol at position i of an encoded pattern, without its gap */
+static QByteArray symbolAt(const QByteArray& pattern, int i)
+{
+  return pattern.mid(i * SYMBOL_LENGTH, SYMBOL_LENGTH - 1);
+}
+
+/* Character whose symbol is symbol, 0 if there is none */
+static char decodeSymbol(const QByteArray& symbol)
+{
+  for (const char* c = CODE39_CHARS; *c; ++c) {
+    if (symbolAt(Code39::encode(QString(QChar(*c))), 1) == symbol) {
+      return *c;
+    }
+  }
+  return 0;
+}
+
+/* Inverse of the full ASCII shift pairs, straight from the standard */
+static QString decodeFullAscii(const QByteArray& text)
+{
+  QString result;
+  for (int i = 0; i < text.size(); ++i) {
+    char c = text[i];
+    char n = (i + 1 < text.size())? text[i + 1]: 0;
+    int code = -1;
+    if (c == '$' && n >= 'A' && n <= 'Z') {
+      code = n - 'A' + 1;
+    } else if (c == '%' && n >= 'A' && n <= 'E') {
+      code = n - 'A' + 27;
+    } else if (c == '%' && n >= 'F' && n <= 'J') {
+      code = n - 'F' + 59;
+    } else if (c == '%' && n >= 'K' && n <= 'O') {
+      code = n - 'K' + 91;
+    } else if (c == '%' && n >= 'P' && n <= 'T') {
+      code = n - 'P' + 123;
+    } else if (c == '%' && n == 'U') {
+      code = 0;
+    } else if (c == '%' && n == 'V') {
+      code = 64;
+    } else if (c == '%' && n == 'W') {
+      code = 96;
+    } else if (c == '/' && n >= 'A' && n <= 'O') {
+      code = n - 'A' + 33;
+    } else if (c == '/' && n == 'Z') {
+      code = 58;
+    } else if (c == '+' && n >= 'A' && n <= 'Z') {
+      code = n - 'A' + 97;
+    }
+    if (code >= 0) {
+      result.append(QChar(code));
+      ++i;
+    } else {
+      result.append(QChar(c));
+    }
+  }
+  return result;
+}
+
+/* Characters between the start and stop symbols of pattern */
+static QByteArray decode(const QByteArray& pattern)
+{
+  QByteArray text;
+  int count = (pattern.size() + 1) / SYMBOL_LENGTH;
+  for (int i = 1; i < count - 1; ++i) {
+    text.append(decodeSymbol(symbolAt(pattern, i)));
+  }
+  return text;
+}
+
+/* Five bars and four spaces, three of them wide, then a narrow gap */
+static bool wellFormed(const QByteArray& pattern)
+{
+  if ((pattern.size() + 1) % SYMBOL_LENGTH != 0) {
+    return false;
+  }
+  int count = (pattern.size() + 1) / SYMBOL_LENGTH;
+  for (int i = 0; i < count; ++i) {
+    QByteArray symbol = symbolAt(pattern, i);
+    int wide = 0;
+    for (int k = 0; k < symbol.size(); ++k) {
+      char e = symbol[k];
+      bool bar = (k % 2 == 0);
+      if (bar? (e != 'N' && e != 'W'): (e != 'n' && e != 'w')) {
+        return false;
+      }
+      wide += (e == 'W' || e == 'w');
+    }
+    if (wide != 3 || (i + 1 < count && pattern[i * SYMBOL_LENGTH + 9] !=
+          'w')) {
+      return false;
+    }
+  }
+  return true;
+}
+
+int main(void)
+{
+  Code39::initPatterns();
+  Code39::initPatterns();
+
+  // Start and stop symbols only
+  CHECK(Code39::encode("") == "NwNnWnWnNwNwNnWnWnN");
+
+  // Known symbols from the standard
+  QByteArray code = Code39::encode("0AZ-");
+  CHECK(code.size() == 6 * SYMBOL_LENGTH - 1);
+  CHECK(symbolAt(code, 0) == "NwNnWnWnN");
+  CHECK(symbolAt(code, 1) == "NnNwWnWnN");
+  CHECK(symbolAt(code, 2) == "WnNnNwNnW");
+  CHECK(symbolAt(code, 3) == "NwWnWnNnN");
+  CHECK(symbolAt(code, 4) == "NwNnNnWnW");
+  CHECK(symbolAt(code, 5) == "NwNnWnWnN");
+  CHECK(wellFormed(code));
+
+  // Every character has its own symbol
+  QByteArray all = Code39::encode(CODE39_CHARS);
+  CHECK(wellFormed(all));
+  CHECK(decode(all) == CODE39_CHARS);
+
+  // Lower case folds to upper case, anything else is dropped
+  CHECK(Code39::encode("abc") == Code39::encode("ABC"));
+  CHECK(Code39::encode("A#B@C") == Code39::encode("ABC"));
+  CHECK(Code39::encode(QString(QChar(0xe9))) == Code39::encode(""));
+
+  // The check character is not drawn
+  CHECK(Code39::encode("CODE39", true) == Code39::encode("CODE39"));
+
+  // Full ASCII spells other characters as shift pairs
+  CHECK(decode(Code39::encode("a", false, true)) == "+A");
+  CHECK(decode(Code39::encode("Ab1", false, true)) == "A+B1");
+  CHECK(decode(Code39::encode(QString(QChar(0)), false, true)) == "%U");
+  CHECK(decode(Code39::encode("#", false, true)) == "/C");
+  CHECK(decode(Code39::encode(" ", false, true)) == " ");
+
+  QString ascii;
+  for (int c = 0; c < 128; ++c) {
+    ascii.append(QChar(c));
+  }
+  QByteArray full = Code39::encode(ascii, false, true);
+  CHECK(wellFormed(full));
+  CHECK(decodeFullAscii(decode(full)) == ascii);
+  CHECK(Code39::encode(QString(QChar(0x100)), false, true) ==
+      Code39::encode(""));
+
+  return testFailures;
+}
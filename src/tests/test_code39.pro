@@ -0,0 +1,7 @@
+TARGET = test_code39
+
+include (tests.pri)
+
+SOURCES += \
+  tests/test_code39.cpp \
+  parser/code39.cpp
@@ -0,0 +1,325 @@
+/**
+ * @file   test_decoders.cpp
+ * @author Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ *
+ * Copyright (C) 2012 - 2014 Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ * All Rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <QBuffer>
+#include <QByteArray>
+#include <QHash>
+
+#include "bitreader.h"
+#include "inflater.h"
+#include "lzwdecoder.h"
+#include "testcheck.h"
+
+/* Text with matches of every length and distance, the same on every run */
+static QByteArray sampleText(int size)
+{
+  static const char* const words[] = {
+    "P", "L", "A", "S", "r10", "r12.5", "s20", "rect30x60", "0.125",
+    "-3.5", "1.0000", "0;0=1", "\n", "#", "OB", "OS", "OC", "OE"
+  };
+  const int count = sizeof(words) / sizeof(words[0]);
+
+  QByteArray text;
+  quint32 seed = 11;
+  while (text.size() < size) {
+    seed = seed * 1664525u + 1013904223u;
+    text.append(words[(seed >> 8) % count]);
+    text.append(' ');
+  }
+  text.resize(size);
+  return text;
+}
+
+template <class Decoder>
+static QByteArray readAll(Decoder& decoder, int chunk, bool* ok)
+{
+  QByteArray result;
+  QByteArray buffer(chunk, 0);
+  qint64 n;
+  while ((n = decoder.read(buffer.data(), chunk)) > 0) {
+    result.append(buffer.constData(), int(n));
+  }
+  *ok = (n == 0 && decoder.atEnd());
+  return result;
+}
+
+/* Raw DEFLATE data of qCompress(), without its size, zlib header and sum */
+static QByteArray deflate(const QByteArray& data, int level)
+{
+  QByteArray z = qCompress(data, level);
+  return z.mid(6, z.size() - 10);
+}
+
+static QByteArray inflate(const QByteArray& raw, int chunk, bool* ok)
+{
+  QBuffer buffer;
+  buffer.setData(raw);
+  buffer.open(QIODevice::ReadOnly);
+  BitReader reader(&buffer);
+  Inflater inflater(&reader);
+  return readAll(inflater, chunk, ok);
+}
+
+/**
+ * compress(1) stream from the flags byte on, written the way ncompress
+ * does: the width grows and the tail of a group of eight codes is padded
+ * exactly where LzwDecoder expects it.  The table is cleared whenever it
+ * fills up.
+ */
+class LzwEncoder {
+public:
+  LzwEncoder(int maxBits): m_maxBits(maxBits), m_bits(9), m_maxCode(511),
+    m_freeEntry(257), m_clear(false), m_pos(0), m_groupStart(0)
+  {
+    m_out.append(char(0x80 | maxBits));
+  }
+
+  QByteArray encode(const QByteArray& data)
+  {
+    if (data.isEmpty()) {
+      return m_out;
+    }
+
+    QHash<quint32, int> table;
+    int ent = (unsigned char)data[0];
+    for (int i = 1; i < data.size(); ++i) {
+      int c = (unsigned char)data[i];
+      quint32 key = (quint32(c) << 16) | quint32(ent);
+      if (table.contains(key)) {
+        ent = table.value(key);
+        continue;
+      }
+      output(ent);
+      ent = c;
+      if (m_freeEntry < (1 << m_maxBits)) {
+        table.insert(key, m_freeEntry++);
+      } else {
+        table.clear();
+        m_freeEntry = 257;
+        m_clear = true;
+        output(LzwDecoder::CLEAR);
+      }
+    }
+    output(ent);
+    return m_out;
+  }
+
+private:
+  void output(int code)
+  {
+    for (int i = 0; i < m_bits; ++i, ++m_pos) {
+      putBit(m_pos, (code >> i) & 1);
+    }
+    if (m_pos - m_groupStart == qint64(m_bits) * 8) {
+      m_groupStart = m_pos;
+    }
+
+    if (m_freeEntry > m_maxCode || m_clear) {
+      if (m_pos > m_groupStart) {
+        m_pos = m_groupStart + qint64(m_bits) * 8;
+        putBit(m_pos - 1, 0);
+        m_groupStart = m_pos;
+      }
+      if (m_clear) {
+        m_bits = 9;
+        m_maxCode = 511;
+        m_clear = false;
+      } else {
+        ++m_bits;
+        m_maxCode = (m_bits == m_maxBits)? (1 << m_maxBits): (1 << m_bits) - 1;
+      }
+    }
+  }
+
+  void putBit(qint64 pos, int bit)
+  {
+    int byte = 1 + int(pos / 8);
+    if (byte >= m_out.size()) {
+      m_out.append(QByteArray(byte + 1 - m_out.size(), 0));
+    }
+    if (bit) {
+      m_out[byte] = char(m_out[byte] | (1 << (pos % 8)));
+    }
+  }
+
+  QByteArray m_out;
+  int m_maxBits;
+  int m_bits;
+  int m_maxCode;
+  int m_freeEntry;
+  bool m_clear;
+  qint64 m_pos;
+  qint64 m_groupStart;
+};
+
+static QByteArray uncompress(const QByteArray& stream, int chunk, bool* ok)
+{
+  QBuffer buffer;
+  buffer.setData(stream);
+  buffer.open(QIODevice::ReadOnly);
+  BitReader reader(&buffer);
+  LzwDecoder decoder(&reader);
+  return readAll(decoder, chunk, ok);
+}
+
+static void testInflateKnownAnswers(void)
+{
+  bool ok;
+
+  // A final stored block
+  static const char stored[] = { 0x01, 0x05, 0x00, char(0xfa), char(0xff),
+    'h', 'e', 'l', 'l', 'o' };
+  CHECK(inflate(QByteArray(stored, sizeof(stored)), 64, &ok) == "hello");
+  CHECK(ok);
+
+  // Fixed Huffman codes with a match overlapping its own output
+  static const char fixed[] = { char(0xcb), 0x48, char(0xcd), char(0xc9),
+    char(0xc9), 0x57, char(0xc8), 0x40, char(0x90), 0x00 };
+  CHECK(inflate(QByteArray(fixed, sizeof(fixed)), 3, &ok) ==
+      "hello hello hello");
+  CHECK(ok);
+
+  static const char empty[] = { 0x03, 0x00 };
+  CHECK(inflate(QByteArray(empty, sizeof(empty)), 64, &ok).isEmpty());
+  CHECK(ok);
+
+  // Reserved block type, and a stored length that fails its complement
+  inflate(QByteArray(1, 0x07), 64, &ok);
+  CHECK(!ok);
+  static const char badLength[] = { 0x01, 0x05, 0x00, 0x00, 0x00 };
+  inflate(QByteArray(badLength, sizeof(badLength)), 64, &ok);
+  CHECK(!ok);
+}
+
+static void testInflateRoundTrip(void)
+{
+  QByteArray text = sampleText(300000);
+  QByteArray run(100000, 'a');
+  const int levels[] = { 0, 1, 6, 9 };
+  const int chunks[] = { 1, 7, 65536 };
+
+  for (int l = 0; l < 4; ++l) {
+    QByteArray raw = deflate(text, levels[l]);
+    for (int c = 0; c < 3; ++c) {
+      bool ok;
+      CHECK(inflate(raw, chunks[c], &ok) == text);
+      CHECK(ok);
+    }
+    bool ok;
+    CHECK(inflate(deflate(run, levels[l]), 7, &ok) == run);
+    CHECK(ok);
+  }
+
+  // Whatever follows the stream is left to the reader, as for a trailer
+  QBuffer buffer;
+  buffer.setData(deflate(text, 6) + "trailer");
+  buffer.open(QIODevice::ReadOnly);
+  BitReader reader(&buffer);
+  Inflater inflater(&reader);
+  bool ok;
+  CHECK(readAll(inflater, 65536, &ok) == text);
+  CHECK(ok);
+  char tail[16];
+  CHECK(reader.readBytes(tail, sizeof(tail)) == 7);
+  CHECK(QByteArray(tail, 7) == "trailer");
+
+  // Truncated input must not pass as a complete stream
+  QByteArray raw = deflate(text, 6);
+  inflate(raw.left(raw.size() / 2), 4096, &ok);
+  CHECK(!ok);
+}
+
+static void testInflateCheckpoints(void)
+{
+  QByteArray text = sampleText(300000);
+  QByteArray raw = deflate(text, 6);
+
+  QBuffer buffer;
+  buffer.setData(raw);
+  buffer.open(QIODevice::ReadOnly);
+  BitReader reader(&buffer);
+  Inflater inflater(&reader);
+  inflater.setCheckpointSpacing(32768);
+  bool ok;
+  CHECK(readAll(inflater, 4096, &ok) == text);
+  QList<Inflater::Checkpoint> checkpoints = inflater.takeCheckpoints();
+  CHECK(!checkpoints.isEmpty());
+
+  // Decoding from any checkpoint gives the rest of the stream
+  for (int i = 0; i < checkpoints.size(); ++i) {
+    const Inflater::Checkpoint& checkpoint = checkpoints[i];
+    QBuffer from;
+    from.setData(raw);
+    from.open(QIODevice::ReadOnly);
+    from.seek(checkpoint.input / 8);
+    BitReader resumed(&from);
+    resumed.skip(checkpoint.input % 8);
+    Inflater tail(&resumed);
+    tail.resume(checkpoint);
+    CHECK(readAll(tail, 4096, &ok) == text.mid(int(checkpoint.output)));
+    CHECK(ok);
+  }
+}
+
+static void testLzw(void)
+{
+  bool ok;
+
+  // compress -b 16 of the classic example, without the magic
+  static const char known[] = { char(0x90), 0x54, char(0x9e), 0x08,
+    0x29, char(0xf2), 0x44, char(0x8a), char(0x93), 0x27, 0x54, 0x02,
+    0x0e, 0x2c, char(0xa8), char(0x90), char(0xa0), 0x41, char(0x84) };
+  CHECK(uncompress(QByteArray(known, sizeof(known)), 5, &ok) ==
+      "TOBEORNOTTOBEORTOBEORNOT");
+  CHECK(ok);
+
+  QByteArray text = sampleText(300000);
+  const int maxBits[] = { 9, 12, 16 };
+  const int chunks[] = { 1, 7, 65536 };
+  for (int b = 0; b < 3; ++b) {
+    QByteArray stream = LzwEncoder(maxBits[b]).encode(text);
+    for (int c = 0; c < 3; ++c) {
+      CHECK(uncompress(stream, chunks[c], &ok) == text);
+      CHECK(ok);
+    }
+  }
+
+  QByteArray run(100000, 'a');
+  CHECK(uncompress(LzwEncoder(16).encode(run), 7, &ok) == run);
+  CHECK(ok);
+
+  // Unsupported widths, and a code that is not defined yet
+  uncompress(QByteArray(1, char(0x80 | 17)), 64, &ok);
+  CHECK(!ok);
+  static const char undefined[] = { char(0x90), 0x41, 0x58, 0x02 };
+  uncompress(QByteArray(undefined, sizeof(undefined)), 64, &ok);
+  CHECK(!ok);
+}
+
+int main(void)
+{
+  testInflateKnownAnswers();
+  testInflateRoundTrip();
+  testInflateCheckpoints();
+  testLzw();
+  return testFailures;
+}
@@ -0,0 +1,11 @@
+TARGET = test_decoders
+
+include (tests.pri)
+
+SOURCES += \
+  tests/test_decoders.cpp \
+  archive/bitreader.cpp \
+  archive/inflater.cpp \
+  archive/lzwdecoder.cpp
+
+LIBS += -lz
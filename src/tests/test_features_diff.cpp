@@ -0,0 +1,122 @@
+/**
+ * @file   test_features_diff.cpp
+ * @author Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ *
+ * Copyright (C) 2012 - 2014 Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ * All Rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <QFile>
+#include <QTemporaryDir>
+
+#include "featuresdiff.h"
+#include "featuresparser.h"
+#include "testcheck.h"
+
+static const char* const OLD_FEATURES =
+  "$0 r10\n"
+  "$1 s20\n"
+  "@0 .smd\n"
+  "#\n"
+  "L 0 0 1 0 0 P 0\n"
+  "P 1 1 1 P 0 0\n"
+  "P 2 2 1 P 0 0\n"
+  "P 2 2 1 P 0 0\n"
+  "A 0 0 1 1 0.5 0.5 0 P 0 Y\n"
+  "S P 0\n"
+  "OB 0 0 I\n"
+  "OS 1 0\n"
+  "OC 1 1 0.5 0.5 Y\n"
+  "OE\n"
+  "SE\n";
+
+/* The symbol table is swapped, so equal records use other numbers */
+static const char* const NEW_FEATURES =
+  "$0 s20\n"
+  "$1 r10\n"
+  "@0 .smd\n"
+  "#\n"
+  "A 0 0 1 1 0.5 0.5 1 P 0 N\n"
+  "P 2 2 0 P 0 0\n"
+  "S P 0\n"
+  "OB 0 0 I\n"
+  "OS 1 0\n"
+  "OC 1 1 0.5 0.5 Y\n"
+  "OE\n"
+  "SE\n"
+  "L 0 0 1 0 1 P 0\n"
+  "P 1 1 0 P 0 0;0\n"
+  "P 1 1 0 P 0 0\n";
+
+static FeaturesDataStore* parse(const QTemporaryDir& dir, const QString& name,
+    const char* text)
+{
+  QString fileName = dir.filePath(name);
+  QFile file(fileName);
+  if (!file.open(QIODevice::WriteOnly) || file.write(text) < 0) {
+    return NULL;
+  }
+  file.close();
+  return FeaturesParser(fileName).parse();
+}
+
+int main(void)
+{
+  QTemporaryDir dir;
+  CHECK(dir.isValid());
+
+  FeaturesDataStore* from = parse(dir, "old", OLD_FEATURES);
+  FeaturesDataStore* same = parse(dir, "same", OLD_FEATURES);
+  FeaturesDataStore* to = parse(dir, "new", NEW_FEATURES);
+  CHECK(from && same && to);
+  if (!from || !same || !to) {
+    return testFailures;
+  }
+  CHECK(from->records().size() == 6 && to->records().size() == 6);
+
+  FeaturesDiff unchanged(from, same);
+  CHECK(unchanged.isEmpty());
+  for (int i = 0; i < unchanged.sources().size(); ++i) {
+    CHECK(unchanged.sources()[i] == i);
+  }
+
+  // Moved records match through the symbol names, duplicates pair up in
+  // file order, and a changed direction or attribute is a new record
+  FeaturesDiff diff(from, to);
+  const int expected[] = { -1, 2, 5, 0, -1, 1 };
+  CHECK(diff.sources().size() == 6);
+  for (int i = 0; i < diff.sources().size() && i < 6; ++i) {
+    CHECK(diff.sources()[i] == expected[i]);
+  }
+  CHECK(diff.added() == 2);
+  CHECK(diff.removed() == 2);
+  CHECK(!diff.isEmpty());
+
+  FeaturesDiff reverse(to, from);
+  CHECK(reverse.added() == 2 && reverse.removed() == 2);
+  CHECK(reverse.sources()[0] == 3 && reverse.sources()[3] == -1);
+
+  CHECK(FeaturesDiff::recordKey(from, from->records()[1]) ==
+      FeaturesDiff::recordKey(to, to->records()[5]));
+  CHECK(FeaturesDiff::recordKey(from, from->records()[1]) !=
+      FeaturesDiff::recordKey(from, from->records()[2]));
+
+  delete from;
+  delete same;
+  delete to;
+  return testFailures;
+}
@@ -0,0 +1,7 @@
+TARGET = test_features_diff
+
+include (tests.pri)
+include (app.pri)
+
+SOURCES += \
+  tests/test_features_diff.cpp
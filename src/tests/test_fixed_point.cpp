@@ -0,0 +1,123 @@
+/**
+ * @file   test_fixed_point.cpp
+ * @author Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ *
+ * Copyright (C) 2012 - 2014 Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ * All Rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <algorithm>
+#include <climits>
+
+#include "featureshape.h"
+#include "fixedpoint.h"
+#include "spatialindex.h"
+#include "testcheck.h"
+
+#define EPS 1e-9
+
+/* Deterministic values in [0, 1) so failures reproduce */
+static qreal nextRandom(quint32& seed)
+{
+  seed = seed * 1664525u + 1013904223u;
+  return (seed >> 8) / 16777216.0;
+}
+
+static void testOrdinate(void)
+{
+  // This test is built with QCAMBER_FIXED_COORDS
+  CHECK(sizeof(Ordinate) == 4);
+
+  FixedPoint::setResolution(1000);
+  Ordinate x = 1.2345;
+  CHECK(ordinateValue(x) == 1235);
+  CHECK_NEAR((qreal)x, 1.235, EPS);
+  CHECK(FixedPoint(-1.2345).raw() == -1234);
+  CHECK_NEAR((qreal)FixedPoint::fromRaw(-1500), -1.5, EPS);
+
+  // Out of range values saturate instead of wrapping
+  CHECK(FixedPoint(1e9).raw() == INT_MAX);
+  CHECK(FixedPoint(-1e9).raw() == INT_MIN);
+
+  // A rect off the grid is rounded outwards
+  FixedRect box = FixedRect::enclosing(QRectF(0.0011, -0.0021, 1, 1));
+  CHECK(box.left == 1 && box.top == -3);
+  CHECK(box.right == 1002 && box.bottom == 998);
+  QRectF r = box.toRectF();
+  CHECK_NEAR(r.left(), 0.001, EPS);
+  CHECK_NEAR(r.top(), -0.003, EPS);
+  CHECK_NEAR(r.right(), 1.002, EPS);
+  CHECK_NEAR(r.bottom(), 0.998, EPS);
+}
+
+static void testIndex(void)
+{
+  const int count = 500;
+  quint32 seed = 1;
+  FixedPoint::setResolution(1e6);
+
+  QVector<FixedRect> boxes;
+  QVector<QRectF> bounds;
+  for (int i = 0; i < count; ++i) {
+    QPointF c(nextRandom(seed) * 100, nextRandom(seed) * 100);
+    FeatureShape s = FeatureShape::disc(c, 0.1 + nextRandom(seed));
+    boxes.append(FixedRect::enclosing(s.boundingRect()));
+    bounds.append(boxes.last().toRectF());
+  }
+
+  SpatialIndex index;
+  index.build(boxes);
+  CHECK(index.size() == count);
+
+  FixedRect all = boxes[0];
+  for (int i = 0; i < count; ++i) {
+    CHECK(index.itemBounds(i) == bounds[i]);
+    all.left = qMin(all.left, boxes[i].left);
+    all.top = qMin(all.top, boxes[i].top);
+    all.right = qMax(all.right, boxes[i].right);
+    all.bottom = qMax(all.bottom, boxes[i].bottom);
+  }
+  CHECK(index.bounds() == all.toRectF());
+
+  // Window queries against a linear scan and the qreal build
+  SpatialIndex reference;
+  reference.build(bounds);
+  for (int q = 0; q < 20; ++q) {
+    QRectF window(nextRandom(seed) * 90, nextRandom(seed) * 90,
+        nextRandom(seed) * 20, nextRandom(seed) * 20);
+    QVector<int> found = index.query(window);
+    std::sort(found.begin(), found.end());
+    QVector<int> expected;
+    for (int i = 0; i < count; ++i) {
+      if (bounds[i].intersects(window)) {
+        expected.append(i);
+      }
+    }
+    CHECK(found == expected);
+
+    QVector<int> same = reference.query(window);
+    std::sort(same.begin(), same.end());
+    CHECK(found == same);
+  }
+}
+
+int main(void)
+{
+  testOrdinate();
+  testIndex();
+  return testFailures;
+}
@@ -0,0 +1,12 @@
+TARGET = test_fixed_point
+
+include (tests.pri)
+
+DEFINES += QCAMBER_FIXED_COORDS
+
+SOURCES += \
+  tests/test_fixed_point.cpp \
+  geometry/arcgeometry.cpp \
+  geometry/featureshape.cpp \
+  geometry/spatialindex.cpp \
+  parser/fixedpoint.cpp
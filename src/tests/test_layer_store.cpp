@@ -0,0 +1,170 @@
+/**
+ * @file   test_layer_store.cpp
+ * @author Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ *
+ * Copyright (C) 2012 - 2014 Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ * All Rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <QFile>
+#include <QTemporaryDir>
+#include <QVector>
+
+#include "featuresdatastore.h"
+#include "featuresdiff.h"
+#include "featuresparser.h"
+#include "layerstore.h"
+#include "testcheck.h"
+
+static const char* const FEATURES =
+  "$0 r10\n"
+  "$1 s20\n"
+  "@0 .smd\n"
+  "@1 .nomenclature\n"
+  "&0 top\n"
+  "#\n"
+  "L 0 0 1 0 0 P 0\n"
+  "P 1 1 1 P 0 0;0,1=0\n"
+  "A 0 0 1 1 0.5 0.5 0 N 0 Y\n"
+  "T 2 2 standard_font P 0 0.1 0.1 1 'QCAMBER' 1\n"
+  "S P 0\n"
+  "OB 0 0 I\n"
+  "OS 1 0\n"
+  "OC 1 1 0.5 0.5 Y\n"
+  "OE\n"
+  "OB 0.2 0.2 H\n"
+  "OS 0.4 0.2\n"
+  "OS 0.4 0.4\n"
+  "OS 0.2 0.2\n"
+  "OE\n"
+  "SE\n"
+  "P 3 3 0 N 0 2\n";
+
+static FeaturesDataStore* parse(const QString& fileName)
+{
+  QFile file(fileName);
+  if (!file.open(QIODevice::WriteOnly) || file.write(FEATURES) < 0) {
+    return NULL;
+  }
+  file.close();
+  return FeaturesParser(fileName).parse();
+}
+
+/* Same records in the same file order, compared through their keys */
+static bool sameRecords(FeaturesDataStore* a, FeaturesDataStore* b)
+{
+  if (!a || !b || a->records().size() != b->records().size()) {
+    return false;
+  }
+  for (int i = 0; i < a->records().size(); ++i) {
+    if (FeaturesDiff::recordKey(a, a->records()[i]) !=
+        FeaturesDiff::recordKey(b, b->records()[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool accepts(const QByteArray& image, const QString& stamp)
+{
+  return LayerStore(image.constData(), image.size()).isValid(stamp);
+}
+
+int main(void)
+{
+  QTemporaryDir dir;
+  CHECK(dir.isValid());
+  QString fileName = dir.filePath("features");
+  FeaturesDataStore* ds = parse(fileName);
+  CHECK(ds != NULL);
+  if (!ds) {
+    return testFailures;
+  }
+  CHECK(ds->records().size() == 6);
+
+  // Build and read back
+  QByteArray image = LayerStore::build(ds, "stamp");
+  CHECK(image.size() % 8 == 0);
+  CHECK(accepts(image, "stamp"));
+  CHECK(!accepts(image, "other"));
+  LayerStore store(image.constData(), image.size());
+  FeaturesDataStore* copy = store.toDataStore();
+  CHECK(sameRecords(ds, copy));
+  CHECK(copy->drawOrder() == ds->drawOrder());
+  CHECK(copy->attrlistMap() == ds->attrlistMap());
+  delete copy;
+
+  // Rebuilding the copy gives an image of the same shape
+  copy = LayerStore(image.constData(), image.size()).toDataStore();
+  QByteArray rebuilt = LayerStore::build(copy, "stamp");
+  CHECK(rebuilt.size() == image.size() && accepts(rebuilt, "stamp"));
+  delete copy;
+
+  // Truncated and corrupted images are rejected
+  CHECK(!accepts(QByteArray(), "stamp"));
+  CHECK(!accepts(image.left(16), "stamp"));
+  CHECK(!accepts(image.left(image.size() - 8), "stamp"));
+  QByteArray bad = image;
+  bad[0] = 'X';
+  CHECK(!accepts(bad, "stamp"));
+
+  // Packing round trip, and damaged packed data unpacks to nothing
+  QByteArray packed = LayerStore::pack(image);
+  CHECK(!packed.isEmpty() && packed.size() < image.size());
+  CHECK(LayerStore::unpack(packed) == image);
+  CHECK(LayerStore::unpack(packed.left(packed.size() / 2)).isEmpty());
+  CHECK(LayerStore::unpack(QByteArray()).isEmpty());
+
+  // A draw order other than file order is stored with the image
+  QVector<int> order;
+  order << 4 << 2 << 0 << 5 << 1 << 3;
+  ds->relocate(order);
+  CHECK(ds->drawOrder() == order);
+  QByteArray ordered = LayerStore::build(ds, "stamp");
+  CHECK(ordered.size() > image.size());
+  CHECK(accepts(ordered, "stamp"));
+  copy = LayerStore(ordered.constData(), ordered.size()).toDataStore();
+  CHECK(sameRecords(ds, copy));
+  CHECK(copy->drawOrder() == order);
+  delete copy;
+  CHECK(LayerStore::unpack(LayerStore::pack(ordered)) == ordered);
+
+  // Demoted layers come back once, packed or spilled
+  for (int spill = 0; spill < 2; ++spill) {
+    LayerStore::demote(fileName, ds, spill);
+    CHECK((LayerStore::demotedSize() > 0) == !spill);
+    copy = LayerStore::load(fileName);
+    CHECK(sameRecords(ds, copy));
+    CHECK(copy && copy->drawOrder() == order);
+    delete copy;
+    CHECK(LayerStore::demotedSize() == 0);
+    CHECK(LayerStore::load(fileName) == NULL);
+  }
+
+  // Cache files
+  QTemporaryDir cacheDir;
+  LayerStore::setMode(LayerStore::CacheFile, cacheDir.path());
+  CHECK(LayerStore::load(fileName) == NULL);
+  LayerStore::save(fileName, ds);
+  copy = LayerStore::load(fileName);
+  CHECK(sameRecords(ds, copy));
+  delete copy;
+  LayerStore::setMode(LayerStore::Off);
+
+  delete ds;
+  return testFailures;
+}
@@ -0,0 +1,7 @@
+TARGET = test_layer_store
+
+include (tests.pri)
+include (app.pri)
+
+SOURCES += \
+  tests/test_layer_store.cpp
@@ -0,0 +1,231 @@
+/**
+ * @file   test_placement.cpp
+ * @author Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ *
+ * Copyright (C) 2012 - 2014 Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ * All Rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <QList>
+#include <QPolygonF>
+#include <QTransform>
+#include <QVector>
+
+#include "placement.h"
+#include "testcheck.h"
+
+#define EPSILON 1e-9
+
+static quint32 nextRandom(quint32& seed)
+{
+  seed = seed * 1664525u + 1013904223u;
+  return seed >> 8;
+}
+
+/* Uniform in [-range, range) */
+static qreal randomValue(quint32& seed, qreal range)
+{
+  return (nextRandom(seed) / qreal(1 << 24) * 2 - 1) * range;
+}
+
+static bool near(const QPointF& a, const QPointF& b)
+{
+  return std::fabs(a.x() - b.x()) <= EPSILON &&
+    std::fabs(a.y() - b.y()) <= EPSILON;
+}
+
+static bool nearRect(const QRectF& a, const QRectF& b)
+{
+  return near(a.topLeft(), b.topLeft()) &&
+    near(a.bottomRight(), b.bottomRight());
+}
+
+/* Mirror, quarter turn and offset of a placed symbol */
+static QTransform orientation(int orient, qreal x, qreal y)
+{
+  static const qreal cosines[] = { 1, 0, -1, 0 };
+  static const qreal sines[] = { 0, 1, 0, -1 };
+  qreal c = cosines[orient % 4], s = sines[orient % 4];
+  QTransform mirror(orient >= 4? -1: 1, 0, 0, 1, 0, 0);
+  return mirror * QTransform(c, s, -s, c, 0, 0) *
+    QTransform(1, 0, 0, 1, x, y);
+}
+
+static void testKnownAnswers(void)
+{
+  Placement identity;
+  CHECK(identity.map(QPointF(1.5, -2)) == QPointF(1.5, -2));
+
+  // A quarter turn then an offset of (3, 4)
+  Placement turn(0, 1, -1, 0, 3, 4);
+  CHECK(turn.map(QPointF(1, 2)) == QPointF(1, 5));
+  CHECK(turn.map(QPointF(0, 0)) == QPointF(3, 4));
+
+  // Quarter turns and mirrors map exactly, as QTransform does
+  for (int orient = 0; orient < 8; ++orient) {
+    QTransform trans = orientation(orient, 3.5, -2.25);
+    Placement placement = Placement::fromTransform(trans);
+    QPointF p(1.25, 0.5);
+    CHECK(placement.map(p) == trans.map(p));
+  }
+
+  CHECK(turn.mapRect(QRectF(0, 0, 2, 1)) == QRectF(2, 4, 1, 2));
+  CHECK(turn.mapRect(QRectF()) == QRectF());
+  CHECK(turn.mapBounds(NULL, 0) == QRectF());
+}
+
+static void testConstruction(void)
+{
+  // Orient codes place exactly like the item transform of a pad
+  for (int orient = 0; orient < 8; ++orient) {
+    QTransform trans = orientation(orient, 3.5, -2.25);
+    Placement placement = Placement::fromOrient(Orient(orient),
+        QPointF(3.5, -2.25));
+    QPointF p(1.25, 0.5);
+    CHECK(placement.map(p) == trans.map(p));
+    CHECK(placement.isMirrored() == (orient >= M_0));
+  }
+  CHECK(Placement::fromOrient(N_0, QPointF()).isIdentity());
+
+  // Step repeats as the QTransform LayerFeatures used to build
+  const qreal angles[] = { 0, 90, 180, 270, -90, 30, 145.5 };
+  for (int a = 0; a < 7; ++a) {
+    for (int mirror = 0; mirror < 2; ++mirror) {
+      QTransform trans;
+      if (mirror) {
+        trans.scale(-1, 1);
+      }
+      trans.rotate(angles[a]);
+      trans.translate(-1.5, 0.75);
+      Placement placement = Placement::fromStepRepeat(angles[a], mirror,
+          QPointF(1.5, 0.75));
+      QPointF p(2.5, -1.25);
+      CHECK(near(placement.map(p), trans.map(p)));
+      CHECK(placement.isMirrored() == bool(mirror));
+    }
+  }
+
+  // Composition and offsets
+  Placement turn(0, 1, -1, 0, 3, 4);
+  Placement scale(2, 0, 0, 2, -1, 0);
+  QPointF p(1, 2);
+  CHECK((turn * scale).map(p) == scale.map(turn.map(p)));
+  CHECK((turn * scale).toTransform() ==
+      turn.toTransform() * scale.toTransform());
+  CHECK(turn.translated(1, -1).map(p) == turn.map(p) + QPointF(1, -1));
+  CHECK(!turn.isIdentity());
+
+  // Placing about an origin, as LayerFeatures::setTransform() did it
+  const QPointF origins[3] = { QPointF(0, 0), QPointF(5, -2),
+    QPointF(-1.5, 8) };
+  QVector<Placement> about = turn.about(origins, 3);
+  CHECK(about.size() == 3);
+  for (int i = 0; i < 3; ++i) {
+    QTransform trans;
+    trans.translate(-origins[i].x(), -origins[i].y());
+    trans = turn.toTransform() * trans;
+    trans.translate(origins[i].x(), origins[i].y());
+    CHECK(near(about[i].map(p), trans.map(p)));
+  }
+  CHECK(turn.about(origins, 0).isEmpty());
+}
+
+static void testRandom(void)
+{
+  quint32 seed = 48;
+  for (int round = 0; round < 100; ++round) {
+    QTransform trans(randomValue(seed, 4), randomValue(seed, 4),
+        randomValue(seed, 4), randomValue(seed, 4), randomValue(seed, 100),
+        randomValue(seed, 100));
+    Placement placement = Placement::fromTransform(trans);
+
+    int count = 1 + nextRandom(seed) % 67;
+    QPolygonF src;
+    for (int i = 0; i < count; ++i) {
+      src.append(QPointF(randomValue(seed, 10), randomValue(seed, 10)));
+    }
+
+    // Single points, arrays and in place all agree with QTransform
+    QPolygonF dst(count);
+    placement.map(src.constData(), dst.data(), count);
+    QPolygonF inPlace = src;
+    placement.map(inPlace);
+    bool same = true;
+    qreal x0 = 0, y0 = 0, x1 = 0, y1 = 0;
+    for (int i = 0; i < count; ++i) {
+      QPointF expected = trans.map(src[i]);
+      same = same && near(placement.map(src[i]), expected) &&
+        near(dst[i], expected) && near(inPlace[i], expected);
+      if (i == 0 || expected.x() < x0) {
+        x0 = expected.x();
+      }
+      if (i == 0 || expected.x() > x1) {
+        x1 = expected.x();
+      }
+      if (i == 0 || expected.y() < y0) {
+        y0 = expected.y();
+      }
+      if (i == 0 || expected.y() > y1) {
+        y1 = expected.y();
+      }
+    }
+    CHECK(same);
+
+    // Bounds without storing the points
+    QRectF bounds = placement.mapBounds(src.constData(), count);
+    CHECK(nearRect(bounds, QRectF(QPointF(x0, y0), QPointF(x1, y1))));
+
+    QRectF rect(randomValue(seed, 10), randomValue(seed, 10),
+        1 + nextRandom(seed) % 5, 1 + nextRandom(seed) % 5);
+    CHECK(nearRect(placement.mapRect(rect), trans.mapRect(rect)));
+  }
+}
+
+static void testPolygonList(void)
+{
+  Placement placement(2, 0, 0, -1, 1, 1);
+  QList<QPolygonF> polygons;
+  QPolygonF square;
+  square << QPointF(0, 0) << QPointF(1, 0) << QPointF(1, 1) << QPointF(0, 1);
+  polygons << square << QPolygonF() << square;
+  placement.map(polygons);
+
+  CHECK(polygons.size() == 3);
+  CHECK(polygons[1].isEmpty());
+  for (int k = 0; k < 3; k += 2) {
+    CHECK(polygons[k].size() == 4);
+    CHECK(polygons[k][0] == QPointF(1, 1));
+    CHECK(polygons[k][1] == QPointF(3, 1));
+    CHECK(polygons[k][2] == QPointF(3, 0));
+    CHECK(polygons[k][3] == QPointF(1, 0));
+  }
+
+  // Nothing to do for an empty array
+  QPolygonF empty;
+  placement.map(empty);
+  CHECK(empty.isEmpty());
+  placement.map(square.constData(), NULL, 0);
+}
+
+int main(void)
+{
+  testKnownAnswers();
+  testConstruction();
+  testRandom();
+  testPolygonList();
+  return testFailures;
+}
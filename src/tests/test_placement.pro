@@ -0,0 +1,7 @@
+TARGET = test_placement
+
+include (tests.pri)
+
+SOURCES += \
+  tests/test_placement.cpp \
+  geometry/placement.cpp
@@ -0,0 +1,185 @@
+/**
+ * @file   test_polygon_boolean.cpp
+ * @author Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ *
+ * Copyright (C) 2012 - 2014 Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ * All Rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "polygonboolean.h"
+#include "testcheck.h"
+
+using namespace PolygonBoolean;
+
+#define GRID 16
+
+static quint32 nextRandom(quint32& seed)
+{
+  seed = seed * 1664525u + 1013904223u;
+  return seed >> 8;
+}
+
+static IntPath rect(Coord l, Coord b, Coord r, Coord t)
+{
+  IntPath path;
+  path << IntPoint(l, b) << IntPoint(r, b) << IntPoint(r, t)
+    << IntPoint(l, t);
+  return path;
+}
+
+static Subject subject(const IntPath& ring, bool positive, int group = 0)
+{
+  Subject s;
+  s.rings.append(ring);
+  s.positive = positive;
+  s.group = group;
+  return s;
+}
+
+static double totalArea(const QVector<Polygon>& polygons)
+{
+  double sum = 0;
+  for (int i = 0; i < polygons.size(); ++i) {
+    sum += area(polygons[i]);
+  }
+  return sum;
+}
+
+/* Every outer contour counter-clockwise, every hole clockwise */
+static bool isOriented(const QVector<Polygon>& polygons)
+{
+  for (int i = 0; i < polygons.size(); ++i) {
+    if (area(polygons[i].outer) <= 0) {
+      return false;
+    }
+    for (int j = 0; j < polygons[i].holes.size(); ++j) {
+      if (area(polygons[i].holes[j]) >= 0) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+static void testKnownAnswers(void)
+{
+  QVector<Subject> subjects;
+  subjects << subject(rect(0, 0, 10, 10), true)
+    << subject(rect(5, 0, 15, 10), true);
+  QVector<Polygon> result = flatten(subjects);
+  CHECK(result.size() == 1);
+  CHECK_NEAR(totalArea(result), 150, 0);
+  CHECK(isOriented(result));
+
+  // A negative punches a hole, a later positive fills an island into it
+  subjects.clear();
+  subjects << subject(rect(0, 0, 10, 10), true)
+    << subject(rect(3, 3, 7, 7), false);
+  result = flatten(subjects);
+  CHECK(result.size() == 1 && result[0].holes.size() == 1);
+  CHECK_NEAR(totalArea(result), 84, 0);
+  CHECK(isOriented(result));
+
+  subjects << subject(rect(4, 4, 6, 6), true);
+  result = flatten(subjects);
+  CHECK(result.size() == 2);
+  CHECK_NEAR(totalArea(result), 88, 0);
+
+  // Negatives only erase their own group
+  subjects.clear();
+  subjects << subject(rect(0, 0, 10, 10), true, 1)
+    << subject(rect(3, 3, 7, 7), false, 2);
+  CHECK_NEAR(totalArea(flatten(subjects)), 100, 0);
+
+  // Nested rings of one subject fill odd-even
+  Subject ring;
+  ring.rings << rect(0, 0, 10, 10) << rect(2, 2, 8, 8);
+  result = flatten(QVector<Subject>() << ring);
+  CHECK(result.size() == 1 && result[0].holes.size() == 1);
+  CHECK_NEAR(totalArea(result), 64, 0);
+
+  // Crossing edges are split on the grid, leaving the four corners
+  IntPath diamond;
+  diamond << IntPoint(5, -2) << IntPoint(12, 5) << IntPoint(5, 12)
+    << IntPoint(-2, 5);
+  subjects.clear();
+  subjects << subject(rect(0, 0, 10, 10), true) << subject(diamond, false);
+  result = flatten(subjects);
+  CHECK(isOriented(result));
+  CHECK(result.size() == 4);
+  CHECK_NEAR(totalArea(result), 4 * 4.5, 0);
+
+  CHECK_NEAR(area(clip(rect(0, 0, 10, 10), IntRect(5, 5, 20, 20))), 25, 0);
+  CHECK(clip(rect(0, 0, 10, 10), IntRect(20, 20, 30, 30)).isEmpty());
+}
+
+static void testRandomStacks(void)
+{
+  quint32 seed = 7;
+  for (int round = 0; round < 200; ++round) {
+    QVector<Subject> subjects;
+    int count = 1 + nextRandom(seed) % 8;
+    for (int i = 0; i < count; ++i) {
+      Coord l = nextRandom(seed) % GRID, b = nextRandom(seed) % GRID;
+      Coord r = l + 1 + nextRandom(seed) % (GRID - l);
+      Coord t = b + 1 + nextRandom(seed) % (GRID - b);
+      subjects << subject(rect(l, b, r, t), i == 0 || nextRandom(seed) % 3);
+    }
+
+    // Paint the stack cell by cell for the expected area
+    bool cells[GRID + 1][GRID + 1] = {};
+    for (int i = 0; i < subjects.size(); ++i) {
+      const IntPath& r = subjects[i].rings[0];
+      for (Coord x = r[0].x; x < r[2].x; ++x) {
+        for (Coord y = r[0].y; y < r[2].y; ++y) {
+          cells[x][y] = subjects[i].positive;
+        }
+      }
+    }
+    int covered = 0;
+    for (int x = 0; x <= GRID; ++x) {
+      for (int y = 0; y <= GRID; ++y) {
+        covered += cells[x][y];
+      }
+    }
+
+    QVector<Polygon> result = flatten(subjects);
+    CHECK_NEAR(totalArea(result), covered, 0);
+    CHECK(isOriented(result));
+  }
+}
+
+static void testConversion(void)
+{
+  QPolygonF polygon;
+  polygon << QPointF(0.5, 0.25) << QPointF(1.5, 0.25) << QPointF(1.5, 1)
+    << QPointF(0.5, 0.25);
+  IntPath path = toIntPath(polygon, 1000);
+  CHECK(path.size() == 3);
+  CHECK(path[1] == IntPoint(1500, 250));
+  QPolygonF back = toPolygonF(path, 1000);
+  CHECK(back.size() == 3);
+  CHECK_NEAR(back[2].y(), 1, 0);
+}
+
+int main(void)
+{
+  testKnownAnswers();
+  testRandomStacks();
+  testConversion();
+  return testFailures;
+}
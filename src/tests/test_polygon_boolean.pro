@@ -0,0 +1,7 @@
+TARGET = test_polygon_boolean
+
+include (tests.pri)
+
+SOURCES += \
+  tests/test_polygon_boolean.cpp \
+  geometry/polygonboolean.cpp
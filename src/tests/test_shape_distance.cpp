@@ -0,0 +1,148 @@
+/**
+ * @file   test_shape_distance.cpp
+ * @author Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ *
+ * Copyright (C) 2012 - 2014 Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ * All Rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <algorithm>
+
+#include "featureshape.h"
+#include "spatialindex.h"
+#include "testcheck.h"
+
+#define EPS 1e-9
+
+/* Deterministic values in [0, 1) so failures reproduce */
+static qreal nextRandom(quint32& seed)
+{
+  seed = seed * 1664525u + 1013904223u;
+  return (seed >> 8) / 16777216.0;
+}
+
+static void testShapes(void)
+{
+  FeatureShape a = FeatureShape::disc(QPointF(0, 0), 1);
+  FeatureShape b = FeatureShape::disc(QPointF(5, 0), 1);
+  Proximity p = ShapeDistance::between(a, b);
+  CHECK_NEAR(p.distance, 3, EPS);
+  CHECK_NEAR(p.pa.x(), 1, EPS);
+  CHECK_NEAR(p.pb.x(), 4, EPS);
+
+  // Overlapping shapes touch
+  FeatureShape c = FeatureShape::disc(QPointF(1.5, 0), 1);
+  CHECK_NEAR(ShapeDistance::between(a, c).distance, 0, EPS);
+
+  FeatureShape line = FeatureShape::capsule(QPointF(0, 0), QPointF(10, 0),
+      1);
+  CHECK_NEAR(ShapeDistance::toPoint(line, QPointF(5, 3)).distance, 2, EPS);
+  CHECK_NEAR(ShapeDistance::toPoint(line, QPointF(13, 4)).distance, 4, EPS);
+  CHECK_NEAR(ShapeDistance::toPoint(line, QPointF(5, 0.5)).distance, 0, EPS);
+
+  // Counterclockwise quarter from (1, 0) to (0, 1), and the other three
+  FeatureShape quarter = FeatureShape::arc(QPointF(1, 0), QPointF(0, 1),
+      QPointF(0, 0), false, 0.1);
+  FeatureShape rest = FeatureShape::arc(QPointF(1, 0), QPointF(0, 1),
+      QPointF(0, 0), true, 0.1);
+  CHECK_NEAR(ShapeDistance::toPoint(quarter, QPointF(0, 0)).distance, 0.9,
+      EPS);
+  CHECK_NEAR(ShapeDistance::toPoint(quarter, QPointF(-2, 0)).distance,
+      std::sqrt(5.0) - 0.1, EPS);
+  CHECK_NEAR(ShapeDistance::toPoint(rest, QPointF(-2, 0)).distance, 0.9,
+      EPS);
+
+  QPolygonF square;
+  square << QPointF(0, 0) << QPointF(2, 0) << QPointF(2, 2) << QPointF(0, 2);
+  FeatureShape box = FeatureShape::contour(QList<QPolygonF>() << square);
+  CHECK_NEAR(ShapeDistance::toPoint(box, QPointF(3, 1)).distance, 1, EPS);
+  CHECK_NEAR(ShapeDistance::toPoint(box, QPointF(1, 1)).distance, 0, EPS);
+  CHECK_NEAR(ShapeDistance::between(box, b).distance, 2, EPS);
+  CHECK_NEAR(ShapeDistance::between(box, line).distance, 0, EPS);
+
+  CHECK_NEAR(ShapeDistance::boundsDistance(QRectF(0, 0, 1, 1),
+        QRectF(4, 5, 1, 1)), 5, EPS);
+  CHECK_NEAR(ShapeDistance::boundsDistance(QRectF(0, 0, 1, 1),
+        QPointF(0.5, 0.5)), 0, EPS);
+}
+
+static void testIndex(void)
+{
+  const int count = 500;
+  quint32 seed = 1;
+  QVector<QRectF> bounds;
+  QVector<FeatureShape> shapes;
+  for (int i = 0; i < count; ++i) {
+    QPointF c(nextRandom(seed) * 100, nextRandom(seed) * 100);
+    FeatureShape s = FeatureShape::disc(c, 0.1 + nextRandom(seed));
+    shapes.append(s);
+    bounds.append(s.boundingRect());
+  }
+
+  SpatialIndex index;
+  index.build(bounds);
+  CHECK(index.size() == count);
+
+  // Window queries against a linear scan
+  for (int q = 0; q < 20; ++q) {
+    QRectF window(nextRandom(seed) * 90, nextRandom(seed) * 90,
+        nextRandom(seed) * 20, nextRandom(seed) * 20);
+    QVector<int> found = index.query(window);
+    std::sort(found.begin(), found.end());
+    QVector<int> expected;
+    for (int i = 0; i < count; ++i) {
+      if (bounds[i].intersects(window)) {
+        expected.append(i);
+      }
+    }
+    CHECK(found == expected);
+  }
+
+  // Nearest neighbours against sorting every exact distance
+  for (int q = 0; q < 20; ++q) {
+    QPointF p(nextRandom(seed) * 100, nextRandom(seed) * 100);
+    SpatialIndex::DistanceFunc distance = [&](int item) {
+      return ShapeDistance::toPoint(shapes[item], p).distance;
+    };
+    QVector<qreal> distances;
+    QVector<int> found = index.nearest(p, 5, distance, -1, &distances);
+
+    QVector<qreal> all;
+    for (int i = 0; i < count; ++i) {
+      all.append(distance(i));
+    }
+    std::sort(all.begin(), all.end());
+
+    CHECK(found.size() == 5 && distances.size() == 5);
+    for (int k = 0; k < found.size() && k < distances.size(); ++k) {
+      CHECK_NEAR(distances[k], all[k], EPS);
+      CHECK_NEAR(distance(found[k]), all[k], EPS);
+    }
+  }
+
+  QVector<int> none = index.nearest(QPointF(-1000, -1000), 3,
+      [&](int item) { return ShapeDistance::toPoint(shapes[item],
+          QPointF(-1000, -1000)).distance; }, 10);
+  CHECK(none.isEmpty());
+}
+
+int main(void)
+{
+  testShapes();
+  testIndex();
+  return testFailures;
+}
@@ -0,0 +1,10 @@
+TARGET = test_shape_distance
+
+include (tests.pri)
+
+SOURCES += \
+  tests/test_shape_distance.cpp \
+  geometry/arcgeometry.cpp \
+  geometry/featureshape.cpp \
+  geometry/spatialindex.cpp \
+  parser/fixedpoint.cpp
@@ -0,0 +1,14 @@
+TARGET = test_standard_symbols
+
+include (tests.pri)
+include (app.pri)
+
+SOURCES += \
+  tests/test_standard_symbols.cpp \
+  tests/testviewwidget.cpp
+
+HEADERS += \
+  tests/testviewwidget.h
+
+# Opens a viewer window for inspection, so "make check" leaves it out.
+CONFIG -= testcase
@@ -0,0 +1,187 @@
+/**
+ * @file   test_symbol_bounds.cpp
+ * @author Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ *
+ * Copyright (C) 2012 - 2014 Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ * All Rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <QFile>
+#include <QTemporaryDir>
+
+#include "arcgeometry.h"
+#include "featuresdatastore.h"
+#include "featuresparser.h"
+#include "symbolfactory.h"
+#include "testcheck.h"
+
+#define EPSILON 1e-9
+
+/* Standard symbols whose analytic box is their outline's box */
+static const char* const EXACT[] = {
+  "r50", "r.5", "s40", "rect100x50", "rect100x50xr20x13",
+  "rect100x50xc20x24", "oval50x100", "oval100x50", "oval_h30x60",
+  "oval_h60x30", "di100x50", "oct60x60x20", "donut_r60x30", "donut_s60x30",
+  "tri30x60", "el60x30", "hex_l60x60x20", "hex_s60x40x10", "bfr60",
+  "bfs60", "hole50xpx4x5", "null1"
+};
+
+/* Thermal boxes ignore the spoke gaps and may be larger */
+static const char* const COVERING[] = {
+  "thr60x40x45x4x10", "thr60x40x0x4x10", "ths60x40x45x4x10",
+  "s_ths60x40x45x4x10", "s_tho60x40x0x4x10", "sr_ths60x40x45x4x10",
+  "rc_ths60x40x45x4x10x10", "rc_tho60x40x45x4x10x5",
+  "moire5x10x4x4x100x0", "moire5x10x2x4x20x30"
+};
+
+static const char* const FEATURES =
+  "$0 r10\n"
+  "$1 s20\n"
+  "#\n"
+  "L 0 0 1 0 0 P 0\n"
+  "L 0 0 1 1 0 P 0\n"
+  "L 0.5 0.5 0.5 0.5 1 P 0\n"
+  "A 1 0 0 1 0 0 0 P 0 N\n"
+  "A 1 0 0 1 0 0 0 P 0 Y\n"
+  "A 0.3 0.4 0.3 0.4 0 0 0 P 0 Y\n"
+  "S P 0\n"
+  "OB 0 0 I\n"
+  "OS 2 0\n"
+  "OC 0 0 1 0 N\n"
+  "OE\n"
+  "SE\n";
+
+/* Each edge of outer is at most slack outside of inner's */
+static bool covers(const QRectF& outer, const QRectF& inner, qreal slack)
+{
+  qreal d[4] = {
+    inner.left() - outer.left(), outer.right() - inner.right(),
+    inner.top() - outer.top(), outer.bottom() - inner.bottom()
+  };
+  for (int i = 0; i < 4; ++i) {
+    if (d[i] < -EPSILON || d[i] > slack) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool same(const QRectF& a, const QRectF& b, qreal eps)
+{
+  return qAbs(a.left() - b.left()) <= eps &&
+    qAbs(a.right() - b.right()) <= eps && qAbs(a.top() - b.top()) <= eps &&
+    qAbs(a.bottom() - b.bottom()) <= eps;
+}
+
+static Symbol* standard(const char* def)
+{
+  Symbol* symbol = SymbolFactory::createStandard(def, P, AttribData());
+  if (!symbol) {
+    fprintf(stderr, "no standard symbol %s\n", def);
+  }
+  return symbol;
+}
+
+static FeaturesDataStore* parse(const QTemporaryDir& dir)
+{
+  QString fileName = dir.filePath("features");
+  QFile file(fileName);
+  if (!file.open(QIODevice::WriteOnly) || file.write(FEATURES) < 0) {
+    return NULL;
+  }
+  file.close();
+  return FeaturesParser(fileName).parse();
+}
+
+int main(void)
+{
+  for (size_t i = 0; i < sizeof(EXACT) / sizeof(EXACT[0]); ++i) {
+    Symbol* symbol = standard(EXACT[i]);
+    CHECK(symbol != NULL);
+    if (symbol) {
+      QRectF box = symbol->boundingRect();
+      QRectF path = symbol->painterPath().boundingRect();
+      if (!same(box, path, EPSILON)) {
+        fprintf(stderr, "%s: box differs from its outline\n", EXACT[i]);
+        CHECK(false);
+      }
+      delete symbol;
+    }
+  }
+
+  for (size_t i = 0; i < sizeof(COVERING) / sizeof(COVERING[0]); ++i) {
+    Symbol* symbol = standard(COVERING[i]);
+    CHECK(symbol != NULL);
+    if (symbol) {
+      QRectF box = symbol->boundingRect();
+      QRectF path = symbol->painterPath().boundingRect();
+      if (!covers(box, path, box.width())) {
+        fprintf(stderr, "%s: box does not cover its outline\n",
+            COVERING[i]);
+        CHECK(false);
+      }
+      delete symbol;
+    }
+  }
+
+  // Known answers, in scene coordinates with y pointing down
+  Symbol* oval = standard("oval_h60x30");
+  CHECK(oval && same(oval->boundingRect(), QRectF(-0.03, -0.015, 0.06,
+          0.03), EPSILON));
+  delete oval;
+  Symbol* thermal = standard("s_ths60x40x45x4x10");
+  CHECK(thermal && same(thermal->boundingRect(), QRectF(-0.03, -0.03,
+          0.06, 0.06), EPSILON));
+  delete thermal;
+
+  // Lines, arcs and surfaces; flattened curves may fall short of the
+  // exact box by the flattening tolerance
+  QTemporaryDir dir;
+  CHECK(dir.isValid());
+  FeaturesDataStore* ds = parse(dir);
+  CHECK(ds && ds->records().size() == 7);
+  if (!ds || ds->records().size() != 7) {
+    delete ds;
+    return testFailures;
+  }
+
+  const QRectF expected[] = {
+    QRectF(-0.005, -0.005, 1.01, 0.01),
+    QRectF(-0.005, -1.005, 1.01, 1.01),
+    QRectF(0.49, -0.51, 0.02, 0.02),
+    QRectF(-0.005, -1.005, 1.01, 1.01),
+    QRectF(-1.005, -1.005, 2.01, 2.01),
+    QRectF(-0.505, -0.505, 1.01, 1.01),
+    QRectF(0, -1, 2, 1)
+  };
+  qreal tolerance = ArcGeometry::tolerance();
+  for (int i = 0; i < ds->records().size(); ++i) {
+    Symbol* symbol = ds->records()[i]->createSymbol();
+    QRectF box = symbol->boundingRect();
+    QRectF path = symbol->painterPath().boundingRect();
+    if (!same(box, expected[i], EPSILON) ||
+        !covers(box, path, tolerance + EPSILON)) {
+      fprintf(stderr, "record %d: box (%g, %g, %g, %g)\n", i, box.x(),
+          box.y(), box.width(), box.height());
+      CHECK(false);
+    }
+    delete symbol;
+  }
+
+  delete ds;
+  return testFailures;
+}
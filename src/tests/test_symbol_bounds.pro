@@ -0,0 +1,7 @@
+TARGET = test_symbol_bounds
+
+include (tests.pri)
+include (app.pri)
+
+SOURCES += \
+  tests/test_symbol_bounds.cpp
@@ -0,0 +1,166 @@
+/**
+ * @file   test_symbol_factory.cpp
+ * @author Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ *
+ * Copyright (C) 2012 - 2014 Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ * All Rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <QString>
+
+#include "symbolfactory.h"
+#include "testcheck.h"
+
+static AttribData noAttrib;
+
+/* True if def creates a standard symbol of type T */
+template <typename T>
+static bool creates(const char* def)
+{
+  Symbol* symbol = SymbolFactory::createStandard(def, P, noAttrib);
+  bool ok = dynamic_cast<T*>(symbol) != NULL;
+  delete symbol;
+  return ok;
+}
+
+static bool rejects(const char* def)
+{
+  Symbol* symbol = SymbolFactory::createStandard(def, P, noAttrib);
+  delete symbol;
+  return symbol == NULL;
+}
+
+/* Outline bounds of a standard symbol, in inches */
+static QRectF bounds(const char* def)
+{
+  Symbol* symbol = SymbolFactory::createStandard(def, P, noAttrib);
+  QRectF rect = symbol? symbol->painterPath().boundingRect(): QRectF();
+  delete symbol;
+  return rect;
+}
+
+static bool centred(const QRectF& rect, qreal w, qreal h)
+{
+  const qreal eps = 1e-12;
+  return qAbs(rect.width() - w) < eps && qAbs(rect.height() - h) < eps &&
+    qAbs(rect.center().x()) < eps && qAbs(rect.center().y()) < eps;
+}
+
+static double paramToDouble(const QString& text)
+{
+  return SymbolParam(text.utf16(), text.length()).toDouble();
+}
+
+int main(void)
+{
+  // Every spec is reached through the prefix dispatcher
+  CHECK(creates<RoundSymbol>("r50"));
+  CHECK(creates<SquareSymbol>("s40"));
+  CHECK(creates<RectangleSymbol>("rect100x50"));
+  CHECK(creates<RectangleSymbol>("rect100x50xr20x13"));
+  CHECK(creates<RectangleSymbol>("rect100x50xc20"));
+  CHECK(creates<OvalSymbol>("oval50x100"));
+  CHECK(creates<HalfOvalSymbol>("oval_h30x60"));
+  CHECK(creates<DiamondSymbol>("di100x50"));
+  CHECK(creates<OctagonSymbol>("oct60x60x20"));
+  CHECK(creates<DonutRSymbol>("donut_r60x30"));
+  CHECK(creates<DonutSSymbol>("donut_s60x30"));
+  CHECK(creates<TriangleSymbol>("tri30x60"));
+  CHECK(creates<EllipseSymbol>("el60x30"));
+  CHECK(creates<HorizontalHexagonSymbol>("hex_l60x60x20"));
+  CHECK(creates<VerticalHexagonSymbol>("hex_s60x60x20"));
+  CHECK(creates<ButterflySymbol>("bfr60"));
+  CHECK(creates<SquareButterflySymbol>("bfs60"));
+  CHECK(creates<RoundThermalRoundSymbol>("thr60x40x45x4x10"));
+  CHECK(creates<RoundThermalSquareSymbol>("ths60x40x45x4x10"));
+  CHECK(creates<SquareThermalSymbol>("s_ths60x40x45x4x10"));
+  CHECK(creates<SquareThermalOpenCornersSymbol>("s_tho60x40x45x4x10"));
+  CHECK(creates<SquareRoundThermalSymbol>("sr_ths60x40x45x4x10"));
+  CHECK(creates<RectangularThermalSymbol>("rc_ths60x40x45x4x10x10"));
+  CHECK(creates<RectangularThermalOpenCornersSymbol>(
+        "rc_tho60x40x45x4x10x5"));
+  CHECK(creates<MoireSymbol>("moire5x10x4x4x100x0"));
+  CHECK(creates<HoleSymbol>("hole50xpx4x5"));
+  CHECK(creates<NullSymbol>("null1"));
+
+  // Unknown names, near misses of a prefix and bad parameters are left to
+  // the user symbols
+  CHECK(rejects(""));
+  CHECK(rejects("r"));
+  CHECK(rejects("R50"));
+  CHECK(rejects("round50"));
+  CHECK(rejects("r50x"));
+  CHECK(rejects("r-50"));
+  CHECK(rejects("rect"));
+  CHECK(rejects("rect100"));
+  CHECK(rejects("rect100x"));
+  CHECK(rejects("rect100x50x"));
+  CHECK(rejects("rect100x50xr"));
+  CHECK(rejects("rect100x50xq20"));
+  CHECK(rejects("rect100x50xr20x5"));
+  CHECK(rejects("rect100x50xr20x"));
+  CHECK(rejects("rectangle100x50"));
+  CHECK(rejects("ova50x100"));
+  CHECK(rejects("oval_v30x60"));
+  CHECK(rejects("donut_q60x30"));
+  CHECK(rejects("hex_m60x60x20"));
+  CHECK(rejects("hole50xqx4x5"));
+  CHECK(rejects("s_ths60x40x45x4"));
+  CHECK(rejects("rc_ths60x40x45x4x10"));
+  CHECK(rejects("moire5x10x4x4x100"));
+  CHECK(rejects("my_pad"));
+  CHECK(rejects("bfr60 "));
+
+  // Parameters are in mils; the captures keep every digit
+  CHECK(centred(bounds("r50"), 0.05, 0.05));
+  CHECK(centred(bounds("r12.5"), 0.0125, 0.0125));
+  CHECK(centred(bounds("r.5"), 0.0005, 0.0005));
+  CHECK(centred(bounds("s40"), 0.04, 0.04));
+  CHECK(centred(bounds("rect100x50"), 0.1, 0.05));
+  CHECK(centred(bounds("rect100x50xr20"), 0.1, 0.05));
+  CHECK(centred(bounds("rect100x50xr20x13"), 0.1, 0.05));
+  CHECK(centred(bounds("rect100x50xc20x24"), 0.1, 0.05));
+  CHECK(centred(bounds("rect1.5x2.25"), 0.0015, 0.00225));
+  CHECK(centred(bounds("di100x50"), 0.1, 0.05));
+  CHECK(centred(bounds("el60x30"), 0.06, 0.03));
+  CHECK(centred(bounds("tri30x60"), 0.03, 0.06));
+  CHECK(centred(bounds("oct60x40x20"), 0.06, 0.04));
+
+  // SymbolParam converts like QString does
+  const char* const numbers[] = {
+    "0", "7", "10", "0.1", ".5", "5.", "12.345", "0.000001",
+    "123456789012345", "1234567890123456789", "1.5e3", "1.2.3", ""
+  };
+  for (size_t i = 0; i < sizeof(numbers) / sizeof(numbers[0]); ++i) {
+    QString text = numbers[i];
+    CHECK(paramToDouble(text) == text.toDouble());
+  }
+  QString text = "x42y";
+  SymbolParam param(text.utf16() + 1, 2);
+  CHECK(param.length() == 2);
+  CHECK(param.toInt() == 42);
+  CHECK(param.toDouble() == 42.0);
+  CHECK(QString(param) == "42");
+  CHECK(param.toLatin1() == "42");
+  CHECK(param == "42");
+  CHECK(!(param == "4"));
+  CHECK(!(param == "420"));
+  CHECK(SymbolParam() == "");
+  CHECK(SymbolParam().length() == 0);
+
+  return testFailures;
+}
@@ -0,0 +1,7 @@
+TARGET = test_symbol_factory
+
+include (tests.pri)
+include (app.pri)
+
+SOURCES += \
+  tests/test_symbol_factory.cpp
@@ -0,0 +1,54 @@
+/**
+ * @file   testcheck.h
+ * @author Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ *
+ * Copyright (C) 2012 - 2014 Wei-Ning Huang (AZ) <aitjcize@gmail.com>
+ * All Rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __TEST_CHECK_H__
+#define __TEST_CHECK_H__
+
+#include <cmath>
+#include <cstdio>
+
+/**
+ * Minimal checks for the stand-alone kernel tests.  Failures are printed
+ * and counted; main() returns testFailures so the exit status tells.
+ */
+static int testFailures = 0;
+
+#define CHECK(cond) \
+  do { \
+    if (!(cond)) { \
+      fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, \
+          #cond); \
+      ++testFailures; \
+    } \
+  } while (0)
+
+#define CHECK_NEAR(value, expected, eps) \
+  do { \
+    double v_ = (value), e_ = (expected); \
+    if (!(std::fabs(v_ - e_) <= (eps))) { \
+      fprintf(stderr, "%s:%d: %s = %.9g, expected %.9g\n", __FILE__, \
+          __LINE__, #value, v_, e_); \
+      ++testFailures; \
+    } \
+  } while (0)
+
+#endif /* __TEST_CHECK_H__ */
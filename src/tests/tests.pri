@@ -1,6 +1,28 @@
-HEADERS += \
-  tests/testviewwidget.h
+# Settings shared by the test projects listed in tests.pro.  Every test is a
+# console program of its own; each .pro sets TARGET, includes this file and
+# adds the sources it links against.  Source paths are relative to src/ like
+# in the other .pri files and are found through VPATH.
+
+SRC_DIR = $$PWD/..
+BUILD_DIR = $$OUT_PWD/.build/$$TARGET
+
+TEMPLATE = app
+CONFIG += console c++17 testcase
+CONFIG -= app_bundle
+QT += core gui widgets
 
-SOURCES += \
-  tests/test_standard_symbols.cpp \
-  tests/testviewwidget.cpp
+VPATH += $$SRC_DIR
+INCLUDEPATH += \
+  $$SRC_DIR \
+  $$SRC_DIR/parser \
+  $$SRC_DIR/parser/odbpp \
+  $$SRC_DIR/symbol \
+  $$SRC_DIR/gui \
+  $$SRC_DIR/graphicsview \
+  $$SRC_DIR/geometry \
+  $$SRC_DIR/archive \
+  $$SRC_DIR/restapi \
+  $$BUILD_DIR
+
+HEADERS += \
+  tests/testcheck.h
@@ -0,0 +1,24 @@
+# Builds each test as its own executable; "make check" runs them all.
+#
+#   qmake src/tests/tests.pro && make && make check
+
+TEMPLATE = subdirs
+
+TESTS = \
+  test_arc_geometry \
+  test_code39 \
+  test_decoders \
+  test_features_diff \
+  test_fixed_point \
+  test_layer_store \
+  test_placement \
+  test_polygon_boolean \
+  test_shape_distance \
+  test_standard_symbols \
+  test_symbol_bounds \
+  test_symbol_factory
+
+for(test, TESTS) {
+  SUBDIRS += $$test
+  $${test}.file = $${test}.pro
+}